@@ -84,17 +84,12 @@ void setup() {
 void loop() {
     midiHandler.task();
 
-    const auto& queue = midiHandler.getQueue();
-    if (queue.empty()) return;
+    // Latest chord from the handler's chord index: no queue scan, no strings
+    const MIDIChord* chord = midiHandler.getLastChord();
+    if (!chord) return;
 
-    int currentChord = midiHandler.lastChord(queue);
-    if (currentChord <= 0) return;
-
-    // Count NoteOn events in the current chord
-    int noteCount = 0;
-    for (const auto& ev : queue) {
-        if (ev.chordIndex == currentChord && ev.status == "NoteOn") noteCount++;
-    }
+    int currentChord = chord->chordIndex;
+    int noteCount = chord->count;
 
     // Only re-analyze when chord changes or new notes are added
     if (currentChord == lastChordIdx && noteCount == lastNoteCount) return;
@@ -103,34 +98,25 @@ void loop() {
     lastChordIdx = currentChord;
     lastNoteCount = noteCount;
 
-    // Get MIDI note numbers and note names for this chord
-    std::vector<std::string> noteNumbers = midiHandler.getChord(
-        currentChord, queue, {"note"}
-    );
-    std::vector<std::string> noteOctaves = midiHandler.getChord(
-        currentChord, queue, {"noteOctave"}
-    );
-
-    if (noteNumbers.empty()) return;
-
-    // Convert to sorted GingoNote array
+    // MIDI note numbers (ascending) and "C4, E4, G4" for this chord
     uint8_t midiNotes[7];
     GingoNote gingoNotes[7];
-    uint8_t count = min((size_t)7, noteNumbers.size());
+    chord->noteNumbers(midiNotes, 7);
+    uint8_t n = GingoAdapter::chordToGingo(*chord, gingoNotes);
 
-    for (uint8_t i = 0; i < count; i++) {
-        midiNotes[i] = (uint8_t)atoi(noteNumbers[i].c_str());
-    }
-    uint8_t n = GingoAdapter::midiToGingoNotes(midiNotes, count, gingoNotes);
+    char notesBuf[64];
+    MIDIChordIndex::format(*chord, MIDI_CHORD_NOTE_OCTAVE, notesBuf, sizeof(notesBuf));
+    String notesStr = notesBuf;
 
     // Build display text
     String displayText = "";
 
     // Active notes count header
     size_t activeCount = midiHandler.getActiveNotesCount();
-    std::string activeStr = midiHandler.getActiveNotes();
+    char activeStr[48];
+    midiHandler.formatActiveNotes(activeStr, sizeof(activeStr));
     char header[64];
-    snprintf(header, sizeof(header), "[%d] %s", (int)activeCount, activeStr.c_str());
+    snprintf(header, sizeof(header), "[%d] %s", (int)activeCount, activeStr);
     displayText += header;
     displayText += "\n";
 
@@ -155,12 +141,6 @@ void loop() {
         iv.label(labelBuf, sizeof(labelBuf));
         iv.fullName(nameBuf, sizeof(nameBuf));
 
-        String notesStr = "";
-        for (size_t i = 0; i < noteOctaves.size(); i++) {
-            if (i > 0) notesStr += ", ";
-            notesStr += noteOctaves[i].c_str();
-        }
-
         displayText += notesStr;
         displayText += "\n-> ";
         displayText += labelBuf;
@@ -172,12 +152,6 @@ void loop() {
 
     } else {
         // --- Chord identification ---
-        String notesStr = "";
-        for (size_t i = 0; i < noteOctaves.size(); i++) {
-            if (i > 0) notesStr += ", ";
-            notesStr += noteOctaves[i].c_str();
-        }
-
         displayText += notesStr;
 
         char chordName[16];
@@ -117,25 +117,25 @@ static void processEvents() {
         if (ev.index <= lastEventIdx) continue;
         lastEventIdx = ev.index;
 
-        if (ev.status == "NoteOn" && ev.velocity > 0) {
+        if (ev.status == MIDI_EVENT_NOTE_ON && ev.velocity > 0) {
             manualNotes[ev.note] = true;
             addLogC(COL_NOTEON, "ON  n=%d(%s) v=%d c=%d i=%d",
-                    ev.note, ev.noteOctave.c_str(),
-                    ev.velocity, ev.chordIndex, ev.index);
-        } else if (ev.status == "NoteOff" ||
-                  (ev.status == "NoteOn" && ev.velocity == 0)) {
+                    ev.note, ev.noteOctave(),
+                    ev.velocity, ev.chordIndex, (int)ev.index);
+        } else if (ev.status == MIDI_EVENT_NOTE_OFF ||
+                  (ev.status == MIDI_EVENT_NOTE_ON && ev.velocity == 0)) {
             manualNotes[ev.note] = false;
             addLogC(COL_NOTEOFF, "OFF n=%d(%s) v=%d i=%d",
-                    ev.note, ev.noteOctave.c_str(), ev.velocity, ev.index);
-        } else if (ev.status == "ControlChange") {
+                    ev.note, ev.noteOctave(), ev.velocity, (int)ev.index);
+        } else if (ev.status == MIDI_EVENT_CONTROL_CHANGE) {
             addLogC(COL_CC, "CC  ctrl=%d val=%d ch=%d i=%d",
-                    ev.note, ev.velocity, ev.channel, ev.index);
-        } else if (ev.status == "PitchBend") {
+                    ev.note, ev.velocity, ev.channel, (int)ev.index);
+        } else if (ev.status == MIDI_EVENT_PITCH_BEND) {
             addLogC(COL_CC, "PB  val=%d ch=%d i=%d",
-                    ev.pitchBend, ev.channel, ev.index);
+                    ev.pitchBend(), ev.channel, (int)ev.index);
         } else {
             addLogC(COL_INFO, "%-11s n=%d v=%d i=%d",
-                    ev.status.c_str(), ev.note, ev.velocity, ev.index);
+                    ev.statusName(), ev.note, ev.velocity, (int)ev.index);
         }
     }
 }
@@ -12,6 +12,13 @@ static const unsigned long INIT_DISPLAY_DELAY = 500;
 // Maximum number of events displayed on screen
 static const int MAX_DISPLAY_EVENTS = 12;
 
+// Set by the MIDI callback; the screen is only redrawn when something arrived.
+static bool queueChanged = true;
+
+static void onMidiEvent(const MIDIEvent& ev, MIDITransport* source, void* ctx) {
+  queueChanged = true;
+}
+
 void setup() {
   Serial.begin(115200);
 
@@ -25,6 +32,7 @@ void setup() {
   display.print("MIDI Handler initialized...");
 
   midiHandler.enableHistory(0);
+  midiHandler.onEvent(onMidiEvent);
   display.print("USB & BLE MIDI Host initialized...");
   delay(INIT_DISPLAY_DELAY);
 }
@@ -35,30 +43,36 @@ void loop() {
   // Button 2: clear the queue and reset MIDI state
   if (digitalRead(PIN_BUTTON_2) == LOW) {
     midiHandler.clearQueue();
+    queueChanged = true;
     delay(200);
   }
 
+  if (!queueChanged) return;
+  queueChanged = false;
+
   const auto& queue = midiHandler.getQueue();
   String log;
 
   if (queue.empty()) {
     log = "[Press any key to start...]";
   } else {
-    std::string active = midiHandler.getActiveNotes();
+    char active[128];
+    midiHandler.formatActiveNotes(active, sizeof(active));
     size_t NotesCount = midiHandler.getActiveNotesCount();
-    log += "[" + String(NotesCount) + "] " + String(active.c_str()) + "\n";
+    log += "[" + String(NotesCount) + "] " + String(active) + "\n";
 
     int count = 0;
-    for (auto it = queue.rbegin(); it != queue.rend() && count < MAX_DISPLAY_EVENTS; ++it, ++count) {
+    for (int i = (int)queue.size() - 1; i >= 0 && count < MAX_DISPLAY_EVENTS; --i, ++count) {
+      const MIDIEvent& ev = queue[i];
       char line[200];
       sprintf(line, "%d;%d;%lu;%lu;%d;%s;%d;%s;%s;%d;%d",
-              it->index, it->msgIndex, it->timestamp, it->delay, it->channel,
-              it->status.c_str(), it->note, it->noteName.c_str(), it->noteOctave.c_str(),
-              it->velocity, it->chordIndex);
+              (int)ev.index, ev.msgIndex, (unsigned long)(ev.timestamp / 1000),
+              (unsigned long)(queue.delayAt(i) / 1000), ev.channel,
+              ev.statusName(), ev.note, ev.noteName(), ev.noteOctave(),
+              ev.velocity, ev.chordIndex);
       log += String(line) + "\n";
     }
   }
 
   display.print(log.c_str());
-  delayMicroseconds(1);
 }
@@ -39,34 +39,36 @@ static unsigned long lastStatusCheck = 0;
 
 // ---- helpers -----------------------------------------------------------
 
-static uint32_t eventColor(const std::string& s) {
-    if (s == "NoteOn")        return USB_COL_CYAN;
-    if (s == "NoteOff")       return USB_COL_GRAY;
-    if (s == "ControlChange") return USB_COL_YELLOW;
-    if (s == "PitchBend")     return USB_COL_MAGENTA;
-    if (s == "ProgramChange") return USB_COL_LIME;
-    return USB_COL_WHITE;
+static uint32_t eventColor(MIDIStatus s) {
+    switch (s) {
+        case MIDI_EVENT_NOTE_ON:        return USB_COL_CYAN;
+        case MIDI_EVENT_NOTE_OFF:       return USB_COL_GRAY;
+        case MIDI_EVENT_CONTROL_CHANGE: return USB_COL_YELLOW;
+        case MIDI_EVENT_PITCH_BEND:     return USB_COL_MAGENTA;
+        case MIDI_EVENT_PROGRAM_CHANGE: return USB_COL_LIME;
+        default:                        return USB_COL_WHITE;
+    }
 }
 
-static void formatEvent(const MIDIEventData& ev, char* buf, int len) {
-    if (ev.status == "NoteOn") {
+static void formatEvent(const MIDIEvent& ev, char* buf, int len) {
+    if (ev.status == MIDI_EVENT_NOTE_ON) {
         snprintf(buf, len, "NOTE+  %-3s  v=%-3d  ch%d",
-                 ev.noteOctave.c_str(), ev.velocity, ev.channel);
-    } else if (ev.status == "NoteOff") {
+                 ev.noteOctave(), ev.velocity, ev.channel);
+    } else if (ev.status == MIDI_EVENT_NOTE_OFF) {
         snprintf(buf, len, "NOTE-  %-3s  v=%-3d  ch%d",
-                 ev.noteOctave.c_str(), ev.velocity, ev.channel);
-    } else if (ev.status == "ControlChange") {
+                 ev.noteOctave(), ev.velocity, ev.channel);
+    } else if (ev.status == MIDI_EVENT_CONTROL_CHANGE) {
         snprintf(buf, len, "CC#%-3d  v=%-3d        ch%d",
                  ev.note, ev.velocity, ev.channel);
-    } else if (ev.status == "PitchBend") {
+    } else if (ev.status == MIDI_EVENT_PITCH_BEND) {
         snprintf(buf, len, "PB  %+6d             ch%d",
-                 ev.pitchBend - 8192, ev.channel);
-    } else if (ev.status == "ProgramChange") {
+                 ev.pitchBend() - 8192, ev.channel);
+    } else if (ev.status == MIDI_EVENT_PROGRAM_CHANGE) {
         snprintf(buf, len, "PC   prog=%-3d          ch%d",
                  ev.note, ev.channel);
     } else {
         snprintf(buf, len, "%-8s                ch%d",
-                 ev.status.c_str(), ev.channel);
+                 ev.statusName(), ev.channel);
     }
 }
 
@@ -14,6 +14,9 @@
 extern "C" {
 // #include <nes/nes.h> /* https://github.com/moononournation/arduino-nofrendo */
 #include <nofrendo.h>
+#if defined(HW_AUDIO_PIPELINE)
+#include <osd.h>
+#endif
 }
 
 #define FSROOT "/fs"
@@ -123,8 +126,13 @@ void setup()
         }
 
         if (!foundRom) {
+#if defined(HW_ROM_PARTITION)
+            /* the ROM comes from the partition, this only names the .sav file */
+            argv[0] = (char *)FSROOT "/" HW_ROM_PARTITION ".nes";
+#else
             Serial.println("Failed to find rom file, please copy rom file to data folder and upload with \"ESP32 Sketch Data Upload\"");
             argv[0] = "/";
+#endif
         }
 
         Serial.println("NoFrendo start!\n");
@@ -154,6 +162,18 @@ extern "C" void display_write_frame(const uint8_t *data[])
             bus->writeIndexedPixels((uint8_t *)(data[i]), myPalette, NES_SCREEN_WIDTH);
     }
     gfx->endWrite();
+
+#if defined(HW_AUDIO_PIPELINE)
+    // print the audio pipeline counters every 600 drawn frames
+    static uint32_t frames = 0;
+    if (++frames % 600 == 0) {
+        audio_stats_t stats;
+        osd_getaudiostats(&stats);
+        Serial.printf("audio: %u pipelined, %u inline, %u stalls, %u underruns, latency %u us (max %u)\n",
+                      stats.pipelined_frames, stats.inline_frames, stats.stalls, stats.underruns,
+                      stats.latency_us, stats.max_latency_us);
+    }
+#endif
 }
 
 extern "C" void display_clear()
@@ -4,8 +4,12 @@
 #include <freertos/task.h>
 #include <freertos/queue.h>
 
+#include <freertos/semphr.h>
+
 #include <driver/i2s.h>
 #include <esp_heap_caps.h>
+#include <esp_partition.h>
+#include <esp_timer.h>
 
 #include <noftypes.h>
 
@@ -15,11 +19,12 @@
 #include <nes/nes.h>
 #include <nes/nes_pal.h>
 #include <nes/nesinput.h>
+#include <nes/nesstate.h>
 #include <nofconfig.h>
 #include <osd.h>
 #include <string.h>
 
-TimerHandle_t timer;
+#include "pin_config.h"
 
 /* memory allocation */
 extern void *mem_alloc(int size, bool prefer_fast_memory)
@@ -31,16 +36,78 @@ extern void *mem_alloc(int size, bool prefer_fast_memory)
     }
 }
 
+/* ROM mapping */
+#if defined(HW_ROM_PARTITION)
+/* Map a raw iNES image flashed to its own data partition, so PRG/CHR are
+ * fetched through the flash cache instead of being copied to PSRAM. The
+ * partition stands in for the file named after it (<partition>.nes, in
+ * any directory); every other name is read from the filesystem. */
+static spi_flash_mmap_handle_t rom_handle;
+
+static bool rom_is_partition(const char *filename)
+{
+    const char *name = strrchr(filename, '/');
+    name = name ? name + 1 : filename;
+
+    return 0 == strcmp(name, HW_ROM_PARTITION ".nes") || 0 == strcmp(name, HW_ROM_PARTITION);
+}
+
+const void *osd_maprom(const char *filename, int *size)
+{
+    const esp_partition_t *part;
+    const void *image;
+
+    if (!rom_is_partition(filename))
+        return NULL;
+
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, HW_ROM_PARTITION);
+    if (NULL == part)
+        return NULL;
+
+    if (ESP_OK != esp_partition_mmap(part, 0, part->size, SPI_FLASH_MMAP_DATA, &image, &rom_handle))
+        return NULL;
+
+    /* an erased partition means the ROM lives on the filesystem after all */
+    if (memcmp(image, "NES\x1A", 4)) {
+        spi_flash_munmap(rom_handle);
+        return NULL;
+    }
+
+    nofrendo_log_printf("Mapped ROM from partition %s\n", HW_ROM_PARTITION);
+    *size = part->size;
+    return image;
+}
+
+void osd_unmaprom(const void *image, int size)
+{
+    spi_flash_munmap(rom_handle);
+}
+#else  /* !defined(HW_ROM_PARTITION) */
+const void *osd_maprom(const char *filename, int *size)
+{
+    return NULL;
+}
+
+void osd_unmaprom(const void *image, int size)
+{
+}
+#endif /* !defined(HW_ROM_PARTITION) */
+
 /* audio */
 #define DEFAULT_SAMPLERATE 22050
 
 #if defined(HW_AUDIO)
 
 #define DEFAULT_FRAGSIZE 1024
+#define DMA_BUF_LEN 512
 static void (*audio_callback)(void *buffer, int length) = NULL;
 QueueHandle_t queue;
 static int16_t *audio_frame;
 
+#if defined(HW_AUDIO_PIPELINE)
+static void audio_pipeline_init(void);
+#endif /* defined(HW_AUDIO_PIPELINE) */
+
 static int osd_init_sound(void)
 {
     audio_frame = NOFRENDO_MALLOC(4 * DEFAULT_FRAGSIZE);
@@ -61,10 +128,10 @@ static int osd_init_sound(void)
 #endif /* !defined(HW_AUDIO_EXTDAC) */
         .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
         .dma_buf_count = 6,
-        .dma_buf_len = 512,
+        .dma_buf_len = DMA_BUF_LEN,
         .use_apll = false,
     };
-    i2s_driver_install(I2S_NUM_0, &cfg, 2, &queue);
+    i2s_driver_install(I2S_NUM_0, &cfg, 8, &queue);
 #if defined(HW_AUDIO_EXTDAC)
     i2s_pin_config_t pins = {
         .bck_io_num = HW_AUDIO_EXTDAC_BCLK,
@@ -81,17 +148,26 @@ static int osd_init_sound(void)
 
     audio_callback = NULL;
 
+#if defined(HW_AUDIO_PIPELINE)
+    audio_pipeline_init();
+#endif /* defined(HW_AUDIO_PIPELINE) */
+
     return 0;
 }
 
 static void osd_stopsound(void)
 {
+#if defined(HW_AUDIO_PIPELINE)
+    apu_sync();
+#endif /* defined(HW_AUDIO_PIPELINE) */
     audio_callback = NULL;
 }
 
-static void do_audio_frame()
+/* returns the time spent blocked in i2s_write, waiting for DMA room */
+static uint32_t do_audio_frame()
 {
     int left = DEFAULT_SAMPLERATE / NES_REFRESH_RATE;
+    int64_t blocked = 0;
     while (left) {
         int n = DEFAULT_FRAGSIZE;
         if (n > left)
@@ -115,9 +191,12 @@ static void do_audio_frame()
         }
 
         size_t i2s_bytes_write;
+        int64_t start = esp_timer_get_time();
         i2s_write(I2S_NUM_0, (const char *)audio_frame, 4 * n, &i2s_bytes_write, portMAX_DELAY);
+        blocked += esp_timer_get_time() - start;
         left -= i2s_bytes_write / 4;
     }
+    return (uint32_t)blocked;
 }
 
 void osd_setsound(void (*playfunc)(void *buffer, int length))
@@ -126,6 +205,70 @@ void osd_setsound(void (*playfunc)(void *buffer, int length))
     audio_callback = playfunc;
 }
 
+#if defined(HW_AUDIO_PIPELINE)
+/* Pipelined audio: each frame is synthesized and written to I2S on core 0
+ * while core 1 goes on emulating the next one. APU register writes made
+ * meanwhile are logged by the APU and replayed before the next frame is
+ * synthesized, so the output matches the inline path sample for sample. */
+static audio_stats_t audio_stats; /* underruns also count in nes_getpace */
+static SemaphoreHandle_t audio_start, audio_done;
+
+/* snapshot of the pipeline counters, declared in osd.h */
+void osd_getaudiostats(audio_stats_t *stats)
+{
+    *stats = audio_stats;
+}
+static int64_t audio_handoff_us;
+
+//This runs on core 0.
+static void audioTask(void *arg)
+{
+    while (1) {
+        xSemaphoreTake(audio_start, portMAX_DELAY);
+        /* core 1 only pays for this wait if it stalls in audio_wait */
+        do_audio_frame();
+        uint32_t latency = (uint32_t)(esp_timer_get_time() - audio_handoff_us);
+        audio_stats.latency_us = latency;
+        if (latency > audio_stats.max_latency_us)
+            audio_stats.max_latency_us = latency;
+        xSemaphoreGive(audio_done);
+    }
+}
+
+/* called by the APU whenever core 1 needs it back */
+static void audio_wait(void)
+{
+    if (xSemaphoreTake(audio_done, 0) != pdTRUE) {
+        int64_t start = esp_timer_get_time();
+        audio_stats.stalls++;
+        xSemaphoreTake(audio_done, portMAX_DELAY);
+        nes_paceblocked((uint32)(esp_timer_get_time() - start));
+    }
+}
+
+static void audio_pipeline_init(void)
+{
+    audio_start = xSemaphoreCreateBinary();
+    audio_done = xSemaphoreCreateBinary();
+    xTaskCreatePinnedToCore(&audioTask, "audioTask", 2048, NULL, 1, NULL, 0);
+}
+
+static void audio_frame_end(void)
+{
+    /* take the APU back from the last frame, if it's still busy */
+    apu_sync();
+
+    if (audio_callback && apu_setdeferred(audio_wait)) {
+        audio_stats.pipelined_frames++;
+        audio_handoff_us = esp_timer_get_time();
+        xSemaphoreGive(audio_start);
+    } else {
+        audio_stats.inline_frames++;
+        nes_paceblocked(do_audio_frame());
+    }
+}
+#endif /* defined(HW_AUDIO_PIPELINE) */
+
 #else /* !defined(HW_AUDIO) */
 
 static int osd_init_sound(void)
@@ -137,8 +280,9 @@ static void osd_stopsound(void)
 {
 }
 
-static void do_audio_frame()
+static uint32_t do_audio_frame()
 {
+    return 0;
 }
 
 void osd_setsound(void (*playfunc)(void *buffer, int length))
@@ -223,7 +367,6 @@ static void free_write(int num_dirties, rect_t *dirty_rects)
 static void custom_blit(bitmap_t *bmp, int num_dirties, rect_t *dirty_rects)
 {
     xQueueSend(vidQueue, &bmp, 0);
-    do_audio_frame();
 }
 
 viddriver_t sdlDriver = {
@@ -252,6 +395,26 @@ void osd_getsoundinfo(sndinfo_t *info)
     info->bps = 16;
 }
 
+/* called for every emulated frame, skipped or not, so the sound never
+ * falls behind the I2S clock that paces emulation */
+void osd_audioframe(void)
+{
+#if defined(HW_AUDIO)
+    if (NULL == audio_callback)
+        return;
+#if defined(HW_AUDIO_PIPELINE)
+    audio_frame_end();
+#else  /* !defined(HW_AUDIO_PIPELINE) */
+    nes_paceblocked(do_audio_frame());
+#endif /* !defined(HW_AUDIO_PIPELINE) */
+#endif /* defined(HW_AUDIO) */
+}
+
+uint32 osd_getmicros(void)
+{
+    return (uint32)esp_timer_get_time();
+}
+
 /* input */
 extern void controller_init();
 extern uint32_t controller_read_input();
@@ -270,7 +433,11 @@ void osd_getinput(void)
     const int ev[32] = {
         event_joypad1_up, event_joypad1_down, event_joypad1_left, event_joypad1_right,
         event_joypad1_select, event_joypad1_start, event_joypad1_a, event_joypad1_b,
+#if defined(HW_REWIND)
+        event_state_save, event_state_rewind, 0, 0,
+#else  /* !defined(HW_REWIND) */
         event_state_save, event_state_load, 0, 0,
+#endif /* !defined(HW_REWIND) */
         0, 0, 0, 0,
         0, 0, 0, 0,
         0, 0, 0, 0,
@@ -330,15 +497,67 @@ int osd_main(int argc, char *argv[])
 {
     config.filename = configfilename;
 
+#if defined(HW_PACE_OVERLAY)
+    gui_togglepace();
+#endif /* defined(HW_PACE_OVERLAY) */
+#if defined(HW_RUNAHEAD)
+    nes_setrunahead(HW_RUNAHEAD);
+#endif /* defined(HW_RUNAHEAD) */
+#if defined(HW_REWIND)
+    state_setrewind(5, HW_REWIND);
+#endif /* defined(HW_REWIND) */
+
     return main_loop(argv[0], system_autodetect);
 }
 
+#if defined(HW_AUDIO)
+/* The I2S clock is the master: a frame is due each time the DMA has
+ * played a frame's worth of samples, so emulation can't drift from the
+ * sound. This runs on core 0. */
+static void (*tick_func)(void);
+
+static void audioClockTask(void *arg)
+{
+    int played = 0;
+    i2s_event_t evt;
+
+    while (1) {
+        xQueueReceive(queue, &evt, portMAX_DELAY);
+        if (evt.type == I2S_EVENT_TX_DONE) {
+            played += DMA_BUF_LEN;
+            while (played >= DEFAULT_SAMPLERATE / NES_REFRESH_RATE) {
+                played -= DEFAULT_SAMPLERATE / NES_REFRESH_RATE;
+                tick_func();
+            }
+        } else if (evt.type == I2S_EVENT_TX_Q_OVF) {
+#if defined(HW_AUDIO_PIPELINE)
+            audio_stats.underruns++;
+#endif /* defined(HW_AUDIO_PIPELINE) */
+            nes_paceunderrun();
+        }
+    }
+}
+#else  /* !defined(HW_AUDIO) */
+static esp_timer_handle_t tick_timer;
+#endif /* !defined(HW_AUDIO) */
+
 //Seemingly, this will be called only once. Should call func with a freq of frequency,
 int osd_installtimer(int frequency, void *func, int funcsize, void *counter, int countersize)
 {
-    nofrendo_log_printf("Timer install, configTICK_RATE_HZ=%d, freq=%d\n", configTICK_RATE_HZ, frequency);
-    timer = xTimerCreate("nes", configTICK_RATE_HZ / frequency, pdTRUE, NULL, func);
-    xTimerStart(timer, 0);
+#if defined(HW_AUDIO)
+    nofrendo_log_printf("Timer install, locked to I2S, freq=%d\n", frequency);
+    tick_func = func;
+    xTaskCreatePinnedToCore(&audioClockTask, "audioClock", 2048, NULL, 2, NULL, 0);
+#else  /* !defined(HW_AUDIO) */
+    /* esp_timer rather than a FreeRTOS timer: 1000 / 60 ticks isn't 60Hz */
+    const esp_timer_create_args_t args = {
+        .callback = (esp_timer_cb_t)func,
+        .name = "nes",
+    };
+    nofrendo_log_printf("Timer install, freq=%d\n", frequency);
+    esp_timer_create(&args, &tick_timer);
+    esp_timer_start_periodic(tick_timer, 1000000 / frequency);
+#endif /* !defined(HW_AUDIO) */
     return 0;
 }
 
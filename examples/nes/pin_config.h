@@ -5,6 +5,27 @@
 // #define HW_CONTROLLER_GPIO_ANALOG_JOYSTICK
 #define HW_CONTROLLER_DABBLE_APP
 
+// #define HW_AUDIO
+/* synthesize audio on core 0, in parallel with emulation on core 1 */
+// #define HW_AUDIO_PIPELINE
+
+/* run the ROM in place from a raw data partition holding the .nes file,
+ * e.g. "nesrom, data, 0x40, , 1M" in the partition table, written with
+ * esptool write_flash <offset> game.nes; it is used when the ROM opened is
+ * named after the partition (nesrom.nes), as when the filesystem has none */
+// #define HW_ROM_PARTITION "nesrom"
+
+/* show frame pacing stats (fps, frameskip, per-stage times) on screen */
+// #define HW_PACE_OVERLAY
+
+/* run-ahead: show this many frames ahead of emulation to hide the game's
+ * own input lag; each frame costs a state save/load and an extra frame */
+// #define HW_RUNAHEAD 1
+
+/* rewind: capture a state every 5 frames in this many bytes (PSRAM when
+ * there is some); holding Y steps back instead of loading the save slot */
+// #define HW_REWIND (512 * 1024)
+
 
 /*ESP32S3*/
 #define PIN_LCD_BL                 38
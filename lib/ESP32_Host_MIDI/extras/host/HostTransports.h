@@ -0,0 +1,147 @@
+#ifndef HOST_TRANSPORTS_H
+#define HOST_TRANSPORTS_H
+
+#include <vector>
+#include "MIDITransport.h"
+
+// Stand-in transports for driving MIDIHandler on a host build.
+
+// Replays a captured raw MIDI byte stream (as a DIN/UART port would deliver
+// it: running status, SysEx) at a fixed message rate. receive() plays the
+// part of the USB/BLE callback, pushing due messages into the ingress ring;
+// task() drains it like every built-in transport.
+class ReplayTransport : public MIDITransport {
+public:
+    static const int QUEUE_SIZE = 64;
+
+    // Splits the stream into messages. SysEx becomes MIDI_PACKET_SYSEX chunks.
+    void load(const uint8_t* bytes, size_t length) {
+        _packets.clear();
+        uint8_t running = 0;
+        size_t i = 0;
+        while (i < length) {
+            uint8_t b = bytes[i];
+            if (b == 0xF0) {
+                size_t end = i;
+                while (end < length && bytes[end] != 0xF7) end++;
+                if (end < length) end++;
+                for (size_t off = i; off < end; off += 16) {
+                    addPacket(bytes + off, end - off < 16 ? end - off : 16, MIDI_PACKET_SYSEX);
+                }
+                running = 0;
+                i = end;
+                continue;
+            }
+            if (b >= 0xF8) {
+                addPacket(bytes + i++, 1, 0);
+                continue;
+            }
+            uint8_t msg[3];
+            size_t n = 0;
+            if (b & 0x80) {
+                running = (b < 0xF0) ? b : 0;
+                msg[n++] = b;
+                i++;
+            } else if (running) {
+                msg[n++] = running;
+            } else {
+                i++;  // Stray data byte
+                continue;
+            }
+            uint8_t type = msg[0] & 0xF0;
+            size_t need = (msg[0] >= 0xF0) ? (msg[0] == 0xF2 ? 3 : (msg[0] == 0xF1 || msg[0] == 0xF3) ? 2 : 1)
+                        : (type == 0xC0 || type == 0xD0) ? 2 : 3;
+            while (n < need && i < length && !(bytes[i] & 0x80)) msg[n++] = bytes[i++];
+            if (n == need) addPacket(msg, n, 0);
+        }
+        _pushTimes.assign(_packets.size(), 0);
+    }
+
+    // messagesPerSecond = 0 replays as fast as the consumer drains.
+    // burst: messages that arrive together (a chord from one USB transfer).
+    void setRate(double messagesPerSecond, unsigned burst = 1) {
+        _rate = messagesPerSecond;
+        _burst = burst ? burst : 1;
+    }
+
+    void start() {
+        _next = 0;
+        _start = hostNanos();
+        _ring.discard();
+    }
+
+    // Pushes the messages whose time has come. Returns false once all are in.
+    bool receive() {
+        uint64_t now = hostNanos();
+        while (_next < _packets.size()) {
+            if (_rate > 0) {
+                uint64_t due = _start + (uint64_t)((_next / _burst) * _burst * 1e9 / _rate);
+                if (now < due) return true;
+            } else if (_ring.size() >= QUEUE_SIZE) {
+                return true;
+            }
+            const Packet& p = _packets[_next];
+            if (!_ring.push(p.data, p.length, (uint32_t)(now / 1000), p.flags)) return true;
+            _pushTimes[_next++] = now;
+        }
+        return false;
+    }
+
+    void task() override { drainMidiRing(_ring); }
+    bool isConnected() const override { return true; }
+    uint32_t getOverflowCount() const override { return _ring.overflowCount(); }
+
+    size_t messageCount() const { return _packets.size(); }
+    // hostNanos() when message i entered the ring.
+    uint64_t pushTime(size_t i) const { return _pushTimes[i]; }
+
+private:
+    struct Packet {
+        uint8_t data[16];
+        uint8_t length;
+        uint8_t flags;
+    };
+    std::vector<Packet> _packets;
+    std::vector<uint64_t> _pushTimes;
+    MIDIPacketRing<QUEUE_SIZE> _ring;
+    double _rate = 0;
+    unsigned _burst = 1;
+    size_t _next = 0;
+    uint64_t _start = 0;
+
+    void addPacket(const uint8_t* data, size_t length, uint8_t flags) {
+        Packet p;
+        memcpy(p.data, data, length);
+        p.length = (uint8_t)length;
+        p.flags = flags;
+        _packets.push_back(p);
+    }
+};
+
+// Output sink: counts what it is sent and when. Receives nothing.
+class LoopbackTransport : public MIDITransport {
+public:
+    explicit LoopbackTransport(size_t maxSends = 0) { _sendTimes.reserve(maxSends); }
+
+    void task() override {}
+    bool isConnected() const override { return true; }
+    bool sendMidiMessage(const uint8_t* data, size_t length) override {
+        if (_sendTimes.size() < _sendTimes.capacity()) _sendTimes.push_back(hostNanos());
+        _messages++;
+        _bytes += length;
+        return true;
+    }
+
+    void reset() { _sendTimes.clear(); _messages = 0; _bytes = 0; }
+    size_t messages() const { return _messages; }
+    size_t bytes() const { return _bytes; }
+    // hostNanos() of send i, for the first maxSends sends.
+    const std::vector<uint64_t>& sendTimes() const { return _sendTimes; }
+
+private:
+    std::vector<uint64_t> _sendTimes;
+    size_t _messages = 0;
+    size_t _bytes = 0;
+};
+
+#endif  // HOST_TRANSPORTS_H
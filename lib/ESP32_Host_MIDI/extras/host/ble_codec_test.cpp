@@ -0,0 +1,307 @@
+// BLE-MIDI codec unit test for a Linux host.
+//
+// Feeds packets as a central sends them (several messages per packet,
+// running status, timestamp roll-over, SysEx split across notifications
+// with real-time bytes in between) through BLEMIDIDecoder, and checks
+// BLEMIDIEncoder's packing, its flush window and that its packets decode
+// back to what went in. Exits non-zero if any check fails.
+//
+//   cmake -S extras/host -B build-host && cmake --build build-host
+//   ctest --test-dir build-host
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "BLEMIDICodec.h"
+
+// ---------- Checks ----------
+
+static int g_checks = 0;
+static int g_failures = 0;
+
+static void checkEq(long got, long want, const char* expr, int line) {
+  g_checks++;
+  if (got != want) {
+    g_failures++;
+    printf("FAIL line %d: %s == %ld, expected %ld\n", line, expr, got, want);
+  }
+}
+
+#define CHECK(cond)         checkEq((cond) ? 1 : 0, 1, #cond, __LINE__)
+#define CHECK_EQ(got, want) checkEq((long)(got), (long)(want), #got, __LINE__)
+
+// ---------- Decoding ----------
+
+struct Decoded {
+  std::vector<uint8_t> data;
+  uint32_t time;
+  bool sysex;
+};
+
+struct Capture {
+  BLEMIDIDecoder decoder;
+  std::vector<Decoded> out;
+
+  static void sink(void* ctx, const uint8_t* data, size_t length, uint32_t timestamp, bool sysex) {
+    Decoded d = { std::vector<uint8_t>(data, data + length), timestamp, sysex };
+    static_cast<Capture*>(ctx)->out.push_back(d);
+  }
+
+  size_t decode(const std::vector<uint8_t>& packet, uint32_t arrival) {
+    return decoder.decode(packet.data(), packet.size(), arrival, sink, this);
+  }
+
+  // Every SysEx chunk so far, joined.
+  std::vector<uint8_t> sysex() const {
+    std::vector<uint8_t> s;
+    for (const Decoded& d : out) {
+      if (d.sysex) s.insert(s.end(), d.data.begin(), d.data.end());
+    }
+    return s;
+  }
+};
+
+static bool same(const Decoded& d, std::initializer_list<uint8_t> bytes) {
+  return d.data == std::vector<uint8_t>(bytes);
+}
+
+// Header and timestamp bytes for sender time ms.
+static uint8_t hdr(uint16_t ms) { return 0x80 | ((ms >> 7) & 0x3F); }
+static uint8_t ts(uint16_t ms) { return 0x80 | (ms & 0x7F); }
+
+static const uint32_t ARRIVAL = 50000000;  // µs, well clear of zero
+
+static void testSeveralMessages() {
+  Capture c;
+  // NoteOn, CC and Program Change in one notification, 1 ms apart.
+  std::vector<uint8_t> p = { hdr(1000), ts(1000), 0x90, 60, 100,
+                             ts(1001), 0xB1, 7, 90,
+                             ts(1002), 0xC2, 5 };
+  CHECK_EQ(c.decode(p, ARRIVAL), 3);
+  CHECK_EQ(c.out.size(), 3);
+  if (c.out.size() != 3) return;
+  CHECK(same(c.out[0], { 0x90, 60, 100 }));
+  CHECK(same(c.out[1], { 0xB1, 7, 90 }));
+  CHECK(same(c.out[2], { 0xC2, 5 }));
+  // The latest stamp maps to the arrival, the others keep their spacing.
+  CHECK_EQ(c.out[2].time, ARRIVAL);
+  CHECK_EQ(c.out[2].time - c.out[1].time, 1000);
+  CHECK_EQ(c.out[1].time - c.out[0].time, 1000);
+  CHECK(!c.out[0].sysex);
+}
+
+static void testRunningStatus() {
+  Capture c;
+  // Without a new timestamp: data pairs straight after the first message.
+  std::vector<uint8_t> p = { hdr(2000), ts(2000), 0x90, 60, 100, 64, 101, 67, 102 };
+  CHECK_EQ(c.decode(p, ARRIVAL), 3);
+  if (c.out.size() == 3) {
+    CHECK(same(c.out[1], { 0x90, 64, 101 }));
+    CHECK(same(c.out[2], { 0x90, 67, 102 }));
+    CHECK_EQ(c.out[2].time, c.out[0].time);
+  }
+
+  // With a new timestamp before each data pair.
+  c.out.clear();
+  p = { hdr(2010), ts(2010), 0x80, 60, 0, ts(2015), 64, 0, ts(2020), 67, 0 };
+  CHECK_EQ(c.decode(p, ARRIVAL + 20000), 3);
+  if (c.out.size() == 3) {
+    CHECK(same(c.out[0], { 0x80, 60, 0 }));
+    CHECK(same(c.out[1], { 0x80, 64, 0 }));
+    CHECK(same(c.out[2], { 0x80, 67, 0 }));
+    CHECK_EQ(c.out[1].time - c.out[0].time, 5000);
+    CHECK_EQ(c.out[2].time - c.out[1].time, 5000);
+  }
+
+  // Running status carries over into the next packet.
+  c.out.clear();
+  p = { hdr(2030), ts(2030), 72, 0 };
+  CHECK_EQ(c.decode(p, ARRIVAL + 30000), 1);
+  if (c.out.size() == 1) CHECK(same(c.out[0], { 0x80, 72, 0 }));
+
+  // A real-time byte doesn't cancel it.
+  c.out.clear();
+  p = { hdr(2040), ts(2040), 0xF8, ts(2040), 74, 0 };
+  CHECK_EQ(c.decode(p, ARRIVAL + 40000), 2);
+  if (c.out.size() == 2) {
+    CHECK(same(c.out[0], { 0xF8 }));
+    CHECK(same(c.out[1], { 0x80, 74, 0 }));
+  }
+}
+
+static void testTimestampRollover() {
+  Capture c;
+  // Low part 126 -> 2: the high part has moved from 7 to 8 (ms 1022 -> 1026).
+  std::vector<uint8_t> p = { hdr(1022), ts(1022), 0x90, 60, 100, ts(1026), 0x80, 60, 0 };
+  CHECK_EQ(c.decode(p, ARRIVAL), 2);
+  if (c.out.size() == 2) {
+    CHECK_EQ(c.out[1].time - c.out[0].time, 4000);
+    CHECK_EQ(c.out[1].time, ARRIVAL);
+  }
+
+  // Across the 13-bit wrap (8191 -> 1) from one packet to the next.
+  c.out.clear();
+  p = { hdr(8191), ts(8191), 0x90, 61, 100 };
+  c.decode(p, ARRIVAL + 7169000);
+  p = { hdr(1), ts(1), 0x80, 61, 0 };
+  c.decode(p, ARRIVAL + 7171000);
+  if (c.out.size() == 2) CHECK_EQ(c.out[1].time - c.out[0].time, 2000);
+  CHECK_EQ(c.out.size(), 2);
+}
+
+static void testSplitSysEx() {
+  Capture c;
+  // F0 7D 01..0C F7 over three notifications, Timing Clock bytes in between.
+  std::vector<uint8_t> p1 = { hdr(3000), ts(3000), 0xF0, 0x7D, 0x01, 0x02, 0x03,
+                              ts(3000), 0xF8, 0x04, 0x05 };
+  std::vector<uint8_t> p2 = { hdr(3001), 0x06, 0x07, ts(3001), 0xF8, 0x08, 0x09, 0x0A };
+  std::vector<uint8_t> p3 = { hdr(3002), 0x0B, 0x0C, ts(3002), 0xF7 };
+  c.decode(p1, ARRIVAL);
+  c.decode(p2, ARRIVAL + 1000);
+  c.decode(p3, ARRIVAL + 2000);
+
+  std::vector<uint8_t> want = { 0xF0, 0x7D, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06,
+                                0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0xF7 };
+  CHECK(c.sysex() == want);
+
+  size_t clocks = 0;
+  for (const Decoded& d : c.out) {
+    if (!d.sysex) {
+      CHECK(same(d, { 0xF8 }));
+      clocks++;
+    }
+  }
+  CHECK_EQ(clocks, 2);
+  // Chunks are stamped in order, and the message after it still decodes.
+  for (size_t i = 1; i < c.out.size(); i++) CHECK(c.out[i].time >= c.out[i - 1].time);
+  c.out.clear();
+  std::vector<uint8_t> p4 = { hdr(3003), ts(3003), 0x90, 60, 1 };
+  CHECK_EQ(c.decode(p4, ARRIVAL + 3000), 1);
+
+  // A long message is handed over in chunks that rejoin exactly.
+  c.out.clear();
+  std::vector<uint8_t> big = { hdr(3100), ts(3100), 0xF0 };
+  for (uint8_t i = 0; i < 40; i++) big.push_back(i);
+  std::vector<uint8_t> end = { hdr(3101), ts(3101), 0xF7 };
+  c.decode(big, ARRIVAL + 100000);
+  c.decode(end, ARRIVAL + 101000);
+  want.assign(1, 0xF0);
+  for (uint8_t i = 0; i < 40; i++) want.push_back(i);
+  want.push_back(0xF7);
+  CHECK(c.sysex() == want);
+  CHECK(c.out.size() > 2);
+}
+
+// ---------- Encoding ----------
+
+static void testEncoderPacking() {
+  BLEMIDIEncoder enc;
+  const uint8_t note[3] = { 0x90, 60, 100 };
+
+  // Minimum MTU: header + 4 x (timestamp + 3 bytes) = 17; a fifth needs 21.
+  enc.setMaxPacket(20);
+  int fit = 0;
+  while (enc.add(note, 3, 1000)) fit++;
+  CHECK_EQ(fit, 4);
+  CHECK_EQ(enc.size(), 17);
+
+  enc.clear();
+  enc.setMaxPacket(100);  // MTU 103
+  fit = 0;
+  while (enc.add(note, 3, 1000)) fit++;
+  CHECK_EQ(fit, 24);
+  CHECK(enc.size() <= 100);
+
+  enc.setMaxPacket(600);
+  CHECK_EQ(enc.maxPacket(), BLEMIDIEncoder::MAX_PACKET);
+  enc.setMaxPacket(2);
+  CHECK_EQ(enc.maxPacket(), 5);
+
+  // Round trip, low timestamp rolling over inside the packet.
+  Capture c;
+  enc.clear();
+  enc.setMaxPacket(20);
+  const uint8_t off[3] = { 0x80, 60, 0 };
+  CHECK(enc.add(note, 3, 1022));
+  CHECK(enc.add(off, 3, 1026));
+  std::vector<uint8_t> packet(enc.data(), enc.data() + enc.size());
+  CHECK_EQ(c.decode(packet, ARRIVAL), 2);
+  if (c.out.size() == 2) {
+    CHECK(same(c.out[0], { 0x90, 60, 100 }));
+    CHECK(same(c.out[1], { 0x80, 60, 0 }));
+    CHECK_EQ(c.out[1].time - c.out[0].time, 4000);
+  }
+
+  // SysEx over several minimum-MTU notifications decodes back whole.
+  std::vector<uint8_t> msg = { 0xF0, 0x7D };
+  for (uint8_t i = 0; i < 50; i++) msg.push_back(i);
+  msg.push_back(0xF7);
+  c.out.clear();
+  enc.clear();
+  size_t done = 0;
+  int packets = 0;
+  while (done < msg.size()) {
+    size_t n = enc.addSysEx(msg.data(), msg.size(), done, 1100);
+    done += n;
+    CHECK(enc.size() <= 20);
+    packet.assign(enc.data(), enc.data() + enc.size());
+    c.decode(packet, ARRIVAL + 100000 + packets * 1000);
+    enc.clear();
+    packets++;
+    if (n == 0) break;
+  }
+  CHECK(c.sysex() == msg);
+  CHECK_EQ(packets, 3);  // 18 + 19 + 17 bytes of 54
+}
+
+static void testFlushWindow() {
+  BLEMIDIEncoder enc;
+  const uint8_t note[3] = { 0x90, 60, 100 };
+
+  CHECK_EQ(enc.flushWindow(), 1000);
+  CHECK(!enc.due(0));  // nothing queued is never due
+
+  enc.start(5000);
+  enc.add(note, 3, 5);
+  CHECK(!enc.due(5999));
+  CHECK(enc.due(6000));
+
+  // Later messages don't move the window of the packet they join.
+  enc.start(5800);
+  enc.add(note, 3, 5);
+  CHECK(enc.due(6000));
+
+  // A new packet starts a new window.
+  enc.clear();
+  CHECK(!enc.due(6000));
+  enc.start(7000);
+  enc.add(note, 3, 7);
+  CHECK(!enc.due(7500));
+
+  // Across the micros() wrap.
+  enc.clear();
+  enc.start(0xFFFFFF00);
+  enc.add(note, 3, 7);
+  CHECK(!enc.due(0x00000200));
+  CHECK(enc.due(0x00000300));
+
+  // No window: due as soon as it holds a message.
+  enc.clear();
+  enc.setFlushWindow(0);
+  enc.start(100);
+  CHECK(!enc.due(100));
+  enc.add(note, 3, 0);
+  CHECK(enc.due(100));
+}
+
+int main() {
+  testSeveralMessages();
+  testRunningStatus();
+  testTimestampRollover();
+  testSplitSysEx();
+  testEncoderPacking();
+  testFlushWindow();
+
+  printf("%d checks, %d failures\n", g_checks, g_failures);
+  return g_failures ? 1 : 0;
+}
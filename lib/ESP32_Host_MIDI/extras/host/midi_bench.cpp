@@ -0,0 +1,201 @@
+// MIDIHandler pipeline benchmark for a Linux host.
+//
+// Replays synthetic captures through ReplayTransport -> MIDIHandler and
+// reports, per scenario and consumer:
+//   events/s   events delivered per second of wall time
+//   allocs     heap allocations during the run (setup excluded)
+//   p50 / p99  latency from the message entering the transport's ingress
+//              ring to the consumer seeing it, in ns
+//
+// Scenarios: dense CC sweeps on 16 channels (running status), and 8-note
+// chord bursts that arrive together, as from one USB transfer.
+// Consumers:
+//   callback   midiHandler.onEvent(), the compact MIDIEvent path
+//   legacy     polling the queue through getEventData(), the std::string view
+//   thru       a MIDIRouter route to a LoopbackTransport
+//
+// Each is run flat out (throughput) and paced at --rate messages/s, where
+// latency is what a sketch calling task() in a tight loop would see.
+//
+// Build and run:
+//   cmake -S extras/host -B build-host && cmake --build build-host
+//   ./build-host/midi_bench [--messages N] [--rate R]
+
+#include <Arduino.h>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <vector>
+#include "MIDIHandler.h"
+#include "HostTransports.h"
+
+// ---------- Allocation counting ----------
+
+static size_t g_allocs = 0;
+
+// Direct malloc() calls from the library (MIDIEventQueue, MIDISysExBuffer)
+// are caught through the linker's --wrap; see CMakeLists.txt.
+extern "C" {
+void* __real_malloc(size_t n);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* p, size_t n);
+void* __wrap_malloc(size_t n) { g_allocs++; return __real_malloc(n); }
+void* __wrap_calloc(size_t n, size_t size) { g_allocs++; return __real_calloc(n, size); }
+void* __wrap_realloc(void* p, size_t n) { g_allocs++; return __real_realloc(p, n); }
+}
+
+// new inside libstdc++ itself (std::string, std::vector) doesn't go through
+// the wrapped symbol, so it is counted here.
+void* operator new(size_t n) {
+  g_allocs++;
+  if (void* p = __real_malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
+void* operator new[](size_t n) { return operator new(n); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+// ---------- Captures ----------
+
+// CC 1 swept up and down on each channel in turn, running status inside a sweep.
+static std::vector<uint8_t> ccSweep(size_t messages) {
+  std::vector<uint8_t> s;
+  s.reserve(messages * 2 + 64);
+  size_t n = 0;
+  for (int ch = 0; n < messages; ch = (ch + 1) & 0x0F) {
+    s.push_back(0xB0 | ch);
+    for (int i = 0; i < 254 && n < messages; i++, n++) {
+      s.push_back(1);
+      s.push_back(i < 127 ? i : 254 - i);
+    }
+  }
+  return s;
+}
+
+// 8-note chords: eight NoteOns, then eight NoteOffs, rooted on a moving note.
+static std::vector<uint8_t> chordBursts(size_t messages) {
+  static const int shape[8] = { 0, 4, 7, 11, 14, 17, 21, 24 };
+  std::vector<uint8_t> s;
+  s.reserve(messages * 3 + 64);
+  for (size_t n = 0, root = 36; n < messages; root = 36 + (root - 35) % 36) {
+    s.push_back(0x90);
+    for (int i = 0; i < 8 && n < messages; i++, n++) {
+      s.push_back(root + shape[i]);
+      s.push_back(64 + i * 8);
+    }
+    s.push_back(0x80);
+    for (int i = 0; i < 8 && n < messages; i++, n++) {
+      s.push_back(root + shape[i]);
+      s.push_back(0);
+    }
+  }
+  return s;
+}
+
+// ---------- Runs ----------
+
+enum Consumer { CONSUMER_CALLBACK, CONSUMER_LEGACY, CONSUMER_THRU };
+static const char* const consumerNames[] = { "callback", "legacy", "thru" };
+
+struct Run {
+  ReplayTransport* replay;
+  std::vector<uint64_t> latency;  // ns, one per delivered message
+  size_t delivered = 0;
+  size_t checksum = 0;            // keeps the legacy strings from being optimized out
+};
+
+static void onEvent(const MIDIEvent& ev, MIDITransport* source, void* ctx) {
+  Run* run = static_cast<Run*>(ctx);
+  run->latency.push_back(hostNanos() - run->replay->pushTime(run->delivered++));
+}
+
+// The queue as sketches written for the string API read it: every new
+// event through getEventData().
+static void pollLegacy(MIDIHandler& handler, Run& run, int32_t& lastIndex) {
+  const MIDIEventQueue& q = handler.getQueue();
+  for (size_t i = 0; i < q.size(); i++) {
+    if (q[i].index <= lastIndex) continue;
+    MIDIEventData d = handler.getEventData(i);
+    run.checksum += d.status.size() + d.noteOctave.size();
+    lastIndex = q[i].index;
+    run.latency.push_back(hostNanos() - run.replay->pushTime(run.delivered++));
+  }
+}
+
+static void runScenario(const char* name, const std::vector<uint8_t>& capture, unsigned burst,
+                        double rate, Consumer consumer) {
+  ReplayTransport replay;
+  replay.load(capture.data(), capture.size());
+  replay.setRate(rate, burst);
+  size_t messages = replay.messageCount();
+  LoopbackTransport loopback(messages);
+
+  std::unique_ptr<MIDIHandler> handler(new MIDIHandler());
+  MIDIHandlerConfig config;
+  config.maxEvents = 100;  // Holds more than one ring drain, so polling sees every event
+  handler->begin(config);
+  handler->addTransport(&replay);
+
+  Run run;
+  run.replay = &replay;
+  run.latency.reserve(messages);
+  if (consumer == CONSUMER_CALLBACK) handler->onEvent(onEvent, &run);
+  if (consumer == CONSUMER_THRU) handler->getRouter().addRoute(&replay, &loopback);
+
+  int32_t lastIndex = 0;
+  size_t allocs = g_allocs;
+  uint64_t t0 = hostNanos();
+  replay.start();
+  bool more;
+  do {
+    more = replay.receive();
+    handler->task();
+    if (consumer == CONSUMER_LEGACY) pollLegacy(*handler, run, lastIndex);
+  } while (more);
+  uint64_t elapsed = hostNanos() - t0;
+  allocs = g_allocs - allocs;
+
+  if (consumer == CONSUMER_THRU) {
+    const std::vector<uint64_t>& sends = loopback.sendTimes();
+    for (size_t i = 0; i < sends.size(); i++) run.latency.push_back(sends[i] - replay.pushTime(i));
+    run.delivered = loopback.messages();
+  }
+
+  std::vector<uint64_t>& lat = run.latency;
+  std::sort(lat.begin(), lat.end());
+  uint64_t p50 = lat.empty() ? 0 : lat[lat.size() / 2];
+  uint64_t p99 = lat.empty() ? 0 : lat[lat.size() * 99 / 100];
+  char mode[24];
+  if (rate > 0) snprintf(mode, sizeof(mode), "%.0f/s", rate);
+  else snprintf(mode, sizeof(mode), "max");
+  printf("%-12s %-9s %-8s %9zu %12.0f %7zu %9llu %9llu%s\n", name, consumerNames[consumer], mode,
+         run.delivered, run.delivered * 1e9 / elapsed, allocs,
+         (unsigned long long)p50, (unsigned long long)p99,
+         run.delivered == messages ? "" : "  (messages lost)");
+}
+
+int main(int argc, char** argv) {
+  size_t messages = 200000;
+  double rate = 20000;
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!strcmp(argv[i], "--messages")) messages = strtoul(argv[i + 1], nullptr, 10);
+    else if (!strcmp(argv[i], "--rate")) rate = strtod(argv[i + 1], nullptr);
+  }
+  // Paced runs last about a second each
+  size_t pacedMessages = std::min(messages, (size_t)(rate > 0 ? rate : messages));
+
+  printf("%-12s %-9s %-8s %9s %12s %7s %9s %9s\n", "scenario", "consumer", "rate", "events",
+         "events/s", "allocs", "p50 ns", "p99 ns");
+  for (int paced = 0; paced < 2; paced++) {
+    size_t n = paced ? pacedMessages : messages;
+    std::vector<uint8_t> cc = ccSweep(n);
+    std::vector<uint8_t> chords = chordBursts(n);
+    for (int c = CONSUMER_CALLBACK; c <= CONSUMER_THRU; c++) {
+      runScenario("cc-sweep", cc, 1, paced ? rate : 0, (Consumer)c);
+      runScenario("chord-burst", chords, 8, paced ? rate : 0, (Consumer)c);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,88 @@
+// Standard MIDI File round-trip test for a Linux host.
+//
+// Sends channel messages through MIDIHandler, records them with
+// MIDIFileWriter (as MIDIHandler::onEvent() delivers them), reads the file
+// back with MIDIFileReader and checks every message survives byte for byte,
+// the 2-byte ones (Program Change, Channel Pressure) included. The file
+// lives in the in-memory FS of shim/FS.h. Exits non-zero if any check fails.
+//
+//   cmake -S extras/host -B build-host && cmake --build build-host
+//   ctest --test-dir build-host
+
+#include <cstdio>
+#include <vector>
+#include "MIDIHandler.h"
+#include "MIDIFile.h"
+
+// ---------- Checks ----------
+
+static int g_checks = 0;
+static int g_failures = 0;
+
+static void checkEq(long got, long want, const char* expr, int line) {
+  g_checks++;
+  if (got != want) {
+    g_failures++;
+    printf("FAIL line %d: %s == %ld, expected %ld\n", line, expr, got, want);
+  }
+}
+
+#define CHECK(cond)         checkEq((cond) ? 1 : 0, 1, #cond, __LINE__)
+#define CHECK_EQ(got, want) checkEq((long)(got), (long)(want), #got, __LINE__)
+
+// ---------- Round trip ----------
+
+static void testRoundTrip(uint8_t format) {
+  static const std::vector<std::vector<uint8_t>> sent = {
+    { 0x90, 60, 100 },   // NoteOn
+    { 0xB0, 7, 90 },     // Control Change
+    { 0xC0, 42 },        // Program Change
+    { 0xD0, 85 },        // Channel Pressure
+    { 0xD0, 86 },        // Channel Pressure, running status
+    { 0xE0, 0x11, 0x45 },  // Pitch Bend
+    { 0xD3, 127 },       // Channel Pressure, channel 4
+    { 0x80, 60, 0 },     // NoteOff
+  };
+
+  fs::FS fs;
+  MIDIFileWriter rec;
+  CHECK(rec.begin(fs, "/take.mid", format));
+
+  MIDIHandler handler;
+  MIDIHandlerConfig config;
+  handler.begin(config);
+  handler.onEvent(MIDIFileWriter::onEvent, &rec);
+
+  uint32_t now = micros();
+  for (size_t i = 0; i < sent.size(); i++) {
+    handler.handleMidiMessage(sent[i].data(), sent[i].size(), now + (uint32_t)i * 1000, nullptr);
+  }
+  CHECK_EQ(rec.getEventCount(), sent.size());
+  CHECK(rec.end());
+
+  MIDIFileReader reader;
+  CHECK(reader.open(fs, "/take.mid"));
+  MIDIFileEvent ev;
+  size_t n = 0;
+  while (reader.next(ev)) {
+    if (n < sent.size()) {
+      CHECK(!ev.sysex);
+      CHECK_EQ(ev.length, sent[n].size());
+      for (size_t b = 0; b < ev.length && b < sent[n].size(); b++) {
+        CHECK_EQ(ev.data[b], sent[n][b]);
+      }
+    }
+    n++;
+  }
+  CHECK_EQ(n, sent.size());
+  CHECK_EQ(reader.getSkippedCount(), 0);
+  reader.close();
+}
+
+int main() {
+  testRoundTrip(0);
+  testRoundTrip(1);
+
+  printf("%d checks, %d failed\n", g_checks, g_failures);
+  return g_failures ? 1 : 0;
+}
@@ -0,0 +1,45 @@
+#ifndef HOST_ARDUINO_SHIM_H
+#define HOST_ARDUINO_SHIM_H
+
+// Minimal Arduino core for building the library's platform-independent
+// parts (MIDIHandler, MIDIEvent, MIDISysEx, MIDIRouter) on Linux.
+// Only what those files use is provided.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdarg>
+#include <ctime>
+#include <string>
+
+// Monotonic nanoseconds, for measurements finer than micros().
+inline uint64_t hostNanos() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// 32-bit like on the ESP32, so wrap-around code paths behave the same.
+inline unsigned long micros() { return (uint32_t)(hostNanos() / 1000); }
+inline unsigned long millis() { return (uint32_t)(hostNanos() / 1000000); }
+inline void delay(unsigned long) {}
+inline void yield() {}
+
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    void print(const char* s) { fputs(s, stdout); }
+    void println(const char* s = "") { puts(s); }
+    void printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        va_list args;
+        va_start(args, fmt);
+        vprintf(fmt, args);
+        va_end(args);
+    }
+};
+
+inline HostSerial Serial;
+
+#endif  // HOST_ARDUINO_SHIM_H
@@ -0,0 +1,77 @@
+#ifndef HOST_FS_SHIM_H
+#define HOST_FS_SHIM_H
+
+// In-memory stand-in for the Arduino fs::FS / fs::File API, enough for
+// MIDIFileWriter and MIDIFileReader. Files live in the FS object.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define FILE_READ  "r"
+#define FILE_WRITE "w"
+
+namespace fs {
+
+class File {
+public:
+  File() : pos(0) {}
+  explicit File(std::shared_ptr<std::vector<uint8_t>> d) : data(d), pos(0) {}
+
+  explicit operator bool() const { return data != nullptr; }
+
+  size_t write(const uint8_t* buf, size_t size) {
+    if (!data) return 0;
+    if (pos + size > data->size()) data->resize(pos + size);
+    memcpy(data->data() + pos, buf, size);
+    pos += size;
+    return size;
+  }
+
+  size_t read(uint8_t* buf, size_t size) {
+    if (!data || pos >= data->size()) return 0;
+    if (size > data->size() - pos) size = data->size() - pos;
+    memcpy(buf, data->data() + pos, size);
+    pos += size;
+    return size;
+  }
+
+  bool seek(uint32_t p) {
+    if (!data || p > data->size()) return false;
+    pos = p;
+    return true;
+  }
+
+  size_t position() const { return pos; }
+  size_t size() const { return data ? data->size() : 0; }
+  void close() { data.reset(); pos = 0; }
+
+private:
+  std::shared_ptr<std::vector<uint8_t>> data;
+  size_t pos;
+};
+
+class FS {
+public:
+  File open(const char* path, const char* mode) {
+    std::shared_ptr<std::vector<uint8_t>>& f = files[path];
+    if (strcmp(mode, FILE_WRITE) == 0) {
+      f = std::make_shared<std::vector<uint8_t>>();
+    } else if (!f) {
+      files.erase(path);
+      return File();
+    }
+    return File(f);
+  }
+
+private:
+  std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> files;
+};
+
+}  // namespace fs
+
+#endif  // HOST_FS_SHIM_H
@@ -3,9 +3,7 @@
 BLEConnection::BLEConnection()
     : pServer(nullptr), pCharacteristic(nullptr),
       pBleCallback(nullptr), pServerCallback(nullptr),
-      sendMutex(nullptr),
-      queueHead(0), queueTail(0),
-      queueMux(portMUX_INITIALIZER_UNLOCKED)
+      sendMutex(nullptr)
 {
 }
 
@@ -37,11 +35,11 @@ void BLEConnection::begin(const std::string& deviceName) {
             bleCon->dispatchConnected();
         }
         void onDisconnect(BLEServer*) override {
-            // Flush pending data from the disconnected central.
-            portENTER_CRITICAL(&bleCon->queueMux);
-            bleCon->queueHead = 0;
-            bleCon->queueTail = 0;
-            portEXIT_CRITICAL(&bleCon->queueMux);
+            // Flush pending data from the disconnected central. Only the
+            // consumer may move the tail, so task() does the actual discard.
+            bleCon->flushPending.store(true, std::memory_order_release);
+            // Same task as onWrite, so the decoder can be reset here.
+            bleCon->decoder.reset();
 
             bleCon->dispatchDisconnected();
             // Restart advertising so a new central can connect.
@@ -64,22 +62,21 @@ void BLEConnection::begin(const std::string& deviceName) {
     // CCCD descriptor: allows the central to enable/disable notifications.
     pCharacteristic->addDescriptor(new BLE2902());
 
-    // Receive callback: strips the 2-byte BLE MIDI header and enqueues raw MIDI bytes.
-    // BLE MIDI packet format: [header][timestamp][midi_bytes...]
+    // Receive callback: decodes every message of the BLE MIDI packet and
+    // enqueues each one with its reconstructed send time.
     // Processing is deferred to task() — same pattern as USBConnection.
     class BLECallback : public BLECharacteristicCallbacks {
     public:
         BLEConnection* bleCon;
         BLECallback(BLEConnection* con) : bleCon(con) {}
         void onWrite(BLECharacteristic* characteristic) override {
+            uint32_t now = (uint32_t)micros();
             String rxValue = characteristic->getValue();
             size_t len = rxValue.length();
-            // Minimum valid BLE MIDI packet: header + timestamp + 1 MIDI byte = 3 bytes
-            if (len >= 3) {
+            // Shortest packets: header + data (SysEx continuation), header + timestamp + status
+            if (len >= 2) {
                 const uint8_t* data = reinterpret_cast<const uint8_t*>(rxValue.c_str());
-                // Skip header (byte 0) and timestamp (byte 1); enqueue raw MIDI bytes.
-                // Processing happens in task() on the main loop — thread-safe.
-                bleCon->enqueueMidiMessage(data + 2, len - 2);
+                bleCon->decodePacket(data, len, now);
             }
         }
     };
@@ -97,6 +94,14 @@ void BLEConnection::begin(const std::string& deviceName) {
 void BLEConnection::task() {
     // Drain the ring buffer and dispatch via MIDITransport callbacks.
     processQueue();
+
+    // Send coalesced output once its window has passed. The check and the
+    // send share one lock so a sendMidiMessage() on another task can't
+    // change the packet in between; if one holds it now, try again next time.
+    if (sendMutex && xSemaphoreTake(sendMutex, 0) == pdTRUE) {
+        if (encoder.due((uint32_t)micros())) sendPacketLocked();
+        xSemaphoreGive(sendMutex);
+    }
 }
 
 bool BLEConnection::isConnected() const {
@@ -106,42 +111,28 @@ bool BLEConnection::isConnected() const {
 }
 
 // ---------- Ring Buffer ----------
-// Same pattern as USBConnection. Spinlock protects cross-task access:
-// enqueue() runs in the BLE stack task; dequeue() runs in the main loop.
-
-bool BLEConnection::enqueueMidiMessage(const uint8_t* data, size_t length) {
-    portENTER_CRITICAL(&queueMux);
-    int next = (queueHead + 1) % QUEUE_SIZE;
-    if (next == queueTail) {
-        // Queue full — discard to avoid blocking the BLE task.
-        portEXIT_CRITICAL(&queueMux);
-        return false;
-    }
-    size_t copyLen = (length > sizeof(bleQueue[0].data)) ? sizeof(bleQueue[0].data) : length;
-    memcpy(bleQueue[queueHead].data, data, copyLen);
-    bleQueue[queueHead].length = copyLen;
-    queueHead = next;
-    portEXIT_CRITICAL(&queueMux);
-    return true;
+// Same pattern as USBConnection: enqueue() runs in the BLE stack task,
+// processQueue() in the main loop. No locks on either side.
+
+bool BLEConnection::enqueueMidiMessage(const uint8_t* data, size_t length, uint32_t timestamp, uint8_t flags) {
+    // Queue full — dropped and counted, never blocks the BLE task.
+    return bleQueue.push(data, length, timestamp, flags);
 }
 
-bool BLEConnection::dequeueMidiMessage(RawBleMessage& msg) {
-    portENTER_CRITICAL(&queueMux);
-    if (queueTail == queueHead) {
-        portEXIT_CRITICAL(&queueMux);
-        return false;
-    }
-    msg = bleQueue[queueTail];
-    queueTail = (queueTail + 1) % QUEUE_SIZE;
-    portEXIT_CRITICAL(&queueMux);
-    return true;
+void BLEConnection::decodePacket(const uint8_t* data, size_t length, uint32_t arrival) {
+    decoder.decode(data, length, arrival, _onDecoded, this);
+}
+
+void BLEConnection::_onDecoded(void* ctx, const uint8_t* data, size_t length, uint32_t timestamp, bool sysex) {
+    static_cast<BLEConnection*>(ctx)->enqueueMidiMessage(data, length, timestamp, sysex ? MIDI_PACKET_SYSEX : 0);
 }
 
 void BLEConnection::processQueue() {
-    RawBleMessage msg;
-    while (dequeueMidiMessage(msg)) {
-        dispatchMidiData(msg.data, msg.length);
+    if (flushPending.load(std::memory_order_acquire)) {
+        flushPending.store(false, std::memory_order_relaxed);
+        bleQueue.discard();
     }
+    drainMidiRing(bleQueue);
 }
 
 // ---------- BLE MIDI Output ----------
@@ -149,30 +140,58 @@ void BLEConnection::processQueue() {
 bool BLEConnection::sendMidiMessage(const uint8_t* data, size_t length) {
     if (!pCharacteristic || !sendMutex || length == 0) return false;
 
-    // Build BLE MIDI 1.0 packet before acquiring the mutex.
-    //   Byte 0: Header    = 0x80 | ((timestamp_ms >> 7) & 0x3F)
-    //   Byte 1: Timestamp = 0x80 | (timestamp_ms & 0x7F)
-    //   Byte 2+: MIDI bytes (status + data bytes)
-    uint32_t ts = (uint32_t)millis();
-    uint8_t header    = 0x80 | ((ts >> 7) & 0x3F);
-    uint8_t timestamp = 0x80 | (ts & 0x7F);
-
-    size_t midiLen = (length > 18) ? 18 : length;  // safe limit for default BLE MTU
-    uint8_t packet[20];
-    packet[0] = header;
-    packet[1] = timestamp;
-    memcpy(packet + 2, data, midiLen);
-
     // Check connection inside the mutex to minimize TOCTOU race window.
     if (xSemaphoreTake(sendMutex, pdMS_TO_TICKS(100)) != pdTRUE) return false;
+    if (!isConnected()) {
+        encoder.clear();
+        xSemaphoreGive(sendMutex);
+        return false;
+    }
 
-    bool sent = false;
-    if (isConnected()) {
-        pCharacteristic->setValue(packet, 2 + midiLen);
-        pCharacteristic->notify();
-        sent = true;
+    // Payload per notification = negotiated ATT MTU - 3 (20 until the central asks for more)
+    uint16_t mtu = pServer->getPeerMTU(pServer->getConnId());
+    encoder.setMaxPacket(mtu > 3 ? mtu - 3 : 20);
+
+    uint32_t ms = (uint32_t)millis();
+    bool queued = true;
+    encoder.start((uint32_t)micros());
+    if (data[0] == 0xF0) {
+        // SysEx: fill notifications one after another until all of it is out
+        size_t done = 0;
+        while (done < length) {
+            encoder.start((uint32_t)micros());
+            size_t n = encoder.addSysEx(data, length, done, ms);
+            done += n;
+            if (done < length) {
+                if (n == 0 && encoder.empty()) {  // cannot fit even one byte
+                    queued = false;
+                    break;
+                }
+                sendPacketLocked();
+            }
+        }
+    } else if (!encoder.add(data, length, ms)) {
+        sendPacketLocked();
+        encoder.start((uint32_t)micros());
+        queued = encoder.add(data, length, ms);  // false if larger than a packet
     }
+    if (encoder.due((uint32_t)micros())) sendPacketLocked();
 
     xSemaphoreGive(sendMutex);
-    return sent;
+    return queued;
+}
+
+void BLEConnection::flush() {
+    if (!sendMutex) return;
+    if (xSemaphoreTake(sendMutex, pdMS_TO_TICKS(100)) != pdTRUE) return;
+    if (!encoder.empty()) sendPacketLocked();
+    xSemaphoreGive(sendMutex);
+}
+
+void BLEConnection::sendPacketLocked() {
+    if (!encoder.empty() && isConnected()) {
+        pCharacteristic->setValue(const_cast<uint8_t*>(encoder.data()), encoder.size());
+        pCharacteristic->notify();
+    }
+    encoder.clear();
 }
@@ -8,16 +8,15 @@
 #include <freertos/portmacro.h>
 #include <freertos/semphr.h>
 #include "MIDITransport.h"
+#include "BLEMIDICodec.h"
 
 // Standard BLE MIDI Service UUIDs (Apple/MIDI Association specification)
 #define BLE_MIDI_SERVICE_UUID        "03B80E5A-EDE8-4B33-A751-6CE34EC4C700"
 #define BLE_MIDI_CHARACTERISTIC_UUID "7772E5DB-3868-4112-A1A9-F2669D106BF3"
 
-// Structure to store a raw BLE MIDI packet (after BLE MIDI header is stripped).
-struct RawBleMessage {
-    uint8_t data[20];  // Up to 18 MIDI bytes (BLE MIDI safe MTU minus 2-byte header)
-    size_t length;
-};
+// One decoded message (or SysEx chunk) from a BLE MIDI packet, stamped with
+// the sender's timing mapped onto micros().
+typedef MIDIPacket RawBleMessage;
 
 class BLEConnection : public MIDITransport {
 public:
@@ -33,11 +32,26 @@ public:
     // Returns whether a BLE central is currently connected.
     bool isConnected() const override;
 
-    // Sends a MIDI message via BLE NOTIFY.
-    // data: raw MIDI bytes (status + data, no BLE header, no CIN byte).
-    // Returns true if connected and notification was sent.
+    // Queues a MIDI message for BLE NOTIFY.
+    // data: raw MIDI bytes (status + data, no BLE header, no CIN byte), or a
+    // whole SysEx message (F0 ... F7), which may span several notifications.
+    // Messages are packed into one notification, up to the negotiated MTU,
+    // until the flush window expires (checked in task()) or the packet is full.
+    // Returns true if connected and all of the message was queued; false if
+    // any of it (e.g. the rest of a SysEx) could not be.
     bool sendMidiMessage(const uint8_t* data, size_t length) override;
 
+    // How long (µs) the first queued message may wait for others to share its
+    // notification. 0 sends every message immediately. Default 1000 — well
+    // under one connection interval (7.5 ms minimum).
+    void setFlushWindow(uint32_t us) { encoder.setFlushWindow(us); }
+
+    // Sends whatever is queued now.
+    void flush();
+
+    // BLE MIDI packets dropped because the main loop fell behind.
+    uint32_t getOverflowCount() const override { return bleQueue.overflowCount(); }
+
 protected:
     BLEServer* pServer;
     BLECharacteristic* pCharacteristic;
@@ -45,17 +59,24 @@ protected:
     BLEServerCallbacks* pServerCallback;        // Managed to prevent memory leak
     SemaphoreHandle_t sendMutex;
 
-    // Ring buffer for incoming BLE MIDI packets.
-    // Protected by spinlock — same pattern as USBConnection.
+    // Lock-free ring for incoming BLE MIDI packets: the BLE stack task
+    // produces, task() on the main loop consumes — same pattern as USBConnection.
     static const int QUEUE_SIZE = 64;
-    RawBleMessage bleQueue[QUEUE_SIZE];
-    volatile int queueHead;
-    volatile int queueTail;
-    portMUX_TYPE queueMux;
+    MIDIPacketRing<QUEUE_SIZE> bleQueue;
+    // Set by the BLE task on disconnect; task() then drops what is still queued.
+    std::atomic<bool> flushPending{false};
+
+    // Input: decoded in the BLE task, one ring entry per message.
+    BLEMIDIDecoder decoder;
+    void decodePacket(const uint8_t* data, size_t length, uint32_t arrival);
+    static void _onDecoded(void* ctx, const uint8_t* data, size_t length, uint32_t timestamp, bool sysex);
+
+    // Output: coalesced under sendMutex.
+    BLEMIDIEncoder encoder;  // also keeps the flush window
 
-    bool enqueueMidiMessage(const uint8_t* data, size_t length);
-    bool dequeueMidiMessage(RawBleMessage& msg);
+    bool enqueueMidiMessage(const uint8_t* data, size_t length, uint32_t timestamp, uint8_t flags = 0);
     void processQueue();
+    void sendPacketLocked();  // sendMutex held
 };
 
 #endif // BLE_CONNECTION_H
@@ -0,0 +1,239 @@
+#include "BLEMIDICodec.h"
+#include <cstring>
+
+// Bytes in a MIDI message, status included.
+static uint8_t bleMidiMsgLength(uint8_t status) {
+    if (status < 0xF0) {
+        uint8_t type = status & 0xF0;
+        return (type == 0xC0 || type == 0xD0) ? 2 : 3;
+    }
+    switch (status) {
+        case 0xF1: return 2;  // MTC Quarter Frame
+        case 0xF2: return 3;  // Song Position Pointer
+        case 0xF3: return 2;  // Song Select
+        default:   return 1;  // Tune Request, undefined, real-time
+    }
+}
+
+// ---------- Decoder ----------
+
+void BLEMIDIDecoder::reset() {
+    _runningStatus = 0;
+    _inSysex = false;
+    _sysexLen = 0;
+    _synced = false;
+    _offset = 0;
+    _lastArrival = 0;
+    _lastTime = 0;
+}
+
+// Extends a 13-bit stamp to the sender's clock: the value closest to what
+// the current offset predicts for 'arrival' (handles the 8.192 s wrap).
+uint32_t BLEMIDIDecoder::senderClock(uint16_t senderMs, uint32_t arrival) const {
+    uint32_t expected = (arrival - _offset) / 1000;
+    int32_t delta = (int32_t)((uint32_t)(senderMs - expected) << 19) >> 19;
+    return expected + delta;
+}
+
+// One offset sample per packet, from its latest stamp: every message in the
+// packet was sent at or before that time, so none maps past the arrival.
+void BLEMIDIDecoder::syncClock(uint16_t latestMs, uint32_t arrival) {
+    if (!_synced) {
+        _offset = arrival - (uint32_t)latestMs * 1000;
+        _lastTime = arrival - 1000000;  // anything before now
+        _synced = true;
+    } else {
+        int32_t elapsed = (int32_t)(arrival - _lastArrival);
+        if (elapsed > 0) _offset += elapsed >> 12;  // follow drift, ~250 ppm
+        uint32_t sample = arrival - senderClock(latestMs, arrival) * 1000;
+        if ((int32_t)(sample - _offset) < 0) _offset = sample;
+    }
+    _lastArrival = arrival;
+}
+
+uint32_t BLEMIDIDecoder::localTime(uint16_t senderMs, uint32_t arrival) {
+    uint32_t t = senderClock(senderMs, arrival) * 1000 + _offset;
+    if ((int32_t)(t - arrival) > 0) t = arrival;      // never in the future
+    if ((int32_t)(t - _lastTime) < 0) t = _lastTime;  // never before the previous message
+    _lastTime = t;
+    return t;
+}
+
+void BLEMIDIDecoder::flushSysex(uint32_t time, Sink sink, void* ctx, size_t& count) {
+    if (_sysexLen == 0) return;
+    sink(ctx, _sysex, _sysexLen, time, true);
+    _sysexLen = 0;
+    count++;
+}
+
+size_t BLEMIDIDecoder::decode(const uint8_t* p, size_t length, uint32_t arrival, Sink sink, void* ctx) {
+    // Header: bit 7 set, bit 6 clear. Anything else is not BLE-MIDI.
+    if (length < 2 || (p[0] & 0xC0) != 0x80) return 0;
+
+    // First pass: the latest stamp in the packet. A byte with bit 7 set is a
+    // timestamp unless it directly follows one (then it is a status byte).
+    uint8_t high = p[0] & 0x3F;
+    int lastLow = -1;
+    bool prevStamp = false;
+    for (size_t k = 1; k < length; k++) {
+        bool isStamp = (p[k] & 0x80) && !prevStamp;
+        if (isStamp) {
+            uint8_t low = p[k] & 0x7F;
+            if (lastLow >= 0 && low < lastLow) high = (high + 1) & 0x3F;
+            lastLow = low;
+        }
+        prevStamp = isStamp;
+    }
+    syncClock((uint16_t)((high << 7) | (lastLow >= 0 ? lastLow : 0)), arrival);
+
+    size_t count = 0;
+    high = p[0] & 0x3F;
+    lastLow = -1;
+    uint32_t time = 0;
+    bool stamped = false;
+    size_t i = 1;
+
+    while (i < length) {
+        uint8_t b = p[i];
+
+        if (b & 0x80) {
+            // Timestamp byte: low 7 bits; a smaller value than the last one
+            // means the high part rolled over.
+            uint8_t low = b & 0x7F;
+            if (lastLow >= 0 && low < lastLow) high = (high + 1) & 0x3F;
+            lastLow = low;
+            time = localTime((uint16_t)((high << 7) | low), arrival);
+            stamped = true;
+            if (++i >= length) break;
+            b = p[i];
+
+            if (b & 0x80) {
+                if (b >= 0xF8) {  // Real-time, allowed anywhere, even inside SysEx
+                    sink(ctx, &b, 1, time, false);
+                    count++;
+                    i++;
+                    continue;
+                }
+                if (b == 0xF7) {
+                    if (_inSysex) {
+                        _sysex[_sysexLen++] = b;
+                        flushSysex(time, sink, ctx, count);
+                        _inSysex = false;
+                    }
+                    i++;
+                    continue;
+                }
+                // Any other status ends an unterminated SysEx (the handler drops it)
+                if (_inSysex) {
+                    flushSysex(time, sink, ctx, count);
+                    _inSysex = false;
+                }
+                if (b == 0xF0) {
+                    _inSysex = true;
+                    _sysex[0] = b;
+                    _sysexLen = 1;
+                    _runningStatus = 0;
+                    i++;
+                    continue;
+                }
+                _runningStatus = (b < 0xF0) ? b : 0;
+                uint8_t need = bleMidiMsgLength(b);
+                uint8_t msg[3] = { b, 0, 0 };
+                size_t n = 1;
+                i++;
+                while (n < need && i < length && !(p[i] & 0x80)) msg[n++] = p[i++];
+                if (n == need) {
+                    sink(ctx, msg, n, time, false);
+                    count++;
+                }
+                continue;
+            }
+            // Timestamp followed by data: running status with a new time (below)
+        }
+
+        // Data byte: SysEx payload, or a running-status message
+        if (_inSysex) {
+            if (!stamped) time = localTime((uint16_t)(high << 7), arrival);  // continuation packet
+            stamped = true;
+            _sysex[_sysexLen++] = b;
+            if (_sysexLen == SYSEX_CHUNK - 1) flushSysex(time, sink, ctx, count);  // room for F7
+            i++;
+            continue;
+        }
+        if (!_runningStatus || !stamped) {
+            i++;  // Stray data byte; nothing to attach it to
+            continue;
+        }
+        uint8_t need = bleMidiMsgLength(_runningStatus);
+        uint8_t msg[3] = { _runningStatus, 0, 0 };
+        size_t n = 1;
+        while (n < need && i < length && !(p[i] & 0x80)) msg[n++] = p[i++];
+        if (n == need) {
+            sink(ctx, msg, n, time, false);
+            count++;
+        }
+    }
+
+    // Hand over the SysEx bytes of this packet now; the rest follows in later packets.
+    if (_inSysex) flushSysex(time, sink, ctx, count);
+    return count;
+}
+
+// ---------- Encoder ----------
+
+void BLEMIDIEncoder::setMaxPacket(size_t bytes) {
+    if (bytes < 5) bytes = 5;
+    if (bytes > MAX_PACKET) bytes = MAX_PACKET;
+    _max = bytes;
+}
+
+uint8_t BLEMIDIEncoder::stamp(uint32_t ms) {
+    ms &= 0x1FFF;
+    if (_len == 0) {
+        _high = (ms >> 7) & 0x3F;
+        _buf[_len++] = 0x80 | _high;
+    } else {
+        // Stamps must not go backwards within a packet; the receiver can only
+        // infer one roll-over of the low 7 bits between two messages.
+        if ((uint32_t)((ms - _lastMs) & 0x1FFF) >= 0x1000) ms = _lastMs;
+        uint8_t low = ms & 0x7F;
+        uint8_t high = (low < _lastLow) ? ((_high + 1) & 0x3F) : _high;
+        if (high != ((ms >> 7) & 0x3F)) return 0;
+        _high = high;
+    }
+    _lastMs = ms;
+    _lastLow = ms & 0x7F;
+    return 0x80 | _lastLow;
+}
+
+bool BLEMIDIEncoder::add(const uint8_t* msg, size_t length, uint32_t ms) {
+    if (length == 0) return true;
+    size_t need = 1 + length + (_len == 0 ? 1 : 0);
+    if (_len + need > _max) return false;
+    uint8_t ts = stamp(ms);
+    if (!ts) return false;
+    _buf[_len++] = ts;
+    memcpy(_buf + _len, msg, length);
+    _len += length;
+    return true;
+}
+
+size_t BLEMIDIEncoder::addSysEx(const uint8_t* msg, size_t length, size_t offset, uint32_t ms) {
+    size_t pos = offset;
+    while (pos < length) {
+        uint8_t b = msg[pos];
+        bool needsStamp = (b == 0xF0 || b == 0xF7);
+        size_t need = (needsStamp ? 2 : 1) + (_len == 0 ? 1 : 0);
+        if (_len + need > _max) break;
+        if (needsStamp) {
+            uint8_t ts = stamp(ms);
+            if (!ts) break;
+            _buf[_len++] = ts;
+        } else if (_len == 0) {
+            stamp(ms);  // Continuation packet: header only, data follows directly
+        }
+        _buf[_len++] = b;
+        pos++;
+    }
+    return pos - offset;
+}
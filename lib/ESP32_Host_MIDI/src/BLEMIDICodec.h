@@ -0,0 +1,123 @@
+#ifndef BLE_MIDI_CODEC_H
+#define BLE_MIDI_CODEC_H
+
+#include <cstdint>
+#include <cstddef>
+
+// BLE-MIDI 1.0 packet codec (MIDI Association "MIDI over Bluetooth LE").
+// No BLE stack dependency, so it can be exercised on a host build.
+//
+// Packet layout:
+//   [header 10hhhhhh] ([timestamp 1lllllll] [status] [data...])...
+// The 13-bit millisecond timestamp is hhhhhh:lllllll; when the low part
+// goes backwards inside a packet the high part has advanced by one.
+// Running status may omit the status byte, with or without a new timestamp.
+// SysEx continues across packets: a continuation packet is the header
+// followed directly by data bytes; F7 is always preceded by a timestamp.
+
+// Decodes every message of every packet and maps the sender's timestamps
+// onto the local micros() clock.
+//
+// Timing: a packet leaves the sender at its timestamp and arrives one or more
+// connection intervals later, so (arrival - sender time) is the true clock
+// offset plus a non-negative delay. The decoder keeps the smallest offset seen
+// — the least-delayed packet — and lets it creep up by ~250 ppm of elapsed
+// time to follow drift between the two clocks. Message times are sender
+// time + offset: the spacing the player intended, without the 7.5-30 ms
+// interval jitter. Resolution is 1 ms, the protocol's own.
+class BLEMIDIDecoder {
+public:
+    // One decoded message. sysex = data is a SysEx chunk (F0 opens the
+    // message, F7 closes it), otherwise data is one complete MIDI message.
+    typedef void (*Sink)(void* ctx, const uint8_t* data, size_t length,
+                         uint32_t timestamp, bool sysex);
+
+    BLEMIDIDecoder() { reset(); }
+
+    // Forgets running status, partial SysEx and the clock estimate.
+    // Call when the connection drops.
+    void reset();
+
+    // arrival: micros() when the packet was received.
+    // Returns the number of messages / SysEx chunks delivered to sink.
+    size_t decode(const uint8_t* packet, size_t length, uint32_t arrival, Sink sink, void* ctx);
+
+    // Current estimate of (local µs - sender ms * 1000). Valid after the first packet.
+    int32_t clockOffset() const { return (int32_t)_offset; }
+
+private:
+    static const uint8_t SYSEX_CHUNK = 16;
+
+    uint8_t _runningStatus;
+    bool _inSysex;
+    uint8_t _sysex[SYSEX_CHUNK];
+    uint8_t _sysexLen;
+
+    bool _synced;
+    uint32_t _offset;       // local µs - sender ms * 1000, modulo 2^32
+    uint32_t _lastArrival;
+    uint32_t _lastTime;     // last timestamp handed out, kept monotonic
+
+    uint32_t senderClock(uint16_t senderMs, uint32_t arrival) const;
+    void syncClock(uint16_t latestMs, uint32_t arrival);
+    uint32_t localTime(uint16_t senderMs, uint32_t arrival);
+    void flushSysex(uint32_t time, Sink sink, void* ctx, size_t& count);
+};
+
+// Packs messages into one BLE-MIDI packet until the next one no longer
+// fits the payload size (negotiated ATT MTU - 3). The caller sends data()
+// and clear()s when add() refuses a message or the packet is due().
+class BLEMIDIEncoder {
+public:
+    static const size_t MAX_PACKET = 512;  // ATT maximum is 517 - 3
+
+    BLEMIDIEncoder()
+        : _max(20), _len(0), _high(0), _lastMs(0), _lastLow(0), _window(1000), _since(0) {}
+
+    // Payload limit; the default 20 fits the minimum MTU of 23.
+    void setMaxPacket(size_t bytes);
+    size_t maxPacket() const { return _max; }
+
+    // How long (µs) the first message of a packet may wait for others to
+    // share it. 0 makes every packet due as soon as it holds a message.
+    void setFlushWindow(uint32_t us) { _window = us; }
+    uint32_t flushWindow() const { return _window; }
+
+    // Call before adding with now = micros(): an empty packet starts its
+    // flush window here.
+    void start(uint32_t now) { if (_len == 0) _since = now; }
+
+    // Whether the packet holds messages whose flush window has passed.
+    bool due(uint32_t now) const { return _len != 0 && now - _since >= _window; }
+
+    // Appends one complete non-SysEx message stamped 'ms' (sender clock,
+    // millis()). Returns false, leaving the packet untouched, if it doesn't
+    // fit: send the packet, clear() and add again.
+    bool add(const uint8_t* msg, size_t length, uint32_t ms);
+
+    // Appends as much of a SysEx message (F0 ... F7) as fits, starting at
+    // 'offset'. Returns the bytes consumed; send, clear() and call again with
+    // offset + consumed until the whole message is in.
+    size_t addSysEx(const uint8_t* msg, size_t length, size_t offset, uint32_t ms);
+
+    bool empty() const { return _len == 0; }
+    const uint8_t* data() const { return _buf; }
+    size_t size() const { return _len; }
+    void clear() { _len = 0; }
+
+private:
+    uint8_t _buf[MAX_PACKET];
+    size_t _max;
+    size_t _len;
+    uint8_t _high;      // Timestamp high bits the receiver will be at after the last message
+    uint32_t _lastMs;
+    uint8_t _lastLow;
+    uint32_t _window;   // flush window, µs
+    uint32_t _since;    // micros() when the packet got its first message
+
+    // Writes the header if the packet is empty; returns the timestamp byte
+    // for 'ms', or 0 if the receiver couldn't reconstruct it from this packet.
+    uint8_t stamp(uint32_t ms);
+};
+
+#endif // BLE_MIDI_CODEC_H
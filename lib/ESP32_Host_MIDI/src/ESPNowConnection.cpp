@@ -5,10 +5,7 @@ ESPNowConnection* ESPNowConnection::_instance = nullptr;
 
 ESPNowConnection::ESPNowConnection()
     : initialized(false),
-      hasPeers(false),
-      queueHead(0),
-      queueTail(0),
-      queueMux(portMUX_INITIALIZER_UNLOCKED)
+      hasPeers(false)
 {
     memset(broadcastMAC, 0xFF, 6);
 }
@@ -74,8 +71,15 @@ void ESPNowConnection::_onReceive(const esp_now_recv_info_t* info, const uint8_t
 #else
 void ESPNowConnection::_onReceive(const uint8_t* mac, const uint8_t* data, int len) {
 #endif
-    if (!_instance || len < 2 || len > 3) return;
-    _instance->enqueueMidiMessage(data, len);
+    if (!_instance || len < 2) return;
+    uint32_t now = (uint32_t)micros();
+    // A whole SysEx message fits in one ESP-NOW frame (up to 250 bytes)
+    if (data[0] == 0xF0) {
+        _instance->enqueueSysEx(data, len, now);
+        return;
+    }
+    if (len > 3) return;
+    _instance->enqueueMidiMessage(data, len, now);
 }
 
 #if ESP_ARDUINO_VERSION_MAJOR >= 3
@@ -91,7 +95,9 @@ void ESPNowConnection::_onSend(const uint8_t* mac, esp_now_send_status_t status)
 // ---------- Send ----------
 
 bool ESPNowConnection::sendMidiMessage(const uint8_t* data, size_t length) {
-    if (!initialized || length == 0 || length > 3) return false;
+    if (!initialized || length == 0) return false;
+    // Channel messages, or one whole SysEx message per frame
+    if (length > 3 && !(data[0] == 0xF0 && length <= ESP_NOW_MAX_DATA_LEN)) return false;
     esp_err_t result = esp_now_send(broadcastMAC, data, length);
     return (result == ESP_OK);
 }
@@ -122,41 +128,25 @@ void ESPNowConnection::getLocalMAC(uint8_t mac[6]) const {
 }
 
 // ---------- Ring Buffer ----------
-// Same pattern as USBConnection/BLEConnection.
-// Spinlock protects cross-task access: enqueue runs in the WiFi task,
-// dequeue runs in the main loop.
-
-bool ESPNowConnection::enqueueMidiMessage(const uint8_t* data, size_t length) {
-    portENTER_CRITICAL(&queueMux);
-    int next = (queueHead + 1) % QUEUE_SIZE;
-    if (next == queueTail) {
-        portEXIT_CRITICAL(&queueMux);
-        return false;
-    }
-    size_t copyLen = (length > sizeof(espNowQueue[0].data))
-                   ? sizeof(espNowQueue[0].data) : length;
-    memcpy(espNowQueue[queueHead].data, data, copyLen);
-    espNowQueue[queueHead].length = copyLen;
-    queueHead = next;
-    portEXIT_CRITICAL(&queueMux);
-    return true;
+// Same pattern as USBConnection/BLEConnection: enqueue runs in the WiFi task,
+// processQueue runs in the main loop. No locks on either side.
+
+bool ESPNowConnection::enqueueMidiMessage(const uint8_t* data, size_t length, uint32_t timestamp) {
+    return espNowQueue.push(data, length, timestamp);
 }
 
-bool ESPNowConnection::dequeueMidiMessage(RawEspNowMessage& msg) {
-    portENTER_CRITICAL(&queueMux);
-    if (queueTail == queueHead) {
-        portEXIT_CRITICAL(&queueMux);
-        return false;
+// Splits one SysEx frame into ring-sized chunks. All or nothing: a
+// partially queued message would be delivered unterminated.
+bool ESPNowConnection::enqueueSysEx(const uint8_t* data, size_t length, uint32_t timestamp) {
+    const size_t chunk = sizeof(MIDIPacket::data);
+    if (espNowQueue.capacity() - espNowQueue.size() < (length + chunk - 1) / chunk) return false;
+    for (size_t off = 0; off < length; off += chunk) {
+        size_t n = (length - off < chunk) ? length - off : chunk;
+        espNowQueue.push(data + off, n, timestamp, MIDI_PACKET_SYSEX);
     }
-    msg = espNowQueue[queueTail];
-    queueTail = (queueTail + 1) % QUEUE_SIZE;
-    portEXIT_CRITICAL(&queueMux);
     return true;
 }
 
 void ESPNowConnection::processQueue() {
-    RawEspNowMessage msg;
-    while (dequeueMidiMessage(msg)) {
-        dispatchMidiData(msg.data, msg.length);
-    }
+    drainMidiRing(espNowQueue);
 }
@@ -9,11 +9,8 @@
 #include <freertos/portmacro.h>
 #include "MIDITransport.h"
 
-// Structure to store a raw ESP-NOW MIDI packet.
-struct RawEspNowMessage {
-    uint8_t data[4];   // Up to 3 MIDI bytes (status + data1 + data2)
-    size_t length;
-};
+// A queued ESP-NOW MIDI packet: a MIDIPacket holding up to 3 MIDI bytes.
+typedef MIDIPacket RawEspNowMessage;
 
 class ESPNowConnection : public MIDITransport {
 public:
@@ -33,6 +30,9 @@ public:
     // Sends raw MIDI bytes via ESP-NOW (broadcast or unicast).
     bool sendMidiMessage(const uint8_t* data, size_t length) override;
 
+    // ESP-NOW packets dropped because the main loop fell behind.
+    uint32_t getOverflowCount() const override { return espNowQueue.overflowCount(); }
+
     // --- Peer management ---
 
     // Adds a unicast peer. If no peers are added, broadcast is used.
@@ -49,16 +49,13 @@ private:
     uint8_t broadcastMAC[6];  // FF:FF:FF:FF:FF:FF
     bool hasPeers;
 
-    // Ring buffer for incoming ESP-NOW MIDI packets.
-    // Protected by spinlock — same pattern as USBConnection/BLEConnection.
+    // Lock-free ring for incoming ESP-NOW MIDI packets: the WiFi task
+    // produces, task() consumes — same pattern as USBConnection/BLEConnection.
     static const int QUEUE_SIZE = 64;
-    RawEspNowMessage espNowQueue[QUEUE_SIZE];
-    volatile int queueHead;
-    volatile int queueTail;
-    portMUX_TYPE queueMux;
+    MIDIPacketRing<QUEUE_SIZE> espNowQueue;
 
-    bool enqueueMidiMessage(const uint8_t* data, size_t length);
-    bool dequeueMidiMessage(RawEspNowMessage& msg);
+    bool enqueueMidiMessage(const uint8_t* data, size_t length, uint32_t timestamp);
+    bool enqueueSysEx(const uint8_t* data, size_t length, uint32_t timestamp);
     void processQueue();
 
     // Static callbacks — ESP-NOW uses global callbacks (no void* context),
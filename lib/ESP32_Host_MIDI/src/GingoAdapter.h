@@ -51,85 +51,115 @@ inline uint8_t midiToGingoNotes(const uint8_t* midiNotes, uint8_t count,
     return n;
 }
 
+// Converts a typed chord snapshot into GingoNote objects (lowest notes first).
+// Returns the number of notes written.
+inline uint8_t snapshotToGingo(const MIDIChordSnapshot& chord,
+                               gingoduino::GingoNote* output) {
+    if (!output) return 0;
+    return midiToGingoNotes(chord.notes, chord.count, output);
+}
+
+// Converts an indexed chord (see MIDIHandler::getChords()) into GingoNote
+// objects (lowest notes first). Returns the number of notes written.
+inline uint8_t chordToGingo(const MIDIChord& chord, gingoduino::GingoNote* output) {
+    if (!output) return 0;
+    uint8_t midiNotes[MIDIChord::MAX_NOTES];
+    uint8_t count = chord.noteNumbers(midiNotes, MIDIChord::MAX_NOTES);
+    return midiToGingoNotes(midiNotes, count, output);
+}
+
 // Converts active notes from MIDIHandler into GingoNote objects.
 // Returns the number of notes written.
 inline uint8_t activeNotesToGingo(const MIDIHandler& handler,
                                   gingoduino::GingoNote* output) {
     if (!output) return 0;
 
-    std::vector<std::string> noteNames = handler.getActiveNotesVector();
-    uint8_t count = 0;
-    for (const auto& name : noteNames) {
-        if (count >= MAX_CHORD_NOTES) break;
-        output[count++] = gingoduino::GingoNote(name.c_str());
-    }
-    return count;
+    MIDIChordSnapshot chord;
+    if (!handler.getActiveChord(chord)) return 0;
+    return snapshotToGingo(chord, output);
 }
 
 // =========================================================================
 // Chord Identification
 // =========================================================================
 
-// Identifies the chord from the last chord in the MIDIHandler queue.
+// Identifies the latest chord played (held or not).
+// Reads the handler's chord index — no queue scan, no strings.
 // Writes the chord name (e.g., "CM", "Am7", "Gdim") into the output buffer.
 // Returns true if a chord was identified, false otherwise.
 inline bool identifyLastChord(const MIDIHandler& handler,
                               char* output, uint8_t maxLen) {
     if (!output || maxLen < 2) return false;
 
-    const auto& queue = handler.getQueue();
-    if (queue.empty()) return false;
-
-    int chordIdx = handler.lastChord(queue);
-    if (chordIdx <= 0) return false;
-
-    std::vector<std::string> noteStrs = handler.getChord(
-        chordIdx, queue, {"note"}
-    );
-
-    if (noteStrs.empty()) return false;
-
-    uint8_t midiNotes[MAX_CHORD_NOTES];
-    uint8_t count = 0;
-    for (const auto& s : noteStrs) {
-        if (count >= MAX_CHORD_NOTES) break;
-        midiNotes[count++] = (uint8_t)atoi(s.c_str());
-    }
+    const MIDIChord* chord = handler.getLastChord();
+    if (!chord) return false;
 
     gingoduino::GingoNote notes[MAX_CHORD_NOTES];
-    uint8_t n = midiToGingoNotes(midiNotes, count, notes);
+    uint8_t n = chordToGingo(*chord, notes);
 
     return gingoduino::GingoChord::identify(notes, n, output, maxLen);
 }
 
-// Identifies a chord from a specific chordIndex in the queue.
+// Identifies the chord formed by the notes currently held.
+// Reads the handler's note bitsets directly — no queue scan, no strings.
 // Returns true if a chord was identified, false otherwise.
-inline bool identifyChord(const MIDIHandler& handler, int chordIndex,
-                          char* output, uint8_t maxLen) {
+inline bool identifyActiveChord(const MIDIHandler& handler,
+                                char* output, uint8_t maxLen) {
     if (!output || maxLen < 2) return false;
 
-    const auto& queue = handler.getQueue();
-    if (queue.empty()) return false;
+    gingoduino::GingoNote notes[MAX_CHORD_NOTES];
+    uint8_t n = activeNotesToGingo(handler, notes);
+    if (n == 0) return false;
+
+    return gingoduino::GingoChord::identify(notes, n, output, maxLen);
+}
 
-    std::vector<std::string> noteStrs = handler.getChord(
-        chordIndex, queue, {"note"}
-    );
+// Collects the notes of a specific chordIndex as GingoNote objects (lowest
+// notes first): from the chord index when it is still kept there, otherwise
+// from its NoteOns in the queue. Returns the number of notes written.
+inline uint8_t chordIndexToGingo(const MIDIHandler& handler, int chordIndex,
+                                 gingoduino::GingoNote* output) {
+    if (!output) return 0;
 
-    if (noteStrs.empty()) return false;
+    if (const MIDIChord* chord = handler.getChords().find(chordIndex)) {
+        return chordToGingo(*chord, output);
+    }
 
     uint8_t midiNotes[MAX_CHORD_NOTES];
     uint8_t count = 0;
-    for (const auto& s : noteStrs) {
+    for (const auto& event : handler.getQueue()) {
         if (count >= MAX_CHORD_NOTES) break;
-        midiNotes[count++] = (uint8_t)atoi(s.c_str());
+        if (event.chordIndex == chordIndex && event.status == MIDI_EVENT_NOTE_ON) {
+            midiNotes[count++] = event.note;
+        }
     }
+    return midiToGingoNotes(midiNotes, count, output);
+}
+
+// Identifies a chord from a specific chordIndex (see chordIndexToGingo()).
+// Returns true if a chord was identified, false otherwise.
+inline bool identifyChord(const MIDIHandler& handler, int chordIndex,
+                          char* output, uint8_t maxLen) {
+    if (!output || maxLen < 2) return false;
 
     gingoduino::GingoNote notes[MAX_CHORD_NOTES];
-    uint8_t n = midiToGingoNotes(midiNotes, count, notes);
+    uint8_t n = chordIndexToGingo(handler, chordIndex, notes);
+    if (n == 0) return false;
 
     return gingoduino::GingoChord::identify(notes, n, output, maxLen);
 }
 
+// Identifies a chord from a specific chordIndex as a Gingoduino chord ID
+// (lowest note = root), like identifyChord() but without building a name.
+// Returns true if a chord was identified.
+inline bool identifyChordId(const MIDIHandler& handler, int chordIndex,
+                            gingoduino::GingoChordId& id) {
+    gingoduino::GingoNote notes[MAX_CHORD_NOTES];
+    uint8_t n = chordIndexToGingo(handler, chordIndex, notes);
+
+    return n > 0 && gingoduino::GingoChord::identify(notes, n, id);
+}
+
 // =========================================================================
 // Harmonic Field Deduction (Tier 2+)
 // =========================================================================
@@ -148,7 +178,8 @@ inline uint8_t deduceField(const char* const* chordNames, uint8_t chordCount,
 }
 
 // Deduces harmonic field from all identified chords in the MIDIHandler queue.
-// Scans the queue, identifies each chord, then passes the chord names to Field::deduce.
+// Scans the queue, identifies each chord as a chord ID, then passes the
+// distinct IDs to Field::deduce — no chord names are built or parsed.
 // Returns number of results written.
 inline uint8_t deduceFieldFromQueue(const MIDIHandler& handler,
                                     gingoduino::FieldMatch* output, uint8_t maxResults) {
@@ -157,9 +188,8 @@ inline uint8_t deduceFieldFromQueue(const MIDIHandler& handler,
     const auto& queue = handler.getQueue();
     if (queue.empty()) return 0;
 
-    // Collect unique chord names from the queue
-    char chordBufs[MAX_CHORD_HISTORY][16];
-    const char* chordPtrs[MAX_CHORD_HISTORY];
+    // Collect unique chords from the queue
+    gingoduino::GingoChordId chords[MAX_CHORD_HISTORY];
     uint8_t chordCount = 0;
 
     // Find all unique chordIndex values in the queue
@@ -167,7 +197,7 @@ inline uint8_t deduceFieldFromQueue(const MIDIHandler& handler,
     uint8_t seenCount = 0;
 
     for (const auto& event : queue) {
-        if (event.chordIndex <= 0 || event.status != "NoteOn") continue;
+        if (event.chordIndex <= 0 || event.status != MIDI_EVENT_NOTE_ON) continue;
 
         // Check if we already processed this chordIndex
         bool seen = false;
@@ -179,25 +209,25 @@ inline uint8_t deduceFieldFromQueue(const MIDIHandler& handler,
         seenChords[seenCount++] = event.chordIndex;
 
         // Try to identify this chord
-        char name[16];
-        if (identifyChord(handler, event.chordIndex, name, sizeof(name))) {
-            // Check for duplicate chord names
+        gingoduino::GingoChordId id;
+        if (identifyChordId(handler, event.chordIndex, id)) {
+            // Check for duplicate chords
             bool dup = false;
             for (uint8_t i = 0; i < chordCount; i++) {
-                if (strcmp(chordBufs[i], name) == 0) { dup = true; break; }
+                if (chords[i].root == id.root && chords[i].formulaIdx == id.formulaIdx) {
+                    dup = true;
+                    break;
+                }
             }
             if (!dup && chordCount < MAX_CHORD_HISTORY) {
-                strncpy(chordBufs[chordCount], name, 15);
-                chordBufs[chordCount][15] = '\0';
-                chordPtrs[chordCount] = chordBufs[chordCount];
-                chordCount++;
+                chords[chordCount++] = id;
             }
         }
     }
 
     if (chordCount == 0) return 0;
 
-    return gingoduino::GingoField::deduce(chordPtrs, chordCount, output, maxResults);
+    return gingoduino::GingoField::deduce(chords, chordCount, output, maxResults);
 }
 
 #endif // GINGODUINO_HAS_FIELD
@@ -233,6 +263,37 @@ inline uint8_t predictNext(const char* tonic, gingoduino::ScaleType scaleType,
 
 #endif // GINGODUINO_HAS_PROGRESSION
 
+// =========================================================================
+// Sequence Playback (Tier 3)
+// =========================================================================
+
+#if GINGODUINO_HAS_SEQUENCE
+
+// Sends the messages of a GingoSequence that are due elapsedMicros after
+// playback started, each through handler.sendRaw(): the first transport
+// that accepts it, like the handler's other send functions. Call it from
+// loop() (or a timer armed for encoder.nextMicros()); the sequence is
+// encoded as it plays and never rendered to a buffer. Returns the messages
+// due, whether or not a transport took them.
+//
+//   gingoduino::GingoSequenceEncoder enc(seq);
+//   uint32_t start = micros();
+//   ...in loop(): GingoAdapter::playSequenceDue(midiHandler, enc, micros() - start);
+inline uint16_t playSequenceDue(MIDIHandler& handler,
+                                gingoduino::GingoSequenceEncoder& encoder,
+                                uint32_t elapsedMicros) {
+    uint16_t sent = 0;
+    gingoduino::GingoMIDIMessage msg;
+    while (!encoder.done() && encoder.nextMicros() <= elapsedMicros) {
+        encoder.next(msg);
+        handler.sendRaw(msg.data, 3);
+        sent++;
+    }
+    return sent;
+}
+
+#endif // GINGODUINO_HAS_SEQUENCE
+
 } // namespace GingoAdapter
 
 #endif // GINGO_ADAPTER_H
@@ -0,0 +1,126 @@
+#include <cstdio>
+#include "MIDIChordIndex.h"
+
+void MIDIChordIndex::noteOn(const MIDIEvent& ev) {
+  MIDIChord* c = count ? &chords[(head + CAPACITY - 1) % CAPACITY] : nullptr;
+  if (!c || c->chordIndex != ev.chordIndex) {
+    c = &chords[head];
+    head = (head + 1) % CAPACITY;
+    if (count < CAPACITY) count++;
+    c->chordIndex = ev.chordIndex;
+    c->count = 0;
+    c->held = 0;
+    c->pitchClasses = 0;
+    c->startTime = ev.timestamp;
+    c->releaseTime = 0;
+  }
+  c->lastNoteTime = ev.timestamp;
+  // Low 32 bits track ev.timestamp; the rest counts its wraps.
+  clockMicros += (uint32_t)(ev.timestamp - (uint32_t)clockMicros);
+  c->pitchClasses |= 1 << (ev.note % 12);
+
+  // Insert in note order; a retriggered note on the same channel is updated in place
+  uint8_t pos = 0;
+  while (pos < c->count && c->notes[pos].note < ev.note) pos++;
+  int same = -1;
+  for (uint8_t i = pos; i < c->count && c->notes[i].note == ev.note; i++) {
+    if (c->notes[i].channel == ev.channel) same = i;
+  }
+  if (same >= 0) {
+    pos = same;
+  } else {
+    if (c->count >= MIDIChord::MAX_NOTES) return;
+    for (uint8_t i = c->count; i > pos; i--) c->notes[i] = c->notes[i - 1];
+    c->count++;
+    c->notes[pos].held = false;
+  }
+
+  MIDIChordNote& n = c->notes[pos];
+  if (!n.held) c->held++;
+  n.timestamp = ev.timestamp;
+  n.millis = (uint32_t)(clockMicros / 1000);
+  n.index = ev.index;
+  n.msgIndex = ev.msgIndex;
+  n.note = ev.note;
+  n.velocity = ev.velocity;
+  n.channel = ev.channel;
+  n.held = true;
+}
+
+void MIDIChordIndex::noteOff(uint16_t chordIndex, uint8_t channel, uint8_t note, uint32_t timestamp) {
+  MIDIChord* c = findMutable(chordIndex);
+  if (!c) return;
+  for (uint8_t i = 0; i < c->count; i++) {
+    MIDIChordNote& n = c->notes[i];
+    if (n.note != note || n.channel != channel || !n.held) continue;
+    n.held = false;
+    if (--c->held == 0) c->releaseTime = timestamp;
+    return;
+  }
+}
+
+void MIDIChordIndex::releaseAll(uint32_t timestamp) {
+  for (uint8_t k = 0; k < count; k++) {
+    MIDIChord& c = chords[k];
+    if (!c.held) continue;
+    for (uint8_t i = 0; i < c.count; i++) c.notes[i].held = false;
+    c.held = 0;
+    c.releaseTime = timestamp;
+  }
+}
+
+MIDIChord* MIDIChordIndex::findMutable(uint16_t chordIndex) {
+  // Newest first: NoteOffs almost always belong to one of the last chords
+  for (uint8_t n = 0; n < count; n++) {
+    MIDIChord& c = chords[(head + CAPACITY - 1 - n) % CAPACITY];
+    if (c.chordIndex == chordIndex) return &c;
+  }
+  return nullptr;
+}
+
+const MIDIChord* MIDIChordIndex::find(uint16_t chordIndex) const {
+  return const_cast<MIDIChordIndex*>(this)->findMutable(chordIndex);
+}
+
+size_t MIDIChordIndex::format(const MIDIChord& chord, uint16_t fields, char* buf, size_t len, bool labels) {
+  if (!buf || len == 0) return 0;
+  static const char* const names[] = {
+    "note", "noteName", "noteOctave", "velocity", "channel", "timestamp", "index", "msgIndex",
+  };
+  size_t pos = 0;
+  auto put = [&](const char* s) {
+    while (*s && pos + 1 < len) buf[pos++] = *s++;
+  };
+  bool multi = (fields & (fields - 1)) != 0 || labels;
+
+  for (uint8_t i = 0; i < chord.count; i++) {
+    const MIDIChordNote& n = chord.notes[i];
+    if (i > 0) put(", ");
+    if (multi) put("{");
+    bool first = true;
+    for (int f = 0; f < 8; f++) {
+      if (!(fields & (1u << f))) continue;
+      if (!first) put(", ");
+      first = false;
+      if (labels) {
+        put(names[f]);
+        put(":");
+      }
+      char num[12];
+      switch (1u << f) {
+        case MIDI_CHORD_NOTE:        snprintf(num, sizeof(num), "%u", n.note); break;
+        case MIDI_CHORD_NOTE_NAME:   put(midiNoteName(n.note)); continue;
+        case MIDI_CHORD_NOTE_OCTAVE: put(midiNoteOctaveName(n.note)); continue;
+        case MIDI_CHORD_VELOCITY:    snprintf(num, sizeof(num), "%u", n.velocity); break;
+        case MIDI_CHORD_CHANNEL:     snprintf(num, sizeof(num), "%u", n.channel); break;
+        case MIDI_CHORD_TIMESTAMP:   snprintf(num, sizeof(num), "%lu", (unsigned long)n.millis); break;
+        case MIDI_CHORD_INDEX:       snprintf(num, sizeof(num), "%ld", (long)n.index); break;
+        default:                     snprintf(num, sizeof(num), "%u", n.msgIndex); break;
+      }
+      put(num);
+    }
+    if (multi) put("}");
+  }
+  buf[pos] = '\0';
+  return pos;
+}
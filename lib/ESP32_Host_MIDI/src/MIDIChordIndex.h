@@ -0,0 +1,108 @@
+#ifndef MIDI_CHORD_INDEX_H
+#define MIDI_CHORD_INDEX_H
+
+#include <cstdint>
+#include <cstddef>
+#include "MIDIEvent.h"
+
+// Chords kept by MIDIChordIndex (the most recent ones; older are dropped).
+#ifndef ESP32_HOST_MIDI_CHORD_HISTORY
+  #define ESP32_HOST_MIDI_CHORD_HISTORY 8
+#endif
+
+// Fields for MIDIChordIndex::format(), combined as a mask.
+enum MIDIChordField : uint16_t {
+  MIDI_CHORD_NOTE        = 1 << 0,  // 60
+  MIDI_CHORD_NOTE_NAME   = 1 << 1,  // C
+  MIDI_CHORD_NOTE_OCTAVE = 1 << 2,  // C4
+  MIDI_CHORD_VELOCITY    = 1 << 3,
+  MIDI_CHORD_CHANNEL     = 1 << 4,
+  MIDI_CHORD_TIMESTAMP   = 1 << 5,  // ms, like the legacy field
+  MIDI_CHORD_INDEX       = 1 << 6,  // MIDIEvent::index of the NoteOn
+  MIDI_CHORD_MSG_INDEX   = 1 << 7,
+};
+
+// One note of a chord, as its NoteOn arrived.
+struct MIDIChordNote {
+  uint32_t timestamp;  // micros() of the NoteOn
+  uint32_t millis;     // ms of the NoteOn; wraps after 49 days, not 71 minutes
+  int32_t index;       // MIDIEvent::index of the NoteOn
+  uint16_t msgIndex;   // Pairs with its NoteOff
+  uint8_t note;
+  uint8_t velocity;
+  uint8_t channel;     // 1-16
+  bool held;           // Not released yet
+};
+
+// A chord group: the NoteOns that share a chordIndex, ascending by note.
+struct MIDIChord {
+  static const uint8_t MAX_NOTES = 16;
+
+  uint16_t chordIndex;
+  uint8_t count;           // Notes in notes[] (NoteOns past MAX_NOTES are not kept)
+  uint8_t held;            // Notes in notes[] still down
+  uint16_t pitchClasses;   // Bit n set = pitch class n played (C = bit 0)
+  uint32_t startTime;      // micros() of the first NoteOn
+  uint32_t lastNoteTime;   // micros() of the latest NoteOn
+  uint32_t releaseTime;    // micros() when the last note was released; valid once held == 0
+  MIDIChordNote notes[MAX_NOTES];
+
+  bool isHeld() const { return held > 0; }
+  // Strum / roll spread: first to last NoteOn.
+  uint32_t spread() const { return lastNoteTime - startTime; }
+  // Copies the note numbers (ascending) into out. Returns how many.
+  uint8_t noteNumbers(uint8_t* out, uint8_t maxNotes) const {
+    uint8_t n = count < maxNotes ? count : maxNotes;
+    for (uint8_t i = 0; i < n; i++) out[i] = notes[i].note;
+    return n;
+  }
+};
+
+// Chord groups built as NoteOn/NoteOff events are parsed, so the latest
+// chords are available without scanning the event queue. A fixed ring of
+// CAPACITY chords: recent(n) is O(1), nothing is allocated.
+class MIDIChordIndex {
+public:
+  static const uint8_t CAPACITY = ESP32_HOST_MIDI_CHORD_HISTORY;
+
+  MIDIChordIndex() : clockMicros(0) { clear(); }
+
+  void clear() { head = 0; count = 0; }
+
+  // A stored NoteOn (velocity > 0). A chordIndex different from the latest
+  // chord's opens a new chord.
+  void noteOn(const MIDIEvent& event);
+  // A NoteOff paired with chord chordIndex by MIDIHandler.
+  void noteOff(uint16_t chordIndex, uint8_t channel, uint8_t note, uint32_t timestamp);
+  // Marks every note released (connection lost, all notes cleared).
+  void releaseAll(uint32_t timestamp);
+
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+
+  // n = 0 is the latest chord. nullptr if fewer than n + 1 are kept.
+  const MIDIChord* recent(size_t n = 0) const {
+    return n < count ? &chords[(head + CAPACITY - 1 - n) % CAPACITY] : nullptr;
+  }
+  // The chord with this chordIndex, nullptr if it is no longer kept.
+  const MIDIChord* find(uint16_t chordIndex) const;
+
+  // Writes the chord's notes, lowest first, with the fields in mask:
+  //   MIDI_CHORD_NOTE_OCTAVE                      -> "C4, E4, G4"
+  //   MIDI_CHORD_NOTE | MIDI_CHORD_VELOCITY       -> "{60, 100}, {64, 90}"
+  //   same with labels                            -> "{note:60, velocity:100}, ..."
+  // Fields appear in MIDIChordField order. Truncated to len; returns the
+  // length written.
+  static size_t format(const MIDIChord& chord, uint16_t fields, char* buf, size_t len,
+                       bool labels = false);
+
+private:
+  MIDIChord chords[CAPACITY];
+  uint8_t head;   // Slot the next chord goes into
+  uint8_t count;
+  uint64_t clockMicros;  // 64-bit µs time of the latest NoteOn, kept by clear()
+
+  MIDIChord* findMutable(uint16_t chordIndex);
+};
+
+#endif  // MIDI_CHORD_INDEX_H
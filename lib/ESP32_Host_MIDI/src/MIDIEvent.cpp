@@ -0,0 +1,76 @@
+#include <Arduino.h>
+#include "MIDIHandler.h"
+
+#if ESP32_HOST_MIDI_HAS_PSRAM
+  #include "esp_heap_caps.h"
+#endif
+
+MIDIEventQueue::~MIDIEventQueue() {
+  release();
+}
+
+bool MIDIEventQueue::setCapacity(size_t capacity, bool preferPsram) {
+  if (capacity == 0) {
+    release();
+    return true;
+  }
+
+  MIDIEvent* newBuf = nullptr;
+#if ESP32_HOST_MIDI_HAS_PSRAM
+  if (preferPsram) {
+    newBuf = static_cast<MIDIEvent*>(heap_caps_malloc(capacity * sizeof(MIDIEvent), MALLOC_CAP_SPIRAM));
+  }
+#else
+  (void)preferPsram;
+#endif
+  if (!newBuf) {
+    newBuf = static_cast<MIDIEvent*>(malloc(capacity * sizeof(MIDIEvent)));
+  }
+  if (!newBuf) return false;
+
+  // Keep the newest events that fit, oldest first.
+  size_t keep = (count < capacity) ? count : capacity;
+  size_t skip = count - keep;
+  uint32_t delay = delayAt(skip);
+  for (size_t i = 0; i < keep; i++) {
+    newBuf[i] = (*this)[skip + i];
+  }
+
+  free(buf);
+  buf = newBuf;
+  cap = capacity;
+  head = 0;
+  count = keep;
+  frontDelay = keep ? delay : 0;
+  return true;
+}
+
+void MIDIEventQueue::release() {
+  free(buf);
+  buf = nullptr;
+  cap = 0;
+  clear();
+}
+
+void MIDIEventQueue::push(const MIDIEvent& ev, uint32_t delayUs) {
+  if (cap == 0) return;
+  if (count == cap) pop();
+  if (count == 0) frontDelay = delayUs;
+  buf[(head + count) % cap] = ev;
+  count++;
+  // Low 32 bits track ev.timestamp; the rest counts its wraps.
+  backMicros += (uint32_t)(ev.timestamp - (uint32_t)backMicros);
+}
+
+void MIDIEventQueue::pop() {
+  if (count == 0) return;
+  if (count > 1) frontDelay = delayAt(1);
+  head = (head + 1) % cap;
+  count--;
+}
+
+uint32_t MIDIEventQueue::millisAt(size_t i) const {
+  uint64_t t = backMicros;
+  for (size_t k = count - 1; k > i; k--) t -= delayAt(k);
+  return (uint32_t)(t / 1000);
+}
@@ -0,0 +1,213 @@
+#ifndef MIDI_EVENT_H
+#define MIDI_EVENT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+// Channel message types, numbered as the upper nibble of the MIDI status byte.
+enum MIDIStatus : uint8_t {
+  MIDI_EVENT_NONE             = 0x00,
+  MIDI_EVENT_NOTE_OFF         = 0x80,
+  MIDI_EVENT_NOTE_ON          = 0x90,
+  MIDI_EVENT_CONTROL_CHANGE   = 0xB0,
+  MIDI_EVENT_PROGRAM_CHANGE   = 0xC0,
+  MIDI_EVENT_CHANNEL_PRESSURE = 0xD0,
+  MIDI_EVENT_PITCH_BEND       = 0xE0,
+  MIDI_EVENT_SYSEX            = 0xF0,  // Callbacks only; SysEx is never stored in the queue
+};
+
+// Legacy status strings ("NoteOn", "ControlChange", ...). Never returns nullptr.
+inline const char* midiStatusName(uint8_t status) {
+  switch (status) {
+    case MIDI_EVENT_NOTE_OFF:         return "NoteOff";
+    case MIDI_EVENT_NOTE_ON:          return "NoteOn";
+    case MIDI_EVENT_CONTROL_CHANGE:   return "ControlChange";
+    case MIDI_EVENT_PROGRAM_CHANGE:   return "ProgramChange";
+    case MIDI_EVENT_CHANNEL_PRESSURE: return "ChannelPressure";
+    case MIDI_EVENT_PITCH_BEND:       return "PitchBend";
+    case MIDI_EVENT_SYSEX:            return "SysEx";
+    default:                          return "";
+  }
+}
+
+// Note name without octave ("C", "D#"). note is masked to 0-127.
+inline const char* midiNoteName(uint8_t note) {
+  static const char* const names[12] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
+  return names[(note & 0x7F) % 12];
+}
+
+// Note name with octave ("C4", "D#5", "C-1"), MIDI 60 = C4.
+// Formatted from a flash table — no allocation, the pointer stays valid forever.
+inline const char* midiNoteOctaveName(uint8_t note) {
+  static const char table[128][5] = {
+    "C-1", "C#-1", "D-1", "D#-1", "E-1", "F-1", "F#-1", "G-1", "G#-1", "A-1", "A#-1", "B-1",
+    "C0", "C#0", "D0", "D#0", "E0", "F0", "F#0", "G0", "G#0", "A0", "A#0", "B0",
+    "C1", "C#1", "D1", "D#1", "E1", "F1", "F#1", "G1", "G#1", "A1", "A#1", "B1",
+    "C2", "C#2", "D2", "D#2", "E2", "F2", "F#2", "G2", "G#2", "A2", "A#2", "B2",
+    "C3", "C#3", "D3", "D#3", "E3", "F3", "F#3", "G3", "G#3", "A3", "A#3", "B3",
+    "C4", "C#4", "D4", "D#4", "E4", "F4", "F#4", "G4", "G#4", "A4", "A#4", "B4",
+    "C5", "C#5", "D5", "D#5", "E5", "F5", "F#5", "G5", "G#5", "A5", "A#5", "B5",
+    "C6", "C#6", "D6", "D#6", "E6", "F6", "F#6", "G6", "G#6", "A6", "A#6", "B6",
+    "C7", "C#7", "D7", "D#7", "E7", "F7", "F#7", "G7", "G#7", "A7", "A#7", "B7",
+    "C8", "C#8", "D8", "D#8", "E8", "F8", "F#8", "G8", "G#8", "A8", "A#8", "B8",
+    "C9", "C#9", "D9", "D#9", "E9", "F9", "F#9", "G9",
+  };
+  return table[note & 0x7F];
+}
+
+// Compact stored form of a parsed MIDI event — 16 bytes, trivially copyable.
+// Names are not stored; call statusName()/noteName()/noteOctave() to format them.
+// The delta time to the previous event is derived from timestamps by
+// MIDIEventQueue::delayAt(), so it is not stored either.
+struct MIDIEvent {
+  uint32_t timestamp;   // Receive time in microseconds (micros()), wraps after ~71 min
+  int32_t index;        // Global event counter
+  uint16_t msgIndex;    // Index linking NoteOn/NoteOff pairs (0 for other messages)
+  uint16_t chordIndex;  // Chord grouping index (simultaneous notes share the same index)
+  MIDIStatus status;    // Message type
+  uint8_t channel;      // MIDI channel (1-16)
+  uint8_t note;         // Note / controller / program number; Pitch Bend LSB
+  uint8_t velocity;     // Velocity / CC value / pressure; Pitch Bend MSB
+
+  bool is(MIDIStatus s) const { return status == s; }
+  const char* statusName() const { return midiStatusName(status); }
+
+  // Empty for non-note messages, like the old string fields.
+  bool isNote() const { return status == MIDI_EVENT_NOTE_ON || status == MIDI_EVENT_NOTE_OFF; }
+  const char* noteName() const { return isNote() ? midiNoteName(note) : ""; }
+  const char* noteOctave() const { return isNote() ? midiNoteOctaveName(note) : ""; }
+
+  // Pitch Bend value (14-bit, 0-16383, center = 8192). 0 for other types.
+  int pitchBend() const {
+    return status == MIDI_EVENT_PITCH_BEND ? (note & 0x7F) | ((velocity & 0x7F) << 7) : 0;
+  }
+};
+
+static_assert(sizeof(MIDIEvent) == 16, "MIDIEvent must stay 16 bytes");
+
+// Legacy string-based view of an event, built on demand from a MIDIEvent.
+// Kept for sketches written against the old queue; prefer MIDIEvent.
+struct MIDIEventData {
+  int index;                // Global event counter
+  int msgIndex;             // Index linking NoteOn/NoteOff pairs
+  unsigned long timestamp;  // Timestamp in milliseconds, wraps after ~49.7 days
+  unsigned long delay;      // Delta time (ms) since previous event
+  int channel;              // MIDI channel (1-16)
+  std::string status;       // Status type: "NoteOn", "NoteOff", "ControlChange", "ProgramChange", "PitchBend", "ChannelPressure"
+  int note;                 // MIDI note number (or controller number for ControlChange)
+  std::string noteName;     // Musical note name (e.g., "C", "D#") — empty for non-note messages
+  std::string noteOctave;   // Note with octave (e.g., "C4", "D#5") — empty for non-note messages
+  int velocity;             // Velocity (or CC value, program number, or pressure value)
+  int chordIndex;           // Chord grouping index (simultaneous notes share the same index)
+  int pitchBend;            // Pitch Bend value (14-bit, 0-16383, center = 8192). 0 for other types.
+};
+
+// Expands a compact event into the legacy view. delayUs is the delta to the
+// previous event and timestampMs its millisecond time, as returned by
+// MIDIEventQueue::delayAt() and MIDIEventQueue::millisAt().
+inline MIDIEventData toEventData(const MIDIEvent& ev, uint32_t delayUs, uint32_t timestampMs) {
+  MIDIEventData d;
+  bool bend = ev.status == MIDI_EVENT_PITCH_BEND;
+  d.index = (int)ev.index;
+  d.msgIndex = ev.msgIndex;
+  d.timestamp = timestampMs;
+  d.delay = delayUs / 1000;
+  d.channel = ev.channel;
+  d.status = ev.statusName();
+  d.note = bend ? 0 : ev.note;
+  d.noteName = ev.noteName();
+  d.noteOctave = ev.noteOctave();
+  d.velocity = bend ? 0 : ev.velocity;
+  d.chordIndex = ev.chordIndex;
+  d.pitchBend = ev.pitchBend();
+  return d;
+}
+
+// Fixed-capacity ring of MIDIEvents. Storage is allocated once by
+// setCapacity(); push() never allocates. When full, push() drops the oldest
+// event unless the owner grows the ring first.
+class MIDIEventQueue {
+public:
+  class const_iterator {
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef MIDIEvent value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const MIDIEvent* pointer;
+    typedef const MIDIEvent& reference;
+
+    const_iterator() : q(nullptr), pos(0) {}
+    const_iterator(const MIDIEventQueue* q, size_t pos) : q(q), pos(pos) {}
+
+    reference operator*() const { return (*q)[pos]; }
+    pointer operator->() const { return &(*q)[pos]; }
+    const_iterator& operator++() { ++pos; return *this; }
+    const_iterator operator++(int) { const_iterator t = *this; ++pos; return t; }
+    const_iterator& operator--() { --pos; return *this; }
+    const_iterator operator--(int) { const_iterator t = *this; --pos; return t; }
+    bool operator==(const const_iterator& o) const { return pos == o.pos && q == o.q; }
+    bool operator!=(const const_iterator& o) const { return !(*this == o); }
+
+    // Position from the oldest event, usable with MIDIEventQueue::delayAt().
+    size_t position() const { return pos; }
+
+  private:
+    const MIDIEventQueue* q;
+    size_t pos;
+  };
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  MIDIEventQueue() : buf(nullptr), cap(0), head(0), count(0), frontDelay(0), backMicros(0) {}
+  ~MIDIEventQueue();
+  MIDIEventQueue(const MIDIEventQueue&) = delete;
+  MIDIEventQueue& operator=(const MIDIEventQueue&) = delete;
+
+  // (Re)allocates storage, keeping the newest events that fit.
+  // preferPsram places the buffer in PSRAM when the board has it.
+  // Returns false (and leaves the queue untouched) if allocation fails.
+  bool setCapacity(size_t capacity, bool preferPsram = false);
+  void release();
+
+  // Appends an event; delayUs is its delta to the previous event.
+  void push(const MIDIEvent& ev, uint32_t delayUs);
+  void pop();
+  void clear() { head = 0; count = 0; frontDelay = 0; }
+
+  size_t size() const { return count; }
+  size_t capacity() const { return cap; }
+  bool empty() const { return count == 0; }
+  bool full() const { return count == cap; }
+
+  // i = 0 is the oldest event.
+  const MIDIEvent& operator[](size_t i) const { return buf[(head + i) % cap]; }
+  const MIDIEvent& front() const { return (*this)[0]; }
+  const MIDIEvent& back() const { return (*this)[count - 1]; }
+
+  // Delta time (µs) between event i and the event received before it.
+  uint32_t delayAt(size_t i) const {
+    return i == 0 ? frontDelay : (*this)[i].timestamp - (*this)[i - 1].timestamp;
+  }
+
+  // Receive time of event i in milliseconds, from a clock that keeps
+  // counting when the 32-bit µs timestamps wrap (~71 min), so it only wraps
+  // after ~49.7 days like millis(). O(size() - i).
+  uint32_t millisAt(size_t i) const;
+
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, count); }
+  const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+  const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+
+private:
+  MIDIEvent* buf;
+  size_t cap;
+  size_t head;
+  size_t count;
+  uint32_t frontDelay;
+  uint64_t backMicros;  // 64-bit µs time of the newest event pushed, even once popped
+};
+
+#endif  // MIDI_EVENT_H
@@ -0,0 +1,444 @@
+#include <Arduino.h>
+#include "MIDIFile.h"
+
+// Variable-length quantity, at most 4 bytes (28 bits). Returns the bytes written.
+static size_t writeVarLen(uint8_t* out, uint32_t value) {
+  uint8_t tmp[4];
+  size_t n = 0;
+  do {
+    tmp[n++] = value & 0x7F;
+    value >>= 7;
+  } while (value && n < 4);
+  for (size_t i = 0; i < n; i++) {
+    out[i] = tmp[n - 1 - i] | (i + 1 < n ? 0x80 : 0);
+  }
+  return n;
+}
+
+static void putBE32(uint8_t* out, uint32_t v) {
+  out[0] = v >> 24; out[1] = v >> 16; out[2] = v >> 8; out[3] = v;
+}
+
+static uint32_t getBE32(const uint8_t* p) {
+  return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// ---------- Writer ----------
+
+bool MIDIFileWriter::begin(fs::FS& fs, const char* path, uint8_t fmt, uint16_t ticks, uint32_t tempo) {
+  end();
+  if (fmt > 1 || ticks == 0 || ticks > 0x7FFF || tempo == 0 || tempo > 0xFFFFFF) return false;
+
+  file = fs.open(path, FILE_WRITE);
+  if (!file) {
+    Serial.println("Failed to create MIDI file!");
+    return false;
+  }
+  format = fmt;
+  ppq = ticks;
+  usPerQuarter = tempo;
+
+  uint8_t hdr[14] = { 'M', 'T', 'h', 'd', 0, 0, 0, 6, 0, format, 0, (uint8_t)(format == 1 ? 2 : 1),
+                      (uint8_t)(ppq >> 8), (uint8_t)ppq };
+  // Tempo and 4/4 time signature at tick 0
+  const uint8_t tempoMap[15] = { 0x00, 0xFF, 0x51, 0x03, (uint8_t)(tempo >> 16), (uint8_t)(tempo >> 8), (uint8_t)tempo,
+                                 0x00, 0xFF, 0x58, 0x04, 0x04, 0x02, 0x18, 0x08 };
+  static const uint8_t endOfTrack[4] = { 0x00, 0xFF, 0x2F, 0x00 };
+  uint8_t chunk[8] = { 'M', 'T', 'r', 'k', 0, 0, 0, 0 };
+
+  bool ok = file.write(hdr, sizeof(hdr)) == sizeof(hdr);
+  if (format == 1) {
+    putBE32(chunk + 4, sizeof(tempoMap) + sizeof(endOfTrack));
+    ok = ok && file.write(chunk, 8) == 8;
+    ok = ok && file.write(tempoMap, sizeof(tempoMap)) == sizeof(tempoMap);
+    ok = ok && file.write(endOfTrack, sizeof(endOfTrack)) == sizeof(endOfTrack);
+    putBE32(chunk + 4, 0);
+  }
+  trackStart = file.position() + 4;
+  ok = ok && file.write(chunk, 8) == 8;  // Length patched by end()
+  trackBytes = 0;
+  if (format == 0) {
+    ok = ok && file.write(tempoMap, sizeof(tempoMap)) == sizeof(tempoMap);
+    trackBytes = sizeof(tempoMap);
+  }
+  if (!ok) {
+    Serial.println("Failed to write MIDI file header!");
+    file.close();
+    return false;
+  }
+
+  head.store(0, std::memory_order_relaxed);
+  tail.store(0, std::memory_order_relaxed);
+  startTime = lastTime = micros();
+  elapsed = 0;
+  lastTick = 0;
+  runningStatus = 0;
+  events = 0;
+  drops = 0;
+  recording = true;
+  return true;
+}
+
+// Ticks from begin() to 'timestamp'. Events stamped before the previous one
+// (another source, or before begin()) are placed at the previous one's time.
+uint32_t MIDIFileWriter::deltaTicks(uint32_t timestamp) {
+  int32_t d = (int32_t)(timestamp - lastTime);
+  if (d > 0) {
+    elapsed += (uint32_t)d;
+    lastTime = timestamp;
+  }
+  uint64_t tick = (elapsed * ppq + usPerQuarter / 2) / usPerQuarter;
+  return (uint32_t)(tick - lastTick);
+}
+
+// Appends one whole event to the ring, or nothing if it doesn't fit.
+bool MIDIFileWriter::put(const uint8_t* bytes, size_t length) {
+  uint32_t h = head.load(std::memory_order_relaxed);
+  if (length > BUFFER_SIZE - (h - tail.load(std::memory_order_acquire))) {
+    drops++;
+    return false;
+  }
+  for (size_t i = 0; i < length; i++) ring[(h + i) % BUFFER_SIZE] = bytes[i];
+  head.store(h + length, std::memory_order_release);
+  return true;
+}
+
+bool MIDIFileWriter::record(const uint8_t* msg, size_t length, uint32_t timestamp) {
+  if (!recording || !msg || length == 0) return false;
+  uint8_t status = msg[0];
+  if (status < 0x80 || status >= 0xF0) return false;
+  size_t need = ((status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0) ? 2 : 3;
+  if (length < need) return false;
+
+  uint32_t delta = deltaTicks(timestamp);
+  uint8_t ev[7];
+  size_t n = writeVarLen(ev, delta);
+  if (status != runningStatus) ev[n++] = status;
+  for (size_t i = 1; i < need; i++) ev[n++] = msg[i] & 0x7F;
+  if (!put(ev, n)) return false;
+  lastTick += delta;
+  runningStatus = status;
+  events++;
+  return true;
+}
+
+bool MIDIFileWriter::record(const MIDIEvent& event) {
+  if (event.status < 0x80 || event.status >= 0xF0) return false;
+  uint8_t msg[3] = { (uint8_t)(event.status | ((event.channel - 1) & 0x0F)), event.note, event.velocity };
+  // MIDIHandler keeps a Program Change in note and a Channel Pressure in velocity
+  if (event.status == MIDI_EVENT_CHANNEL_PRESSURE) msg[1] = event.velocity;
+  bool twoBytes = event.status == MIDI_EVENT_PROGRAM_CHANGE || event.status == MIDI_EVENT_CHANNEL_PRESSURE;
+  return record(msg, twoBytes ? 2 : 3, event.timestamp);
+}
+
+bool MIDIFileWriter::recordSysEx(const uint8_t* data, size_t length, uint32_t timestamp) {
+  if (!recording || !data || length < 2 || data[0] != 0xF0) return false;
+
+  // delta, F0, length of the rest, the rest (F7 included)
+  uint32_t delta = deltaTicks(timestamp);
+  uint8_t hdr[9];
+  size_t n = writeVarLen(hdr, delta);
+  hdr[n++] = 0xF0;
+  n += writeVarLen(hdr + n, length - 1);
+
+  uint32_t h = head.load(std::memory_order_relaxed);
+  if (n + length - 1 > BUFFER_SIZE - (h - tail.load(std::memory_order_acquire))) {
+    drops++;
+    return false;
+  }
+  for (size_t i = 0; i < n; i++) ring[(h++) % BUFFER_SIZE] = hdr[i];
+  for (size_t i = 1; i < length; i++) ring[(h++) % BUFFER_SIZE] = data[i];
+  head.store(h, std::memory_order_release);
+  lastTick += delta;
+  runningStatus = 0;  // SysEx cancels running status
+  events++;
+  return true;
+}
+
+void MIDIFileWriter::onEvent(const MIDIEvent& event, MIDITransport* source, void* ctx) {
+  static_cast<MIDIFileWriter*>(ctx)->record(event);
+}
+
+// Writes ring contents while at least minBytes are pending, a block (or the
+// part before the wrap point) at a time.
+void MIDIFileWriter::writeOut(size_t minBytes) {
+  while (true) {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    size_t avail = head.load(std::memory_order_acquire) - t;
+    if (avail == 0 || avail < minBytes) return;
+    size_t offset = t % BUFFER_SIZE;
+    size_t n = avail < BLOCK_SIZE ? avail : BLOCK_SIZE;
+    if (n > BUFFER_SIZE - offset) n = BUFFER_SIZE - offset;
+    if (file.write(ring + offset, n) != n) {
+      Serial.println("MIDI file write failed!");  // Card full or removed; the data is lost
+    }
+    trackBytes += n;
+    tail.store(t + n, std::memory_order_release);
+  }
+}
+
+void MIDIFileWriter::task() {
+  if (recording) writeOut(BLOCK_SIZE);
+}
+
+bool MIDIFileWriter::end() {
+  if (!file) return false;
+  recording = false;
+  writeOut(1);
+
+  static const uint8_t endOfTrack[4] = { 0x00, 0xFF, 0x2F, 0x00 };
+  bool ok = file.write(endOfTrack, sizeof(endOfTrack)) == sizeof(endOfTrack);
+  trackBytes += sizeof(endOfTrack);
+
+  uint8_t len[4];
+  putBE32(len, trackBytes);
+  ok = ok && file.seek(trackStart) && file.write(len, sizeof(len)) == sizeof(len);
+  file.close();
+  if (!ok) Serial.println("Failed to finish MIDI file!");
+  return ok;
+}
+
+// ---------- Reader ----------
+
+bool MIDIFileReader::open(fs::FS& fs, const char* path) {
+  close();
+  file = fs.open(path, FILE_READ);
+  if (!file) {
+    Serial.println("Failed to open MIDI file!");
+    return false;
+  }
+
+  uint8_t hdr[14];
+  if (file.read(hdr, sizeof(hdr)) != sizeof(hdr) || memcmp(hdr, "MThd", 4) != 0 || getBE32(hdr + 4) < 6) {
+    Serial.println("Not a MIDI file!");
+    close();
+    return false;
+  }
+  format = hdr[9];
+  uint16_t declared = (hdr[10] << 8) | hdr[11];
+  division = (hdr[12] << 8) | hdr[13];
+  if (format > 1 || division == 0 || (division & 0x8000 && (division & 0xFF) == 0)) {
+    Serial.println("Unsupported MIDI file format!");
+    close();
+    return false;
+  }
+  if (declared > MAX_TRACKS) {
+    Serial.printf("MIDI file has %d tracks, only the first %d are played!\n", declared, MAX_TRACKS);
+  }
+
+  // Index the track chunks; unknown chunks are skipped
+  uint32_t size = file.size();
+  uint32_t pos = 8 + getBE32(hdr + 4);
+  while (trackCount < MAX_TRACKS && pos + 8 <= size) {
+    uint8_t chunk[8];
+    if (!file.seek(pos) || file.read(chunk, 8) != 8) break;
+    uint32_t len = getBE32(chunk + 4);
+    if (memcmp(chunk, "MTrk", 4) == 0) {
+      Track& t = tracks[trackCount++];
+      t.start = pos + 8;
+      t.end = (len > size - t.start) ? size : t.start + len;  // Tolerate a truncated last track
+    }
+    if (len > size - pos - 8) break;
+    pos += 8 + len;
+  }
+  if (trackCount == 0) {
+    Serial.println("MIDI file has no tracks!");
+    close();
+    return false;
+  }
+  return rewind();
+}
+
+void MIDIFileReader::close() {
+  if (file) file.close();
+  trackCount = 0;
+}
+
+bool MIDIFileReader::rewind() {
+  if (!file) return false;
+  usPerQuarter = 500000;  // 120 BPM until the file says otherwise
+  tempoTick = 0;
+  tempoTime = 0;
+  skipped = 0;
+  for (uint8_t i = 0; i < trackCount; i++) {
+    Track& t = tracks[i];
+    t.pos = t.start;
+    t.tick = 0;
+    t.runningStatus = 0;
+    t.done = false;
+    t.bufPos = t.bufLen = 0;
+    readDelta(t);
+  }
+  return true;
+}
+
+bool MIDIFileReader::readByte(Track& t, uint8_t& b) {
+  if (t.bufPos == t.bufLen) {
+    if (t.pos >= t.end) return false;
+    size_t n = t.end - t.pos;
+    if (n > TRACK_BUFFER) n = TRACK_BUFFER;
+    if (!file.seek(t.pos)) return false;
+    n = file.read(t.buf, n);
+    if (n == 0) return false;
+    t.pos += n;
+    t.bufLen = n;
+    t.bufPos = 0;
+  }
+  b = t.buf[t.bufPos++];
+  return true;
+}
+
+bool MIDIFileReader::readVarLen(Track& t, uint32_t& value) {
+  value = 0;
+  for (int i = 0; i < 4; i++) {
+    uint8_t b;
+    if (!readByte(t, b)) return false;
+    value = (value << 7) | (b & 0x7F);
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+void MIDIFileReader::skipBytes(Track& t, uint32_t n) {
+  uint32_t inBuf = t.bufLen - t.bufPos;
+  if (n <= inBuf) {
+    t.bufPos += n;
+    return;
+  }
+  n -= inBuf;
+  t.bufPos = t.bufLen = 0;
+  t.pos = (n > t.end - t.pos) ? t.end : t.pos + n;
+}
+
+void MIDIFileReader::readDelta(Track& t) {
+  uint32_t delta;
+  if (readVarLen(t, delta)) t.tick += delta;
+  else t.done = true;
+}
+
+uint64_t MIDIFileReader::tickToTime(uint32_t tick) const {
+  if (division & 0x8000) {
+    // SMPTE: frames per second (29 = 29.97 drop frame) x ticks per frame
+    uint32_t fps = (uint8_t)(-(int8_t)(division >> 8));
+    uint32_t tpf = division & 0xFF;
+    if (fps == 29) return (uint64_t)tick * 100000000 / (2997 * tpf);
+    return (uint64_t)tick * 1000000 / (fps * tpf);
+  }
+  return tempoTime + (uint64_t)(tick - tempoTick) * usPerQuarter / division;
+}
+
+bool MIDIFileReader::next(MIDIFileEvent& ev) {
+  while (true) {
+    // Track with the earliest pending event; ties go to the lower track, so
+    // tempo changes in the tempo track apply before notes at the same tick.
+    int best = -1;
+    for (uint8_t i = 0; i < trackCount; i++) {
+      if (tracks[i].done) continue;
+      if (best < 0 || (int32_t)(tracks[i].tick - tracks[best].tick) < 0) best = i;
+    }
+    if (best < 0) return false;
+    Track& t = tracks[best];
+
+    uint8_t b;
+    if (!readByte(t, b)) {
+      t.done = true;
+      continue;
+    }
+
+    uint8_t status = b;
+    if (b < 0x80) {
+      status = t.runningStatus;
+      if (!status) {
+        skipped++;
+        t.done = true;  // Lost sync; the rest of the track can't be trusted
+        continue;
+      }
+    }
+
+    ev.tick = t.tick;
+    ev.track = best;
+
+    if (status < 0xF0) {
+      // Channel message
+      t.runningStatus = status;
+      size_t need = ((status & 0xF0) == 0xC0 || (status & 0xF0) == 0xD0) ? 2 : 3;
+      msg[0] = status;
+      size_t n = 1;
+      if (b < 0x80) msg[n++] = b;
+      while (n < need && readByte(t, msg[n])) n++;
+      if (n < need) {
+        t.done = true;
+        continue;
+      }
+      ev.time = (uint32_t)tickToTime(t.tick);
+      ev.sysex = false;
+      ev.data = msg;
+      ev.length = need;
+      readDelta(t);
+      return true;
+    }
+
+    t.runningStatus = 0;  // SysEx and meta events cancel running status
+
+    if (status == 0xF0 || status == 0xF7) {
+      // F0 <len> <bytes after F0>, or F7 <len> <raw bytes> (escape / continuation)
+      uint32_t len;
+      if (!readVarLen(t, len)) {
+        t.done = true;
+        continue;
+      }
+      size_t prefix = (status == 0xF0) ? 1 : 0;
+      if (len == 0 || len + prefix > MAX_SYSEX) {
+        skipBytes(t, len);
+        if (len) skipped++;
+        readDelta(t);
+        continue;
+      }
+      sysex[0] = 0xF0;
+      size_t n = 0;
+      while (n < len && readByte(t, sysex[prefix + n])) n++;
+      if (n < len) {
+        t.done = true;
+        continue;
+      }
+      ev.time = (uint32_t)tickToTime(t.tick);
+      ev.sysex = (status == 0xF0);
+      ev.data = sysex;
+      ev.length = prefix + len;
+      readDelta(t);
+      return true;
+    }
+
+    if (status == 0xFF) {
+      uint8_t type;
+      uint32_t len;
+      if (!readByte(t, type) || !readVarLen(t, len)) {
+        t.done = true;
+        continue;
+      }
+      if (type == 0x2F) {  // End of Track
+        t.done = true;
+        continue;
+      }
+      if (type == 0x51 && len == 3) {  // Set Tempo
+        uint8_t v[3];
+        if (!readByte(t, v[0]) || !readByte(t, v[1]) || !readByte(t, v[2])) {
+          t.done = true;
+          continue;
+        }
+        tempoTime = tickToTime(t.tick);
+        tempoTick = t.tick;
+        usPerQuarter = ((uint32_t)v[0] << 16) | (v[1] << 8) | v[2];
+        if (usPerQuarter == 0) usPerQuarter = 1;
+      } else {
+        skipBytes(t, len);
+      }
+      readDelta(t);
+      continue;
+    }
+
+    // F1-F6 / F8-FE are not valid SMF events
+    skipped++;
+    t.done = true;
+  }
+}
@@ -0,0 +1,168 @@
+#ifndef MIDI_FILE_H
+#define MIDI_FILE_H
+
+#include <FS.h>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "MIDIEvent.h"
+#include "MIDITransport.h"
+
+// Standard MIDI File (SMF) recording and incremental reading on any Arduino
+// filesystem (SD, SD_MMC, LittleFS...). Neither class loads the file into
+// RAM or allocates while running: the writer streams through a fixed buffer,
+// the reader keeps a small read window per track.
+
+// Records MIDI to a Type-0 or Type-1 SMF while it is played.
+//
+//   MIDIFileWriter rec;
+//   rec.begin(SD, "/take1.mid");
+//   midiHandler.onEvent(MIDIFileWriter::onEvent, &rec);
+//   ...in loop(): rec.task();
+//   ...when done: rec.end();
+//
+// record() only copies the encoded event into a ring of BUFFER_SIZE bytes;
+// task() writes it out in whole BLOCK_SIZE blocks (one SD sector), so the
+// MIDI path never waits on the card. record() and task() may run on different
+// tasks (one producer, one consumer). Events that don't fit while the card
+// is busy are dropped and counted.
+class MIDIFileWriter {
+public:
+  static const size_t BLOCK_SIZE = 512;
+  static const size_t BUFFER_SIZE = 4 * BLOCK_SIZE;
+
+  MIDIFileWriter() : recording(false), format(0), ppq(480), usPerQuarter(500000), trackStart(0),
+                     trackBytes(0), startTime(0), lastTime(0), elapsed(0), lastTick(0),
+                     runningStatus(0), events(0), drops(0) {}
+  ~MIDIFileWriter() { end(); }
+  MIDIFileWriter(const MIDIFileWriter&) = delete;
+  MIDIFileWriter& operator=(const MIDIFileWriter&) = delete;
+
+  // Creates path (replacing it) and writes the header. format: 0 = one track,
+  // 1 = a tempo track plus one track with the recorded events. Delta times
+  // are in ticks of 1/ppq quarter note at usPerQuarter (500000 = 120 BPM);
+  // time zero is the call to begin().
+  bool begin(fs::FS& fs, const char* path, uint8_t format = 0, uint16_t ppq = 480,
+             uint32_t usPerQuarter = 500000);
+
+  // A channel message (status 0x80-0xEF, running status not allowed) received
+  // at 'timestamp' (micros()). Other system messages have no place in an SMF
+  // and are ignored. Returns false if it was dropped.
+  bool record(const uint8_t* msg, size_t length, uint32_t timestamp);
+  bool record(const MIDIEvent& event);
+  // A whole SysEx message, F0 ... F7.
+  bool recordSysEx(const uint8_t* data, size_t length, uint32_t timestamp);
+
+  // MIDIHandler::onEvent() adapter; ctx is the writer.
+  static void onEvent(const MIDIEvent& event, MIDITransport* source, void* ctx);
+
+  // Writes every full block. Call from loop() or a low-priority task.
+  void task();
+  // Writes the rest, closes the track and the file. Stop record() calls first.
+  bool end();
+
+  bool isRecording() const { return recording; }
+  uint32_t getEventCount() const { return events; }
+  uint32_t getDropCount() const { return drops; }
+
+private:
+  fs::File file;
+  bool recording;
+  uint8_t format;
+  uint16_t ppq;
+  uint32_t usPerQuarter;
+  uint32_t trackStart;  // File offset of the event track's length field
+  uint32_t trackBytes;  // Bytes written to the event track
+
+  // Producer side
+  uint32_t startTime;
+  uint32_t lastTime;
+  uint64_t elapsed;     // µs since begin(); 64 bits so takes can outlast the micros() wrap
+  uint64_t lastTick;
+  uint8_t runningStatus;
+  uint32_t events;
+  uint32_t drops;
+
+  uint8_t ring[BUFFER_SIZE];
+  std::atomic<uint32_t> head{0};  // Written by record()
+  std::atomic<uint32_t> tail{0};  // Written by task()
+
+  uint32_t deltaTicks(uint32_t timestamp);
+  bool put(const uint8_t* bytes, size_t length);
+  void writeOut(size_t minBytes);
+};
+
+// One message read from an SMF. data points into the reader and stays valid
+// until the next call to next().
+struct MIDIFileEvent {
+  uint32_t time;        // µs from the start of the file, tempo map applied
+  uint32_t tick;        // Absolute tick
+  uint8_t track;
+  bool sysex;           // data is a whole SysEx message, F0 ... F7
+  const uint8_t* data;  // Channel or system message, or SysEx
+  size_t length;
+};
+
+// Reads a Type-0 or Type-1 SMF one event at a time, merging the tracks in
+// time order. Only the chunk headers are read up front; each track is then
+// read through a TRACK_BUFFER-byte window, so file size doesn't matter.
+// Tempo changes are applied as they are read; other meta events are skipped.
+class MIDIFileReader {
+public:
+  static const uint8_t MAX_TRACKS = 16;
+  static const size_t TRACK_BUFFER = 64;
+  static const size_t MAX_SYSEX = 256;
+
+  MIDIFileReader() : trackCount(0), format(0), division(0), usPerQuarter(500000),
+                     tempoTick(0), tempoTime(0), skipped(0) {}
+  MIDIFileReader(const MIDIFileReader&) = delete;
+  MIDIFileReader& operator=(const MIDIFileReader&) = delete;
+
+  bool open(fs::FS& fs, const char* path);
+  void close();
+  // Back to the first event.
+  bool rewind();
+
+  // Fills ev with the next event in time order. Returns false at the end.
+  bool next(MIDIFileEvent& ev);
+
+  bool isOpen() const { return trackCount > 0; }
+  uint8_t getFormat() const { return format; }
+  uint8_t getTrackCount() const { return trackCount; }
+  uint16_t getDivision() const { return division; }
+  // SysEx over MAX_SYSEX and malformed events that were skipped.
+  uint32_t getSkippedCount() const { return skipped; }
+
+private:
+  struct Track {
+    uint32_t start;     // File offset of the first event
+    uint32_t end;       // File offset past the last byte
+    uint32_t pos;       // File offset of the byte after the window
+    uint32_t tick;      // Absolute tick of the pending event
+    uint8_t runningStatus;
+    bool done;
+    uint8_t bufPos;
+    uint8_t bufLen;
+    uint8_t buf[TRACK_BUFFER];
+  };
+
+  fs::File file;
+  Track tracks[MAX_TRACKS];
+  uint8_t trackCount;
+  uint8_t format;
+  uint16_t division;       // Ticks per quarter, or SMPTE (bit 15 set)
+  uint32_t usPerQuarter;
+  uint32_t tempoTick;      // Tick and time of the last tempo change
+  uint64_t tempoTime;
+  uint32_t skipped;
+  uint8_t msg[3];
+  uint8_t sysex[MAX_SYSEX];
+
+  bool readByte(Track& t, uint8_t& b);
+  bool readVarLen(Track& t, uint32_t& value);
+  void skipBytes(Track& t, uint32_t n);
+  void readDelta(Track& t);
+  uint64_t tickToTime(uint32_t tick) const;
+};
+
+#endif  // MIDI_FILE_H
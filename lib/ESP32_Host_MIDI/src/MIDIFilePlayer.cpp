@@ -0,0 +1,244 @@
+#include <Arduino.h>
+#include "MIDIFilePlayer.h"
+
+MIDIFilePlayer::MIDIFilePlayer()
+  : timer(nullptr),
+    playerTask(nullptr),
+    transport(nullptr),
+    outputCb(nullptr),
+    outputCtx(nullptr),
+    hasPending(false),
+    playing(false),
+    busy(false),
+    endOfFile(false),
+    finished(false),
+    startTime(0),
+    pausedAt(0),
+    sysexLen(0),
+    channelsUsed(0),
+    dry(false),
+    maxLateness(0),
+    underruns(0)
+{
+}
+
+MIDIFilePlayer::~MIDIFilePlayer() {
+  close();
+  if (timer) esp_timer_delete(timer);
+  if (playerTask) vTaskDelete(playerTask);
+}
+
+bool MIDIFilePlayer::open(fs::FS& fs, const char* path) {
+  close();
+  if (!playerTask &&
+      xTaskCreatePinnedToCore(_playerTask, "midi_player", 4096, this, TASK_PRIORITY,
+                              &playerTask, tskNO_AFFINITY) != pdPASS) {
+    playerTask = nullptr;
+    Serial.println("Failed to create MIDI player task!");
+    return false;
+  }
+  if (!timer) {
+    esp_timer_create_args_t args = {};
+    args.callback = _onTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "midi_player";
+    if (esp_timer_create(&args, &timer) != ESP_OK) {
+      timer = nullptr;
+      Serial.println("Failed to create MIDI player timer!");
+      return false;
+    }
+  }
+  if (!reader.open(fs, path)) return false;
+  stop();  // Rewinds and fills the queue
+  return true;
+}
+
+void MIDIFilePlayer::close() {
+  halt();
+  reader.close();
+  queue.discard();
+  hasPending = false;
+}
+
+void MIDIFilePlayer::setOutput(MIDITransport* t) {
+  transport = t;
+  outputCb = nullptr;
+}
+
+void MIDIFilePlayer::setOutput(OutputCallback cb, void* ctx) {
+  outputCb = cb;
+  outputCtx = ctx;
+}
+
+bool MIDIFilePlayer::play() {
+  if (!reader.isOpen() || !timer) return false;
+  if (playing.load()) return true;
+  if (finished.load()) stop();
+
+  task();
+  startTime = micros() - pausedAt;
+  dry = false;
+  playing.store(true);
+  return esp_timer_start_once(timer, 1) == ESP_OK;
+}
+
+void MIDIFilePlayer::pause() {
+  if (!playing.load()) return;
+  pausedAt = micros() - startTime;
+  halt();
+}
+
+void MIDIFilePlayer::stop() {
+  halt();
+  // The timer is idle now, so the consumer side of the queue is ours
+  queue.discard();
+  hasPending = false;
+  sysexLen = 0;
+  pausedAt = 0;
+  endOfFile.store(false);
+  finished.store(false);
+  reader.rewind();
+  task();
+}
+
+uint32_t MIDIFilePlayer::getPosition() const {
+  return playing.load() ? micros() - startTime : pausedAt;
+}
+
+// Stops the timer and waits out a dispatch running on the player task, then
+// releases whatever the file left sounding.
+void MIDIFilePlayer::halt() {
+  bool wasPlaying = playing.exchange(false);
+  while (busy.load()) yield();
+  if (timer) esp_timer_stop(timer);
+  if (wasPlaying) allNotesOff();
+}
+
+void MIDIFilePlayer::task() {
+  if (!reader.isOpen() || endOfFile.load()) return;
+  while (true) {
+    if (!hasPending) {
+      if (!reader.next(pending)) {
+        endOfFile.store(true);
+        return;
+      }
+      hasPending = true;
+    }
+    size_t space = QUEUE_SIZE - queue.size();
+    if (pending.sysex) {
+      // Queued as 18-byte chunks and sent whole by the timer. A SysEx split
+      // across several file events can't be sent whole, so it is skipped.
+      if (pending.data[pending.length - 1] == 0xF7) {
+        size_t chunk = sizeof(MIDIPacket::data);
+        if (space < (pending.length + chunk - 1) / chunk) return;
+        for (size_t off = 0; off < pending.length; off += chunk) {
+          size_t n = pending.length - off < chunk ? pending.length - off : chunk;
+          queue.push(pending.data + off, n, pending.time, MIDI_PACKET_SYSEX);
+        }
+      }
+    } else if (pending.length <= sizeof(MIDIPacket::data)) {
+      if (space == 0) return;
+      queue.push(pending.data, pending.length, pending.time);
+    }
+    hasPending = false;
+  }
+}
+
+// Runs on the esp_timer task, which every esp_timer callback shares: only
+// wakes the player task, which may block in the output.
+void MIDIFilePlayer::_onTimer(void* arg) {
+  xTaskNotifyGive(static_cast<MIDIFilePlayer*>(arg)->playerTask);
+}
+
+void MIDIFilePlayer::_playerTask(void* arg) {
+  MIDIFilePlayer* player = static_cast<MIDIFilePlayer*>(arg);
+  for (;;) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    player->dispatchDue();
+  }
+}
+
+// Sends every event whose time has come, then re-arms the timer for the next.
+// Packet timestamps are µs from the start of the file.
+void MIDIFilePlayer::dispatchDue() {
+  busy.store(true);
+  if (!playing.load()) {
+    busy.store(false);
+    return;
+  }
+
+  uint32_t wait;
+  uint32_t now = micros() - startTime;
+  const MIDIPacket* p;
+  while (true) {
+    if (queue.peek(p) == 0) {
+      if (endOfFile.load()) {
+        playing.store(false);
+        finished.store(true);
+        busy.store(false);
+        return;
+      }
+      if (!dry) underruns++;
+      dry = true;
+      wait = 1000;  // Poll until task() catches up
+      break;
+    }
+    dry = false;
+    int32_t ahead = (int32_t)(p->timestamp - now);
+    if (ahead > 0) {
+      wait = ahead;
+      break;
+    }
+    if ((uint32_t)-ahead > maxLateness) maxLateness = -ahead;
+
+    if (p->flags & MIDI_PACKET_SYSEX) {
+      if (p->data[0] == 0xF0) sysexLen = 0;
+      if (sysexLen + p->length <= MAX_SYSEX) {
+        memcpy(sysex + sysexLen, p->data, p->length);
+        sysexLen += p->length;
+      }
+      if (p->data[p->length - 1] == 0xF7) {
+        send(sysex, sysexLen);
+        sysexLen = 0;
+      }
+    } else {
+      send(p->data, p->length);
+    }
+    queue.consume(1);
+    now = micros() - startTime;
+  }
+
+  esp_timer_start_once(timer, wait);
+  busy.store(false);
+}
+
+void MIDIFilePlayer::send(const uint8_t* data, size_t length) {
+  uint8_t status = data[0];
+  if (status >= 0x80 && status < 0xF0 && length >= 2) {
+    uint8_t ch = status & 0x0F;
+    uint8_t type = status & 0xF0;
+    channelsUsed |= 1u << ch;
+    if (type == 0x90 && length >= 3 && data[2] > 0) sounding[ch].set(data[1]);
+    else if (type == 0x80 || type == 0x90) sounding[ch].reset(data[1]);
+  }
+  if (outputCb) outputCb(outputCtx, data, length);
+  else if (transport) transport->sendMidiMessage(data, length);
+}
+
+// NoteOff for every note the file left on, and sustain off on the channels
+// it used, so pausing or stopping mid-song doesn't leave notes hanging.
+void MIDIFilePlayer::allNotesOff() {
+  for (uint8_t ch = 0; ch < 16; ch++) {
+    for (int note = sounding[ch].first(); note >= 0; note = sounding[ch].next(note)) {
+      uint8_t msg[3] = { (uint8_t)(0x80 | ch), (uint8_t)note, 0 };
+      send(msg, sizeof(msg));
+    }
+    sounding[ch].clear();
+    if (channelsUsed & (1u << ch)) {
+      uint8_t msg[3] = { (uint8_t)(0xB0 | ch), 64, 0 };
+      send(msg, sizeof(msg));
+    }
+  }
+  channelsUsed = 0;
+}
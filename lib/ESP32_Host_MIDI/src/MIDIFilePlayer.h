@@ -0,0 +1,112 @@
+#ifndef MIDI_FILE_PLAYER_H
+#define MIDI_FILE_PLAYER_H
+
+#include <atomic>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "MIDIFile.h"
+#include "MIDINoteSet.h"
+#include "MIDITransport.h"
+
+// Plays a Standard MIDI File to a transport or to a callback (e.g. a synth).
+//
+//   MIDIFilePlayer player;
+//   player.open(SD, "/song.mid");
+//   player.setOutput(&uartMidi);                     // DIN-5 out
+//   // or: player.setOutput([](void*, const uint8_t* d, size_t n) {
+//   //       if ((d[0] & 0xF0) == 0x90 && d[2]) synth.noteOn(d[1], d[2]);
+//   //       else if ((d[0] & 0xF0) == 0x80 || (d[0] & 0xF0) == 0x90) synth.noteOff(d[1]);
+//   //     });
+//   player.play();
+//   ...in loop(): player.task();
+//
+// task() reads ahead from the file into a ring of QUEUE_SIZE packets; the
+// file is never loaded whole. Events leave from the player's own task
+// (TASK_PRIORITY), woken by a one-shot esp_timer armed for the next event's
+// time, not from loop(), so they keep their timing while the sketch draws or
+// writes to the card. The timer callback only wakes the task, so an output
+// that blocks (a UART write waiting for FIFO space) delays the player, not
+// the other esp_timer callbacks. The output still runs off loop(): it must
+// be a transport whose sendMidiMessage() may be called from another task
+// (UART and BLE lock around their output state, ESP-NOW hands each message
+// to esp_now_send) or a callback that only queues (SynthEngine::noteOn is
+// fine). RTP-MIDI is not safe: its session is driven from loop().
+class MIDIFilePlayer {
+public:
+  typedef void (*OutputCallback)(void* ctx, const uint8_t* data, size_t length);
+
+  static const size_t QUEUE_SIZE = 128;
+  static const size_t MAX_SYSEX = MIDIFileReader::MAX_SYSEX;
+  static const UBaseType_t TASK_PRIORITY = 5;  // Above loop() (1)
+
+  MIDIFilePlayer();
+  ~MIDIFilePlayer();
+  MIDIFilePlayer(const MIDIFilePlayer&) = delete;
+  MIDIFilePlayer& operator=(const MIDIFilePlayer&) = delete;
+
+  bool open(fs::FS& fs, const char* path);
+  void close();
+
+  void setOutput(MIDITransport* transport);
+  void setOutput(OutputCallback cb, void* ctx = nullptr);
+
+  // Starts from the beginning, or resumes after pause().
+  bool play();
+  // Silences held notes and keeps the position.
+  void pause();
+  // Silences held notes and goes back to the beginning.
+  void stop();
+  // Reads ahead. Call from loop() often enough to stay QUEUE_SIZE events ahead.
+  void task();
+
+  bool isPlaying() const { return playing.load(); }
+  // True once the last event has been sent.
+  bool isFinished() const { return finished.load(); }
+  // Position in µs from the start of the file.
+  uint32_t getPosition() const;
+
+  // Scheduling accuracy: the latest any event went out after its time (µs),
+  // and how often the queue ran dry because task() wasn't called in time.
+  uint32_t getMaxLateness() const { return maxLateness; }
+  uint32_t getUnderrunCount() const { return underruns; }
+
+private:
+  MIDIFileReader reader;
+  MIDIPacketRing<QUEUE_SIZE> queue;
+  esp_timer_handle_t timer;
+  TaskHandle_t playerTask;
+
+  MIDITransport* transport;
+  OutputCallback outputCb;
+  void* outputCtx;
+
+  // Read-ahead state (task() only)
+  MIDIFileEvent pending;
+  bool hasPending;
+
+  std::atomic<bool> playing;
+  std::atomic<bool> busy;      // dispatchDue() running
+  std::atomic<bool> endOfFile;
+  std::atomic<bool> finished;
+  uint32_t startTime;          // micros() at file position 0
+  uint32_t pausedAt;           // Position kept by pause()
+
+  // Player task side
+  uint8_t sysex[MAX_SYSEX];
+  size_t sysexLen;
+  MIDINoteSet sounding[16];
+  uint16_t channelsUsed;
+  bool dry;                    // Queue was empty at the last callback
+  uint32_t maxLateness;
+  uint32_t underruns;
+
+  static void _onTimer(void* arg);
+  static void _playerTask(void* arg);
+  void dispatchDue();
+  void send(const uint8_t* data, size_t length);
+  void halt();
+  void allNotesOff();
+};
+
+#endif  // MIDI_FILE_PLAYER_H
@@ -6,36 +6,29 @@ MIDIHandler midiHandler;
 #include <cstdio>
 #include <sstream>
 
-#if ESP32_HOST_MIDI_HAS_PSRAM
-  #include "esp_heap_caps.h"
-#endif
-
 MIDIHandler::MIDIHandler()
-  : maxEvents(20),
+  : subscriptionCount(0),
+    maxEvents(20),
     globalIndex(0),
     nextMsgIndex(1),
     lastTimestamp(0),
     lastNoteOnTimestamp(0),
+    chordStartTime(0),
     nextChordIndex(1),
     currentChordIndex(0),
-    historyQueue(nullptr),
-    historyQueueCapacity(0),
-    historyQueueSize(0),
-    historyQueueHead(0),
-    transportCount(0)
+    transportCount(0),
+    sysExActive(0),
+    sysExDrops(0)
 {
+  memset(subscriptions, 0, sizeof(subscriptions));
   memset(transports, 0, sizeof(transports));
+  memset(noteChannels, 0, sizeof(noteChannels));
+  memset(noteVelocity, 0, sizeof(noteVelocity));
+  memset(noteChord, 0, sizeof(noteChord));
+  memset(noteMsgIndex, 0, sizeof(noteMsgIndex));
 }
 
 MIDIHandler::~MIDIHandler() {
-  if (historyQueue) {
-    // Call destructor on each element to properly release std::string
-    for (int i = 0; i < historyQueueCapacity; i++) {
-      historyQueue[i].~MIDIEventData();
-    }
-    free(historyQueue);
-    historyQueue = nullptr;
-  }
 }
 
 void MIDIHandler::begin() {
@@ -45,7 +38,10 @@ void MIDIHandler::begin() {
 
 void MIDIHandler::begin(const MIDIHandlerConfig& cfg) {
   this->config = cfg;
-  this->maxEvents = cfg.maxEvents;
+  setQueueLimit(cfg.maxEvents);
+  for (int i = 0; i <= MAX_TRANSPORTS; i++) {
+    sysEx[i].setLimit(cfg.sysExMaxSize);
+  }
 
 #if ESP32_HOST_MIDI_HAS_USB
   registerTransport(&usbTransport);
@@ -74,13 +70,46 @@ void MIDIHandler::_onTransportMidiData(void* ctx, const uint8_t* data, size_t le
   static_cast<MIDIHandler*>(ctx)->handleMidiMessage(data, len);
 }
 
+void MIDIHandler::_onTransportMidiStamped(void* ctx, MIDITransport* source,
+                                          const uint8_t* data, size_t len, uint32_t timestamp) {
+  static_cast<MIDIHandler*>(ctx)->handleMidiMessage(data, len, timestamp, source);
+}
+
+void MIDIHandler::_onTransportSysEx(void* ctx, MIDITransport* source,
+                                    const uint8_t* data, size_t len, uint32_t timestamp) {
+  static_cast<MIDIHandler*>(ctx)->handleSysExChunk(data, len, timestamp, source);
+}
+
+void MIDIHandler::_onTransportMidiBatch(void* ctx, MIDITransport* source,
+                                        const MIDIPacket* packets, size_t count) {
+  MIDIHandler* self = static_cast<MIDIHandler*>(ctx);
+  // Forward the whole span before parsing any of it: the last packet of a
+  // burst is sent without waiting for the ones ahead of it to be parsed.
+  if (!self->router.empty()) {
+    for (size_t i = 0; i < count; i++) {
+      if (!(packets[i].flags & MIDI_PACKET_SYSEX)) self->router.forward(packets[i].data, packets[i].length, source);
+    }
+  }
+  for (size_t i = 0; i < count; i++) {
+    const MIDIPacket& p = packets[i];
+    if (p.flags & MIDI_PACKET_SYSEX) self->handleSysExChunk(p.data, p.length, p.timestamp, source);
+    else self->parseMidiMessage(p.data, p.length, p.timestamp, source);
+  }
+}
+
 void MIDIHandler::_onTransportDisconnected(void* ctx) {
   static_cast<MIDIHandler*>(ctx)->clearActiveNotesNow();
 }
 
 void MIDIHandler::registerTransport(MIDITransport* t) {
-  if (transportCount >= MAX_TRANSPORTS) return;
+  if (transportCount >= MAX_TRANSPORTS) {
+    Serial.println("Too many MIDI transports! Raise ESP32_HOST_MIDI_MAX_TRANSPORTS.");
+    return;
+  }
   t->setMidiCallback(_onTransportMidiData, this);
+  t->setMidiStampedCallback(_onTransportMidiStamped, this);
+  t->setSysExCallback(_onTransportSysEx, this);
+  t->setMidiBatchCallback(_onTransportMidiBatch, this);
   t->setConnectionCallbacks(nullptr, _onTransportDisconnected, this);
   transports[transportCount++] = t;
 }
@@ -92,158 +121,137 @@ void MIDIHandler::addTransport(MIDITransport* transport) {
 void MIDIHandler::enableHistory(int capacity) {
   if (capacity <= 0) {
     // Disable history, freeing allocated memory
-    if (historyQueue) {
-      free(historyQueue);
-      historyQueue = nullptr;
-    }
-    historyQueueCapacity = 0;
-    historyQueueSize = 0;
-    historyQueueHead = 0;
+    historyQueue.release();
     Serial.println("MIDI history disabled!");
     return;
   }
 
-  // Free existing history before reallocating
-  if (historyQueue) {
-    free(historyQueue);
-    historyQueue = nullptr;
-  }
-
   // Allocate history buffer — prefer PSRAM if available, fall back to heap
-#if ESP32_HOST_MIDI_HAS_PSRAM
-  historyQueue = static_cast<MIDIEventData*>(heap_caps_malloc(capacity * sizeof(MIDIEventData), MALLOC_CAP_SPIRAM));
-#else
-  historyQueue = static_cast<MIDIEventData*>(malloc(capacity * sizeof(MIDIEventData)));
-#endif
-
-  if (!historyQueue) {
+  historyQueue.release();
+  if (!historyQueue.setCapacity(capacity, true)) {
     Serial.println("Failed to allocate memory for history buffer!");
-    historyQueueCapacity = 0;
     return;
   }
 
-  historyQueueCapacity = capacity;
-  historyQueueSize = 0;
-  historyQueueHead = 0;
-
-  // Initialize each object using placement new to avoid std::string issues
-  for (int i = 0; i < historyQueueCapacity; i++) {
-    new (&historyQueue[i]) MIDIEventData();
-  }
-
   Serial.println("MIDI history enabled!");
 }
 
 
 void MIDIHandler::setQueueLimit(int maxEvents) {
+  if (maxEvents < 1) maxEvents = 1;
   this->maxEvents = maxEvents;
+  // The queue is allocated here, once, so adding events never allocates.
+  if (eventQueue.capacity() != static_cast<size_t>(maxEvents) &&
+      !eventQueue.setCapacity(maxEvents)) {
+    Serial.println("Failed to allocate MIDI event queue!");
+  }
 }
 
-const std::deque<MIDIEventData>& MIDIHandler::getQueue() const {
+const MIDIEventQueue& MIDIHandler::getQueue() const {
   return eventQueue;
 }
 
-// Expands the dynamic ring buffer.
-void MIDIHandler::expandHistoryQueue() {
-  int newCapacity = (historyQueueCapacity > 0) ? (historyQueueCapacity * 2) : 10;
+MIDIEventData MIDIHandler::getEventData(size_t i) const {
+  return toEventData(eventQueue[i], eventQueue.delayAt(i), eventQueue.millisAt(i));
+}
 
-#if ESP32_HOST_MIDI_HAS_PSRAM
-  MIDIEventData* newQueue = static_cast<MIDIEventData*>(heap_caps_malloc(newCapacity * sizeof(MIDIEventData), MALLOC_CAP_SPIRAM));
-#else
-  MIDIEventData* newQueue = static_cast<MIDIEventData*>(malloc(newCapacity * sizeof(MIDIEventData)));
-#endif
+// Doubles the history ring so no events are discarded.
+void MIDIHandler::expandHistoryQueue() {
+  size_t newCapacity = (historyQueue.capacity() > 0) ? (historyQueue.capacity() * 2) : 10;
 
-  if (!newQueue) {
+  if (!historyQueue.setCapacity(newCapacity, true)) {
     Serial.println("Failed to expand MIDI history buffer!");
     return;
   }
-  // Calculate tail index in the current circular buffer.
-  int tail = (historyQueueHead + historyQueueCapacity - historyQueueSize) % historyQueueCapacity;
-  // Copy events from old buffer to new, preserving order.
-  for (int i = 0; i < historyQueueSize; i++) {
-    int index = (tail + i) % historyQueueCapacity;
-    newQueue[i] = historyQueue[index];
-  }
-  // Initialize remaining elements in the new buffer
-  for (int i = historyQueueSize; i < newCapacity; i++) {
-    new (&newQueue[i]) MIDIEventData();
-  }
-  free(historyQueue);
-  historyQueue = newQueue;
-  historyQueueCapacity = newCapacity;
-  // After copying, new head is immediately after the last element.
-  historyQueueHead = historyQueueSize;
-  Serial.printf("MIDI history expanded to %d events!\n", historyQueueCapacity);
+  Serial.printf("MIDI history expanded to %d events!\n", (int)historyQueue.capacity());
 }
 
-void MIDIHandler::addEvent(const MIDIEventData& event) {
-  // Add event to the main queue (stored in SRAM)
-  eventQueue.push_back(event);
-  processQueue();
+void MIDIHandler::addEvent(const MIDIEvent& event) {
+  uint32_t delay = (event.index <= 1) ? 0 : (event.timestamp - lastTimestamp);
+  lastTimestamp = event.timestamp;
+
+  // Add event to the main queue (stored in SRAM); the oldest is dropped when full
+  if (eventQueue.capacity() == 0) setQueueLimit(maxEvents);
+  eventQueue.push(event, delay);
 
   // If history is active, add event to the dynamic buffer
-  if (historyQueue != nullptr && historyQueueCapacity > 0) {
+  if (historyQueue.capacity() > 0) {
     // If buffer is full, expand to avoid discarding events
-    if (historyQueueSize == historyQueueCapacity) {
+    if (historyQueue.full()) {
       expandHistoryQueue();
     }
-    historyQueue[historyQueueHead] = event;
-    historyQueueHead = (historyQueueHead + 1) % historyQueueCapacity;
-    historyQueueSize++;
+    historyQueue.push(event, delay);
+  }
+}
+
+void MIDIHandler::addEvent(const MIDIEventData& event) {
+  MIDIEvent ev;
+  ev.timestamp = event.timestamp * 1000;
+  ev.index = event.index;
+  ev.msgIndex = event.msgIndex;
+  ev.chordIndex = event.chordIndex;
+  ev.status = MIDI_EVENT_NONE;
+  for (uint8_t st = 0x80; st < 0xF0; st += 0x10) {
+    if (event.status == midiStatusName(st)) ev.status = static_cast<MIDIStatus>(st);
+  }
+  ev.channel = event.channel;
+  if (ev.status == MIDI_EVENT_PITCH_BEND) {
+    ev.note = event.pitchBend & 0x7F;
+    ev.velocity = (event.pitchBend >> 7) & 0x7F;
+  } else {
+    ev.note = event.note;
+    ev.velocity = event.velocity;
   }
+  addEvent(ev);
 }
 
 
 void MIDIHandler::processQueue() {
+  // The queue is a fixed-size ring trimmed on insert; only shrink it here.
   while (eventQueue.size() > static_cast<size_t>(maxEvents)) {
-    eventQueue.pop_front();
+    eventQueue.pop();
   }
 }
 
 std::string MIDIHandler::getNoteName(int note) const {
-  static const char* names[12] = { "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B" };
-  return names[note % 12];
+  return midiNoteName(note);
 }
 
 std::string MIDIHandler::getNoteWithOctave(int note) const {
-  int octave = (note / 12) - 1;
-  return getNoteName(note) + std::to_string(octave);
+  return midiNoteOctaveName(note);
 }
 
 
 std::string MIDIHandler::getActiveNotes() const {
-  std::ostringstream oss;
-  oss << "{";
-
-  // Step 1: Create a sorted vector from the active notes map
-  std::vector<int> sortedNotes;
-  for (const auto& kv : activeNotes) {
-    sortedNotes.push_back(kv.first);
-  }
+  char buf[128 * 4 + 4];
+  formatActiveNotes(buf, sizeof(buf));
+  return buf;
+}
 
-  // Step 2: Sort by note number
-  std::sort(sortedNotes.begin(), sortedNotes.end());
+size_t MIDIHandler::formatActiveNotes(char* buf, size_t len) const {
+  if (!buf || len == 0) return 0;
+  size_t pos = 0;
+  auto put = [&](const char* s) {
+    while (*s && pos + 1 < len) buf[pos++] = *s++;
+  };
 
-  // Step 3: Build the formatted string
-  bool first = true;
-  for (int note : sortedNotes) {
-    if (!first) oss << ", ";
-    oss << getNoteName(note);
-    first = false;
+  // Bits come out in note order, so no sorting is needed
+  put("{");
+  for (int note = heldNotes.first(); note >= 0; note = heldNotes.next(note)) {
+    if (pos > 1) put(", ");
+    put(midiNoteName(note));
   }
-
-  oss << "}";
-  return oss.str();
+  put("}");
+  buf[pos] = '\0';
+  return pos;
 }
 
 std::vector<std::string> MIDIHandler::getActiveNotesVector() const {
   std::vector<std::string> activeNotesVector;
+  activeNotesVector.reserve(heldNotes.count());
 
-  // Use std::map for automatic sorting by MIDI note number
-  std::map<int, int> sortedActiveNotes(activeNotes.begin(), activeNotes.end());
-
-  for (const auto& kv : sortedActiveNotes) {
-    activeNotesVector.push_back(getNoteName(kv.first));
+  for (int note = heldNotes.first(); note >= 0; note = heldNotes.next(note)) {
+    activeNotesVector.push_back(midiNoteName(note));
   }
 
   return activeNotesVector;
@@ -253,13 +261,10 @@ std::string MIDIHandler::getActiveNotesString() const {
   std::ostringstream oss;
   oss << "{";
 
-  // Use std::map for automatic sorting
-  std::map<int, int> sortedActiveNotes(activeNotes.begin(), activeNotes.end());
-
   bool first = true;
-  for (const auto& kv : sortedActiveNotes) {
+  for (int note = heldNotes.first(); note >= 0; note = heldNotes.next(note)) {
     if (!first) oss << ", ";
-    oss << getNoteName(kv.first) << ", {" << kv.second << "}";
+    oss << midiNoteName(note) << ", {" << noteChord[note] << "}";
     first = false;
   }
 
@@ -269,28 +274,59 @@ std::string MIDIHandler::getActiveNotesString() const {
 
 
 size_t MIDIHandler::getActiveNotesCount() const {
-  return activeNotes.size();
+  return heldNotes.count();
 }
 
 void MIDIHandler::fillActiveNotes(bool out[128]) const {
   memset(out, 0, 128);
-  for (const auto& kv : activeNotes) {
-    if (kv.first >= 0 && kv.first < 128)
-      out[kv.first] = true;
+  for (int note = heldNotes.first(); note >= 0; note = heldNotes.next(note)) {
+    out[note] = true;
+  }
+}
+
+uint8_t MIDIHandler::getNoteVelocity(uint8_t channel, uint8_t note) const {
+  uint8_t ch = (channel - 1) & 0x0F;
+  return channelNotes[ch].test(note) ? noteVelocity[ch][note & 0x7F] : 0;
+}
+
+bool MIDIHandler::getActiveChord(MIDIChordSnapshot& out) const {
+  out.chordIndex = currentChordIndex;
+  out.count = 0;
+  out.totalHeld = heldNotes.count();
+  out.pitchClasses = 0;
+  out.startTime = chordStartTime;
+
+  for (int note = heldNotes.first(); note >= 0; note = heldNotes.next(note)) {
+    out.pitchClasses |= 1 << (note % 12);
+    if (out.count >= MIDIChordSnapshot::MAX_NOTES) continue;
+
+    // A note held on several channels reports its loudest NoteOn
+    uint8_t vel = 0;
+    for (uint16_t chans = noteChannels[note]; chans; chans &= chans - 1) {
+      uint8_t v = noteVelocity[__builtin_ctz(chans)][note];
+      if (v > vel) vel = v;
+    }
+    out.notes[out.count] = note;
+    out.velocities[out.count] = vel;
+    out.count++;
   }
+  return out.count > 0;
 }
 
 // Clears active notes
 void MIDIHandler::clearActiveNotesNow() {
-  activeNotes.clear();
-  activeMsgIndex.clear();
+  for (int ch = 0; ch < 16; ch++) channelNotes[ch].clear();
+  heldNotes.clear();
+  memset(noteChannels, 0, sizeof(noteChannels));
   currentChordIndex = 0;
+  chords.releaseAll(micros());
 }
 
 // Clears the event queue and resets all state
 void MIDIHandler::clearQueue() {
   eventQueue.clear();
   clearActiveNotesNow();
+  chords.clear();
   globalIndex = 0;
   nextMsgIndex = 1;
   lastTimestamp = 0;
@@ -298,7 +334,7 @@ void MIDIHandler::clearQueue() {
   nextChordIndex = 1;
 }
 
-int MIDIHandler::lastChord(const std::deque<MIDIEventData>& queue) const {
+int MIDIHandler::lastChord(const MIDIEventQueue& queue) const {
   int maxChord = 0;
   for (const auto& event : queue) {
     if (event.chordIndex > maxChord) {
@@ -308,13 +344,44 @@ int MIDIHandler::lastChord(const std::deque<MIDIEventData>& queue) const {
   return maxChord;
 }
 
-std::vector<std::string> MIDIHandler::getChord(int chord, const std::deque<MIDIEventData>& queue, const std::vector<std::string>& fields, bool includeLabels) const {
+// Field names accepted by getChord(); unknown names yield empty strings.
+enum : uint8_t {
+  LEGACY_FIELD_NONE, LEGACY_FIELD_NOTE_NAME, LEGACY_FIELD_NOTE_OCTAVE, LEGACY_FIELD_STATUS,
+  LEGACY_FIELD_NOTE, LEGACY_FIELD_TIMESTAMP, LEGACY_FIELD_VELOCITY, LEGACY_FIELD_CHANNEL,
+  LEGACY_FIELD_PITCH_BEND,
+};
+
+static uint8_t legacyFieldCode(const std::string& field) {
+  static const char* const names[] = {
+    "", "noteName", "noteOctave", "status", "note", "timestamp", "velocity", "channel", "pitchBend",
+  };
+  for (uint8_t i = 1; i < sizeof(names) / sizeof(names[0]); i++) {
+    if (field == names[i]) return i;
+  }
+  return LEGACY_FIELD_NONE;
+}
+
+static std::string legacyFieldString(const MIDIEventData& event, uint8_t code) {
+  switch (code) {
+    case LEGACY_FIELD_NOTE_NAME:   return event.noteName;
+    case LEGACY_FIELD_NOTE_OCTAVE: return event.noteOctave;
+    case LEGACY_FIELD_STATUS:      return event.status;
+    case LEGACY_FIELD_NOTE:        return std::to_string(event.note);
+    case LEGACY_FIELD_TIMESTAMP:   return std::to_string(event.timestamp);
+    case LEGACY_FIELD_VELOCITY:    return std::to_string(event.velocity);
+    case LEGACY_FIELD_CHANNEL:     return std::to_string(event.channel);
+    case LEGACY_FIELD_PITCH_BEND:  return std::to_string(event.pitchBend);
+    default:                       return "";
+  }
+}
+
+std::vector<std::string> MIDIHandler::getChord(int chord, const MIDIEventQueue& queue, const std::vector<std::string>& fields, bool includeLabels) const {
   std::vector<MIDIEventData> chordEvents;
 
   // Filter only NoteOn events from the specified chord
-  for (const auto& event : queue) {
-    if (event.chordIndex == chord && event.status == "NoteOn") {
-      chordEvents.push_back(event);
+  for (auto it = queue.begin(); it != queue.end(); ++it) {
+    if (it->chordIndex == chord && it->status == MIDI_EVENT_NOTE_ON) {
+      chordEvents.push_back(toEventData(*it, queue.delayAt(it.position()), queue.millisAt(it.position())));
     }
   }
 
@@ -359,56 +426,24 @@ std::vector<std::string> MIDIHandler::getChord(int chord, const std::deque<MIDIE
       result.push_back(oss.str());
     }
   }
-  // If a single field was requested
-  else if (fields.size() == 1) {
-    std::string field = fields[0];
-    for (const auto& event : chordEvents) {
-      if (field == "noteName") {
-        result.push_back(event.noteName);
-      } else if (field == "noteOctave") {
-        result.push_back(event.noteOctave);
-      } else if (field == "status") {
-        result.push_back(event.status);
-      } else if (field == "note") {
-        result.push_back(std::to_string(event.note));
-      } else if (field == "timestamp") {
-        result.push_back(std::to_string(event.timestamp));
-      } else if (field == "velocity") {
-        result.push_back(std::to_string(event.velocity));
-      } else if (field == "channel") {
-        result.push_back(std::to_string(event.channel));
-      } else if (field == "pitchBend") {
-        result.push_back(std::to_string(event.pitchBend));
-      }
-    }
-  }
-  // If multiple fields were requested
+  // One or more named fields. Names are resolved once, not per event.
   else {
+    uint8_t codes[16];
+    size_t n = 0;
+    for (const auto& field : fields) {
+      if (n < sizeof(codes)) codes[n++] = legacyFieldCode(field);
+    }
     for (const auto& event : chordEvents) {
-      std::ostringstream oss;
-      bool first = true;
-      for (const auto& field : fields) {
-        if (!first) oss << ", ";
-        if (field == "noteName") {
-          oss << event.noteName;
-        } else if (field == "noteOctave") {
-          oss << event.noteOctave;
-        } else if (field == "status") {
-          oss << event.status;
-        } else if (field == "note") {
-          oss << event.note;
-        } else if (field == "timestamp") {
-          oss << event.timestamp;
-        } else if (field == "velocity") {
-          oss << event.velocity;
-        } else if (field == "channel") {
-          oss << event.channel;
-        } else if (field == "pitchBend") {
-          oss << event.pitchBend;
-        }
-        first = false;
+      if (n == 1) {
+        if (codes[0] != LEGACY_FIELD_NONE) result.push_back(legacyFieldString(event, codes[0]));
+        continue;
       }
-      result.push_back(oss.str());
+      std::string line;
+      for (size_t i = 0; i < n; i++) {
+        if (i > 0) line += ", ";
+        line += legacyFieldString(event, codes[i]);
+      }
+      result.push_back(line);
     }
   }
 
@@ -421,18 +456,44 @@ std::vector<std::string> MIDIHandler::getAnswer(const std::string& field, bool i
 
 std::vector<std::string> MIDIHandler::getAnswer(const std::vector<std::string>& fields, bool includeLabels) const {
   std::vector<std::string> result;
-  const std::deque<MIDIEventData>& queue = getQueue();
+  const MIDIEventQueue& queue = getQueue();
 
-  if (!queue.empty()) {
-    int lastChordIdx = lastChord(queue);
-    result = getChord(lastChordIdx, queue, fields, includeLabels);
+  // The chord index knows the latest chord without scanning the queue
+  const MIDIChord* last = chords.recent(0);
+  if (!queue.empty() && last) {
+    result = getChord(last->chordIndex, queue, fields, includeLabels);
   }
 
   return result;
 }
 
 
+// Removes a note from the active set, returning its NoteOn pairing.
+// Only a NoteOff on a channel that holds the note releases it.
+void MIDIHandler::releaseNote(uint8_t channel, uint8_t note, uint16_t& msgIndex, uint16_t& chordIdx) {
+  uint8_t ch = (channel - 1) & 0x0F;
+  if (channelNotes[ch].test(note)) {
+    chordIdx = noteChord[note];
+    msgIndex = noteMsgIndex[note];
+    channelNotes[ch].reset(note);
+    noteChannels[note] &= ~(1u << ch);
+    if (noteChannels[note] == 0) heldNotes.reset(note);
+  } else {
+    chordIdx = currentChordIndex;
+  }
+}
+
 void MIDIHandler::handleMidiMessage(const uint8_t* data, size_t length) {
+  handleMidiMessage(data, length, micros(), nullptr);
+}
+
+void MIDIHandler::handleMidiMessage(const uint8_t* data, size_t length, uint32_t timestamp, MIDITransport* source) {
+  // Thru first, so forwarding latency doesn't include parsing and callbacks
+  if (!router.empty()) router.forward(data, length, source);
+  parseMidiMessage(data, length, timestamp, source);
+}
+
+void MIDIHandler::parseMidiMessage(const uint8_t* data, size_t length, uint32_t timestamp, MIDITransport* source) {
   // USB-MIDI: 4+ bytes (CIN + MIDI), skip first byte.
   // BLE/raw MIDI: 2-3 bytes, use directly.
   const uint8_t* midiData;
@@ -440,169 +501,287 @@ void MIDIHandler::handleMidiMessage(const uint8_t* data, size_t length) {
   else if (length >= 2) midiData = data;      // BLE/raw MIDI: status + data
   else return;
 
-  // Debug callback — fire before parsing
-  if (rawMidiCb) rawMidiCb(data, length, midiData);
-
-  unsigned long now = millis();
-
-  uint8_t midiStatus = midiData[0] & 0xF0;
-  int channel = (midiData[0] & 0x0F) + 1;
-  unsigned long diff = (globalIndex == 0) ? 0 : (now - lastTimestamp);
-  lastTimestamp = now;
-
-  // Channel messages other than NoteOn/NoteOff
-  if (midiStatus == 0xB0) {  // Control Change
-    MIDIEventData event;
-    event.index = ++globalIndex;
-    event.msgIndex = 0;
-    event.timestamp = now;
-    event.delay = diff;
-    event.channel = channel;
-    event.status = "ControlChange";
-    event.note = midiData[1];        // Controller number
-    event.noteName = "";
-    event.noteOctave = "";
-    event.velocity = midiData[2];    // CC value
-    event.chordIndex = currentChordIndex;
-    event.pitchBend = 0;
-    addEvent(event);
+  if (length >= 4) {
+    // USB-MIDI SysEx frames: CIN 0x4 = 3 bytes, more to follow;
+    // 0x5/0x6/0x7 = ends with 1/2/3 bytes (0x5 without F7 is 1-byte system common)
+    uint8_t cin = data[0] & 0x0F;
+    if (cin >= 0x4 && cin <= 0x7 && !(cin == 0x5 && midiData[0] != 0xF7)) {
+      static const uint8_t cinBytes[4] = { 3, 1, 2, 3 };
+      handleSysExChunk(midiData, cinBytes[cin - 4], timestamp, source);
+      return;
+    }
+  } else if (midiData[0] == 0xF0) {
+    handleSysExChunk(midiData, length, timestamp, source);  // short SysEx in one packet
     return;
   }
 
-  if (midiStatus == 0xC0) {  // Program Change
-    MIDIEventData event;
-    event.index = ++globalIndex;
-    event.msgIndex = 0;
-    event.timestamp = now;
-    event.delay = diff;
-    event.channel = channel;
-    event.status = "ProgramChange";
-    event.note = midiData[1];  // Program number
-    event.noteName = "";
-    event.noteOctave = "";
-    event.velocity = 0;
-    event.chordIndex = currentChordIndex;
-    event.pitchBend = 0;
-    addEvent(event);
-    return;
-  }
+  // Debug callback — fire before parsing
+  if (rawMidiCb) rawMidiCb(data, length, midiData);
 
-  if (midiStatus == 0xD0) {  // Channel Pressure (Aftertouch)
-    MIDIEventData event;
-    event.index = ++globalIndex;
-    event.msgIndex = 0;
-    event.timestamp = now;
-    event.delay = diff;
-    event.channel = channel;
-    event.status = "ChannelPressure";
-    event.note = 0;
-    event.noteName = "";
-    event.noteOctave = "";
-    event.velocity = midiData[1];  // Pressure value
-    event.chordIndex = currentChordIndex;
-    event.pitchBend = 0;
-    addEvent(event);
-    return;
-  }
+  // Transports are drained one after another, so a packet can be older than
+  // the last one stored. Keep stored time monotonic so delays stay valid.
+  uint32_t now = timestamp;
+  if (globalIndex > 0 && (int32_t)(now - lastTimestamp) < 0) now = lastTimestamp;
 
-  if (midiStatus == 0xE0) {  // Pitch Bend
-    int pitchValue = (midiData[1] & 0x7F) | ((midiData[2] & 0x7F) << 7);
-    MIDIEventData event;
-    event.index = ++globalIndex;
-    event.msgIndex = 0;
-    event.timestamp = now;
-    event.delay = diff;
-    event.channel = channel;
-    event.status = "PitchBend";
-    event.note = 0;
-    event.noteName = "";
-    event.noteOctave = "";
-    event.velocity = 0;
-    event.chordIndex = currentChordIndex;
-    event.pitchBend = pitchValue;
-    addEvent(event);
-    return;
-  }
+  uint8_t midiStatus = midiData[0] & 0xF0;
+  uint8_t data2 = (length == 2) ? 0 : midiData[2];  // 2-byte messages have no second data byte
 
-  // NoteOn / NoteOff
-  int note = midiData[1];
-  int velocity = midiData[2];
-  std::string statusType;
-  int msgIndex = 0;
-  int chordIdx = currentChordIndex;
+  // Every stored event starts from the same compact record; no strings are built here.
+  MIDIEvent event;
+  event.timestamp = now;
+  event.index = 0;
+  event.msgIndex = 0;
+  event.chordIndex = currentChordIndex;
+  event.status = static_cast<MIDIStatus>(midiStatus);
+  event.channel = (midiData[0] & 0x0F) + 1;
+  event.note = midiData[1] & 0x7F;
+  event.velocity = data2 & 0x7F;
 
-  if (midiStatus == 0x90) {  // NoteOn
-    if (velocity > 0) {
+  // Channel messages other than NoteOn/NoteOff
+  switch (midiStatus) {
+    case 0xB0:  // Control Change: note = controller, velocity = value
+    case 0xE0:  // Pitch Bend: note/velocity hold the 14-bit LSB/MSB
+      break;
+    case 0xC0:  // Program Change: note = program
+      event.velocity = 0;
+      break;
+    case 0xD0:  // Channel Pressure (Aftertouch): velocity = pressure
+      event.velocity = event.note;
+      event.note = 0;
+      break;
+    case 0x90:  // NoteOn
+    case 0x80:  // NoteOff
+      break;
+    default:
+      return;  // Unrecognized MIDI message
+  }
+
+  // A channel message interrupts an unterminated SysEx from the same source
+  if (sysExActive) {
+    int slot = sysExSlot(source);
+    if (sysExActive & (1u << slot)) abortSysEx(slot);
+  }
+
+  if (midiStatus == 0x90 || midiStatus == 0x80) {
+    int note = event.note;
+
+    if (midiStatus == 0x90 && event.velocity > 0) {
       // Velocity filter: ignore ghost notes below threshold
-      if (config.velocityThreshold > 0 && velocity < config.velocityThreshold) {
+      if (config.velocityThreshold > 0 && event.velocity < config.velocityThreshold) {
         return;
       }
 
-      statusType = "NoteOn";
-      msgIndex = nextMsgIndex++;
+      event.msgIndex = nextMsgIndex++;
+      if (nextMsgIndex == 0) nextMsgIndex = 1;  // 0 means "no pair"
 
       // Chord detection: determine if this NoteOn starts a new chord
       bool startNewChord = false;
-      if (activeNotes.empty()) {
+      if (heldNotes.empty()) {
         startNewChord = true;
-      } else if (config.chordTimeWindow > 0 && (now - lastNoteOnTimestamp) > config.chordTimeWindow) {
+      } else if (config.chordTimeWindow > 0 && (now - lastNoteOnTimestamp) > config.chordTimeWindow * 1000UL) {
         startNewChord = true;
       }
 
       if (startNewChord) {
         currentChordIndex = nextChordIndex++;
+        if (nextChordIndex == 0) nextChordIndex = 1;
+        chordStartTime = now;
       }
 
       lastNoteOnTimestamp = now;
-      chordIdx = currentChordIndex;
-      activeNotes[note] = currentChordIndex;
-      activeMsgIndex[note] = msgIndex;
-    } else {  // NoteOn with velocity 0 equals NoteOff
-      statusType = "NoteOff";
-      auto it = activeNotes.find(note);
-      if (it != activeNotes.end()) {
-        chordIdx = it->second;
-        msgIndex = activeMsgIndex[note];
-        activeNotes.erase(it);
-        activeMsgIndex.erase(note);
-      } else {
-        chordIdx = currentChordIndex;
-      }
+      event.chordIndex = currentChordIndex;
+      uint8_t ch = event.channel - 1;
+      channelNotes[ch].set(note);
+      heldNotes.set(note);
+      noteChannels[note] |= 1u << ch;
+      noteVelocity[ch][note] = event.velocity;
+      noteChord[note] = currentChordIndex;
+      noteMsgIndex[note] = event.msgIndex;
+    } else {  // NoteOff, or NoteOn with velocity 0
+      event.status = MIDI_EVENT_NOTE_OFF;
+      releaseNote(event.channel, note, event.msgIndex, event.chordIndex);
     }
-  } else if (midiStatus == 0x80) {  // NoteOff
-    statusType = "NoteOff";
-    auto it = activeNotes.find(note);
-    if (it != activeNotes.end()) {
-      chordIdx = it->second;
-      msgIndex = activeMsgIndex[note];
-      activeNotes.erase(it);
-      activeMsgIndex.erase(note);
-    } else {
-      chordIdx = currentChordIndex;
+
+    if (heldNotes.empty()) {
+      currentChordIndex = 0;
     }
-  } else {
-    return;  // Unrecognized MIDI message
   }
 
-  if (activeNotes.empty()) {
-    currentChordIndex = 0;
+  event.index = ++globalIndex;
+  addEvent(event);
+
+  if (event.status == MIDI_EVENT_NOTE_ON) chords.noteOn(event);
+  else if (event.status == MIDI_EVENT_NOTE_OFF) chords.noteOff(event.chordIndex, event.channel, event.note, now);
+
+  if (subscriptionCount > 0) dispatchCallbacks(event, source);
+}
+
+// --- SysEx ---
+
+int MIDIHandler::sysExSlot(MIDITransport* source) const {
+  for (int i = 0; i < transportCount; i++) {
+    if (transports[i] == source) return i;
   }
+  return MAX_TRANSPORTS;
+}
 
-  MIDIEventData event;
-  event.index = ++globalIndex;
-  event.msgIndex = msgIndex;
-  event.timestamp = now;
-  event.delay = diff;
-  event.channel = channel;
-  event.status = statusType;
-  event.note = note;
-  event.noteName = getNoteName(note);
-  event.noteOctave = getNoteWithOctave(note);
-  event.velocity = velocity;
-  event.chordIndex = chordIdx;
-  event.pitchBend = 0;
+void MIDIHandler::abortSysEx(int slot) {
+  sysEx[slot].end();
+  sysExActive &= ~(1u << slot);
+  sysExDrops++;
+}
 
-  addEvent(event);
+void MIDIHandler::handleSysExChunk(const uint8_t* data, size_t length, uint32_t timestamp, MIDITransport* source) {
+  if (!data || length == 0) return;
+  int slot = sysExSlot(source);
+  MIDISysExBuffer& sx = sysEx[slot];
+
+  bool first = data[0] == 0xF0;
+  bool last = data[length - 1] == 0xF7;
+  if (first) {
+    if (sx.inProgress()) abortSysEx(slot);  // previous message never got its F7
+    sx.begin(timestamp);
+    sysExActive |= 1u << slot;
+  } else if (!sx.inProgress()) {
+    return;  // Continuation without a start: its F0 was lost
+  }
+
+  // Chunk subscribers see the bytes in place; nothing is copied for them
+  for (int i = 0; i < subscriptionCount; i++) {
+    const Subscription& s = subscriptions[i];
+    if (!s.active || s.status != SUB_SYSEX_CHUNK) continue;
+    if (s.source && s.source != source) continue;
+    s.fn.sysExChunk(data, length, first, last, timestamp);
+  }
+
+  sx.append(data, length);
+  if (!last) return;
+
+  sx.end();
+  sysExActive &= ~(1u << slot);
+  if (!sx.complete()) {
+    sysExDrops++;
+    return;
+  }
+  if (!router.empty()) router.forwardSysEx(sx.data(), sx.size(), source);
+  for (int i = 0; i < subscriptionCount; i++) {
+    const Subscription& s = subscriptions[i];
+    if (!s.active || s.status != MIDI_EVENT_SYSEX) continue;
+    if (s.source && s.source != source) continue;
+    s.fn.sysEx(sx.data(), sx.size(), sx.startTime());
+  }
+}
+
+// --- Push-style callbacks ---
+
+// Claims a free slot; the caller stores the typed callback. -1 if full.
+int MIDIHandler::subscribe(uint8_t status, void* ctx, uint8_t channel, MIDITransport* source) {
+  if (channel > 16) return -1;
+  for (int i = 0; i < MAX_SUBSCRIPTIONS; i++) {
+    Subscription& s = subscriptions[i];
+    if (s.active) continue;
+    s.active = true;
+    s.status = status;
+    s.channel = channel;
+    s.source = source;
+    s.ctx = ctx;
+    if (i >= subscriptionCount) subscriptionCount = i + 1;
+    return i;
+  }
+  Serial.println("MIDI callback table full!");
+  return -1;
+}
+
+void MIDIHandler::removeCallback(int id) {
+  if (id < 0 || id >= MAX_SUBSCRIPTIONS) return;
+  subscriptions[id].active = false;
+  while (subscriptionCount > 0 && !subscriptions[subscriptionCount - 1].active) subscriptionCount--;
+}
+
+int MIDIHandler::onNoteOn(NoteCallback cb, uint8_t channel, MIDITransport* source) {
+  int id = cb ? subscribe(MIDI_EVENT_NOTE_ON, nullptr, channel, source) : -1;
+  if (id >= 0) subscriptions[id].fn.note = cb;
+  return id;
+}
+
+int MIDIHandler::onNoteOff(NoteCallback cb, uint8_t channel, MIDITransport* source) {
+  int id = cb ? subscribe(MIDI_EVENT_NOTE_OFF, nullptr, channel, source) : -1;
+  if (id >= 0) subscriptions[id].fn.note = cb;
+  return id;
+}
+
+int MIDIHandler::onControlChange(ControlChangeCallback cb, uint8_t channel, MIDITransport* source) {
+  int id = cb ? subscribe(MIDI_EVENT_CONTROL_CHANGE, nullptr, channel, source) : -1;
+  if (id >= 0) subscriptions[id].fn.controlChange = cb;
+  return id;
+}
+
+int MIDIHandler::onProgramChange(ProgramChangeCallback cb, uint8_t channel, MIDITransport* source) {
+  int id = cb ? subscribe(MIDI_EVENT_PROGRAM_CHANGE, nullptr, channel, source) : -1;
+  if (id >= 0) subscriptions[id].fn.programChange = cb;
+  return id;
+}
+
+int MIDIHandler::onChannelPressure(ChannelPressureCallback cb, uint8_t channel, MIDITransport* source) {
+  int id = cb ? subscribe(MIDI_EVENT_CHANNEL_PRESSURE, nullptr, channel, source) : -1;
+  if (id >= 0) subscriptions[id].fn.channelPressure = cb;
+  return id;
+}
+
+int MIDIHandler::onPitchBend(PitchBendCallback cb, uint8_t channel, MIDITransport* source) {
+  int id = cb ? subscribe(MIDI_EVENT_PITCH_BEND, nullptr, channel, source) : -1;
+  if (id >= 0) subscriptions[id].fn.pitchBend = cb;
+  return id;
+}
+
+int MIDIHandler::onEvent(EventCallback cb, void* ctx, uint8_t channel, MIDITransport* source) {
+  int id = cb ? subscribe(MIDI_EVENT_NONE, ctx, channel, source) : -1;
+  if (id >= 0) subscriptions[id].fn.event = cb;
+  return id;
+}
+
+int MIDIHandler::onSysEx(SysExCallback cb, MIDITransport* source) {
+  int id = cb ? subscribe(MIDI_EVENT_SYSEX, nullptr, 0, source) : -1;
+  if (id >= 0) subscriptions[id].fn.sysEx = cb;
+  return id;
+}
+
+int MIDIHandler::onSysExChunk(SysExChunkCallback cb, MIDITransport* source) {
+  int id = cb ? subscribe(SUB_SYSEX_CHUNK, nullptr, 0, source) : -1;
+  if (id >= 0) subscriptions[id].fn.sysExChunk = cb;
+  return id;
+}
+
+void MIDIHandler::dispatchCallbacks(const MIDIEvent& ev, MIDITransport* source) {
+  for (int i = 0; i < subscriptionCount; i++) {
+    const Subscription& s = subscriptions[i];
+    if (!s.active) continue;
+    if (s.status != MIDI_EVENT_NONE && s.status != ev.status) continue;
+    if (s.channel && s.channel != ev.channel) continue;
+    if (s.source && s.source != source) continue;
+
+    switch (s.status) {
+      case MIDI_EVENT_NOTE_ON:
+      case MIDI_EVENT_NOTE_OFF:
+        s.fn.note(ev.channel, ev.note, ev.velocity, ev.timestamp);
+        break;
+      case MIDI_EVENT_CONTROL_CHANGE:
+        s.fn.controlChange(ev.channel, ev.note, ev.velocity, ev.timestamp);
+        break;
+      case MIDI_EVENT_PROGRAM_CHANGE:
+        s.fn.programChange(ev.channel, ev.note, ev.timestamp);
+        break;
+      case MIDI_EVENT_CHANNEL_PRESSURE:
+        s.fn.channelPressure(ev.channel, ev.velocity, ev.timestamp);
+        break;
+      case MIDI_EVENT_PITCH_BEND:
+        s.fn.pitchBend(ev.channel, ev.pitchBend() - 8192, ev.timestamp);
+        break;
+      default:
+        s.fn.event(ev, source, s.ctx);
+        break;
+    }
+  }
 }
 
 // --- MIDI Output (via any transport that supports sending) ---
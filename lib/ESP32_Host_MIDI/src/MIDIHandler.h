@@ -1,11 +1,13 @@
 #ifndef MIDI_HANDLER_H
 #define MIDI_HANDLER_H
 
-#include <deque>
-#include <map>
 #include <string>
-#include <unordered_map>
 #include <vector>
+#include "MIDIEvent.h"
+#include "MIDINoteSet.h"
+#include "MIDIChordIndex.h"
+#include "MIDISysEx.h"
+#include "MIDIRouter.h"
 #include "MIDIHandlerConfig.h"
 #include "MIDITransport.h"
 
@@ -45,6 +47,11 @@
   #endif
 #endif
 
+// Transports MIDIHandler can drive (built-in ones included).
+#ifndef ESP32_HOST_MIDI_MAX_TRANSPORTS
+  #define ESP32_HOST_MIDI_MAX_TRANSPORTS 8
+#endif
+
 #if ESP32_HOST_MIDI_HAS_USB
   #include "USBConnection.h"
 #endif
@@ -53,22 +60,6 @@
   #include "BLEConnection.h"
 #endif
 
-// Structure representing a parsed MIDI event using MIDI 1.0 terminology.
-struct MIDIEventData {
-  int index;                // Global event counter
-  int msgIndex;             // Index linking NoteOn/NoteOff pairs
-  unsigned long timestamp;  // Timestamp in milliseconds (millis())
-  unsigned long delay;      // Delta time (ms) since previous event
-  int channel;              // MIDI channel (1-16)
-  std::string status;       // Status type: "NoteOn", "NoteOff", "ControlChange", "ProgramChange", "PitchBend", "ChannelPressure"
-  int note;                 // MIDI note number (or controller number for ControlChange)
-  std::string noteName;     // Musical note name (e.g., "C", "D#") — empty for non-note messages
-  std::string noteOctave;   // Note with octave (e.g., "C4", "D#5") — empty for non-note messages
-  int velocity;             // Velocity (or CC value, program number, or pressure value)
-  int chordIndex;           // Chord grouping index (simultaneous notes share the same index)
-  int pitchBend;            // Pitch Bend value (14-bit, 0-16383, center = 8192). 0 for other types.
-};
-
 class MIDIHandler {
 public:
   MIDIHandler();
@@ -78,12 +69,59 @@ public:
   void begin(const MIDIHandlerConfig& config);
   void task();
   void enableHistory(int capacity);
-  void addEvent(const MIDIEventData& event);
+  void addEvent(const MIDIEvent& event);
+  void addEvent(const MIDIEventData& event);  // legacy: converted to MIDIEvent
   void processQueue();
   void setQueueLimit(int maxEvents);
-  const std::deque<MIDIEventData>& getQueue() const;
+  const MIDIEventQueue& getQueue() const;
+  const MIDIEventQueue& getHistory() const { return historyQueue; }
+
+  // Legacy string view of queue entry i (0 = oldest). Allocates; meant for
+  // printing, not for per-event processing.
+  MIDIEventData getEventData(size_t i) const;
 
   void handleMidiMessage(const uint8_t* data, size_t length);
+  // timestamp: arrival time in micros(); source: transport it came from (may be nullptr).
+  void handleMidiMessage(const uint8_t* data, size_t length, uint32_t timestamp, MIDITransport* source);
+  // Raw SysEx bytes in arrival order: F0 opens a message, F7 closes it.
+  // Chunks from different sources are reassembled independently.
+  void handleSysExChunk(const uint8_t* data, size_t length, uint32_t timestamp, MIDITransport* source);
+
+  // Push-style callbacks. Called from task(), right after the message has been
+  // parsed and stored, so getActiveNoteSet() etc. already reflect it.
+  // timestamp is the arrival time in micros(), stamped by the transport.
+  // channel: 1-16, 0 = any channel. source: one transport, nullptr = any.
+  // Each on*() returns an id for removeCallback(), or -1 if all
+  // MAX_SUBSCRIPTIONS slots are taken.
+  typedef void (*NoteCallback)(uint8_t channel, uint8_t note, uint8_t velocity, uint32_t timestamp);
+  typedef void (*ControlChangeCallback)(uint8_t channel, uint8_t controller, uint8_t value, uint32_t timestamp);
+  typedef void (*ProgramChangeCallback)(uint8_t channel, uint8_t program, uint32_t timestamp);
+  typedef void (*ChannelPressureCallback)(uint8_t channel, uint8_t pressure, uint32_t timestamp);
+  typedef void (*PitchBendCallback)(uint8_t channel, int value, uint32_t timestamp);  // value: -8192 to 8191
+  typedef void (*EventCallback)(const MIDIEvent& event, MIDITransport* source, void* ctx);
+  // Whole message, F0 ... F7; timestamp is the arrival of the F0.
+  typedef void (*SysExCallback)(const uint8_t* data, size_t length, uint32_t timestamp);
+  // Chunks as they arrive, before the message is complete. data points into
+  // the transport's receive buffer and is only valid during the call.
+  typedef void (*SysExChunkCallback)(const uint8_t* data, size_t length, bool first, bool last, uint32_t timestamp);
+
+  int onNoteOn(NoteCallback cb, uint8_t channel = 0, MIDITransport* source = nullptr);
+  int onNoteOff(NoteCallback cb, uint8_t channel = 0, MIDITransport* source = nullptr);  // includes NoteOn velocity 0
+  int onControlChange(ControlChangeCallback cb, uint8_t channel = 0, MIDITransport* source = nullptr);
+  int onProgramChange(ProgramChangeCallback cb, uint8_t channel = 0, MIDITransport* source = nullptr);
+  int onChannelPressure(ChannelPressureCallback cb, uint8_t channel = 0, MIDITransport* source = nullptr);
+  int onPitchBend(PitchBendCallback cb, uint8_t channel = 0, MIDITransport* source = nullptr);
+  // Every stored message, with its source transport and a user pointer.
+  int onEvent(EventCallback cb, void* ctx = nullptr, uint8_t channel = 0, MIDITransport* source = nullptr);
+  // Complete SysEx up to config.sysExMaxSize bytes. Needs no channel filter.
+  int onSysEx(SysExCallback cb, MIDITransport* source = nullptr);
+  // Every SysEx chunk, any length, without buffering.
+  int onSysExChunk(SysExChunkCallback cb, MIDITransport* source = nullptr);
+  void removeCallback(int id);
+
+  // SysEx messages not delivered whole: over the size cap, or cut short by
+  // another message or a new F0.
+  uint32_t getSysExDropCount() const { return sysExDrops; }
 
   // Debug callback — called with raw MIDI bytes before parsing.
   // Set to nullptr to disable. Signature: (rawData, rawLength, midiBytes3)
@@ -97,6 +135,19 @@ public:
   size_t getActiveNotesCount() const;
   void fillActiveNotes(bool out[128]) const;
   void clearActiveNotesNow();
+
+  // Allocation-free active note state.
+  // Notes held on any channel / on one channel (1-16).
+  const MIDINoteSet& getActiveNoteSet() const { return heldNotes; }
+  const MIDINoteSet& getActiveNoteSet(uint8_t channel) const { return channelNotes[(channel - 1) & 0x0F]; }
+  bool isNoteActive(uint8_t note) const { return heldNotes.test(note); }
+  bool isNoteActive(uint8_t channel, uint8_t note) const { return channelNotes[(channel - 1) & 0x0F].test(note); }
+  // NoteOn velocity of a held note, 0 if it is not held on that channel.
+  uint8_t getNoteVelocity(uint8_t channel, uint8_t note) const;
+  // Writes "{C, E, G}" into buf (truncated to len). Returns the length written.
+  size_t formatActiveNotes(char* buf, size_t len) const;
+  // Fills a typed snapshot of the held notes. Returns false if none are held.
+  bool getActiveChord(MIDIChordSnapshot& out) const;
   void clearQueue();
 
   // Register an external transport (ESP-NOW, RTP-MIDI, custom, etc.).
@@ -104,6 +155,11 @@ public:
   // MIDIHandler will call task() on it and receive data via callbacks.
   void addTransport(MIDITransport* transport);
 
+  // Thru: routes received messages to other transports as they are drained
+  // in task(), before they are parsed. See MIDIRouter / MIDIRoute.
+  //   midiHandler.getRouter().addRoute(&usbIn, &uartOut, MIDI_ROUTE_NOTES);
+  MIDIRouter& getRouter() { return router; }
+
   // MIDI Output — send via any transport that supports sending.
   // channel: 1-16. Returns true if any transport sent the message.
   bool sendNoteOn(uint8_t channel, uint8_t note, uint8_t velocity);
@@ -118,9 +174,16 @@ public:
   bool isBleConnected() const;
 #endif
 
-  // Chord event utility methods:
-  int lastChord(const std::deque<MIDIEventData>& queue) const;
-  std::vector<std::string> getChord(int chord, const std::deque<MIDIEventData>& queue, const std::vector<std::string>& fields = { "all" }, bool includeLabels = false) const;
+  // Chord groups indexed as notes arrive: the latest ESP32_HOST_MIDI_CHORD_HISTORY
+  // chords with their notes and timing, without scanning the queue.
+  //   const MIDIChord* c = midiHandler.getLastChord();
+  //   MIDIChordIndex::format(*c, MIDI_CHORD_NOTE_OCTAVE, buf, sizeof(buf));
+  const MIDIChordIndex& getChords() const { return chords; }
+  const MIDIChord* getLastChord() const { return chords.recent(0); }
+
+  // Chord event utility methods (string based; allocate on every call):
+  int lastChord(const MIDIEventQueue& queue) const;
+  std::vector<std::string> getChord(int chord, const MIDIEventQueue& queue, const std::vector<std::string>& fields = { "all" }, bool includeLabels = false) const;
   std::vector<std::string> getAnswer(const std::string& field = "all", bool includeLabels = false) const;
   std::vector<std::string> getAnswer(const std::vector<std::string>& fields, bool includeLabels = false) const;
 
@@ -128,37 +191,89 @@ private:
   MIDIHandlerConfig config;
   RawMidiCallback rawMidiCb = nullptr;
 
-  std::deque<MIDIEventData> eventQueue;
+  // Subscriptions: a fixed table, so registering and dispatching never allocate.
+  struct Subscription {
+    bool active;
+    uint8_t status;          // MIDIStatus, SUB_SYSEX_CHUNK, or MIDI_EVENT_NONE = every message (onEvent)
+    uint8_t channel;         // 1-16, 0 = any
+    MIDITransport* source;   // nullptr = any
+    void* ctx;
+    union {
+      NoteCallback note;
+      ControlChangeCallback controlChange;
+      ProgramChangeCallback programChange;
+      ChannelPressureCallback channelPressure;
+      PitchBendCallback pitchBend;
+      EventCallback event;
+      SysExCallback sysEx;
+      SysExChunkCallback sysExChunk;
+    } fn;
+  };
+  static const int MAX_SUBSCRIPTIONS = 16;
+  Subscription subscriptions[MAX_SUBSCRIPTIONS];
+  int subscriptionCount;     // slots in use, including removed ones below the highest
+
+  static const uint8_t SUB_SYSEX_CHUNK = 0xF7;
+
+  int subscribe(uint8_t status, void* ctx, uint8_t channel, MIDITransport* source);
+  void dispatchCallbacks(const MIDIEvent& event, MIDITransport* source);
+
+  MIDIEventQueue eventQueue;
   int maxEvents;
-  int globalIndex;
-  int nextMsgIndex;
-  unsigned long lastTimestamp;
-  unsigned long lastNoteOnTimestamp;
+  int32_t globalIndex;
+  uint16_t nextMsgIndex;
+  uint32_t lastTimestamp;        // micros() of the previous event
+  uint32_t lastNoteOnTimestamp;  // micros() of the previous NoteOn
 
-  std::unordered_map<int, int> activeNotes;
-  std::unordered_map<int, int> activeMsgIndex;
+  // Active notes: a 128-bit set per channel plus their union. noteChannels
+  // says which channels hold each note, so the union updates in O(1).
+  MIDINoteSet channelNotes[16];
+  MIDINoteSet heldNotes;
+  uint16_t noteChannels[128];
+  uint8_t noteVelocity[16][128];
+  uint16_t noteChord[128];
+  uint16_t noteMsgIndex[128];
+  uint32_t chordStartTime;  // micros() of the current chord's first NoteOn
 
-  int nextChordIndex;
-  int currentChordIndex;
+  uint16_t nextChordIndex;
+  uint16_t currentChordIndex;
+  MIDIChordIndex chords;
 
   // History buffer (PSRAM when available, heap otherwise)
-  MIDIEventData* historyQueue;
-  int historyQueueCapacity;
-  int historyQueueSize;
-  int historyQueueHead;
+  MIDIEventQueue historyQueue;
 
   void expandHistoryQueue();
+  void releaseNote(uint8_t channel, uint8_t note, uint16_t& msgIndex, uint16_t& chordIdx);
 
   std::string getNoteName(int note) const;
   std::string getNoteWithOctave(int note) const;
 
   // --- Transport abstraction ---
-  static const int MAX_TRANSPORTS = 4;
+  static const int MAX_TRANSPORTS = ESP32_HOST_MIDI_MAX_TRANSPORTS;
+  static_assert(MAX_TRANSPORTS < 32, "sysExActive holds one bit per transport");
   MIDITransport* transports[MAX_TRANSPORTS];
   int transportCount;
 
+  // SysEx reassembly, one buffer per transport slot plus one for messages
+  // fed without a source. Bit n of sysExActive = sysEx[n] is mid-message.
+  MIDISysExBuffer sysEx[MAX_TRANSPORTS + 1];
+  uint32_t sysExActive;
+  uint32_t sysExDrops;
+  int sysExSlot(MIDITransport* source) const;
+  void abortSysEx(int slot);
+
+  MIDIRouter router;
+
   void registerTransport(MIDITransport* t);
+  // handleMidiMessage() without the thru step.
+  void parseMidiMessage(const uint8_t* data, size_t length, uint32_t timestamp, MIDITransport* source);
   static void _onTransportMidiData(void* ctx, const uint8_t* data, size_t len);
+  static void _onTransportMidiStamped(void* ctx, MIDITransport* source,
+                                     const uint8_t* data, size_t len, uint32_t timestamp);
+  static void _onTransportSysEx(void* ctx, MIDITransport* source,
+                               const uint8_t* data, size_t len, uint32_t timestamp);
+  static void _onTransportMidiBatch(void* ctx, MIDITransport* source,
+                                    const MIDIPacket* packets, size_t count);
   static void _onTransportDisconnected(void* ctx);
 
   // Built-in transports (owned by MIDIHandler, registered automatically in begin())
@@ -1,6 +1,8 @@
 #ifndef MIDI_HANDLER_CONFIG_H
 #define MIDI_HANDLER_CONFIG_H
 
+#include <cstddef>
+
 // Configuration structure for MIDIHandler behavior.
 // Create an instance, modify the desired fields, and pass it to midiHandler.begin(config).
 // All fields have sensible defaults — you only need to change what you want to calibrate.
@@ -43,8 +45,19 @@ struct MIDIHandlerConfig {
     // Initial capacity for the PSRAM history buffer.
     // Set to 0 to disable history (default).
     // Set to a positive value to enable history on begin().
+    // The buffer doubles when full; to keep a whole session, stream it to
+    // a card with MIDIFileWriter (MIDIFile.h) instead.
     int historyCapacity = 0;
 
+    // --- SysEx ---
+
+    // Largest SysEx message (bytes, F0 and F7 included) reassembled for
+    // midiHandler.onSysEx(). The buffer is allocated per transport on its
+    // first SysEx, in PSRAM when available. Longer messages are still
+    // streamed to onSysExChunk() but not delivered whole.
+    // Set to 0 to disable reassembly (chunk callbacks keep working).
+    size_t sysExMaxSize = 512;
+
     // --- BLE Configuration ---
 
     // BLE device name used when advertising.
@@ -0,0 +1,80 @@
+#ifndef MIDI_NOTE_SET_H
+#define MIDI_NOTE_SET_H
+
+#include <cstdint>
+#include <cstring>
+
+// 128-bit set of MIDI note numbers (0-127). O(1) set/clear/test,
+// popcount-based size and allocation-free iteration in ascending order:
+//
+//   for (int n = set.first(); n >= 0; n = set.next(n)) { ... }
+struct MIDINoteSet {
+  uint32_t words[4];
+
+  MIDINoteSet() { clear(); }
+
+  void clear() { memset(words, 0, sizeof(words)); }
+  void set(uint8_t note) { words[(note >> 5) & 3] |= (1u << (note & 31)); }
+  void reset(uint8_t note) { words[(note >> 5) & 3] &= ~(1u << (note & 31)); }
+  bool test(uint8_t note) const { return (words[(note >> 5) & 3] >> (note & 31)) & 1; }
+
+  bool empty() const { return (words[0] | words[1] | words[2] | words[3]) == 0; }
+  int count() const {
+    return __builtin_popcount(words[0]) + __builtin_popcount(words[1]) +
+           __builtin_popcount(words[2]) + __builtin_popcount(words[3]);
+  }
+
+  // Lowest note in the set, or -1 if empty.
+  int first() const { return next(-1); }
+
+  // Lowest note above 'after', or -1 if none.
+  int next(int after) const {
+    int n = after + 1;
+    if (n >= 128) return -1;
+    int w = n >> 5;
+    uint32_t bits = words[w] & (~0u << (n & 31));
+    while (true) {
+      if (bits) return (w << 5) + __builtin_ctz(bits);
+      if (++w == 4) return -1;
+      bits = words[w];
+    }
+  }
+
+  // Highest note in the set, or -1 if empty.
+  int last() const {
+    for (int w = 3; w >= 0; w--) {
+      if (words[w]) return (w << 5) + 31 - __builtin_clz(words[w]);
+    }
+    return -1;
+  }
+
+  // 12-bit pitch-class mask: bit 0 = C, bit 1 = C#, ... bit 11 = B.
+  uint16_t pitchClasses() const {
+    uint16_t mask = 0;
+    for (int n = first(); n >= 0; n = next(n)) mask |= 1 << (n % 12);
+    return mask;
+  }
+
+  MIDINoteSet& operator|=(const MIDINoteSet& o) {
+    for (int i = 0; i < 4; i++) words[i] |= o.words[i];
+    return *this;
+  }
+  bool operator==(const MIDINoteSet& o) const { return memcmp(words, o.words, sizeof(words)) == 0; }
+  bool operator!=(const MIDINoteSet& o) const { return !(*this == o); }
+};
+
+// Typed snapshot of the notes currently held, for chord analysis without
+// going through note-name strings (see GingoAdapter::identifyActiveChord).
+struct MIDIChordSnapshot {
+  static const uint8_t MAX_NOTES = 16;
+
+  uint16_t chordIndex;             // Chord grouping index (0 when nothing is held)
+  uint8_t count;                   // Notes in notes[] (lowest MAX_NOTES if more are held)
+  uint8_t totalHeld;               // All notes held, may exceed MAX_NOTES
+  uint8_t notes[MAX_NOTES];        // MIDI note numbers, ascending
+  uint8_t velocities[MAX_NOTES];   // NoteOn velocity of each note
+  uint16_t pitchClasses;           // Bit n set = pitch class n is held (C = bit 0)
+  uint32_t startTime;              // micros() of the chord's first NoteOn
+};
+
+#endif  // MIDI_NOTE_SET_H
@@ -0,0 +1,122 @@
+#include <Arduino.h>
+#include <cmath>
+#include "MIDIRouter.h"
+
+int MIDIRouter::addRoute(const MIDIRoute& route) {
+  if (!route.dest) return -1;
+  for (int i = 0; i < MAX_ROUTES; i++) {
+    if (routes[i].active) continue;
+    routes[i].active = true;
+    routes[i].route = route;
+    if (i >= routeCount) routeCount = i + 1;
+    return i;
+  }
+  Serial.println("MIDI route table full!");
+  return -1;
+}
+
+int MIDIRouter::addRoute(MIDITransport* source, MIDITransport* dest, uint16_t types) {
+  MIDIRoute route;
+  route.source = source;
+  route.dest = dest;
+  route.types = types;
+  return addRoute(route);
+}
+
+void MIDIRouter::removeRoute(int id) {
+  if (id < 0 || id >= MAX_ROUTES) return;
+  routes[id].active = false;
+  while (routeCount > 0 && !routes[routeCount - 1].active) routeCount--;
+}
+
+void MIDIRouter::clear() {
+  for (int i = 0; i < MAX_ROUTES; i++) routes[i].active = false;
+  routeCount = 0;
+}
+
+MIDIRoute* MIDIRouter::getRoute(int id) {
+  if (id < 0 || id >= MAX_ROUTES || !routes[id].active) return nullptr;
+  return &routes[id].route;
+}
+
+void MIDIRouter::buildVelocityCurve(uint8_t table[128], float gamma) {
+  table[0] = 0;
+  for (int v = 1; v < 128; v++) {
+    float out = 1.0f + 126.0f * powf(v / 127.0f, gamma);
+    table[v] = (uint8_t)(out + 0.5f);
+  }
+}
+
+void MIDIRouter::forward(const uint8_t* data, size_t length, MIDITransport* source) {
+  if (length >= 4) {
+    // USB-MIDI event: CIN 0x4-0x7 are SysEx frames, forwarded whole later.
+    uint8_t cin = data[0] & 0x0F;
+    if (cin >= 0x4 && cin <= 0x7 && !(cin == 0x5 && data[1] != 0xF7)) return;
+    if (cin < 0x2) return;  // Reserved / cable events
+    // Message length from the CIN: 0x2, 0xC, 0xD = 2 bytes; 0x5, 0xF = 1 byte
+    static const uint8_t cinLength[16] = { 0, 0, 2, 3, 3, 1, 2, 3, 3, 3, 3, 3, 2, 2, 3, 1 };
+    forwardMessage(data + 1, cinLength[cin], source);
+  } else if (length > 0 && data[0] != 0xF0) {
+    forwardMessage(data, length, source);
+  }
+}
+
+void MIDIRouter::forwardMessage(const uint8_t* msg, size_t length, MIDITransport* source) {
+  uint8_t status = msg[0];
+  if (status < 0x80 || status == 0xF7) return;
+
+  uint16_t type;
+  int ch = -1;
+  if (status < 0xF0) {
+    type = 1u << ((status >> 4) - 8);
+    ch = status & 0x0F;
+  } else {
+    type = (status >= 0xF8) ? MIDI_ROUTE_REALTIME : MIDI_ROUTE_SYSTEM_COMMON;
+  }
+
+  bool matched = false;
+  for (int i = 0; i < routeCount; i++) {
+    if (!routes[i].active) continue;
+    const MIDIRoute& r = routes[i].route;
+    if (r.source && r.source != source) continue;
+    if (r.dest == source) continue;  // Never echo back
+    if (!(r.types & type)) continue;
+    if (ch >= 0 && !(r.channels & (1u << ch))) continue;
+    matched = true;
+
+    const uint8_t* out = msg;
+    uint8_t buf[3];
+    if (ch >= 0 && (r.outChannel || r.transpose || r.velocityCurve)) {
+      memcpy(buf, msg, length < sizeof(buf) ? length : sizeof(buf));
+      if (r.outChannel) buf[0] = (status & 0xF0) | ((r.outChannel - 1) & 0x0F);
+      if (r.transpose && (type & (MIDI_ROUTE_NOTES | MIDI_ROUTE_POLY_PRESSURE))) {
+        int note = buf[1] + r.transpose;
+        if (note < 0 || note > 127) continue;  // No octave folding: it would leave notes hanging
+        buf[1] = note;
+      }
+      if (r.velocityCurve && type == MIDI_ROUTE_NOTE_ON && buf[2] > 0) {
+        uint8_t v = r.velocityCurve[buf[2] & 0x7F];
+        buf[2] = v ? (v & 0x7F) : 1;  // A NoteOn must not turn into a NoteOff
+      }
+      out = buf;
+    }
+
+    if (r.dest->sendMidiMessage(out, length)) forwarded++;
+    else sendFailures++;
+  }
+  if (!matched) filtered++;
+}
+
+void MIDIRouter::forwardSysEx(const uint8_t* data, size_t length, MIDITransport* source) {
+  bool matched = false;
+  for (int i = 0; i < routeCount; i++) {
+    if (!routes[i].active) continue;
+    const MIDIRoute& r = routes[i].route;
+    if (r.source && r.source != source) continue;
+    if (r.dest == source || !(r.types & MIDI_ROUTE_SYSEX)) continue;
+    matched = true;
+    if (r.dest->sendMidiMessage(data, length)) forwarded++;
+    else sendFailures++;
+  }
+  if (!matched) filtered++;
+}
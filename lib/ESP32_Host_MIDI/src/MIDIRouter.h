@@ -0,0 +1,89 @@
+#ifndef MIDI_ROUTER_H
+#define MIDI_ROUTER_H
+
+#include <cstdint>
+#include <cstddef>
+#include "MIDITransport.h"
+
+// Message classes for MIDIRoute::types. Channel messages use bit
+// (status >> 4) - 8, so NoteOff = bit 0 ... PitchBend = bit 6.
+enum : uint16_t {
+  MIDI_ROUTE_NOTE_OFF         = 1 << 0,
+  MIDI_ROUTE_NOTE_ON          = 1 << 1,
+  MIDI_ROUTE_POLY_PRESSURE    = 1 << 2,
+  MIDI_ROUTE_CONTROL_CHANGE   = 1 << 3,
+  MIDI_ROUTE_PROGRAM_CHANGE   = 1 << 4,
+  MIDI_ROUTE_CHANNEL_PRESSURE = 1 << 5,
+  MIDI_ROUTE_PITCH_BEND       = 1 << 6,
+  MIDI_ROUTE_SYSEX            = 1 << 7,  // Forwarded once complete (see sysExMaxSize)
+  MIDI_ROUTE_SYSTEM_COMMON    = 1 << 8,  // F1-F6
+  MIDI_ROUTE_REALTIME         = 1 << 9,  // F8-FF: clock, start, stop...
+
+  MIDI_ROUTE_NOTES            = MIDI_ROUTE_NOTE_OFF | MIDI_ROUTE_NOTE_ON,
+  MIDI_ROUTE_CHANNEL          = 0x007F,
+  MIDI_ROUTE_ALL              = 0x03FF,
+};
+
+// One entry of the routing matrix: what goes from source to dest, and how
+// it is rewritten on the way. Defaults forward everything unchanged.
+struct MIDIRoute {
+  MIDITransport* source = nullptr;          // nullptr = any input
+  MIDITransport* dest = nullptr;            // Never sent back to the transport it came from
+  uint16_t channels = 0xFFFF;               // Bit n = channel n+1 passes
+  uint16_t types = MIDI_ROUTE_ALL;          // MIDI_ROUTE_* bits that pass
+  int8_t transpose = 0;                     // Semitones for notes and poly pressure; out of range = dropped
+  uint8_t outChannel = 0;                   // 1-16 = rechannelize, 0 = keep
+  const uint8_t* velocityCurve = nullptr;   // 128-entry NoteOn velocity table, nullptr = unchanged
+};
+
+// Source-to-destination matrix for MIDI thru. MIDIHandler calls forward()
+// for every packet it drains from a transport, before parsing or queueing
+// it, so thru latency doesn't depend on how much work the handler does.
+// Sends run on the task() thread, one whole message at a time, so several
+// routes into one output merge without interleaving bytes.
+class MIDIRouter {
+public:
+  static const int MAX_ROUTES = 16;
+
+  MIDIRouter() : routeCount(0), forwarded(0), filtered(0), sendFailures(0) { clear(); }
+
+  // Returns the route id, or -1 if the table is full or dest is missing.
+  int addRoute(const MIDIRoute& route);
+  // Convenience: forward everything (types) from source to dest.
+  int addRoute(MIDITransport* source, MIDITransport* dest, uint16_t types = MIDI_ROUTE_ALL);
+  void removeRoute(int id);
+  void clear();
+  // nullptr for unused ids. Edits take effect with the next message.
+  MIDIRoute* getRoute(int id);
+
+  bool empty() const { return routeCount == 0; }
+
+  // A packet as drained from source: a 4-byte USB-MIDI event or raw MIDI bytes.
+  // USB SysEx frames are skipped; whole SysEx goes through forwardSysEx().
+  void forward(const uint8_t* data, size_t length, MIDITransport* source);
+  void forwardSysEx(const uint8_t* data, size_t length, MIDITransport* source);
+
+  // Fills table with out = 1 + 126 * (in / 127) ^ gamma for in > 0 (0 stays 0).
+  // gamma < 1 lifts soft playing, > 1 tames it.
+  static void buildVelocityCurve(uint8_t table[128], float gamma);
+
+  // Messages sent / dropped by every route's filters / refused by a destination.
+  uint32_t getForwardedCount() const { return forwarded; }
+  uint32_t getFilteredCount() const { return filtered; }
+  uint32_t getSendFailures() const { return sendFailures; }
+
+private:
+  struct Slot {
+    bool active;
+    MIDIRoute route;
+  };
+  Slot routes[MAX_ROUTES];
+  int routeCount;  // Slots in use, including removed ones below the highest
+  uint32_t forwarded;
+  uint32_t filtered;
+  uint32_t sendFailures;
+
+  void forwardMessage(const uint8_t* msg, size_t length, MIDITransport* source);
+};
+
+#endif  // MIDI_ROUTER_H
@@ -0,0 +1,57 @@
+#include <Arduino.h>
+#include "MIDIHandler.h"
+
+#if ESP32_HOST_MIDI_HAS_PSRAM
+  #include "esp_heap_caps.h"
+#endif
+
+MIDISysExBuffer::~MIDISysExBuffer() {
+  release();
+}
+
+void MIDISysExBuffer::setLimit(size_t maxSize, bool psram) {
+  if (maxSize != limit) release();
+  limit = maxSize;
+  preferPsram = psram;
+}
+
+void MIDISysExBuffer::release() {
+  free(buf);
+  buf = nullptr;
+  cap = 0;
+  len = 0;
+  active = false;
+}
+
+void MIDISysExBuffer::begin(uint32_t timestamp) {
+  active = true;
+  overflowed = false;
+  len = 0;
+  start = timestamp;
+
+  // Allocated once, on the first message, at the full cap: appending never allocates.
+  if (!buf && limit > 0) {
+#if ESP32_HOST_MIDI_HAS_PSRAM
+    if (preferPsram) {
+      buf = static_cast<uint8_t*>(heap_caps_malloc(limit, MALLOC_CAP_SPIRAM));
+    }
+#endif
+    if (!buf) buf = static_cast<uint8_t*>(malloc(limit));
+    if (!buf) {
+      Serial.println("Failed to allocate SysEx buffer!");
+      return;
+    }
+    cap = limit;
+  }
+}
+
+bool MIDISysExBuffer::append(const uint8_t* data, size_t length) {
+  if (overflowed) return false;
+  if (!buf || len + length > cap) {
+    overflowed = true;
+    return false;
+  }
+  memcpy(buf + len, data, length);
+  len += length;
+  return true;
+}
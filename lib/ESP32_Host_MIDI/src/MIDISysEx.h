@@ -0,0 +1,46 @@
+#ifndef MIDI_SYSEX_H
+#define MIDI_SYSEX_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Reassembles one SysEx message (F0 ... F7) from the chunks a transport
+// delivers. The buffer is allocated on the first SysEx, bounded by the size
+// cap, and placed in PSRAM when the board has it. Messages longer than the
+// cap are still streamed as chunks by MIDIHandler but not kept whole.
+class MIDISysExBuffer {
+public:
+  MIDISysExBuffer() : buf(nullptr), cap(0), limit(0), len(0), start(0),
+                      active(false), overflowed(false), preferPsram(false) {}
+  ~MIDISysExBuffer();
+  MIDISysExBuffer(const MIDISysExBuffer&) = delete;
+  MIDISysExBuffer& operator=(const MIDISysExBuffer&) = delete;
+
+  // Largest message kept whole (bytes, F0 and F7 included). 0 = don't reassemble.
+  void setLimit(size_t maxSize, bool preferPsram = true);
+  void release();
+
+  // Starts a new message at 'timestamp'. Any message in progress is dropped.
+  void begin(uint32_t timestamp);
+  // Appends a chunk. Returns false once the message exceeds the cap.
+  bool append(const uint8_t* data, size_t length);
+  void end() { active = false; }
+
+  bool inProgress() const { return active; }
+  bool complete() const { return !overflowed && limit > 0; }  // valid after the last chunk
+  const uint8_t* data() const { return buf; }
+  size_t size() const { return len; }
+  uint32_t startTime() const { return start; }
+
+private:
+  uint8_t* buf;
+  size_t cap;
+  size_t limit;
+  size_t len;
+  uint32_t start;
+  bool active;
+  bool overflowed;
+  bool preferPsram;
+};
+
+#endif  // MIDI_SYSEX_H
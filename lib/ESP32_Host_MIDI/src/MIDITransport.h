@@ -1,8 +1,98 @@
 #ifndef MIDI_TRANSPORT_H
 #define MIDI_TRANSPORT_H
 
+#include <Arduino.h>
+#include <atomic>
 #include <cstdint>
 #include <cstddef>
+#include <cstring>
+
+// MIDIPacket::flags
+enum : uint8_t {
+    // data is a run of raw SysEx bytes: starts with F0 on the first chunk,
+    // ends with F7 on the last one, plain data bytes in between.
+    MIDI_PACKET_SYSEX = 0x01,
+};
+
+// One raw message as received by a transport: a 4-byte USB-MIDI event
+// (CIN + 3 MIDI bytes), 1-18 raw MIDI bytes from BLE/UART/ESP-NOW/RTP,
+// or a SysEx chunk (MIDI_PACKET_SYSEX).
+struct MIDIPacket {
+    uint32_t timestamp;  // micros() when the transport received it
+    uint8_t data[18];
+    uint8_t length;
+    uint8_t flags;       // MIDI_PACKET_* bits
+};
+
+// Wait-free single-producer/single-consumer ring of MIDIPackets.
+// The producer (USB/BLE/WiFi task, or the transport's own parser) calls push();
+// the consumer (task() on the main loop) calls peek()/consume().
+// No locks and no critical sections: head is written only by the producer,
+// tail only by the consumer. N must be a power of two.
+template <size_t N>
+class MIDIPacketRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MIDIPacketRing size must be a power of two");
+
+public:
+    // Producer side. timestamp is the arrival time (micros()), taken by the
+    // caller as close to reception as possible.
+    // Returns false (and counts an overflow) when full.
+    bool push(const uint8_t* data, size_t length, uint32_t timestamp, uint8_t flags = 0) {
+        uint32_t h = _head.load(std::memory_order_relaxed);
+        if (h - _tail.load(std::memory_order_acquire) >= N) {
+            _overflows.store(_overflows.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        MIDIPacket& p = _buf[h & (N - 1)];
+        size_t n = (length > sizeof(p.data)) ? sizeof(p.data) : length;
+        memcpy(p.data, data, n);
+        p.length = (uint8_t)n;
+        p.timestamp = timestamp;
+        p.flags = flags;
+        _head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Points first at the oldest packet and returns how many
+    // packets follow it contiguously (0 if empty). Call again after consume()
+    // to get the part that wrapped around.
+    size_t peek(const MIDIPacket*& first) const {
+        uint32_t t = _tail.load(std::memory_order_relaxed);
+        size_t avail = _head.load(std::memory_order_acquire) - t;
+        size_t toEnd = N - (t & (N - 1));
+        first = &_buf[t & (N - 1)];
+        return (avail < toEnd) ? avail : toEnd;
+    }
+
+    // Consumer side. Releases n packets returned by peek().
+    void consume(size_t n) {
+        _tail.store(_tail.load(std::memory_order_relaxed) + (uint32_t)n, std::memory_order_release);
+    }
+
+    // Consumer side. Drops everything pushed so far.
+    void discard() {
+        _tail.store(_head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    size_t size() const {
+        return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+    }
+    static constexpr size_t capacity() { return N; }
+
+    // Packets dropped because the consumer fell behind.
+    uint32_t overflowCount() const { return _overflows.load(std::memory_order_relaxed); }
+
+    // Consumer-side debug access; i = 0 is the oldest pending packet.
+    const MIDIPacket& at(size_t i) const {
+        return _buf[(_tail.load(std::memory_order_relaxed) + i) & (N - 1)];
+    }
+
+private:
+    MIDIPacket _buf[N];
+    std::atomic<uint32_t> _head{0};       // free-running, written by the producer
+    std::atomic<uint32_t> _tail{0};       // free-running, written by the consumer
+    std::atomic<uint32_t> _overflows{0};  // written by the producer
+};
 
 // Abstract base class for MIDI transports.
 // USB, BLE, ESP-NOW, RTP-MIDI — any transport implements this interface.
@@ -18,6 +108,13 @@
 class MIDITransport {
 public:
     typedef void (*MIDIDataCallback)(void* context, const uint8_t* data, size_t length);
+    typedef void (*MIDIStampedCallback)(void* context, MIDITransport* source,
+                                        const uint8_t* data, size_t length, uint32_t timestamp);
+    // A SysEx chunk, see MIDI_PACKET_SYSEX. data stays valid only during the call.
+    typedef void (*MIDISysExCallback)(void* context, MIDITransport* source,
+                                      const uint8_t* data, size_t length, uint32_t timestamp);
+    typedef void (*MIDIBatchCallback)(void* context, MIDITransport* source,
+                                      const MIDIPacket* packets, size_t count);
     typedef void (*ConnectionCallback)(void* context);
 
     virtual ~MIDITransport() = default;
@@ -30,18 +127,67 @@ public:
     // Returns true if the message was sent successfully.
     virtual bool sendMidiMessage(const uint8_t* data, size_t length) { return false; }
 
+    // Incoming packets dropped because the ingress ring was full.
+    virtual uint32_t getOverflowCount() const { return 0; }
+
     // Callback registration — used by MIDIHandler to receive data and events.
     void setMidiCallback(MIDIDataCallback cb, void* ctx) {
         _midiCb = cb; _midiCtx = ctx;
     }
+    // Optional: receive each message with its source and arrival time (µs).
+    // Takes precedence over the plain MIDI callback when set.
+    void setMidiStampedCallback(MIDIStampedCallback cb, void* ctx) {
+        _stampedCb = cb; _stampedCtx = ctx;
+    }
+    // Optional: receive SysEx chunks. Without it, SysEx is dropped.
+    void setSysExCallback(MIDISysExCallback cb, void* ctx) {
+        _sysExCb = cb; _sysExCtx = ctx;
+    }
+    // Optional: receive whole spans of packets drained from the ingress ring.
+    // Without it, drained packets are delivered one by one to the callbacks above.
+    void setMidiBatchCallback(MIDIBatchCallback cb, void* ctx) {
+        _batchCb = cb; _batchCtx = ctx;
+    }
     void setConnectionCallbacks(ConnectionCallback onConn, ConnectionCallback onDisconn, void* ctx) {
         _onConnect = onConn; _onDisconnect = onDisconn; _connCtx = ctx;
     }
 
 protected:
     // Transport implementations call these to deliver data/events to the consumer.
+    // Transports that parse in task() get the current time as arrival time;
+    // queued transports pass the time stamped when the packet was received.
     void dispatchMidiData(const uint8_t* data, size_t len) {
-        if (_midiCb) _midiCb(_midiCtx, data, len);
+        dispatchMidiData(data, len, (uint32_t)micros());
+    }
+    void dispatchMidiData(const uint8_t* data, size_t len, uint32_t timestamp) {
+        if (_stampedCb) _stampedCb(_stampedCtx, this, data, len, timestamp);
+        else if (_midiCb) _midiCb(_midiCtx, data, len);
+    }
+    void dispatchSysExData(const uint8_t* data, size_t len, uint32_t timestamp) {
+        if (_sysExCb) _sysExCb(_sysExCtx, this, data, len, timestamp);
+    }
+    void dispatchMidiBatch(const MIDIPacket* packets, size_t count) {
+        if (_batchCb) {
+            _batchCb(_batchCtx, this, packets, count);
+        } else {
+            for (size_t i = 0; i < count; i++) {
+                const MIDIPacket& p = packets[i];
+                if (p.flags & MIDI_PACKET_SYSEX) dispatchSysExData(p.data, p.length, p.timestamp);
+                else dispatchMidiData(p.data, p.length, p.timestamp);
+            }
+        }
+    }
+    // Hands everything pending in ring to the consumer, at most two spans
+    // (before and after the wrap point). Call from task().
+    template <size_t N>
+    void drainMidiRing(MIDIPacketRing<N>& ring) {
+        const MIDIPacket* first;
+        for (int pass = 0; pass < 2; pass++) {
+            size_t n = ring.peek(first);
+            if (n == 0) break;
+            dispatchMidiBatch(first, n);
+            ring.consume(n);
+        }
     }
     void dispatchConnected() { if (_onConnect) _onConnect(_connCtx); }
     void dispatchDisconnected() { if (_onDisconnect) _onDisconnect(_connCtx); }
@@ -49,6 +195,12 @@ protected:
 private:
     MIDIDataCallback _midiCb = nullptr;
     void* _midiCtx = nullptr;
+    MIDIStampedCallback _stampedCb = nullptr;
+    void* _stampedCtx = nullptr;
+    MIDISysExCallback _sysExCb = nullptr;
+    void* _sysExCtx = nullptr;
+    MIDIBatchCallback _batchCb = nullptr;
+    void* _batchCtx = nullptr;
     ConnectionCallback _onConnect = nullptr;
     ConnectionCallback _onDisconnect = nullptr;
     void* _connCtx = nullptr;
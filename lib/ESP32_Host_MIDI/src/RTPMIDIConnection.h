@@ -93,9 +93,14 @@ public:
     }
 
     // Processes incoming RTP-MIDI packets. Call from loop().
+    // The AppleMIDI callbacks only queue messages; one read() can decode a
+    // whole RTP packet, which is then dispatched as a single batch.
     void task() override {
         if (!_initialized) return;
-        _rtpMidiInternal::midi.read();
+        while (_rtpMidiInternal::midi.read()) {
+            if (_rxQueue.size() >= QUEUE_SIZE / 2) drainMidiRing(_rxQueue);
+        }
+        drainMidiRing(_rxQueue);
     }
 
     // Returns true while at least one macOS/iOS session is connected.
@@ -129,6 +134,9 @@ public:
     // Returns the number of active RTP-MIDI peer sessions.
     int connectedCount() const { return _connectedCount; }
 
+    // Messages dropped because the ingress ring was full.
+    uint32_t getOverflowCount() const override { return _rxQueue.overflowCount(); }
+
     // --- Internal helpers called by file-scope callbacks below ---
     void _handleConnected() {
         _connectedCount++;
@@ -143,30 +151,33 @@ private:
     bool _initialized;
     volatile int _connectedCount;
 
+    static const int QUEUE_SIZE = 64;
+    MIDIPacketRing<QUEUE_SIZE> _rxQueue;
+
     static void _onNoteOn(byte channel, byte note, byte velocity) {
         if (!_instance) return;
         uint8_t msg[3] = { (uint8_t)(0x90 | (channel - 1)), note, velocity };
-        _instance->dispatchMidiData(msg, 3);
+        _instance->_rxQueue.push(msg, 3, (uint32_t)micros());
     }
     static void _onNoteOff(byte channel, byte note, byte velocity) {
         if (!_instance) return;
         uint8_t msg[3] = { (uint8_t)(0x80 | (channel - 1)), note, velocity };
-        _instance->dispatchMidiData(msg, 3);
+        _instance->_rxQueue.push(msg, 3, (uint32_t)micros());
     }
     static void _onControlChange(byte channel, byte controller, byte value) {
         if (!_instance) return;
         uint8_t msg[3] = { (uint8_t)(0xB0 | (channel - 1)), controller, value };
-        _instance->dispatchMidiData(msg, 3);
+        _instance->_rxQueue.push(msg, 3, (uint32_t)micros());
     }
     static void _onProgramChange(byte channel, byte program) {
         if (!_instance) return;
         uint8_t msg[2] = { (uint8_t)(0xC0 | (channel - 1)), program };
-        _instance->dispatchMidiData(msg, 2);
+        _instance->_rxQueue.push(msg, 2, (uint32_t)micros());
     }
     static void _onAfterTouch(byte channel, byte pressure) {
         if (!_instance) return;
         uint8_t msg[2] = { (uint8_t)(0xD0 | (channel - 1)), pressure };
-        _instance->dispatchMidiData(msg, 2);
+        _instance->_rxQueue.push(msg, 2, (uint32_t)micros());
     }
     static void _onPitchBend(byte channel, int bend) {
         if (!_instance) return;
@@ -176,7 +187,7 @@ private:
             (uint8_t)(val & 0x7F),
             (uint8_t)((val >> 7) & 0x7F)
         };
-        _instance->dispatchMidiData(msg, 3);
+        _instance->_rxQueue.push(msg, 3, (uint32_t)micros());
     }
 };
 
@@ -7,16 +7,29 @@ UARTConnection::UARTConnection()
       _bufLen(0),
       _expectedLen(0),
       _runningStatus(0),
-      _inSysex(false)
+      _inSysex(false),
+      _sysexLen(0),
+      _rxTime(0),
+      _txMutex(nullptr),
+      _txRunningStatusEnabled(true),
+      _txRunningStatus(0)
 {
     memset(_buf, 0, sizeof(_buf));
 }
 
+UARTConnection::~UARTConnection() {
+    if (_txMutex) {
+        vSemaphoreDelete(_txMutex);
+        _txMutex = nullptr;
+    }
+}
+
 bool UARTConnection::begin(HardwareSerial& serialPort, int rxPin, int txPin) {
     if (_initialized) return true;
 
     _serial  = &serialPort;
     _txPin   = txPin;
+    if (txPin >= 0 && !_txMutex) _txMutex = xSemaphoreCreateMutex();
 
     // Standard MIDI serial: 31250 baud, 8 data bits, no parity, 1 stop bit.
     serialPort.begin(31250, SERIAL_8N1, rxPin, txPin);
@@ -34,9 +47,21 @@ bool UARTConnection::isConnected() const {
 
 void UARTConnection::task() {
     if (!_initialized || !_serial) return;
-    while (_serial->available()) {
-        _processByte((uint8_t)_serial->read());
+    // Read in chunks; each complete message lands in _rxQueue. Drain whenever
+    // the ring could fill so a long backlog never drops messages.
+    uint8_t chunk[32];
+    int avail;
+    while ((avail = _serial->available()) > 0) {
+        size_t n = _serial->readBytes(chunk, (avail < (int)sizeof(chunk)) ? avail : sizeof(chunk));
+        _rxTime = (uint32_t)micros();
+        for (size_t i = 0; i < n; i++) {
+            _processByte(chunk[i]);
+        }
+        if (_rxQueue.size() > QUEUE_SIZE - sizeof(chunk)) drainMidiRing(_rxQueue);
     }
+    // Hand over partial SysEx now rather than waiting for the next chunk.
+    if (_sysexLen > 0) _flushSysex();
+    drainMidiRing(_rxQueue);
 }
 
 uint8_t UARTConnection::_midiMsgLength(uint8_t statusByte) {
@@ -73,13 +98,16 @@ void UARTConnection::_processByte(uint8_t byte) {
         // even between the bytes of another message. Dispatch immediately
         // without disturbing the current accumulator state.
         if (byte >= 0xF8) {
-            dispatchMidiData(&byte, 1);
+            _rxQueue.push(&byte, 1, _rxTime);
             return;
         }
 
-        // SysEx start: ignore everything until End of SysEx (0xF7).
+        // SysEx start: collect bytes until End of SysEx (0xF7), queued in chunks.
         if (byte == 0xF0) {
+            if (_sysexLen > 0) _flushSysex();  // previous one unterminated
             _inSysex = true;
+            _sysex[0] = byte;
+            _sysexLen = 1;
             _bufLen = 0;
             _expectedLen = 0;
             return;
@@ -87,6 +115,10 @@ void UARTConnection::_processByte(uint8_t byte) {
 
         // End of SysEx.
         if (byte == 0xF7) {
+            if (_inSysex) {
+                _sysex[_sysexLen++] = byte;
+                _flushSysex();
+            }
             _inSysex = false;
             _bufLen = 0;
             _expectedLen = 0;
@@ -95,6 +127,8 @@ void UARTConnection::_processByte(uint8_t byte) {
 
         // Any other status byte while inside SysEx aborts it (protocol error
         // recovery — treat the new status as the start of a fresh message).
+        // The handler drops the unterminated message.
+        if (_sysexLen > 0) _flushSysex();
         _inSysex = false;
 
         // Start accumulating the new message.
@@ -112,13 +146,18 @@ void UARTConnection::_processByte(uint8_t byte) {
 
         // Single-byte messages are complete immediately.
         if (_expectedLen == 1) {
-            dispatchMidiData(_buf, 1);
+            _rxQueue.push(_buf, 1, _rxTime);
             _bufLen = 0;
         }
 
     } else {
         // --- Data byte ---
-        if (_inSysex) return;
+        if (_inSysex) {
+            _sysex[_sysexLen++] = byte;
+            // Leave room for the F7 so the last chunk always carries it.
+            if (_sysexLen >= SYSEX_CHUNK - 1) _flushSysex();
+            return;
+        }
 
         if (_bufLen == 0) {
             // No active status — apply running status if available.
@@ -130,7 +169,7 @@ void UARTConnection::_processByte(uint8_t byte) {
             _expectedLen = _midiMsgLength(_runningStatus);
 
             if (_bufLen >= _expectedLen) {
-                dispatchMidiData(_buf, _expectedLen);
+                _rxQueue.push(_buf, _expectedLen, _rxTime);
                 _bufLen = 0;
             }
             return;
@@ -142,7 +181,7 @@ void UARTConnection::_processByte(uint8_t byte) {
         }
 
         if (_bufLen >= _expectedLen) {
-            dispatchMidiData(_buf, _expectedLen);
+            _rxQueue.push(_buf, _expectedLen, _rxTime);
             // Keep _buf[0] (running status) but reset the accumulator
             // so the next data byte (if any) re-uses the same status.
             _bufLen = 0;
@@ -150,10 +189,41 @@ void UARTConnection::_processByte(uint8_t byte) {
     }
 }
 
+void UARTConnection::_flushSysex() {
+    _rxQueue.push(_sysex, _sysexLen, _rxTime, MIDI_PACKET_SYSEX);
+    _sysexLen = 0;
+}
+
 // ---------- Send ----------
 
 bool UARTConnection::sendMidiMessage(const uint8_t* data, size_t length) {
-    if (!_initialized || !_serial || _txPin < 0 || length == 0) return false;
+    if (!_initialized || !_serial || _txPin < 0 || !_txMutex || length == 0) return false;
+
+    // Blocks while another task's message is going out (a few ms at most at
+    // 31250 baud), so the status byte it sent or skipped stays true.
+    if (xSemaphoreTake(_txMutex, portMAX_DELAY) != pdTRUE) return false;
+
+    uint8_t status = data[0];
+    if (status >= 0x80 && status < 0xF0) {
+        if (_txRunningStatusEnabled && status == _txRunningStatus && length > 1) {
+            _serial->write(data + 1, length - 1);
+            xSemaphoreGive(_txMutex);
+            return true;
+        }
+        _txRunningStatus = status;
+    } else if (status < 0xF8) {
+        // SysEx, system common or a raw continuation: receivers drop running status.
+        // Real-time bytes (0xF8-0xFF) leave it intact.
+        _txRunningStatus = 0;
+    }
     _serial->write(data, length);
+    xSemaphoreGive(_txMutex);
     return true;
 }
+
+void UARTConnection::setRunningStatus(bool enable) {
+    if (_txMutex) xSemaphoreTake(_txMutex, portMAX_DELAY);
+    _txRunningStatusEnabled = enable;
+    _txRunningStatus = 0;
+    if (_txMutex) xSemaphoreGive(_txMutex);
+}
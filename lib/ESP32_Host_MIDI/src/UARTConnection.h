@@ -3,6 +3,8 @@
 
 #include <Arduino.h>
 #include <HardwareSerial.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 #include "MIDITransport.h"
 
 // UARTConnection — MIDI DIN-5 serial transport at 31250 baud.
@@ -20,6 +22,7 @@
 class UARTConnection : public MIDITransport {
 public:
     UARTConnection();
+    ~UARTConnection();
 
     // Configures and opens the serial port at 31250 baud (MIDI standard).
     //   serialPort : HardwareSerial instance (Serial1, Serial2, …)
@@ -36,10 +39,19 @@ public:
     // MIDI DIN-5 has no handshake — "connected" means the port is open.
     bool isConnected() const override;
 
-    // Sends raw MIDI bytes over the TX pin.
+    // Sends raw MIDI bytes over the TX pin. Safe to call from several tasks
+    // (e.g. loop() and MIDIFilePlayer's timer): each message is written whole.
     // Returns false if txPin was not configured (-1) or begin() not called.
     bool sendMidiMessage(const uint8_t* data, size_t length) override;
 
+    // Running status on output (default on): a channel message with the same
+    // status byte as the previous one is sent without it, saving a third of
+    // the bandwidth for dense note/CC streams merged onto one DIN port.
+    void setRunningStatus(bool enable);
+
+    // Parsed messages dropped because one task() call produced more than the ring holds.
+    uint32_t getOverflowCount() const override { return _rxQueue.overflowCount(); }
+
 private:
     HardwareSerial* _serial;
     bool _initialized;
@@ -50,13 +62,31 @@ private:
     uint8_t _bufLen;        // Bytes accumulated so far
     uint8_t _expectedLen;   // Total bytes expected for current message
     uint8_t _runningStatus; // Last channel status byte (running status)
-    bool _inSysex;          // True while inside a SysEx message (ignored)
+    bool _inSysex;          // True while inside a SysEx message
+
+    // SysEx bytes not yet queued; pushed as a MIDI_PACKET_SYSEX chunk when
+    // full, on F7, on an interrupting status byte, or at the end of task().
+    static const uint8_t SYSEX_CHUNK = 16;
+    uint8_t _sysex[SYSEX_CHUNK];
+    uint8_t _sysexLen;
+
+    // Complete messages parsed in this task() call, dispatched as one batch.
+    static const int QUEUE_SIZE = 64;
+    MIDIPacketRing<QUEUE_SIZE> _rxQueue;
+    uint32_t _rxTime;       // micros() when the current chunk was read
+
+    // Output, under _txMutex: the running-status decision and the write
+    // must not interleave with another task's message.
+    SemaphoreHandle_t _txMutex;
+    bool _txRunningStatusEnabled;
+    uint8_t _txRunningStatus;  // Last channel status sent, 0 = none
 
     // Returns the total byte count for a given MIDI status byte.
     uint8_t _midiMsgLength(uint8_t statusByte);
 
     // Processes one incoming byte through the state machine.
     void _processByte(uint8_t byte);
+    void _flushSysex();
 };
 
 #endif // UART_CONNECTION_H
@@ -19,9 +19,6 @@ USBConnection::USBConnection()
     deviceHandle(nullptr),
     eventFlags(0),
     midiTransfer(nullptr),
-    queueHead(0),
-    queueTail(0),
-    queueMux(portMUX_INITIALIZER_UNLOCKED),
     firstMidiReceived(false),
     isMidiDeviceConfirmed(false),
     deviceName(""),
@@ -69,50 +66,22 @@ void USBConnection::task() {
     processQueue();
 }
 
-bool USBConnection::enqueueMidiMessage(const uint8_t* data, size_t /*length*/) {
-    portENTER_CRITICAL(&queueMux);
-    int next = (queueHead + 1) % QUEUE_SIZE;
-    if (next == queueTail) {
-        // Queue full; discard the message.
-        portEXIT_CRITICAL(&queueMux);
-        return false;
-    }
-    size_t copyLength = 4;
-    memcpy(usbQueue[queueHead].data, data, copyLength);
-    usbQueue[queueHead].length = copyLength;
-    queueHead = next;
-    portEXIT_CRITICAL(&queueMux);
-    return true;
-}
-
-bool USBConnection::dequeueMidiMessage(RawUsbMessage &msg) {
-    portENTER_CRITICAL(&queueMux);
-    if (queueTail == queueHead) {
-        portEXIT_CRITICAL(&queueMux);
-        return false;
-    }
-    msg = usbQueue[queueTail];
-    queueTail = (queueTail + 1) % QUEUE_SIZE;
-    portEXIT_CRITICAL(&queueMux);
-    return true;
+bool USBConnection::enqueueMidiMessage(const uint8_t* data, size_t /*length*/, uint32_t timestamp) {
+    // Called from the USB task; never blocks. Full queue: the event is dropped and counted.
+    return usbQueue.push(data, 4, timestamp);
 }
 
 void USBConnection::processQueue() {
-    RawUsbMessage msg;
-    while (dequeueMidiMessage(msg)) {
-        dispatchMidiData(msg.data, msg.length);
-    }
+    // Hand the pending events to the handler in one or two contiguous spans.
+    drainMidiRing(usbQueue);
 }
 
 int USBConnection::getQueueSize() const {
-    int size = queueHead - queueTail;
-    if (size < 0) size += QUEUE_SIZE;
-    return size;
+    return (int)usbQueue.size();
 }
 
 const RawUsbMessage& USBConnection::getQueueMessage(int index) const {
-    int realIndex = (queueTail + index) % QUEUE_SIZE;
-    return usbQueue[realIndex];
+    return usbQueue.at(index);
 }
 
 // ---------- USB Task (core 0) ----------
@@ -174,10 +143,12 @@ void USBConnection::_clientEventCallback(const usb_host_client_event_msg_t *even
 void USBConnection::_onReceive(usb_transfer_t *transfer) {
     USBConnection *usbCon = static_cast<USBConnection*>(transfer->context);
     if (transfer->status == 0 && transfer->actual_num_bytes >= 4) {
+        // All events in one transfer arrived together
+        uint32_t now = (uint32_t)micros();
         // Iterate in 4-byte blocks (each block = 1 USB-MIDI event)
         for (int offset = 0; offset + 4 <= transfer->actual_num_bytes; offset += 4) {
             if (transfer->data_buffer[offset] == 0x00) continue;
-            usbCon->enqueueMidiMessage(transfer->data_buffer + offset, 4);
+            usbCon->enqueueMidiMessage(transfer->data_buffer + offset, 4, now);
         }
     }
     if (usbCon->isReady) {
@@ -8,12 +8,8 @@
 #include <freertos/task.h>
 #include "MIDITransport.h"
 
-// Structure to store a raw USB packet.
-// Although transfers can be up to 64 bytes, only the first 4 are relevant per USB-MIDI event.
-struct RawUsbMessage {
-    uint8_t data[64];
-    size_t length;
-};
+// Each queued USB-MIDI event is a 4-byte MIDIPacket (CIN + 3 MIDI bytes).
+typedef MIDIPacket RawUsbMessage;
 
 class USBConnection : public MIDITransport {
 public:
@@ -31,6 +27,9 @@ public:
     // Returns the last error message (empty if none).
     const String& getLastError() const { return lastError; }
 
+    // USB-MIDI events dropped because the main loop fell behind.
+    uint32_t getOverflowCount() const override { return usbQueue.overflowCount(); }
+
     // Queue access methods (for debugging or external analysis)
     int getQueueSize() const;
     const RawUsbMessage& getQueueMessage(int index) const;
@@ -45,13 +44,10 @@ protected:
     uint32_t eventFlags;
     usb_transfer_t* midiTransfer;
 
-    // Ring buffer for raw USB packets.
-    // Protected by spinlock for thread-safe access on dual-core ESP32.
+    // Lock-free ring for USB-MIDI events: the USB task (core 0) produces,
+    // task() on the main loop consumes.
     static const int QUEUE_SIZE = 64;
-    RawUsbMessage usbQueue[QUEUE_SIZE];
-    volatile int queueHead;
-    volatile int queueTail;
-    portMUX_TYPE queueMux;
+    MIDIPacketRing<QUEUE_SIZE> usbQueue;
 
     // Connection control data
     bool firstMidiReceived;
@@ -60,8 +56,7 @@ protected:
     String lastError;
 
     // Helper functions to manage the queue.
-    bool enqueueMidiMessage(const uint8_t* data, size_t length);
-    bool dequeueMidiMessage(RawUsbMessage &msg);
+    bool enqueueMidiMessage(const uint8_t* data, size_t length, uint32_t timestamp);
     void processQueue();
 
     // Dedicated FreeRTOS task for USB event handling (core 0)
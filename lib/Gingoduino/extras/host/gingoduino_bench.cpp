@@ -0,0 +1,396 @@
+// Gingoduino — Music Theory Library for Embedded Systems
+// Host microbenchmarks.
+//
+// Reports operations per second for the hot paths a sketch calls per
+// chord or per note:
+//   construct   notes, chords, scales and fields from names or IDs
+//   identify    chords from notes (names, IDs, voicings, fret shapes)
+//   deduce      harmonic fields and progressions
+//   fingering   fretboard searches, with and without a cache
+//   sequence    timeline seeks and MIDI encoding of long sequences
+//
+// Built by extras/host/CMakeLists.txt once per table variant, so the
+// constexpr tables and the PROGMEM scans can be compared run to run.
+//
+//   ./build-host/gingoduino_bench [--json] [--quick] [--filter TEXT]
+//
+// --json prints one JSON object instead of the table; --quick runs each
+// case for a few milliseconds (a smoke test, not a measurement).
+//
+// SPDX-License-Identifier: MIT
+
+#include "Gingoduino.h"
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace gingoduino;
+
+// ---------------------------------------------------------------------------
+// Inputs
+// ---------------------------------------------------------------------------
+
+static const char* const NOTE_NAMES[12] = {
+    "C", "Db", "D", "Eb", "E", "F", "F#", "G", "Ab", "A", "Bb", "B"
+};
+
+// The C major field, triads then sevenths
+static const char* const FIELD[14] = {
+    "CM", "Dm", "Em", "FM", "GM", "Am", "Bdim",
+    "C7M", "Dm7", "Em7", "F7M", "G7", "Am7", "Bm7(b5)"
+};
+
+static const char* const PROGRESSION[8] = {
+    "CM", "Am", "Dm7", "G7", "Em", "FM", "Bm7(b5)", "CM"
+};
+static const char* const MELODY[8] = { "C", "E", "G", "F", "A", "C", "B", "D" };
+static const uint8_t MELODY_MIDI[8] = { 60, 64, 67, 65, 69, 72, 71, 62 };
+static const char* const BRANCHES[4] = { "I", "VIm", "IIm", "V7" };
+
+static const ScaleType SCALES[5] = {
+    SCALE_MAJOR, SCALE_NATURAL_MINOR, SCALE_HARMONIC_MINOR,
+    SCALE_MELODIC_MINOR, SCALE_HARMONIC_MAJOR
+};
+
+// Filled in by setup()
+static GingoChord    g_field[14];
+static GingoNote     g_fieldNotes[14][GINGODUINO_MAX_CHORD_NOTES];
+static uint8_t       g_fieldSizes[14];
+static GingoNote     g_inversions[14][GINGODUINO_MAX_CHORD_NOTES];
+static GingoChordId  g_progressionIds[8];
+static uint8_t       g_branchIds[4];
+static GingoFretboard g_violao = GingoFretboard::violao();
+static GingoFretboard g_cavaquinho = GingoFretboard::cavaquinho();
+static GingoFingeringCache g_cache;
+static GingoSequence g_song(GingoSequenceAllocator::heap());   // 2048 events
+static GingoSequence g_phrase;                                 // 64 inline events
+
+static void setup() {
+    for (uint8_t i = 0; i < 14; i++) {
+        g_field[i] = GingoChord(FIELD[i]);
+        g_fieldSizes[i] = g_field[i].notes(g_fieldNotes[i], GINGODUINO_MAX_CHORD_NOTES);
+        // First inversion: the third in the bass
+        uint8_t n = g_fieldSizes[i];
+        for (uint8_t k = 0; k < n; k++) g_inversions[i][k] = g_fieldNotes[i][(k + 1) % n];
+    }
+    for (uint8_t i = 0; i < 8; i++) {
+        GingoChord c(PROGRESSION[i]);
+        g_progressionIds[i].root = c.root().semitone();
+        g_progressionIds[i].formulaIdx = c.formulaIndex();
+    }
+    for (uint8_t i = 0; i < 4; i++) g_branchIds[i] = GingoTree::findBranch(BRANCHES[i]);
+    // The melody in eighths with a rest every fourth event
+    for (uint16_t i = 0; i < 2048; i++) {
+        GingoEvent e = (i % 4 == 3)
+            ? GingoEvent::rest(GingoDuration("eighth"))
+            : GingoEvent::fromMIDI(MELODY_MIDI[i % 8], GingoDuration("eighth"));
+        g_song.add(e);
+        if (i < GINGODUINO_MAX_EVENTS) g_phrase.add(e);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Cases: each run does `ops` operations and returns something to keep
+// ---------------------------------------------------------------------------
+
+static uint32_t noteFromName() {
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < 12; i++) sum += GingoNote(NOTE_NAMES[i]).semitone();
+    return sum;
+}
+
+static uint32_t chordFromName() {
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < 14; i++) sum += GingoChord(FIELD[i]).formulaIndex();
+    return sum;
+}
+
+static uint32_t chordFromId() {
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < 8; i++) {
+        const GingoChordId& id = g_progressionIds[i];
+        sum += GingoChord(GingoNote::fromSemitone(id.root), (ChordType)id.formulaIdx).size();
+    }
+    return sum;
+}
+
+static uint32_t chordNotes() {
+    uint32_t sum = 0;
+    GingoNote notes[GINGODUINO_MAX_CHORD_NOTES];
+    for (uint8_t i = 0; i < 14; i++) sum += g_field[i].notes(notes, GINGODUINO_MAX_CHORD_NOTES);
+    return sum;
+}
+
+static uint32_t scaleNotes() {
+    uint32_t sum = 0;
+    GingoNote notes[12];
+    for (uint8_t i = 0; i < 5; i++) sum += GingoScale("D", SCALES[i]).notes(notes, 12);
+    return sum;
+}
+
+static uint32_t fieldChords() {
+    uint32_t sum = 0;
+    GingoChord chords[7];
+    for (uint8_t i = 0; i < 5; i++) {
+        GingoField f("D", SCALES[i]);
+        sum += f.chords(chords, 7) + f.sevenths(chords, 7);
+    }
+    return sum;
+}
+
+static uint32_t identifyName() {
+    uint32_t sum = 0;
+    char name[16];
+    for (uint8_t i = 0; i < 14; i++) {
+        sum += GingoChord::identify(g_fieldNotes[i], g_fieldSizes[i], name, sizeof(name));
+    }
+    return sum;
+}
+
+static uint32_t identifyId() {
+    uint32_t sum = 0;
+    GingoChordId id;
+    for (uint8_t i = 0; i < 14; i++) {
+        if (GingoChord::identify(g_fieldNotes[i], g_fieldSizes[i], id)) sum += id.formulaIdx;
+    }
+    return sum;
+}
+
+static uint32_t identifyVoicing() {
+    uint32_t sum = 0;
+    GingoChordMatch m;
+    for (uint8_t i = 0; i < 14; i++) {
+        if (GingoChord::identifyVoicing(g_inversions[i], g_fieldSizes[i], &m)) sum += m.kind;
+    }
+    return sum;
+}
+
+static uint32_t identifyFrets() {
+    static const uint8_t C[6] = { 255, 3, 2, 0, 1, 0 };
+    char name[16];
+    return g_violao.identify(C, 6, name, sizeof(name));
+}
+
+static uint32_t deduceChordNames() {
+    FieldMatch out[5];
+    return GingoField::deduce(PROGRESSION, 8, out, 5);
+}
+
+static uint32_t deduceChordIds() {
+    FieldMatch out[5];
+    return GingoField::deduce(g_progressionIds, 8, out, 5);
+}
+
+static uint32_t deduceNoteNames() {
+    FieldMatch out[5];
+    return GingoField::deduce(MELODY, 8, out, 5);
+}
+
+static uint32_t deduceMidi() {
+    FieldMatch out[5];
+    return GingoField::deduce(MELODY_MIDI, 8, out, 5);
+}
+
+static uint32_t progressionDeduce() {
+    GingoProgression p("C", SCALE_MAJOR);
+    ProgressionMatch out[5];
+    return p.deduce(BRANCHES, 4, out, 5);
+}
+
+static uint32_t progressionPredict() {
+    GingoProgression p("C", SCALE_MAJOR);
+    ProgressionRoute out[5];
+    return p.predict(BRANCHES, 4, out, 5);
+}
+
+static GingoProgressionTracker g_tracker("C", SCALE_MAJOR);
+
+static uint32_t trackerPush() {
+    for (uint8_t i = 0; i < 4; i++) g_tracker.push(g_branchIds[i]);
+    return g_tracker.count();
+}
+
+static uint32_t treeSequence() {
+    GingoTree t("C", SCALE_MAJOR, 0);
+    return t.countValidTransitions(BRANCHES, 4);
+}
+
+static uint32_t violaoFingerings() {
+    uint32_t sum = 0;
+    GingoFingering out[GINGODUINO_MAX_FINGERINGS];
+    for (uint8_t i = 0; i < 14; i++) sum += g_violao.fingerings(g_field[i], out, GINGODUINO_MAX_FINGERINGS);
+    return sum;
+}
+
+static uint32_t violaoFingering() {
+    uint32_t sum = 0;
+    GingoFingering fg;
+    for (uint8_t i = 0; i < 14; i++) sum += g_violao.fingering(g_field[i], 0, fg);
+    return sum;
+}
+
+static uint32_t cavaquinhoFingerings() {
+    uint32_t sum = 0;
+    GingoFingering out[GINGODUINO_MAX_FINGERINGS];
+    for (uint8_t i = 0; i < 14; i++) sum += g_cavaquinho.fingerings(g_field[i], out, GINGODUINO_MAX_FINGERINGS);
+    return sum;
+}
+
+// The 7 triads fit the cache, so after the first run every call is a hit
+static uint32_t violaoFingeringsCached() {
+    uint32_t sum = 0;
+    GingoFingering out[GINGODUINO_MAX_FINGERINGS];
+    for (uint8_t i = 0; i < 7; i++) {
+        sum += g_violao.fingerings(g_field[i], out, GINGODUINO_MAX_FINGERINGS,
+                                   GingoFingeringRules(), &g_cache);
+    }
+    return sum;
+}
+
+// Beats spread over the 1024-beat song
+static uint32_t sequenceSeek() {
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < 16; i++) sum += g_song.indexAtBeat(i * 63.7f);
+    return sum;
+}
+
+// Replace the last event, then ask for the length: only its start is redone
+static uint32_t sequenceEditTotal() {
+    GingoEvent last = g_song.at(g_song.size() - 1);
+    g_song.remove(g_song.size() - 1);
+    g_song.add(last);
+    return (uint32_t)g_song.totalSeconds();
+}
+
+// The phrase rendered at once (96 messages)
+static uint32_t sequenceToMidi() {
+    uint8_t buf[GINGODUINO_MAX_EVENTS * 6];
+    return g_phrase.toMIDI(buf, sizeof(buf));
+}
+
+// The same phrase, one message at a time (96 messages)
+static uint32_t sequenceEncode() {
+    GingoSequenceEncoder enc(g_phrase);
+    GingoMIDIMessage msg;
+    uint32_t sum = 0;
+    while (enc.next(msg)) sum += msg.data[1];
+    return sum;
+}
+
+// The whole song polled every 10 ms of playback (3072 messages)
+static uint32_t songPoll() {
+    GingoSequenceEncoder enc(g_song);
+    uint8_t buf[48];
+    uint32_t sum = 0;
+    for (uint32_t now = 0; !enc.done(); now += 10000) sum += enc.poll(now, buf, sizeof(buf));
+    return sum;
+}
+
+struct Case {
+    const char* group;
+    const char* name;
+    uint32_t  (*run)();
+    uint32_t    ops;   // operations per run
+};
+
+static const Case CASES[] = {
+    { "construct", "note_from_name",          noteFromName,           12 },
+    { "construct", "chord_from_name",         chordFromName,          14 },
+    { "construct", "chord_from_id",           chordFromId,             8 },
+    { "construct", "chord_notes",             chordNotes,             14 },
+    { "construct", "scale_notes",             scaleNotes,              5 },
+    { "construct", "field_chords_sevenths",   fieldChords,             5 },
+    { "identify",  "identify_name",           identifyName,           14 },
+    { "identify",  "identify_id",             identifyId,             14 },
+    { "identify",  "identify_voicing",        identifyVoicing,        14 },
+    { "identify",  "fretboard_identify",      identifyFrets,           1 },
+    { "deduce",    "field_chord_names_8",     deduceChordNames,        1 },
+    { "deduce",    "field_chord_ids_8",       deduceChordIds,          1 },
+    { "deduce",    "field_note_names_8",      deduceNoteNames,         1 },
+    { "deduce",    "field_midi_8",            deduceMidi,              1 },
+    { "deduce",    "progression_deduce_4",    progressionDeduce,       1 },
+    { "deduce",    "progression_predict_4",   progressionPredict,      1 },
+    { "deduce",    "tracker_push",            trackerPush,             4 },
+    { "deduce",    "tree_sequence_4",         treeSequence,            1 },
+    { "fingering", "violao_fingerings_5",     violaoFingerings,       14 },
+    { "fingering", "violao_fingering_pos0",   violaoFingering,        14 },
+    { "fingering", "cavaquinho_fingerings_5", cavaquinhoFingerings,   14 },
+    { "fingering", "violao_fingerings_cached", violaoFingeringsCached, 7 },
+    { "sequence",  "sequence_seek_2048",      sequenceSeek,           16 },
+    { "sequence",  "sequence_edit_total_2048", sequenceEditTotal,      1 },
+    { "sequence",  "sequence_to_midi_64",     sequenceToMidi,         96 },
+    { "sequence",  "sequence_encode_64",      sequenceEncode,         96 },
+    { "sequence",  "song_poll_2048",          songPoll,             3072 },
+};
+
+// ---------------------------------------------------------------------------
+// Runner
+// ---------------------------------------------------------------------------
+
+static volatile uint32_t g_sink;
+
+static double seconds(std::chrono::steady_clock::time_point from) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - from).count();
+}
+
+// Operations per second, run in doubling batches until minTime has passed.
+static double measure(const Case& c, double minTime, uint64_t& opsDone) {
+    uint64_t runs = 0;
+    uint64_t batch = 1;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    do {
+        for (uint64_t i = 0; i < batch; i++) g_sink += c.run();
+        runs += batch;
+        batch *= 2;
+        elapsed = seconds(t0);
+    } while (elapsed < minTime);
+    opsDone = runs * c.ops;
+    return opsDone / elapsed;
+}
+
+int main(int argc, char** argv) {
+    bool json = false;
+    double minTime = 0.25;
+    const char* filter = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--json")) json = true;
+        else if (!strcmp(argv[i], "--quick")) minTime = 0.005;
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+        else {
+            fprintf(stderr, "usage: %s [--json] [--quick] [--filter TEXT]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    setup();
+    // Warm the fingering cache so the cached case measures hits only
+    violaoFingeringsCached();
+
+    if (json) {
+        printf("{\n  \"tier\": %d,\n  \"constexpr_tables\": %d,\n  \"results\": [",
+               GINGODUINO_TIER, GINGODUINO_CONSTEXPR_TABLES);
+    } else {
+        printf("constexpr tables: %d\n", GINGODUINO_CONSTEXPR_TABLES);
+        printf("%-10s %-26s %14s %10s\n", "group", "case", "ops/s", "ns/op");
+    }
+
+    bool first = true;
+    for (size_t i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++) {
+        const Case& c = CASES[i];
+        if (filter && !strstr(c.name, filter) && !strstr(c.group, filter)) continue;
+        uint64_t ops;
+        double rate = measure(c, minTime, ops);
+        if (json) {
+            printf("%s\n    {\"group\": \"%s\", \"name\": \"%s\", \"ops\": %llu, "
+                   "\"ops_per_sec\": %.1f, \"ns_per_op\": %.2f}",
+                   first ? "" : ",", c.group, c.name, (unsigned long long)ops, rate, 1e9 / rate);
+        } else {
+            printf("%-10s %-26s %14.0f %10.1f\n", c.group, c.name, rate, 1e9 / rate);
+        }
+        first = false;
+    }
+    if (json) printf("\n  ]\n}\n");
+    return 0;
+}
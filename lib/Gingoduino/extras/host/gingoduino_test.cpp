@@ -0,0 +1,745 @@
+// Gingoduino — Music Theory Library for Embedded Systems
+// Host unit tests: golden results and cross-checks per module.
+//
+// Built by extras/host/CMakeLists.txt once per table variant; both must
+// give the same results. Exits non-zero if any check fails.
+//
+// SPDX-License-Identifier: MIT
+
+#include "Gingoduino.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace gingoduino;
+
+// ---------------------------------------------------------------------------
+// Checks
+// ---------------------------------------------------------------------------
+
+static int g_checks = 0;
+static int g_failures = 0;
+
+static void check(bool ok, const char* expr, int line) {
+    g_checks++;
+    if (!ok) {
+        g_failures++;
+        printf("FAIL line %d: %s\n", line, expr);
+    }
+}
+
+static void checkEq(long got, long want, const char* expr, int line) {
+    g_checks++;
+    if (got != want) {
+        g_failures++;
+        printf("FAIL line %d: %s == %ld, expected %ld\n", line, expr, got, want);
+    }
+}
+
+static void checkStr(const char* got, const char* want, const char* expr, int line) {
+    g_checks++;
+    if (!got || strcmp(got, want) != 0) {
+        g_failures++;
+        printf("FAIL line %d: %s == \"%s\", expected \"%s\"\n", line, expr,
+               got ? got : "(null)", want);
+    }
+}
+
+#define CHECK(cond)          check((cond), #cond, __LINE__)
+#define CHECK_EQ(got, want)  checkEq((long)(got), (long)(want), #got, __LINE__)
+#define CHECK_STR(got, want) checkStr((got), (want), #got, __LINE__)
+
+// Names of notes joined by spaces: "C E G".
+static const char* joinNotes(const GingoNote* notes, uint8_t count, char* buf, size_t len) {
+    buf[0] = '\0';
+    for (uint8_t i = 0; i < count; i++) {
+        if (i) strncat(buf, " ", len - strlen(buf) - 1);
+        strncat(buf, notes[i].name(), len - strlen(buf) - 1);
+    }
+    return buf;
+}
+
+static const char* chordNotes(const char* name, char* buf, size_t len) {
+    GingoNote notes[GINGODUINO_MAX_CHORD_NOTES];
+    uint8_t n = GingoChord(name).notes(notes, GINGODUINO_MAX_CHORD_NOTES);
+    return joinNotes(notes, n, buf, len);
+}
+
+static const char* scaleNotes(const GingoScale& scale, char* buf, size_t len) {
+    GingoNote notes[12];
+    uint8_t n = scale.notes(notes, 12);
+    return joinNotes(notes, n, buf, len);
+}
+
+// A fingering as fret digits, low string first, x = muted: "x32010".
+// Frets past 9 are bracketed: "(10)".
+static const char* shape(const GingoFingering& fg, char* buf, size_t len) {
+    size_t pos = 0;
+    buf[0] = '\0';
+    for (uint8_t s = 0; s < fg.numStrings && pos + 5 < len; s++) {
+        const GingoStringState& st = fg.strings[s];
+        if (st.action == STRING_MUTED)   pos += snprintf(buf + pos, len - pos, "x");
+        else if (st.action == STRING_OPEN) pos += snprintf(buf + pos, len - pos, "0");
+        else if (st.fret < 10)           pos += snprintf(buf + pos, len - pos, "%u", st.fret);
+        else                             pos += snprintf(buf + pos, len - pos, "(%u)", st.fret);
+    }
+    return buf;
+}
+
+// ---------------------------------------------------------------------------
+// Notes
+// ---------------------------------------------------------------------------
+
+static void testNotes() {
+    GingoNote bb("Bb");
+    CHECK_STR(bb.name(), "Bb");
+    CHECK_STR(bb.natural(), "A#");
+    CHECK_EQ(bb.sound(), 'B');
+    CHECK_EQ(bb.semitone(), 10);
+    CHECK_EQ(bb.midiNumber(4), 70);
+    CHECK(GingoNote("A").frequency(4) > 439.99f && GingoNote("A").frequency(4) < 440.01f);
+
+    CHECK_STR(GingoNote::fromMIDI(61).name(), "C#");
+    CHECK_EQ(GingoNote::octaveFromMIDI(61), 4);
+    CHECK_EQ(GingoNote::fromMIDI(60).midiNumber(GingoNote::octaveFromMIDI(60)), 60);
+    CHECK_STR(GingoNote("E").transpose(3).name(), "G");
+    CHECK_STR(GingoNote("C").transpose(-1).name(), "B");
+    CHECK_EQ(GingoNote::toSemitone("Cb"), 11);
+    CHECK_EQ(GingoNote::toSemitone("B#"), 0);
+
+    char buf[8];
+    GingoNote::toNatural("Ebb", buf, sizeof(buf));
+    CHECK_STR(buf, "D");
+
+    CHECK(GingoNote("Db") == GingoNote("C#"));
+    CHECK(GingoNote("Db").isEnharmonic(GingoNote("C#")));
+    CHECK(GingoNote("D") != GingoNote("E"));
+
+    // Circle of fifths
+    CHECK_EQ(GingoNote("C").distance(GingoNote("G")), 1);
+    CHECK_EQ(GingoNote("C").distance(GingoNote("F#")), 6);
+
+    for (uint8_t st = 0; st < 12; st++) {
+        CHECK_EQ(GingoNote::fromSemitone(st).semitone(), st);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Intervals
+// ---------------------------------------------------------------------------
+
+static void testIntervals() {
+    char buf[32];
+    GingoInterval fifth("5J");
+    CHECK_EQ(fifth.semitones(), 7);
+    CHECK_EQ(fifth.degree(), 5);
+    CHECK_STR(fifth.label(buf, sizeof(buf)), "5J");
+    CHECK_STR(fifth.angloSaxon(buf, sizeof(buf)), "P5");
+    CHECK_STR(fifth.fullName(buf, sizeof(buf)), "Perfect Fifth");
+    CHECK(fifth.isConsonant());
+    CHECK(!GingoInterval("2m").isConsonant());
+
+    GingoInterval third(GingoNote("C"), GingoNote("E"));
+    CHECK_STR(third.label(buf, sizeof(buf)), "3M");
+    CHECK_EQ(third.invert().semitones(), 8);
+
+    CHECK_EQ((GingoInterval("7M") + GingoInterval("2M")).semitones(), 13);
+    CHECK_EQ((GingoInterval("5J") - GingoInterval("3M")).semitones(), 3);
+    CHECK(GingoInterval((uint8_t)14).isCompound());
+    CHECK_EQ(GingoInterval((uint8_t)14).simple().semitones(), 2);
+    CHECK_EQ(GingoInterval::labelToSemitones("7m"), 10);
+}
+
+// ---------------------------------------------------------------------------
+// Chords
+// ---------------------------------------------------------------------------
+
+static void testChords() {
+    char buf[64];
+
+    struct { const char* name; const char* root; const char* type; uint8_t size; const char* notes; } golden[] = {
+        { "CM",       "C",  "M",       3, "C E G" },
+        { "Dm7",      "D",  "m7",      4, "D F A C" },
+        { "G7",       "G",  "7",       4, "G B D F" },
+        { "Bm7(b5)",  "B",  "m7(b5)",  4, "B D F A" },
+        { "F#dim7",   "F#", "dim7",    4, "F# A C D#" },
+        { "Ab6(9)",   "Ab", "6(9)",    5, "G# C D# F A#" },
+        { "E7(b9)",   "E",  "7(b9)",   5, "E G# B D F" },
+        { "Caug",     "C",  "aug",     3, "C E G#" },
+        { "Csus4",    "C",  "sus4",    3, "C F G" },
+    };
+    for (size_t i = 0; i < sizeof(golden) / sizeof(golden[0]); i++) {
+        GingoChord c(golden[i].name);
+        CHECK_STR(c.root().name(), golden[i].root);
+        CHECK_STR(c.type(), golden[i].type);
+        CHECK_EQ(c.size(), golden[i].size);
+        CHECK_STR(chordNotes(golden[i].name, buf, sizeof(buf)), golden[i].notes);
+    }
+
+    // Aliases resolve to the same formula
+    CHECK_EQ(GingoChord("Cmaj7").formulaIndex(), CHORD_MAJOR_7);
+    CHECK_EQ(GingoChord("C").formulaIndex(), CHORD_MAJOR);
+    CHECK_EQ(GingoChord("Cxyz").formulaIndex(), 255);
+
+    CHECK_STR(GingoChord(GingoNote("Bb"), CHORD_MINOR_7).name(), "Bbm7");
+    CHECK_STR(GingoChord("CM").transpose(2).name(), "DM");
+    CHECK(GingoChord("CM").contains(GingoNote("E")));
+    CHECK(!GingoChord("CM").contains(GingoNote("F")));
+
+    // identify: first note is the root
+    GingoNote g7[] = { GingoNote("G"), GingoNote("F"), GingoNote("B"), GingoNote("D") };
+    CHECK(GingoChord::identify(g7, 4, buf, sizeof(buf)));
+    CHECK_STR(buf, "G7");
+    GingoChordId id;
+    CHECK(GingoChord::identify(g7, 4, id));
+    CHECK_EQ(id.root, 7);
+    CHECK_EQ(id.formulaIdx, CHORD_DOMINANT_7);
+
+    GingoNote add9[] = { GingoNote("C"), GingoNote("E"), GingoNote("G"), GingoNote("D") };
+    CHECK(GingoChord::identify(add9, 4, buf, sizeof(buf)));
+    CHECK_STR(buf, "C(9)");
+
+    // identifyVoicing
+    GingoChordMatch m;
+    GingoNote ce[] = { GingoNote("E"), GingoNote("G"), GingoNote("C") };
+    CHECK(!GingoChord::identify(ce, 3, buf, sizeof(buf)));
+    CHECK(GingoChord::identifyVoicing(ce, 3, &m));
+    CHECK_STR(m.name.c_str(), "CM/E");
+    CHECK_EQ(m.kind, GingoChordMatch::INVERSION);
+    GingoNote d7c[] = { GingoNote("C"), GingoNote("D"), GingoNote("F#"), GingoNote("A") };
+    CHECK(GingoChord::identifyVoicing(d7c, 4, &m));
+    CHECK_STR(m.name.c_str(), "D7/C");
+    GingoNote slash[] = { GingoNote("C"), GingoNote("F#"), GingoNote("A"), GingoNote("C#") };
+    CHECK(GingoChord::identifyVoicing(slash, 4, &m));
+    CHECK_STR(m.name.c_str(), "F#m/C");
+    CHECK_EQ(m.kind, GingoChordMatch::SLASH);
+
+    // Every formula on every root: the notes identify back to a chord with
+    // the same root and pitch-class set, and the name parses back
+    for (uint8_t f = 0; f < CHORD_TYPE_COUNT; f++) {
+        for (uint8_t r = 0; r < 12; r++) {
+            GingoChord c(GingoNote::fromSemitone(r), (ChordType)f);
+            CHECK_EQ(GingoChord(c.name()).formulaIndex(), f);
+
+            GingoNote notes[GINGODUINO_MAX_CHORD_NOTES];
+            uint8_t n = c.notes(notes, GINGODUINO_MAX_CHORD_NOTES);
+            GingoChordId found;
+            bool ok = GingoChord::identify(notes, n, found);
+            CHECK(ok);
+            if (!ok) continue;
+            CHECK_EQ(found.root, r);
+            GingoNote back[GINGODUINO_MAX_CHORD_NOTES];
+            uint8_t bn = GingoChord(GingoNote::fromSemitone(r), (ChordType)found.formulaIdx)
+                             .notes(back, GINGODUINO_MAX_CHORD_NOTES);
+            uint16_t want = 0, got = 0;
+            for (uint8_t i = 0; i < n; i++)  want |= (uint16_t)(1u << notes[i].semitone());
+            for (uint8_t i = 0; i < bn; i++) got  |= (uint16_t)(1u << back[i].semitone());
+            CHECK_EQ(got, want);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Scales
+// ---------------------------------------------------------------------------
+
+static void testScales() {
+    char buf[64];
+
+    struct { const char* tonic; ScaleType type; uint8_t mode; bool penta; const char* notes; } golden[] = {
+        { "C", SCALE_MAJOR,          1, false, "C D E F G A B" },
+        { "F", SCALE_MAJOR,          1, false, "F G A A# C D E" },
+        { "D", SCALE_MAJOR,          2, false, "D E F G A B C" },
+        { "C", SCALE_MAJOR,          1, true,  "C D E G A" },
+        { "A", SCALE_NATURAL_MINOR,  1, false, "A B C D E F G" },
+        { "E", SCALE_HARMONIC_MINOR, 1, false, "E F# G A B C D#" },
+        { "A", SCALE_MELODIC_MINOR,  1, false, "A B C D E F# G#" },
+        { "C", SCALE_DIMINISHED,     1, false, "C D D# F F# G# A B" },
+        { "C", SCALE_HARMONIC_MAJOR, 1, false, "C D E F G G# B" },
+        { "C", SCALE_WHOLE_TONE,     1, false, "C D E F# G# A#" },
+        { "C", SCALE_AUGMENTED,      1, false, "C D# E G G# B" },
+        { "A", SCALE_BLUES,          1, false, "A C D D# E G" },
+    };
+    for (size_t i = 0; i < sizeof(golden) / sizeof(golden[0]); i++) {
+        GingoScale s(golden[i].tonic, golden[i].type, golden[i].mode, golden[i].penta);
+        CHECK_STR(scaleNotes(s, buf, sizeof(buf)), golden[i].notes);
+    }
+
+    GingoScale c("C", SCALE_MAJOR);
+    CHECK_EQ(c.size(), 7);
+    CHECK_EQ(c.mask(), 0xAB5);
+    CHECK_STR(c.quality(), "major");
+    CHECK_EQ(c.signature(), 0);
+    CHECK_EQ(GingoScale("F", SCALE_MAJOR).signature(), -1);
+    CHECK_EQ(GingoScale("D", SCALE_MAJOR).signature(), 2);
+    CHECK_EQ(c.degreeOf(GingoNote("G")), 5);
+    CHECK_EQ(c.degreeOf(GingoNote("F#")), 0);
+    CHECK_STR(c.degree(3).name(), "E");
+    CHECK(c.contains(GingoNote("B")));
+    CHECK(!c.contains(GingoNote("Bb")));
+    CHECK_STR(c.relative().tonic().name(), "A");
+    CHECK_STR(scaleNotes(c.relative(), buf, sizeof(buf)), "A B C D E F G");
+    CHECK_STR(c.mode(2).tonic().name(), "D");
+    CHECK_EQ(c.mode(2).modeNumber(), 2);
+    CHECK_STR(c.mode(2).modeName(buf, sizeof(buf)), "Dorian");
+    CHECK_EQ(c.mode(2).brightness(), 3);
+    CHECK_STR(GingoScale("A", SCALE_NATURAL_MINOR).quality(), "minor");
+
+    GingoScale dorian("D", "dorian");
+    CHECK_EQ(dorian.parent(), SCALE_MAJOR);
+    CHECK_EQ(dorian.modeNumber(), 2);
+    CHECK_EQ(dorian.mask(), c.mode(2).mask());
+
+    // Every mode of every parent is a rotation of the parent's notes
+    for (uint8_t t = 0; t < SCALE_TYPE_COUNT; t++) {
+        GingoScale parent("C", (ScaleType)t);
+        uint8_t size = parent.size();
+        for (uint8_t m = 1; m <= size; m++) {
+            GingoScale mode = parent.mode(m);
+            CHECK_EQ(mode.size(), size);
+            uint16_t rel = mode.mask();
+            uint8_t k = mode.tonic().semitone();
+            uint16_t abs = (uint16_t)(((rel << k) | (rel >> (12 - k))) & 0x0FFF);
+            CHECK_EQ(abs, parent.mask());
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Fields
+// ---------------------------------------------------------------------------
+
+static void fieldNames(const GingoChord* chords, uint8_t n, char* buf, size_t len) {
+    buf[0] = '\0';
+    for (uint8_t i = 0; i < n; i++) {
+        if (i) strncat(buf, " ", len - strlen(buf) - 1);
+        strncat(buf, chords[i].name(), len - strlen(buf) - 1);
+    }
+}
+
+static void testFields() {
+    char buf[128];
+    GingoChord chords[7];
+
+    GingoField c("C", SCALE_MAJOR);
+    fieldNames(chords, c.chords(chords, 7), buf, sizeof(buf));
+    CHECK_STR(buf, "CM Dm Em FM GM Am Bdim");
+    fieldNames(chords, c.sevenths(chords, 7), buf, sizeof(buf));
+    CHECK_STR(buf, "C7M Dm7 Em7 F7M G7 Am7 Bm7(b5)");
+    CHECK_STR(c.chord(5).name(), "GM");
+    CHECK_STR(c.seventh(2).name(), "Dm7");
+    CHECK_EQ(c.function(1), FUNC_TONIC);
+    CHECK_EQ(c.function(4), FUNC_SUBDOMINANT);
+    CHECK_EQ(c.function(5), FUNC_DOMINANT);
+    CHECK_EQ(c.functionOf("Dm"), FUNC_SUBDOMINANT);
+    CHECK_STR(c.role(6, buf, sizeof(buf)), "relative of I");
+    CHECK_STR(c.roleOf("Em", buf, sizeof(buf)), "transitive");
+
+    GingoField am("A", SCALE_NATURAL_MINOR);
+    fieldNames(chords, am.chords(chords, 7), buf, sizeof(buf));
+    CHECK_STR(buf, "Am Bdim CM Dm Em FM GM");
+
+    GingoField hm("A", SCALE_HARMONIC_MINOR);
+    fieldNames(chords, hm.chords(chords, 7), buf, sizeof(buf));
+    CHECK_STR(buf, "Am Bdim Caug Dm EM FM G#dim");
+    fieldNames(chords, hm.sevenths(chords, 7), buf, sizeof(buf));
+    CHECK_STR(buf, "Am7M Bm7(b5) C+M7 Dm7 E7 F7M G#dim7");
+
+    // deduce from chord names
+    const char* items[] = { "CM", "FM", "G7", "Am" };
+    FieldMatch m[3];
+    CHECK_EQ(GingoField::deduce(items, 4, m, 3), 3);
+    CHECK_STR(m[0].tonicName, "C");
+    CHECK_EQ(m[0].scaleType, SCALE_MAJOR);
+    CHECK_EQ(m[0].matched, 4);
+    CHECK_EQ(m[0].total, 4);
+    CHECK_EQ(m[0].roleCount, 4);
+    CHECK_STR(m[0].roles[0], "I");
+    CHECK_STR(m[0].roles[2], "V7");
+    CHECK_STR(m[0].roles[3], "VI");
+    CHECK_STR(m[1].tonicName, "A");
+    CHECK_EQ(m[1].scaleType, SCALE_NATURAL_MINOR);
+    CHECK_EQ(m[1].matched, 4);
+    CHECK_STR(m[1].roles[2], "VII7");
+
+    // deduce from note names, MIDI notes and chord IDs agree
+    const char* noteNames[] = { "D", "F#", "A", "C#", "E", "B" };
+    uint8_t midi[] = { 62, 66, 69, 73, 64, 71 };
+    FieldMatch byName[8], byMidi[8];
+    uint8_t nn = GingoField::deduce(noteNames, 6, byName, 8);
+    CHECK_EQ(GingoField::deduce(midi, 6, byMidi, 8), nn);
+    CHECK_STR(byMidi[0].tonicName, "D");
+    CHECK_EQ(byMidi[0].scaleType, SCALE_MAJOR);
+    CHECK_EQ(byMidi[0].matched, 6);
+    for (uint8_t i = 0; i < nn; i++) {
+        CHECK_STR(byMidi[i].tonicName, byName[i].tonicName);
+        CHECK_EQ(byMidi[i].scaleType, byName[i].scaleType);
+        CHECK_EQ(byMidi[i].matched, byName[i].matched);
+    }
+
+    GingoChordId ids[4];
+    for (uint8_t i = 0; i < 4; i++) {
+        GingoChord ch(items[i]);
+        ids[i].root = ch.root().semitone();
+        ids[i].formulaIdx = ch.formulaIndex();
+    }
+    FieldMatch byId[3];
+    CHECK_EQ(GingoField::deduce(ids, 4, byId, 3), 3);
+    for (uint8_t i = 0; i < 3; i++) {
+        CHECK_STR(byId[i].tonicName, m[i].tonicName);
+        CHECK_EQ(byId[i].scaleType, m[i].scaleType);
+        CHECK_EQ(byId[i].matched, m[i].matched);
+        CHECK_EQ(byId[i].roleCount, m[i].roleCount);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Trees
+// ---------------------------------------------------------------------------
+
+static void testTrees() {
+    char buf[32];
+    GingoTree t("C", SCALE_MAJOR, 0);
+    CHECK_STR(t.traditionName(buf, sizeof(buf)), "harmonic_tree");
+    CHECK(t.isValid("IIm", "V7"));
+    CHECK(!t.isValid("V7", "IIm"));
+    const char* seq[] = { "IIm", "V7", "I" };
+    CHECK(t.isValidSequence(seq, 3));
+    CHECK_EQ(t.countValidTransitions(seq, 3), 2);
+    CHECK(t.resolve("V7", buf, sizeof(buf)));
+    CHECK_STR(buf, "G7");
+    CHECK(t.resolve("IIm", buf, sizeof(buf)));
+    CHECK_STR(buf, "Dm");
+
+    const char* next[24];
+    uint8_t n = t.neighbors("I", next, 24);
+    CHECK_EQ(n, 10);
+    bool hasVIm = false, hasV7 = false;
+    for (uint8_t i = 0; i < n; i++) {
+        if (strcmp(next[i], "VIm") == 0) hasVIm = true;
+        if (strcmp(next[i], "V7") == 0) hasV7 = true;
+    }
+    CHECK(hasVIm && hasV7);
+
+    CHECK_EQ(GingoTree("A", SCALE_NATURAL_MINOR, 0).context(), 1);
+    CHECK_EQ(GingoTree::findBranch("not a branch"), 255);
+    CHECK(GingoTree::branchName(255) == nullptr);
+
+    // Branch IDs round-trip, and the ID API agrees with the string API
+    uint8_t branches = 0;
+    while (GingoTree::branchName(branches)) branches++;
+    CHECK_EQ(branches, 41);
+    for (uint8_t b = 0; b < branches; b++) {
+        CHECK_EQ(GingoTree::findBranch(GingoTree::branchName(b)), b);
+    }
+    for (uint8_t trad = 0; trad < 2; trad++) {
+        GingoTree tr("C", SCALE_MAJOR, trad);
+        for (uint8_t o = 0; o < branches; o++) {
+            uint8_t ids[48];
+            const char* names[48];
+            uint8_t ni = tr.neighbors(o, ids, 48);
+            uint8_t ns = tr.neighbors(GingoTree::branchName(o), names, 48);
+            CHECK_EQ(ni, ns);
+            for (uint8_t i = 0; i < ni; i++) {
+                CHECK(tr.hasEdge(o, ids[i]));
+                CHECK(tr.isValid(GingoTree::branchName(o), GingoTree::branchName(ids[i])));
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Progressions
+// ---------------------------------------------------------------------------
+
+static void testProgressions() {
+    GingoProgression p("C", SCALE_MAJOR);
+    const char* seq[] = { "IIm", "V7", "I" };
+
+    ProgressionMatch m;
+    CHECK(p.identify(seq, 3, &m));
+    CHECK_EQ(m.traditionId, 1);
+    CHECK_STR(m.schema, "ii-V-I");
+    CHECK_EQ(m.matched, 2);
+    CHECK_EQ(m.total, 2);
+    CHECK_EQ(m.scoreNum, 100);
+
+    ProgressionMatch ms[4];
+    CHECK_EQ(p.deduce(seq, 3, ms, 4), 4);
+    CHECK_EQ(ms[0].traditionId, 0);
+    CHECK_STR(ms[0].schema, "descending");
+    CHECK_EQ(ms[0].scoreNum, 100);
+
+    ProgressionRoute r[4];
+    CHECK_EQ(p.predict(seq, 2, r, 4), 2);
+    CHECK_STR(r[0].next, "I");
+    CHECK_STR(r[0].schema, "ii-V-I");
+    CHECK_EQ(r[0].confidenceNum, 100);
+
+    GingoProgressionTracker tr("C", SCALE_MAJOR);
+    for (uint8_t i = 0; i < 3; i++) tr.push(seq[i]);
+    CHECK_EQ(tr.count(), 3);
+    CHECK(tr.deduce(ms, 4) > 0);
+    CHECK_STR(ms[0].schema, "descending");
+    CHECK_EQ(ms[0].matched, 2);
+    CHECK_EQ(tr.predict(r, 3), 3);
+    CHECK_STR(r[0].next, "V7");
+    tr.reset();
+    CHECK_EQ(tr.count(), 0);
+
+    // Pushing IDs is the same as pushing names
+    GingoProgressionTracker byId("C", SCALE_MAJOR);
+    for (uint8_t i = 0; i < 3; i++) byId.push(GingoTree::findBranch(seq[i]));
+    for (uint8_t i = 0; i < 3; i++) tr.push(seq[i]);
+    ProgressionRoute a[3], b[3];
+    uint8_t na = tr.predict(a, 3);
+    CHECK_EQ(byId.predict(b, 3), na);
+    for (uint8_t i = 0; i < na; i++) CHECK_STR(b[i].next, a[i].next);
+}
+
+// ---------------------------------------------------------------------------
+// Fretboards
+// ---------------------------------------------------------------------------
+
+// Whether a fingering sounds every tone of the chord (all but the fifth
+// when the chord has more tones than the instrument has strings).
+static bool coversChord(const GingoFingering& fg, const GingoChord& chord, uint8_t strings) {
+    GingoNote tones[GINGODUINO_MAX_CHORD_NOTES];
+    uint8_t n = chord.notes(tones, GINGODUINO_MAX_CHORD_NOTES);
+    uint16_t sounding = 0;
+    for (uint8_t i = 0; i < fg.numNotes; i++) sounding |= (uint16_t)(1u << (fg.midiNotes[i] % 12));
+    for (uint8_t i = 0; i < n; i++) {
+        if (n > strings && i == 2) continue;
+        if (!(sounding & (1u << tones[i].semitone()))) return false;
+    }
+    return true;
+}
+
+static void testFretboards() {
+    char buf[32];
+    GingoFretboard fb = GingoFretboard::violao();
+    CHECK_STR(fb.name(), "Violao");
+    CHECK_EQ(fb.numStrings(), 6);
+    CHECK_EQ(fb.numFrets(), 19);
+    CHECK_EQ(fb.openMidi(0), 40);
+    CHECK_STR(fb.noteAt(0, 5).name(), "A");
+    CHECK_EQ(fb.midiAt(5, 3), 67);
+
+    struct { const char* chord; const char* shape; } golden[] = {
+        { "CM", "x32010" }, { "GM", "320003" }, { "Am", "x02210" },
+        { "EM", "022100" }, { "E7", "020100" }, { "Dm", "xx0231" },
+        { "A7", "x02020" },
+    };
+    for (size_t i = 0; i < sizeof(golden) / sizeof(golden[0]); i++) {
+        GingoFingering fg;
+        CHECK(fb.fingering(GingoChord(golden[i].chord), 0, fg));
+        CHECK_STR(shape(fg, buf, sizeof(buf)), golden[i].shape);
+    }
+
+    uint8_t c[] = { 255, 3, 2, 0, 1, 0 };
+    CHECK(fb.identify(c, 6, buf, sizeof(buf)));
+    CHECK_STR(buf, "CM");
+
+    GingoFretPos pos[GINGODUINO_MAX_FRET_POSITIONS];
+    CHECK_EQ(fb.positions(GingoNote("E"), pos, GINGODUINO_MAX_FRET_POSITIONS), 11);
+    CHECK_EQ(pos[0].midi, 40);
+    CHECK_EQ(fb.scalePositions(GingoScale("C", SCALE_MAJOR, 1, true),
+                               pos, GINGODUINO_MAX_FRET_POSITIONS, 0, 3), 12);
+
+    GingoFingering fg;
+    GingoFretboard capo2 = fb.capo(2);
+    CHECK(capo2.fingering(GingoChord("DM"), 0, fg));
+    CHECK_STR(shape(fg, buf, sizeof(buf)), "x32010");
+    CHECK_EQ(fg.capoFret, 2);
+
+    GingoFretboard cv = GingoFretboard::cavaquinho();
+    struct { const char* chord; const char* shape; } cavaquinho[] = {
+        { "CM", "2012" }, { "GM", "x000" }, { "Am", "x212" }, { "D7", "0214" },
+    };
+    for (size_t i = 0; i < sizeof(cavaquinho) / sizeof(cavaquinho[0]); i++) {
+        CHECK(cv.fingering(GingoChord(cavaquinho[i].chord), 0, fg));
+        CHECK_STR(shape(fg, buf, sizeof(buf)), cavaquinho[i].shape);
+    }
+
+    // fingerings(): the C major field, triads and sevenths, on both
+    // instruments. Sorted by score, every tone sounds, root in the bass,
+    // and the cache returns the same shapes as a fresh search.
+    const char* field[] = { "CM", "Dm", "Em", "FM", "GM", "Am", "Bdim",
+                            "C7M", "Dm7", "Em7", "F7M", "G7", "Am7", "Bm7(b5)" };
+    GingoFretboard boards[] = { fb, cv };
+    GingoFingeringCache cache;
+    for (uint8_t b = 0; b < 2; b++) {
+        for (size_t i = 0; i < sizeof(field) / sizeof(field[0]); i++) {
+            GingoChord chord(field[i]);
+            GingoFingering out[GINGODUINO_MAX_FINGERINGS];
+            uint8_t n = boards[b].fingerings(chord, out, GINGODUINO_MAX_FINGERINGS);
+            CHECK(n > 0);
+            for (uint8_t k = 0; k < n; k++) {
+                CHECK(coversChord(out[k], chord, boards[b].numStrings()));
+                CHECK_EQ(out[k].midiNotes[0] % 12, chord.root().semitone());
+                if (k) CHECK(out[k - 1].score <= out[k].score);
+            }
+
+            GingoFingering cached[GINGODUINO_MAX_FINGERINGS];
+            for (uint8_t pass = 0; pass < 2; pass++) {
+                uint8_t cn = boards[b].fingerings(chord, cached, GINGODUINO_MAX_FINGERINGS,
+                                                  GingoFingeringRules(), &cache);
+                CHECK_EQ(cn, n);
+                for (uint8_t k = 0; k < cn && k < n; k++) {
+                    char want[32];
+                    CHECK_STR(shape(cached[k], buf, sizeof(buf)), shape(out[k], want, sizeof(want)));
+                }
+            }
+        }
+    }
+
+    GingoFingering best[GINGODUINO_MAX_FINGERINGS];
+    CHECK(fb.fingerings(GingoChord("CM"), best, GINGODUINO_MAX_FINGERINGS) > 0);
+    CHECK_STR(shape(best[0], buf, sizeof(buf)), "x32010");
+}
+
+// ---------------------------------------------------------------------------
+// Sequences
+// ---------------------------------------------------------------------------
+
+// malloc / free that keep count, to check chunks are allocated and released
+static int g_liveChunks = 0;
+static void* countedAllocate(size_t bytes) { g_liveChunks++; return malloc(bytes); }
+static void  countedRelease(void* ptr)     { g_liveChunks--; free(ptr); }
+
+// Every message of an encoder, concatenated as toMIDI() writes them.
+static uint16_t encodeAll(GingoSequenceEncoder& enc, uint8_t* buf, uint16_t maxLen) {
+    uint16_t len = 0;
+    GingoMIDIMessage msg;
+    while (len + 3 <= maxLen && enc.next(msg)) {
+        memcpy(buf + len, msg.data, 3);
+        len += 3;
+    }
+    return len;
+}
+
+static void testSequences() {
+    GingoSequence seq(GingoTempo(120), GingoTimeSig(4, 4));
+    CHECK(seq.add(GingoEvent::noteEvent(GingoNote("C"), GingoDuration("quarter"), 4)));
+    CHECK(seq.add(GingoEvent::rest(GingoDuration("quarter"))));
+    CHECK(seq.add(GingoEvent::noteEvent(GingoNote("E"), GingoDuration("half"), 4)));
+    CHECK(seq.totalBeats() == 4.0f);
+    CHECK(seq.totalSeconds() == 2.0f);
+    CHECK(seq.barCount() == 1.0f);
+    CHECK(seq.startBeat(2) == 2.0f);
+    CHECK(seq.startSeconds(2) == 1.0f);
+    CHECK_EQ(seq.indexAtBeat(-1.0f), 0);
+    CHECK_EQ(seq.indexAtBeat(0.99f), 0);
+    CHECK_EQ(seq.indexAtBeat(1.0f), 1);
+    CHECK_EQ(seq.indexAtBeat(3.9f), 2);
+    CHECK_EQ(seq.indexAtBeat(4.0f), 3);
+    CHECK_EQ(seq.indexAtSeconds(1.2f), 2);
+
+    uint8_t midi[12];
+    const uint8_t want[12] = { 0x90, 60, 100, 0x80, 60, 0, 0x90, 64, 100, 0x80, 64, 0 };
+    CHECK_EQ(seq.toMIDI(midi, sizeof(midi)), 12);
+    CHECK(memcmp(midi, want, 12) == 0);
+    CHECK_EQ(seq.toMIDI(midi, 11), 6);
+    CHECK_EQ(seq.toMIDI(midi, sizeof(midi), 2), 12);
+    CHECK_EQ(midi[0], 0x91);
+
+    // Each message at its time; poll() sends only what is due
+    GingoSequenceEncoder enc(seq);
+    const uint32_t times[4] = { 0, 500000, 1000000, 2000000 };
+    GingoMIDIMessage msg;
+    for (uint8_t i = 0; i < 4; i++) {
+        CHECK_EQ(enc.nextMicros(), times[i]);
+        CHECK(enc.next(msg));
+        CHECK_EQ(msg.micros, times[i]);
+        CHECK(memcmp(msg.data, want + 3 * i, 3) == 0);
+    }
+    CHECK(enc.done());
+    CHECK(!enc.next(msg));
+    enc.rewind();
+    CHECK_EQ(enc.poll(0, midi, sizeof(midi)), 3);
+    CHECK_EQ(enc.poll(999999, midi, sizeof(midi)), 3);
+    CHECK_EQ(enc.poll(2000000, midi, sizeof(midi)), 6);
+    CHECK(enc.done());
+
+    // Seeking skips the note already sounding
+    enc.seekBeat(0.5f);
+    CHECK_EQ(enc.nextMicros(), 1000000);
+    enc.seekBeat(2.0f);
+    CHECK_EQ(enc.nextMicros(), 1000000);
+    enc.seekSeconds(0.0f);
+    CHECK_EQ(enc.nextMicros(), 0);
+
+    // Inline storage only
+    GingoSequence phrase;
+    CHECK_EQ(phrase.capacity(), GINGODUINO_MAX_EVENTS);
+    for (uint16_t i = 0; i < GINGODUINO_MAX_EVENTS; i++) {
+        CHECK(phrase.add(GingoEvent::fromMIDI(60 + i % 12, GingoDuration("eighth"))));
+    }
+    CHECK(!phrase.add(GingoEvent()));
+    CHECK_EQ(phrase.size(), GINGODUINO_MAX_EVENTS);
+
+    // Allocated chunks: 1000 eighths with a rest every fifth event
+    GingoSequenceAllocator counted = { countedAllocate, countedRelease };
+    {
+        GingoSequence song(counted);
+        for (uint16_t i = 0; i < 1000; i++) {
+            GingoEvent e = (i % 5 == 4) ? GingoEvent::rest(GingoDuration("eighth"))
+                                        : GingoEvent::fromMIDI(48 + i % 24, GingoDuration("eighth"));
+            CHECK(song.add(e));
+        }
+        CHECK_EQ(song.size(), 1000);
+        int chunks = (1000 - GINGODUINO_MAX_EVENTS + GINGODUINO_SEQUENCE_CHUNK - 1)
+                     / GINGODUINO_SEQUENCE_CHUNK;
+        CHECK_EQ(g_liveChunks, chunks);
+        CHECK_EQ(song.at(700).midiNumber(), 48 + 700 % 24);
+        CHECK(song.totalBeats() == 500.0f);
+        CHECK(song.startBeat(999) == 499.5f);
+        CHECK_EQ(song.indexAtBeat(250.2f), 500);
+
+        // Encoding one message at a time gives the bytes of toMIDI()
+        static uint8_t whole[6000], streamed[6000];
+        uint16_t len = song.toMIDI(whole, sizeof(whole));
+        CHECK_EQ(len, 800 * 6);
+        GingoSequenceEncoder songEnc(song, 0);
+        CHECK_EQ(encodeAll(songEnc, streamed, sizeof(streamed)), len);
+        CHECK(memcmp(whole, streamed, len) == 0);
+
+        GingoSequence copy(song);
+        CHECK_EQ(copy.size(), 1000);
+        CHECK_EQ(g_liveChunks, 2 * chunks);
+        CHECK(copy.totalBeats() == 500.0f);
+
+        // Editing restarts the starts from the edited event
+        CHECK(song.remove(10));
+        CHECK_EQ(song.size(), 999);
+        CHECK(song.totalBeats() == 499.5f);
+        CHECK(song.startBeat(10) == 5.0f);
+        CHECK_EQ(song.at(10).midiNumber(), 48 + 11);
+        song.transpose(2);
+        CHECK_EQ(song.at(0).midiNumber(), 50);
+        CHECK(song.totalBeats() == 499.5f);
+
+        copy = phrase;
+        CHECK_EQ(copy.size(), GINGODUINO_MAX_EVENTS);
+        CHECK_EQ(g_liveChunks, chunks);
+    }
+    CHECK_EQ(g_liveChunks, 0);
+}
+
+// ---------------------------------------------------------------------------
+
+int main() {
+    testNotes();
+    testIntervals();
+    testChords();
+    testScales();
+    testFields();
+    testTrees();
+    testProgressions();
+    testFretboards();
+    testSequences();
+
+    printf("gingoduino_test (constexpr tables %d): %d checks, %d failed\n",
+           GINGODUINO_CONSTEXPR_TABLES, g_checks, g_failures);
+    return g_failures ? 1 : 0;
+}
@@ -5,6 +5,7 @@
 
 #include "GingoChord.h"
 #include "gingoduino_progmem.h"
+#include "gingoduino_tables.h"
 
 namespace gingoduino {
 
@@ -12,6 +13,22 @@ namespace gingoduino {
 // Constructor helpers
 // ---------------------------------------------------------------------------
 
+// Root name + canonical type (+ "/" + bass). Returns the length written.
+static uint8_t writeChordName(const char* root, uint8_t formulaIdx, const char* bass,
+                              char* output, uint8_t maxLen) {
+    char typeName[8];
+    data::readPgmStr(typeName, data::CHORD_CANONICAL_NAMES[formulaIdx], sizeof(typeName));
+    uint8_t pos = 0;
+    for (const char* p = root; *p && pos < maxLen - 1; p++) output[pos++] = *p;
+    for (const char* p = typeName; *p && pos < maxLen - 1; p++) output[pos++] = *p;
+    if (bass) {
+        if (pos < maxLen - 1) output[pos++] = '/';
+        for (const char* p = bass; *p && pos < maxLen - 1; p++) output[pos++] = *p;
+    }
+    output[pos] = '\0';
+    return pos;
+}
+
 void GingoChord::resolveFormula() {
     if (type_.empty()) {
         // No type suffix means Major
@@ -52,6 +69,23 @@ GingoChord::GingoChord(const char* name)
     resolveFormula();
 }
 
+GingoChord::GingoChord(const GingoNote& root, ChordType type)
+    : rootStr_(root.name()), formulaIdx_(255)
+{
+    if (type >= CHORD_TYPE_COUNT) {
+        name_.set(root.name());
+        return;
+    }
+    char typeBuf[8];
+    data::readPgmStr(typeBuf, data::CHORD_CANONICAL_NAMES[type], sizeof(typeBuf));
+    type_.set(typeBuf);
+
+    char nameBuf[16];
+    writeChordName(root.name(), type, nullptr, nameBuf, sizeof(nameBuf));
+    name_.set(nameBuf);
+    formulaIdx_ = type;
+}
+
 // ---------------------------------------------------------------------------
 // Accessors
 // ---------------------------------------------------------------------------
@@ -74,10 +108,7 @@ uint8_t GingoChord::notes(GingoNote* output, uint8_t maxNotes) const {
 
     uint8_t written = 0;
     for (uint8_t i = 0; i < count && written < maxNotes; i++) {
-        uint8_t noteSt = (rootSt + intervals[i]) % 12;
-        char noteName[3];
-        data::readChromaticName(noteSt, noteName, sizeof(noteName));
-        output[written++] = GingoNote(noteName);
+        output[written++] = GingoNote::fromSemitone((rootSt + intervals[i]) % 12);
     }
     return written;
 }
@@ -101,17 +132,21 @@ uint8_t GingoChord::intervalLabels(LabelStr* output, uint8_t maxLabels) const {
 bool GingoChord::contains(const GingoNote& note) const {
     if (formulaIdx_ == 255) return false;
 
+    uint8_t rootSt = GingoNote::toSemitone(rootStr_.c_str());
+    uint8_t targetSt = note.semitone();
+
+#if GINGODUINO_CONSTEXPR_TABLES
+    return (data::CHORD_SETS.set[formulaIdx_] >> ((targetSt - rootSt + 12) % 12)) & 1;
+#else
     uint8_t intervals[7];
     uint8_t count;
     data::readChordFormula(formulaIdx_, intervals, &count);
 
-    uint8_t rootSt = GingoNote::toSemitone(rootStr_.c_str());
-    uint8_t targetSt = note.semitone();
-
     for (uint8_t i = 0; i < count; i++) {
         if ((rootSt + intervals[i]) % 12 == targetSt) return true;
     }
     return false;
+#endif
 }
 
 GingoChord GingoChord::transpose(int8_t semitones) const {
@@ -150,87 +185,150 @@ uint8_t GingoChord::intervals(GingoInterval* output, uint8_t maxIntervals) const
 // Identify
 // ---------------------------------------------------------------------------
 
-bool GingoChord::identify(const GingoNote* notes, uint8_t count,
-                          char* output, uint8_t maxLen) {
-    if (!notes || count == 0 || !output || maxLen < 2) return false;
+// Pitch-class set of the notes, transposed so that root is bit 0.
+static uint16_t rotateSet(uint16_t set, uint8_t root) {
+    if (root == 0) return set;
+    return (uint16_t)(((set >> root) | (set << (12 - root))) & 0x0FFF);
+}
 
+// Formula for a root-relative pitch-class set, or 255. When several
+// formulas fold to the same set, the one whose intervals match the note
+// order exactly (detected) is preferred, else the lowest index.
+static uint8_t lookupSet(uint16_t set, const uint8_t* detected, uint8_t count) {
+    int8_t e = data::findChordPitchSet(set);
+    if (e < 0) return 255;
+    uint8_t first = pgm_read_byte(&data::CHORD_PITCH_SETS[e].formulaIdx);
+    if (!detected) return first;
+
+    for (uint8_t k = (uint8_t)e; k < data::CHORD_PITCH_SETS_SIZE &&
+         pgm_read_word(&data::CHORD_PITCH_SETS[k].mask) == set; k++) {
+        uint8_t fi = pgm_read_byte(&data::CHORD_PITCH_SETS[k].formulaIdx);
+        uint8_t fIntervals[7];
+        uint8_t fCount;
+        data::readChordFormula(fi, fIntervals, &fCount);
+        if (fCount != count) continue;
+        bool match = true;
+        for (uint8_t j = 0; j < fCount; j++) {
+            if (detected[j] != fIntervals[j]) { match = false; break; }
+        }
+        if (match) return fi;
+    }
+    return first;
+}
+
+// Formula of notes with the first one as the root, or 255.
+static uint8_t identifyFormula(const GingoNote* notes, uint8_t count) {
     // Get root semitone (first note)
     uint8_t rootSt = notes[0].semitone();
 
-    // Compute interval offsets from root
+    // Pitch-class set relative to the root, plus the interval offsets in
+    // note order to tell apart formulas that share a set (add9 vs add2)
+    uint16_t set = 0;
     uint8_t detected[7];
-    for (uint8_t i = 0; i < count && i < 7; i++) {
-        detected[i] = (notes[i].semitone() - rootSt + 12) % 12;
-        // For extended chords, handle second octave
-        if (i > 0 && detected[i] <= detected[i - 1]) {
-            detected[i] += 12;
+    for (uint8_t i = 0; i < count; i++) {
+        uint8_t iv = (notes[i].semitone() - rootSt + 12) % 12;
+        set |= (uint16_t)(1u << iv);
+        if (i < 7) {
+            detected[i] = iv;
+            // For extended chords, handle second octave
+            if (i > 0 && detected[i] <= detected[i - 1]) {
+                detected[i] += 12;
+            }
         }
     }
 
-    // Compare against every formula
-    for (uint8_t fi = 0; fi < 42; fi++) {
-        uint8_t fIntervals[7];
-        uint8_t fCount;
-        data::readChordFormula(fi, fIntervals, &fCount);
+    return lookupSet(set, detected, count);
+}
 
-        if (fCount != count) continue;
+bool GingoChord::identify(const GingoNote* notes, uint8_t count,
+                          char* output, uint8_t maxLen) {
+    if (!notes || count == 0 || !output || maxLen < 2) return false;
 
-        bool match = true;
-        for (uint8_t j = 0; j < fCount; j++) {
-            if (detected[j] != fIntervals[j]) {
-                match = false;
-                break;
-            }
-        }
+    uint8_t fi = identifyFormula(notes, count);
+    if (fi == 255) {
+        output[0] = '\0';
+        return false;
+    }
+    writeChordName(notes[0].name(), fi, nullptr, output, maxLen);
+    return true;
+}
 
-        if (match) {
-            // Found! Build chord name: root + canonical type name
-            const char* rootName = notes[0].name();
-            uint8_t pos = 0;
-            while (rootName[pos] && pos < maxLen - 1) {
-                output[pos] = rootName[pos];
-                pos++;
-            }
+bool GingoChord::identify(const GingoNote* notes, uint8_t count, GingoChordId& id) {
+    if (!notes || count == 0) return false;
 
-            // Find canonical name for this formula index
-            // (shortest name that maps to this index)
-            char bestName[10] = "";
-            uint8_t bestLen = 255;
-            for (uint8_t a = 0; a < data::CHORD_TYPE_MAP_SIZE; a++) {
-                uint8_t idx = pgm_read_byte(&data::CHORD_TYPE_MAP[a].formulaIdx);
-                if (idx == fi) {
-                    char aliasName[10];
-                    data::readPgmStr(aliasName, data::CHORD_TYPE_MAP[a].name, sizeof(aliasName));
-                    uint8_t alen = (uint8_t)strlen(aliasName);
-                    // Prefer shortest alphanumeric name
-                    bool hasAlpha = false;
-                    for (uint8_t c = 0; c < alen; c++) {
-                        if ((aliasName[c] >= 'A' && aliasName[c] <= 'Z') ||
-                            (aliasName[c] >= 'a' && aliasName[c] <= 'z') ||
-                            (aliasName[c] >= '0' && aliasName[c] <= '9')) {
-                            hasAlpha = true;
-                            break;
-                        }
-                    }
-                    if (hasAlpha && alen < bestLen) {
-                        bestLen = alen;
-                        for (uint8_t c = 0; c <= alen; c++) bestName[c] = aliasName[c];
-                    }
-                }
-            }
+    uint8_t fi = identifyFormula(notes, count);
+    if (fi == 255) return false;
+    id.root = notes[0].semitone();
+    id.formulaIdx = fi;
+    return true;
+}
 
-            // Append type name
-            uint8_t ti = 0;
-            while (bestName[ti] && pos < maxLen - 1) {
-                output[pos++] = bestName[ti++];
+bool GingoChord::identifyVoicing(const GingoNote* notes, uint8_t count,
+                                 GingoChordMatch* match) {
+    if (!notes || count == 0 || !match) return false;
+
+    uint16_t set = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        set |= (uint16_t)(1u << notes[i].semitone());
+    }
+    uint8_t bass = notes[0].semitone();
+    uint16_t upper = set & (uint16_t)~(1u << bass);
+    uint8_t pitches = 0;
+    for (uint16_t s = set; s; s &= s - 1) pitches++;
+
+    // One pass over the 12 candidate roots, starting at the bass so that
+    // root position returns at once. Lower kind wins, then lower formula.
+    uint8_t bestKind = 255, bestFormula = 255, bestRoot = 0;
+    for (uint8_t n = 0; n < 12; n++) {
+        uint8_t root = (bass + n) % 12;
+        uint8_t kind;
+        uint8_t fi;
+        if (set & (1u << root)) {
+            fi = lookupSet(rotateSet(set, root), nullptr, 0);
+            kind = (root == bass) ? GingoChordMatch::ROOT_POSITION : GingoChordMatch::INVERSION;
+            if (fi == 255 && root != bass && pitches >= 4) {
+                fi = lookupSet(rotateSet(upper, root), nullptr, 0);
+                kind = GingoChordMatch::SLASH;
             }
-            output[pos] = '\0';
-            return true;
+        } else {
+            if (pitches < 3) continue;
+            fi = lookupSet(rotateSet(set, root) | 1u, nullptr, 0);
+            kind = GingoChordMatch::ROOTLESS;
+            if (fi != 255 && pgm_read_byte(&data::CHORD_FORMULAS[fi].count) < 4) continue;
+        }
+        if (fi == 255) continue;
+        if (kind < bestKind || (kind == bestKind && fi < bestFormula)) {
+            bestKind = kind;
+            bestFormula = fi;
+            bestRoot = root;
+            if (kind == GingoChordMatch::ROOT_POSITION) break;
         }
     }
+    if (bestKind == 255) return false;
 
-    output[0] = '\0';
-    return false;
+    // Spell the root and bass as they were given; a rootless root uses
+    // the sharp-based chromatic name
+    char rootName[5];
+    data::readChromaticName(bestRoot, rootName, sizeof(rootName));
+    for (uint8_t i = 0; i < count; i++) {
+        if (notes[i].semitone() != bestRoot) continue;
+        const char* given = notes[i].name();
+        uint8_t k = 0;
+        while (given[k] && k < sizeof(rootName) - 1) { rootName[k] = given[k]; k++; }
+        rootName[k] = '\0';
+        break;
+    }
+    bool slashed = bestKind == GingoChordMatch::INVERSION || bestKind == GingoChordMatch::SLASH;
+
+    char nameBuf[16];
+    writeChordName(rootName, bestFormula, slashed ? notes[0].name() : nullptr,
+                   nameBuf, sizeof(nameBuf));
+    match->name.set(nameBuf);
+    match->root = bestRoot;
+    match->bass = bass;
+    match->formulaIdx = bestFormula;
+    match->kind = (GingoChordMatch::Kind)bestKind;
+    return true;
 }
 
 } // namespace gingoduino
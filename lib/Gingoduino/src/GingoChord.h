@@ -13,6 +13,28 @@
 
 namespace gingoduino {
 
+/// Result of GingoChord::identifyVoicing().
+struct GingoChordMatch {
+    enum Kind : uint8_t {
+        ROOT_POSITION,  // lowest note is the root
+        INVERSION,      // lowest note is another chord tone: "CM/E"
+        SLASH,          // lowest note is outside the chord: "D/C"
+        ROOTLESS        // root not played (jazz voicing); name includes it
+    };
+
+    NameStr name;        // "CM", "Am7/C", "CM9"
+    uint8_t root;        // pitch class of the root (C = 0)
+    uint8_t bass;        // pitch class of the first note
+    uint8_t formulaIdx;  // index in CHORD_FORMULAS
+    Kind    kind;
+};
+
+/// A chord as numbers: root pitch class and formula, no name.
+struct GingoChordId {
+    uint8_t root;        // pitch class of the root (C = 0)
+    uint8_t formulaIdx;  // index in CHORD_FORMULAS (ChordType)
+};
+
 /// Represents a musical chord — a root note plus a set of intervals.
 ///
 /// Constructed from a name string (e.g. "Cm7", "Db7M", "A#m") and
@@ -28,6 +50,8 @@ namespace gingoduino {
 ///
 ///   GingoNote notes[7];
 ///   uint8_t n = c.notes(notes, 7);  // n=4, notes filled
+///
+///   GingoChord d(GingoNote("D"), CHORD_MINOR_7);  // "Dm7"
 class GingoChord {
 public:
     /// Default constructor (C Major).
@@ -36,6 +60,10 @@ public:
     /// Construct from a chord name: "CM", "Dm7", "Bb7M(#5)", etc.
     explicit GingoChord(const char* name);
 
+    /// Construct from a root and a formula, without parsing a name.
+    /// The name is the root plus the canonical type: (Bb, CHORD_MINOR_7) -> "Bbm7".
+    GingoChord(const GingoNote& root, ChordType type);
+
     /// The full chord name as given.
     const char* name() const { return name_.c_str(); }
 
@@ -63,11 +91,28 @@ public:
     GingoChord transpose(int8_t semitones) const;
 
     /// Identify a chord from a set of notes (reverse lookup).
-    /// The first note is treated as the root.
+    /// The first note is treated as the root; the others may come in any
+    /// order or octave, and may repeat.
     /// Writes the chord name to output. Returns true if found.
     static bool identify(const GingoNote* notes, uint8_t count,
                          char* output, uint8_t maxLen);
 
+    /// Identify a chord like above, as an ID instead of a name.
+    /// Returns true and fills id if found.
+    static bool identify(const GingoNote* notes, uint8_t count, GingoChordId& id);
+
+    /// Identify a voicing: like identify(), but the first note is only the
+    /// bass. Every rotation of the pitch-class set is tried in one pass;
+    /// root position wins over an inversion, then a slash chord over a
+    /// foreign bass, then a rootless voicing (4+ note chords only).
+    /// Returns true and fills match if any fits.
+    ///
+    ///   {E, G, C}        -> "CM/E"   INVERSION
+    ///   {C, D, F#, A}    -> "D7/C"   INVERSION
+    ///   {C, F#, A, C#}   -> "F#m/C"  SLASH
+    static bool identifyVoicing(const GingoNote* notes, uint8_t count,
+                                GingoChordMatch* match);
+
     /// Fill output array with GingoInterval objects for this chord.
     /// Returns the number of intervals written.
     uint8_t intervals(GingoInterval* output, uint8_t maxIntervals) const;
@@ -8,6 +8,7 @@
 #if GINGODUINO_HAS_FIELD
 
 #include "gingoduino_progmem.h"
+#include "gingoduino_tables.h"
 
 namespace gingoduino {
 
@@ -59,6 +60,10 @@ GingoField::GingoField(const char* tonic, ScaleType type)
     : scale_(tonic, type)
 {}
 
+GingoField::GingoField(const GingoNote& tonic, ScaleType type)
+    : scale_(tonic, type)
+{}
+
 GingoField::GingoField(const char* tonic, const char* typeName)
     : scale_(tonic, typeName)
 {}
@@ -75,6 +80,24 @@ uint8_t GingoField::buildChords(GingoChord* output, uint8_t maxChords,
     if (scaleSize == 0) return 0;
 
     uint8_t written = 0;
+
+#if GINGODUINO_CONSTEXPR_TABLES
+    // Stacked thirds on a whole parent scale: the formulas are in
+    // FIELD_CHORDS, so no chord needs identifying or its name parsing
+    if (!scale_.isPentatonic() && (offsetCount == 3 || offsetCount == 4)) {
+        const data::FieldRow& row = data::FIELD_CHORDS.row[scale_.parent()];
+        const uint8_t* formulas = (offsetCount == 3) ? row.triad : row.seventh;
+        uint8_t mode = scale_.modeNumber();
+        uint8_t first = (mode >= 1 && mode <= scaleSize) ? mode - 1 : 0;
+        for (uint8_t i = 0; i < scaleSize && written < maxChords; i++) {
+            uint8_t fi = formulas[(first + i) % scaleSize];
+            // No formula fits: root + "M", as below
+            output[written++] = GingoChord(scaleNotes[i], fi == 255 ? CHORD_MAJOR : (ChordType)fi);
+        }
+        return written;
+    }
+#endif
+
     for (uint8_t i = 0; i < scaleSize && written < maxChords; i++) {
         // Collect chord tones by picking scale notes at the offsets
         GingoNote chordNotes[7];
@@ -177,174 +200,267 @@ const char* GingoField::roleOf(const char* chordName, char* buf, uint8_t maxLen)
 // deduce — infer probable harmonic fields from notes or chords
 // ---------------------------------------------------------------------------
 
-// Helper: detect if string looks like a bare note (1-2 chars, A-G + optional #/b)
-static bool looksLikeNote(const char* s) {
-    if (!s || !s[0]) return false;
-    char c = s[0];
-    if (c < 'A' || c > 'G') return false;
-    if (s[1] == '\0') return true;
-    if ((s[1] == '#' || s[1] == 'b') && s[2] == '\0') return true;
-    if (s[1] == '#' && s[2] == '#' && s[3] == '\0') return true;
-    if (s[1] == 'b' && s[2] == 'b' && s[3] == '\0') return true;
-    return false;
+// Every candidate key is scored on 12-bit sets. The input's roots (its
+// pitch classes in note mode) are grouped by formula; each group rotated
+// to the candidate tonic and ANDed with the roots whose triad or seventh
+// has that formula gives its matches as a popcount. A group holds each
+// root once, so a repeated item opens another group. Roles are filled in
+// only for the results written.
+
+// Candidate scale types (same 5 as gingo), in ScaleType order
+static const ScaleType DEDUCE_TYPES[] = {
+    SCALE_MAJOR, SCALE_NATURAL_MINOR, SCALE_HARMONIC_MINOR,
+    SCALE_MELODIC_MINOR, SCALE_HARMONIC_MAJOR
+};
+static const uint8_t DEDUCE_TYPE_COUNT = sizeof(DEDUCE_TYPES) / sizeof(DEDUCE_TYPES[0]);
+
+// Input items grouped per pass; scores add up across passes
+static const uint8_t DEDUCE_GROUPS = 16;
+
+// Chromatic tonic names
+static const char* const TONICS[12] = {
+    "C", "C#", "D", "D#", "E", "F",
+    "F#", "G", "G#", "A", "A#", "B"
+};
+
+static const char* const ROMAN[7] = {
+    "I", "II", "III", "IV", "V", "VI", "VII"
+};
+static const char* const ROMAN7[7] = {
+    "I7", "II7", "III7", "IV7", "V7", "VI7", "VII7"
+};
+
+// A candidate scale type, relative to a tonic of C.
+struct DeduceScale {
+    uint16_t set;         // pitch classes
+    uint8_t  step[7];     // semitone of each degree
+    uint8_t  triad[7];    // formula of each degree's triad
+    uint8_t  seventh[7];  // formula of each degree's seventh chord
+};
+
+static void loadDeduceScale(ScaleType type, DeduceScale& ds) {
+    ds.set = (uint16_t)(pgm_read_dword(&data::SCALE_MASKS[type]) & 0x0FFF);
+    uint8_t d = 0;
+    for (uint8_t pc = 0; pc < 12 && d < 7; pc++) {
+        if (ds.set & (1u << pc)) ds.step[d++] = pc;
+    }
+#if GINGODUINO_CONSTEXPR_TABLES
+    const data::FieldRow& row = data::FIELD_CHORDS.row[type];
+    for (d = 0; d < 7; d++) {
+        // No formula fits: root + "M", as buildChords() does
+        ds.triad[d]   = row.triad[d]   == 255 ? (uint8_t)CHORD_MAJOR : row.triad[d];
+        ds.seventh[d] = row.seventh[d] == 255 ? (uint8_t)CHORD_MAJOR : row.seventh[d];
+    }
+#else
+    GingoField field(GingoNote::fromSemitone(0), type);
+    GingoChord chords[7];
+    uint8_t n = field.chords(chords, 7);
+    for (d = 0; d < 7; d++) ds.triad[d] = d < n ? chords[d].formulaIndex() : 255;
+    n = field.sevenths(chords, 7);
+    for (d = 0; d < 7; d++) ds.seventh[d] = d < n ? chords[d].formulaIndex() : 255;
+#endif
+}
+
+// Roots of the degrees whose triad or seventh has formula f.
+static uint16_t rootsWith(const DeduceScale& ds, uint8_t f) {
+    uint16_t roots = 0;
+    for (uint8_t d = 0; d < 7; d++) {
+        if (ds.triad[d] == f || ds.seventh[d] == f) roots |= (uint16_t)(1u << ds.step[d]);
+    }
+    return roots;
+}
+
+// Transpose a pitch-class set so that pitch class k is bit 0.
+static uint16_t rotateDown(uint16_t set, uint8_t k) {
+    return (uint16_t)(((set >> k) | (set << (12 - k))) & 0x0FFF);
 }
 
-// Helper: simple insertion sort for FieldMatch by (matched desc, scaleType asc)
-static void sortMatches(FieldMatch* arr, uint8_t n) {
-    for (uint8_t i = 1; i < n; i++) {
-        FieldMatch key = arr[i];
-        int8_t j = (int8_t)(i - 1);
-        while (j >= 0 && (arr[j].matched < key.matched ||
-               (arr[j].matched == key.matched && arr[j].scaleType > key.scaleType))) {
-            arr[j + 1] = arr[j];
-            j--;
+struct DeduceGroup {
+    uint16_t roots;
+    uint8_t  formula;
+};
+
+struct DeduceCandidate {
+    uint8_t matched;
+    uint8_t type;   // index in DEDUCE_TYPES
+    uint8_t tonic;  // pitch class
+};
+
+// Item readers for deduceItems(): root pitch class and formula of item i
+// (formula unused in note mode).
+
+struct NameItems {
+    const char* const* items;
+    bool               notes;
+    void operator()(uint8_t i, uint8_t& root, uint8_t& formula) const {
+        if (notes) {
+            root = GingoNote(items[i]).semitone();
+            formula = 0;
+        } else {
+            GingoChord c(items[i]);
+            root = c.root().semitone();
+            formula = c.formulaIndex();
         }
-        arr[j + 1] = key;
     }
+};
+
+struct MidiItems {
+    const uint8_t* notes;
+    void operator()(uint8_t i, uint8_t& root, uint8_t& formula) const {
+        root = notes[i] % 12;
+        formula = 0;
+    }
+};
+
+struct IdItems {
+    const GingoChordId* chords;
+    void operator()(uint8_t i, uint8_t& root, uint8_t& formula) const {
+        root = chords[i].root % 12;
+        formula = chords[i].formulaIdx;
+    }
+};
+
+static void copyRole(char* dst, const char* rom) {
+    uint8_t ri = 0;
+    while (rom[ri] && ri < 7) {
+        dst[ri] = rom[ri];
+        ri++;
+    }
+    dst[ri] = '\0';
 }
 
-uint8_t GingoField::deduce(const char* const* items, uint8_t itemCount,
+template<class Items>
+static void fillRoles(const Items& read, uint8_t count, bool chordMode,
+                      const DeduceScale& ds, uint8_t tonic, FieldMatch& fm) {
+    fm.roleCount = 0;
+    for (uint8_t i = 0; i < count && fm.roleCount < 7; i++) {
+        uint8_t root, f;
+        read(i, root, f);
+        uint8_t rel = (uint8_t)((root - tonic + 12) % 12);
+        if (!(ds.set & (1u << rel))) continue;
+        uint8_t d = (uint8_t)__builtin_popcount(ds.set & ((1u << rel) - 1));
+        const char* rom;
+        if (!chordMode || ds.triad[d] == f) rom = ROMAN[d];
+        else if (ds.seventh[d] == f)        rom = ROMAN7[d];
+        else continue;
+        copyRole(fm.roles[fm.roleCount++], rom);
+    }
+}
+
+template<class Items>
+static uint8_t deduceItems(const Items& read, uint8_t count, bool chordMode,
                            FieldMatch* output, uint8_t maxResults) {
-    if (itemCount == 0 || maxResults == 0) return 0;
+    if (count == 0 || maxResults == 0) return 0;
 
-    // Detect input type from first item
-    bool noteMode = looksLikeNote(items[0]);
-
-    // Candidate scale types (same 5 as gingo)
-    static const ScaleType DEDUCE_TYPES[] = {
-        SCALE_MAJOR, SCALE_NATURAL_MINOR, SCALE_HARMONIC_MINOR,
-        SCALE_MELODIC_MINOR, SCALE_HARMONIC_MAJOR
-    };
-
-    // Chromatic tonic names
-    static const char* const TONICS[12] = {
-        "C", "C#", "D", "D#", "E", "F",
-        "F#", "G", "G#", "A", "A#", "B"
-    };
-
-    // Collect all candidates in a temporary buffer (max 60)
-    // We use maxResults as output cap but need to compare all 60 internally
-    FieldMatch candidates[60];
-    uint8_t candCount = 0;
+    DeduceScale scales[DEDUCE_TYPE_COUNT];
+    for (uint8_t t = 0; t < DEDUCE_TYPE_COUNT; t++) {
+        loadDeduceScale(DEDUCE_TYPES[t], scales[t]);
+    }
 
-    for (uint8_t t = 0; t < 5; t++) {
-        ScaleType st = DEDUCE_TYPES[t];
-        for (uint8_t k = 0; k < 12; k++) {
-            GingoField field(TONICS[k], st);
-            uint8_t matched = 0;
-            uint8_t roleCount = 0;
-
-            FieldMatch& fm = candidates[candCount];
-            fm.tonicName = TONICS[k];
-            fm.scaleType = st;
-            fm.total = itemCount;
-            fm.roleCount = 0;
-
-            if (noteMode) {
-                // Note mode: check if each note's pitch class belongs to the scale
-                for (uint8_t i = 0; i < itemCount; i++) {
-                    GingoNote n(items[i]);
-                    uint8_t deg = field.scale().degreeOf(n);
-                    if (deg > 0) {
-                        matched++;
-                        if (roleCount < 7) {
-                            // Write roman numeral degree
-                            static const char* const ROMAN[] = {
-                                "", "I", "II", "III", "IV", "V", "VI", "VII"
-                            };
-                            if (deg <= 7) {
-                                uint8_t ri = 0;
-                                const char* rom = ROMAN[deg];
-                                while (rom[ri] && ri < 7) {
-                                    fm.roles[roleCount][ri] = rom[ri];
-                                    ri++;
-                                }
-                                fm.roles[roleCount][ri] = '\0';
-                                roleCount++;
-                            }
-                        }
-                    }
-                }
-            } else {
-                // Chord mode: check if each chord matches a triad or seventh
-                GingoChord triads[7];
-                GingoChord seventhsArr[7];
-                uint8_t nTriads = field.chords(triads, 7);
-                uint8_t nSevenths = field.sevenths(seventhsArr, 7);
-
-                for (uint8_t i = 0; i < itemCount; i++) {
-                    GingoChord inputChord(items[i]);
-                    uint8_t inputRoot = inputChord.root().semitone();
-                    const char* inputType = inputChord.type();
-                    bool found = false;
-
-                    // Check triads
-                    for (uint8_t d = 0; d < nTriads && !found; d++) {
-                        if (triads[d].root().semitone() == inputRoot &&
-                            strcmp(triads[d].type(), inputType) == 0) {
-                            found = true;
-                            if (roleCount < 7) {
-                                static const char* const ROMAN[] = {
-                                    "I", "II", "III", "IV", "V", "VI", "VII"
-                                };
-                                uint8_t ri = 0;
-                                const char* rom = ROMAN[d];
-                                while (rom[ri] && ri < 7) {
-                                    fm.roles[roleCount][ri] = rom[ri];
-                                    ri++;
-                                }
-                                fm.roles[roleCount][ri] = '\0';
-                                roleCount++;
-                            }
-                        }
-                    }
-
-                    // Check sevenths
-                    for (uint8_t d = 0; d < nSevenths && !found; d++) {
-                        if (seventhsArr[d].root().semitone() == inputRoot &&
-                            strcmp(seventhsArr[d].type(), inputType) == 0) {
-                            found = true;
-                            if (roleCount < 7) {
-                                static const char* const ROMAN7[] = {
-                                    "I7", "II7", "III7", "IV7", "V7", "VI7", "VII7"
-                                };
-                                uint8_t ri = 0;
-                                const char* rom = ROMAN7[d];
-                                while (rom[ri] && ri < 7) {
-                                    fm.roles[roleCount][ri] = rom[ri];
-                                    ri++;
-                                }
-                                fm.roles[roleCount][ri] = '\0';
-                                roleCount++;
-                            }
-                        }
-                    }
-
-                    if (found) matched++;
-                }
+    uint8_t matched[DEDUCE_TYPE_COUNT][12];
+    memset(matched, 0, sizeof(matched));
+
+    for (uint16_t first = 0; first < count; ) {
+        DeduceGroup groups[DEDUCE_GROUPS];
+        uint8_t groupCount = 0;
+        uint16_t i = first;
+        for (; i < count && groupCount < DEDUCE_GROUPS; i++) {
+            uint8_t root, f;
+            read((uint8_t)i, root, f);
+            if (!chordMode) f = 0;
+            else if (f >= CHORD_TYPE_COUNT) continue;  // unknown chord matches nothing
+            uint16_t bit = (uint16_t)(1u << root);
+            uint8_t g = 0;
+            while (g < groupCount && (groups[g].formula != f || (groups[g].roots & bit))) g++;
+            if (g == groupCount) {
+                groups[g].roots = 0;
+                groups[g].formula = f;
+                groupCount++;
             }
+            groups[g].roots |= bit;
+        }
+        first = i;
 
-            fm.matched = matched;
-            fm.roleCount = roleCount;
-
-            // Only keep candidates with at least one match
-            if (matched > 0) {
-                candCount++;
+        for (uint8_t t = 0; t < DEDUCE_TYPE_COUNT; t++) {
+            uint16_t keyRoots[DEDUCE_GROUPS];
+            for (uint8_t g = 0; g < groupCount; g++) {
+                keyRoots[g] = chordMode ? rootsWith(scales[t], groups[g].formula) : scales[t].set;
+            }
+            for (uint8_t k = 0; k < 12; k++) {
+                uint8_t m = 0;
+                for (uint8_t g = 0; g < groupCount; g++) {
+                    m += (uint8_t)__builtin_popcount(rotateDown(groups[g].roots, k) & keyRoots[g]);
+                }
+                matched[t][k] += m;
             }
         }
     }
 
-    // Sort by matched desc, then scaleType asc
-    sortMatches(candidates, candCount);
+    // Keep candidates with at least one match, by matched desc; listed in
+    // (scale type, tonic) order and sorted stably, so ties keep that order
+    DeduceCandidate cands[DEDUCE_TYPE_COUNT * 12];
+    uint8_t candCount = 0;
+    for (uint8_t t = 0; t < DEDUCE_TYPE_COUNT; t++) {
+        for (uint8_t k = 0; k < 12; k++) {
+            if (matched[t][k] == 0) continue;
+            DeduceCandidate c = { matched[t][k], t, k };
+            uint8_t j = candCount++;
+            while (j > 0 && cands[j - 1].matched < c.matched) {
+                cands[j] = cands[j - 1];
+                j--;
+            }
+            cands[j] = c;
+        }
+    }
 
-    // Copy top results
     uint8_t written = (candCount < maxResults) ? candCount : maxResults;
     for (uint8_t i = 0; i < written; i++) {
-        output[i] = candidates[i];
+        const DeduceCandidate& c = cands[i];
+        FieldMatch& fm = output[i];
+        fm.tonicName = TONICS[c.tonic];
+        fm.scaleType = DEDUCE_TYPES[c.type];
+        fm.matched = c.matched;
+        fm.total = count;
+        fillRoles(read, count, chordMode, scales[c.type], c.tonic, fm);
     }
     return written;
 }
 
+// Helper: detect if string looks like a bare note (1-2 chars, A-G + optional #/b)
+static bool looksLikeNote(const char* s) {
+    if (!s || !s[0]) return false;
+    char c = s[0];
+    if (c < 'A' || c > 'G') return false;
+    if (s[1] == '\0') return true;
+    if ((s[1] == '#' || s[1] == 'b') && s[2] == '\0') return true;
+    if (s[1] == '#' && s[2] == '#' && s[3] == '\0') return true;
+    if (s[1] == 'b' && s[2] == 'b' && s[3] == '\0') return true;
+    return false;
+}
+
+uint8_t GingoField::deduce(const char* const* items, uint8_t itemCount,
+                           FieldMatch* output, uint8_t maxResults) {
+    if (itemCount == 0 || maxResults == 0) return 0;
+
+    // Detect input type from first item
+    NameItems read = { items, looksLikeNote(items[0]) };
+    return deduceItems(read, itemCount, !read.notes, output, maxResults);
+}
+
+uint8_t GingoField::deduce(const uint8_t* midiNotes, uint8_t noteCount,
+                           FieldMatch* output, uint8_t maxResults) {
+    if (!midiNotes) return 0;
+    MidiItems read = { midiNotes };
+    return deduceItems(read, noteCount, false, output, maxResults);
+}
+
+uint8_t GingoField::deduce(const GingoChordId* chords, uint8_t chordCount,
+                           FieldMatch* output, uint8_t maxResults) {
+    if (!chords) return 0;
+    IdItems read = { chords };
+    return deduceItems(read, chordCount, true, output, maxResults);
+}
+
 } // namespace gingoduino
 
 #endif // GINGODUINO_HAS_FIELD
@@ -40,6 +40,8 @@ public:
     GingoField();
     GingoField(const char* tonic, ScaleType type);
     GingoField(const char* tonic, const char* typeName);
+    /// From a tonic note (no name parsing).
+    GingoField(const GingoNote& tonic, ScaleType type);
 
     /// The tonic note.
     GingoNote tonic() const { return scale_.tonic(); }
@@ -91,11 +93,22 @@ public:
     static uint8_t deduce(const char* const* items, uint8_t itemCount,
                           FieldMatch* output, uint8_t maxResults);
 
+    /// Deduce from MIDI note numbers (octave ignored), as note mode above.
+    static uint8_t deduce(const uint8_t* midiNotes, uint8_t noteCount,
+                          FieldMatch* output, uint8_t maxResults);
+
+    /// Deduce from chord IDs (e.g. from GingoChord::identify()), as chord
+    /// mode above. No name is built or parsed.
+    static uint8_t deduce(const GingoChordId* chords, uint8_t chordCount,
+                          FieldMatch* output, uint8_t maxResults);
+
 private:
     GingoScale scale_;
 
     /// Build chords by stacking intervals at given degree offsets.
-    /// offsets: array of scale-degree offsets {0, 2, 4} for triads.
+    /// offsets: array of scale-degree offsets {0, 2, 4} for triads,
+    /// {0, 2, 4, 6} for sevenths (the only ones used, which lets the
+    /// constexpr tables stand in for identify()).
     uint8_t buildChords(GingoChord* output, uint8_t maxChords,
                         const uint8_t* offsets, uint8_t offsetCount) const;
 };
@@ -71,9 +71,7 @@ GingoFretPos GingoFretboard::position(uint8_t string, uint8_t fret) const {
     } else {
         pos.midi = 0;
     }
-    char name[3];
-    data::readChromaticName(pos.midi % 12, name, sizeof(name));
-    pos.note = GingoNote(name);
+    pos.note = GingoNote::fromSemitone(pos.midi % 12);
     pos.octave = (pos.midi / 12) - 1;
     return pos;
 }
@@ -83,9 +81,7 @@ GingoNote GingoFretboard::noteAt(uint8_t string, uint8_t fret) const {
     if (string < numStrings_) {
         midi = openMidi_[string] + capoFret_ + fret;
     }
-    char name[3];
-    data::readChromaticName(midi % 12, name, sizeof(name));
-    return GingoNote(name);
+    return GingoNote::fromSemitone(midi % 12);
 }
 
 uint8_t GingoFretboard::midiAt(uint8_t string, uint8_t fret) const {
@@ -125,9 +121,7 @@ uint8_t GingoFretboard::scalePositions(const GingoScale& scale,
         uint8_t baseMidi = openMidi_[s] + capoFret_;
         for (uint8_t f = fretLo; f <= fretHi && written < maxPositions; f++) {
             uint8_t midi = baseMidi + f;
-            char name[3];
-            data::readChromaticName(midi % 12, name, sizeof(name));
-            GingoNote n(name);
+            GingoNote n = GingoNote::fromSemitone(midi % 12);
             if (scale.contains(n)) {
                 GingoFretPos& p = output[written++];
                 p.string = s;
@@ -145,20 +139,46 @@ uint8_t GingoFretboard::scalePositions(const GingoScale& scale,
 // Fingerings
 // ---------------------------------------------------------------------------
 
-uint16_t GingoFretboard::scoreFingering(const GingoFingering& fg) const {
+// Fingers a shape needs (frets per string, 255 = muted): one per fretted
+// string, less what one barre saves. A barre at fret f covers adjacent
+// strings fretted at f or above (muted ones may lie between), and holds
+// all of those at f with one finger.
+static uint8_t fingersFor(const uint8_t* frets, uint8_t numStrings, bool barre) {
+    uint8_t fretted = 0, held = 1;
+    for (uint8_t s = 0; s < numStrings; s++) {
+        uint8_t f = frets[s];
+        if (f == 0 || f == 255) continue;
+        fretted++;
+        if (!barre) continue;
+        // Barre at f from string s upwards
+        uint8_t run = 0;
+        for (uint8_t t = s; t < numStrings; t++) {
+            if (frets[t] == 255) continue;
+            if (frets[t] == 0 || frets[t] < f) break;
+            if (frets[t] == f) run++;
+        }
+        if (run > held) held = run;
+    }
+    return fretted ? (uint8_t)(fretted - held + 1) : 0;
+}
+
+// Playability of a shape, lower = better. Muting strings below the bass
+// note is easy; a muted string above it costs more.
+static uint16_t shapeScore(const uint8_t* frets, uint8_t numStrings) {
     uint16_t score = 0;
     uint8_t minFret = 255, maxFret = 0;
-    uint8_t mutedCount = 0;
+    bool sounding = false;
 
-    for (uint8_t i = 0; i < fg.numStrings; i++) {
-        if (fg.strings[i].action == STRING_MUTED) {
-            mutedCount++;
-            score += 10;
-        } else if (fg.strings[i].action == STRING_FRETTED) {
-            uint8_t f = fg.strings[i].fret;
-            if (f < minFret) minFret = f;
-            if (f > maxFret) maxFret = f;
+    for (uint8_t s = 0; s < numStrings; s++) {
+        uint8_t f = frets[s];
+        if (f == 255) {
+            score += sounding ? 18 : 6;
+            continue;
         }
+        sounding = true;
+        if (f == 0) continue;
+        if (f < minFret) minFret = f;
+        if (f > maxFret) maxFret = f;
     }
 
     // Span penalty
@@ -171,115 +191,286 @@ uint16_t GingoFretboard::scoreFingering(const GingoFingering& fg) const {
         score += minFret;
     }
 
-    // Prefer more sounding notes
-    if (mutedCount > 0) {
-        score += (uint16_t)mutedCount * 8;
-    }
+    // Each fretting finger (a barre counts once)
+    score += (uint16_t)fingersFor(frets, numStrings, true) * 2;
 
     return score;
 }
 
-bool GingoFretboard::fingering(const GingoChord& chord, uint8_t positionIdx,
-                               GingoFingering& output) const {
-    // Get chord notes
-    GingoNote chordNotes[7];
-    uint8_t chordSize = chord.notes(chordNotes, 7);
-    if (chordSize == 0) return false;
+uint16_t GingoFretboard::scoreFingering(const GingoFingering& fg) const {
+    uint8_t frets[GINGODUINO_MAX_STRINGS];
+    for (uint8_t i = 0; i < fg.numStrings; i++) {
+        frets[i] = (fg.strings[i].action == STRING_MUTED) ? 255 : fg.strings[i].fret;
+    }
+    return shapeScore(frets, fg.numStrings);
+}
 
-    // Determine the fret window based on positionIdx
-    uint8_t windowStart = positionIdx * 4;
-    uint8_t windowEnd = windowStart + 4;
-    if (windowEnd > numFrets_) windowEnd = numFrets_;
-    if (windowStart > numFrets_) return false;
+// ---------------------------------------------------------------------------
+// Fingering search
+// ---------------------------------------------------------------------------
+//
+// Depth-first over the strings, low to high, once per hand position: the
+// lowest fretted fret b (0 = open strings only). Each string is open,
+// muted, or fretted on a chord tone within [b, b + maxSpan - 1]. The
+// score's mute, span and position terms only grow as strings are added,
+// so a branch is cut as soon as they can't beat the worst of the k shapes
+// kept, or the strings left can't sound the missing tones.
+
+struct FretSearch {
+    GingoFingeringRules rules;
+    uint8_t  numStrings;
+    uint8_t  openPc[GINGODUINO_MAX_STRINGS];
+    uint32_t toneFrets[GINGODUINO_MAX_STRINGS];  // bit f: fret f is a chord tone
+    uint32_t rootFrets[GINGODUINO_MAX_STRINGS];  // bit f: fret f is the root
+    uint16_t required;                           // pitch classes that must sound
+    uint8_t  base;                               // hand position
+    uint32_t window;                             // frets allowed at base (bit 0 = open)
+    uint8_t  lastOnBase;                         // highest string with a tone at base
+    uint8_t  onBase;                             // strings of the shape at base
+    uint8_t  frets[GINGODUINO_MAX_STRINGS];      // shape so far, 255 = muted
+    GingoFretShape* best;
+    uint8_t  k;
+    uint8_t  found;
+};
+
+static uint8_t bitCount(uint16_t v) {
+    uint8_t n = 0;
+    while (v) { v &= (uint16_t)(v - 1); n++; }
+    return n;
+}
 
-    // Initialize output
-    output.numStrings = numStrings_;
-    output.chordName.set(chord.name());
-    output.baseFret = windowStart;
-    output.capoFret = capoFret_;
-    output.numNotes = 0;
+// Insert the current shape among the k best, after equal scores.
+static void keepShape(FretSearch& fs, uint16_t score) {
+    uint8_t i = (fs.found < fs.k) ? fs.found++ : (uint8_t)(fs.k - 1);
+    while (i > 0 && fs.best[i - 1].score > score) {
+        fs.best[i] = fs.best[i - 1];
+        i--;
+    }
+    for (uint8_t s = 0; s < GINGODUINO_MAX_STRINGS; s++) {
+        fs.best[i].frets[s] = (s < fs.numStrings) ? fs.frets[s] : 255;
+    }
+    fs.best[i].score = score;
+}
+
+// penalty: score of the mutes so far (a lower bound for the rest).
+static void searchString(FretSearch& fs, uint8_t s, uint16_t covered,
+                         uint16_t penalty, uint8_t maxFret, bool sounding) {
+    uint16_t bound = penalty + (uint16_t)(maxFret - fs.base) * 5 + fs.base;
+    if (fs.found == fs.k && bound >= fs.best[fs.k - 1].score) return;
+    if (bitCount((uint16_t)(fs.required & ~covered)) > fs.numStrings - s) return;
+    // Shapes that leave the base fret unused belong to a higher position
+    if (fs.base > 0 && fs.onBase == 0 && (s > fs.lastOnBase || s == fs.numStrings)) return;
+
+    if (s == fs.numStrings) {
+        if (!sounding) return;
+        if (fingersFor(fs.frets, fs.numStrings, fs.rules.barre) > fs.rules.maxFingers) return;
+        uint16_t score = shapeScore(fs.frets, fs.numStrings);
+        if (fs.found == fs.k && score >= fs.best[fs.k - 1].score) return;
+        keepShape(fs, score);
+        return;
+    }
+
+    uint32_t cand = fs.toneFrets[s] & fs.window;
+    if (!sounding && fs.rules.rootInBass) cand &= fs.rootFrets[s];
+    while (cand) {
+        uint8_t f = (uint8_t)__builtin_ctzl(cand);
+        cand &= cand - 1;
+        fs.frets[s] = f;
+        if (f == fs.base) fs.onBase++;
+        searchString(fs, (uint8_t)(s + 1),
+                     (uint16_t)(covered | (1u << ((fs.openPc[s] + f) % 12))),
+                     penalty, f > maxFret ? f : maxFret, true);
+        if (f == fs.base) fs.onBase--;
+    }
+    fs.frets[s] = 255;
+    searchString(fs, (uint8_t)(s + 1), covered,
+                 (uint16_t)(penalty + (sounding ? 18 : 6)), maxFret, sounding);
+}
+
+uint8_t GingoFretboard::searchShapes(const GingoChord& chord, const GingoFingeringRules& rules,
+                                     uint8_t fretLo, uint8_t fretHi,
+                                     GingoFretShape* best, uint8_t k) const {
+    GingoNote chordNotes[GINGODUINO_MAX_CHORD_NOTES];
+    uint8_t chordSize = chord.notes(chordNotes, GINGODUINO_MAX_CHORD_NOTES);
+    if (chordSize == 0 || k == 0 || rules.maxSpan == 0) return 0;
+
+    uint8_t rootPc = chordNotes[0].semitone();
+    uint16_t mask = 0;
+    for (uint8_t n = 0; n < chordSize; n++) {
+        mask |= (uint16_t)(1u << chordNotes[n].semitone());
+    }
+
+    FretSearch fs;
+    fs.rules = rules;
+    fs.numStrings = numStrings_;
+    fs.required = mask;
+    if (bitCount(mask) > numStrings_) {
+        fs.required &= (uint16_t)~(1u << ((rootPc + 7) % 12));  // the fifth can go
+        if (bitCount(fs.required) > numStrings_) return 0;
+    }
 
-    // For each string, find the best fret within the window
-    // that matches a chord tone
+    if (fretHi > numFrets_) fretHi = numFrets_;
+    if (fretHi > 31) fretHi = 31;
     for (uint8_t s = 0; s < numStrings_; s++) {
         uint8_t baseMidi = openMidi_[s] + capoFret_;
-        bool found = false;
-
-        // Check open string first
-        uint8_t openPc = baseMidi % 12;
-        for (uint8_t n = 0; n < chordSize; n++) {
-            if (chordNotes[n].semitone() == openPc) {
-                output.strings[s].string = s;
-                output.strings[s].action = STRING_OPEN;
-                output.strings[s].fret = 0;
-                output.midiNotes[output.numNotes++] = baseMidi;
-                found = true;
-                break;
-            }
+        fs.openPc[s] = baseMidi % 12;
+        fs.toneFrets[s] = 0;
+        fs.rootFrets[s] = 0;
+        for (uint8_t f = 0; f <= fretHi; f++) {
+            uint8_t pc = (baseMidi + f) % 12;
+            if (mask & (1u << pc)) fs.toneFrets[s] |= (uint32_t)1 << f;
+            if (pc == rootPc) fs.rootFrets[s] |= (uint32_t)1 << f;
         }
+    }
 
-        if (!found) {
-            // Check frets in window
-            for (uint8_t f = (windowStart > 0 ? windowStart : 1); f <= windowEnd; f++) {
-                uint8_t midi = baseMidi + f;
-                uint8_t pc = midi % 12;
-                for (uint8_t n = 0; n < chordSize; n++) {
-                    if (chordNotes[n].semitone() == pc) {
-                        output.strings[s].string = s;
-                        output.strings[s].action = STRING_FRETTED;
-                        output.strings[s].fret = f;
-                        output.midiNotes[output.numNotes++] = midi;
-                        found = true;
-                        break;
-                    }
-                }
-                if (found) break;
-            }
+    fs.best = best;
+    fs.k = k;
+    fs.found = 0;
+    fs.onBase = 0;
+
+    if (fretLo == 0) {
+        fs.base = 0;
+        fs.window = 1;
+        searchString(fs, 0, 0, 0, 0, false);
+    }
+    for (uint8_t b = (fretLo > 0 ? fretLo : 1); b <= fretHi; b++) {
+        uint8_t top = b + rules.maxSpan - 1;
+        if (top > fretHi) top = fretHi;
+        fs.base = b;
+        fs.window = 1 | ((((uint32_t)2 << top) - 1) & ~(((uint32_t)1 << b) - 1));
+        fs.lastOnBase = 255;
+        for (uint8_t s = 0; s < numStrings_; s++) {
+            if (fs.toneFrets[s] & ((uint32_t)1 << b)) fs.lastOnBase = s;
         }
+        if (fs.lastOnBase == 255) continue;
+        searchString(fs, 0, 0, 0, b, false);
+    }
+    return fs.found;
+}
 
-        if (!found) {
-            output.strings[s].string = s;
+void GingoFretboard::toFingering(const GingoFretShape& shape, const GingoChord& chord,
+                                 GingoFingering& output) const {
+    output.numStrings = numStrings_;
+    output.chordName.set(chord.name());
+    output.baseFret = 0;
+    output.capoFret = capoFret_;
+    output.numNotes = 0;
+
+    for (uint8_t s = 0; s < numStrings_; s++) {
+        uint8_t f = shape.frets[s];
+        output.strings[s].string = s;
+        if (f == 255) {
             output.strings[s].action = STRING_MUTED;
             output.strings[s].fret = 0;
+            continue;
         }
+        output.strings[s].action = f ? STRING_FRETTED : STRING_OPEN;
+        output.strings[s].fret = f;
+        output.midiNotes[output.numNotes++] = openMidi_[s] + capoFret_ + f;
+        if (f && (output.baseFret == 0 || f < output.baseFret)) output.baseFret = f;
     }
 
     output.score = scoreFingering(output);
-    return output.numNotes >= chordSize;
 }
 
-uint8_t GingoFretboard::fingerings(const GingoChord& chord,
-                                   GingoFingering* output, uint8_t maxResults) const {
-    uint8_t written = 0;
-    uint8_t maxWindows = (numFrets_ / 4) + 1;
+bool GingoFretboard::fingering(const GingoChord& chord, uint8_t positionIdx,
+                               GingoFingering& output) const {
+    // Position windows as before: fretted notes within frets 1-4, 4-8, ...
+    uint8_t windowStart = positionIdx * 4;
+    uint8_t windowEnd = windowStart + 4;
+    if (windowEnd > numFrets_) windowEnd = numFrets_;
+    if (windowStart > numFrets_) return false;
+
+    // Root in the bass when the window allows it, else an inversion (on
+    // 4-string instruments the usual first-position shapes often are)
+    GingoFingeringRules rules;
+    GingoFretShape shape;
+    uint8_t found = searchShapes(chord, rules, windowStart, windowEnd, &shape, 1);
+    if (found == 0) {
+        rules.rootInBass = false;
+        found = searchShapes(chord, rules, windowStart, windowEnd, &shape, 1);
+    }
+    if (found == 0) {
+        output.numStrings = 0;
+        output.numNotes = 0;
+        return false;
+    }
+    toFingering(shape, chord, output);
+    return true;
+}
 
-    // Generate fingerings for each position window
-    GingoFingering candidates[GINGODUINO_MAX_FINGERINGS + 4];
-    uint8_t candidateCount = 0;
+// FNV-1a over the fields of a cache key.
+static uint32_t searchHash(const uint8_t* openMidi, uint8_t numStrings,
+                           const uint8_t* fields, uint8_t numFields) {
+    uint32_t h = 2166136261u;
+    for (uint8_t i = 0; i < numStrings; i++) h = (h ^ openMidi[i]) * 16777619u;
+    for (uint8_t i = 0; i < numFields; i++) h = (h ^ fields[i]) * 16777619u;
+    return h;
+}
 
-    for (uint8_t w = 0; w < maxWindows && candidateCount < GINGODUINO_MAX_FINGERINGS + 4; w++) {
-        GingoFingering fg;
-        if (fingering(chord, w, fg)) {
-            candidates[candidateCount++] = fg;
+uint8_t GingoFretboard::fingerings(const GingoChord& chord,
+                                   GingoFingering* output, uint8_t maxResults,
+                                   const GingoFingeringRules& rules,
+                                   GingoFingeringCache* cache) const {
+    if (maxResults == 0) return 0;
+
+    GingoFretShape found[GINGODUINO_MAX_FINGERINGS];
+    const GingoFretShape* shapes = found;
+    uint8_t count = 0;
+
+    if (cache) {
+        GingoNote chordNotes[GINGODUINO_MAX_CHORD_NOTES];
+        uint8_t chordSize = chord.notes(chordNotes, GINGODUINO_MAX_CHORD_NOTES);
+        if (chordSize == 0) return 0;
+        uint16_t mask = 0;
+        for (uint8_t n = 0; n < chordSize; n++) {
+            mask |= (uint16_t)(1u << chordNotes[n].semitone());
         }
-    }
 
-    // Sort by score (insertion sort, small array)
-    for (uint8_t i = 1; i < candidateCount; i++) {
-        GingoFingering key = candidates[i];
-        int8_t j = (int8_t)i - 1;
-        while (j >= 0 && candidates[j].score > key.score) {
-            candidates[j + 1] = candidates[j];
-            j--;
+        GingoFingeringCache::Key key;
+        for (uint8_t s = 0; s < numStrings_; s++) key.openMidi[s] = openMidi_[s];
+        key.numStrings = numStrings_;
+        key.numFrets = numFrets_;
+        key.capo = capoFret_;
+        key.rules = rules;
+        key.mask = mask;
+        key.root = chordNotes[0].semitone();
+        const uint8_t fields[9] = {
+            numFrets_, capoFret_, rules.maxSpan, rules.maxFingers,
+            (uint8_t)rules.barre, (uint8_t)rules.rootInBass,
+            (uint8_t)(mask & 0xFF), (uint8_t)(mask >> 8), key.root
+        };
+        uint32_t hash = searchHash(openMidi_, numStrings_, fields, 9);
+
+        // The hash only narrows the scan; a hit needs the whole key to match
+        GingoFingeringCache::Entry* e = nullptr;
+        for (uint8_t i = 0; i < cache->count_; i++) {
+            GingoFingeringCache::Entry& c = cache->entries_[i];
+            if (c.hash == hash && GingoFingeringCache::sameKey(c.key, key)) { e = &c; break; }
         }
-        candidates[j + 1] = key;
+        if (!e) {
+            if (cache->count_ < GINGODUINO_FINGERING_CACHE) {
+                e = &cache->entries_[cache->count_++];
+            } else {
+                e = &cache->entries_[cache->next_];
+                cache->next_ = (uint8_t)((cache->next_ + 1) % GINGODUINO_FINGERING_CACHE);
+            }
+            e->hash = hash;
+            e->key = key;
+            e->count = searchShapes(chord, rules, 0, numFrets_,
+                                    e->shapes, GINGODUINO_MAX_FINGERINGS);
+        }
+        shapes = e->shapes;
+        count = e->count;
+    } else {
+        uint8_t k = (maxResults < GINGODUINO_MAX_FINGERINGS) ? maxResults : GINGODUINO_MAX_FINGERINGS;
+        count = searchShapes(chord, rules, 0, numFrets_, found, k);
     }
 
-    // Copy best results
-    for (uint8_t i = 0; i < candidateCount && written < maxResults; i++) {
-        output[written++] = candidates[i];
+    uint8_t written = (count < maxResults) ? count : maxResults;
+    for (uint8_t i = 0; i < written; i++) {
+        toFingering(shapes[i], chord, output[i]);
     }
-
     return written;
 }
 
@@ -295,9 +486,7 @@ bool GingoFretboard::identify(const uint8_t* stringFrets, uint8_t count,
     for (uint8_t i = 0; i < count && i < numStrings_; i++) {
         if (stringFrets[i] == 255) continue;  // muted
         uint8_t midi = openMidi_[i] + capoFret_ + stringFrets[i];
-        char name[3];
-        data::readChromaticName(midi % 12, name, sizeof(name));
-        notes[noteCount++] = GingoNote(name);
+        notes[noteCount++] = GingoNote::fromSemitone(midi % 12);
     }
 
     if (noteCount == 0) {
@@ -52,6 +52,75 @@ struct GingoFingering {
     uint16_t score;       ///< lower = better playability
 };
 
+/// Constraints for the fingering search.
+struct GingoFingeringRules {
+    uint8_t maxSpan;     ///< frets one hand position covers (default 4)
+    uint8_t maxFingers;  ///< fretting fingers; a barre counts as one (default 4)
+    bool    barre;       ///< index finger may barre the lowest fret (default true)
+    bool    rootInBass;  ///< lowest sounding string plays the root (default true)
+
+    GingoFingeringRules(uint8_t span = 4, uint8_t fingers = 4,
+                        bool allowBarre = true, bool root = true)
+        : maxSpan(span), maxFingers(fingers), barre(allowBarre), rootInBass(root) {}
+};
+
+/// A fingering in compact form: one fret per string, 255 = muted.
+struct GingoFretShape {
+    uint8_t  frets[GINGODUINO_MAX_STRINGS];
+    uint16_t score;
+};
+
+/// Fingering results of recently searched chords, e.g. the chords of a
+/// key, so asking for one again is a copy instead of a search.
+/// Holds GINGODUINO_FINGERING_CACHE chords (default 8); the oldest is
+/// replaced when full. Entries remember the fretboard (tuning, frets,
+/// capo) and rules they were found with, so one cache can be shared.
+class GingoFingeringCache {
+public:
+    GingoFingeringCache() : count_(0), next_(0) {}
+
+    /// Forget all entries.
+    void clear() { count_ = 0; next_ = 0; }
+
+private:
+    friend class GingoFretboard;
+
+    // What a search depends on: fretboard, rules and chord.
+    struct Key {
+        uint8_t             openMidi[GINGODUINO_MAX_STRINGS];
+        uint8_t             numStrings;
+        uint8_t             numFrets;
+        uint8_t             capo;
+        GingoFingeringRules rules;
+        uint16_t            mask;   // chord pitch classes
+        uint8_t             root;
+    };
+
+    struct Entry {
+        uint32_t       hash;   // of key, to skip most compares
+        Key            key;
+        uint8_t        count;
+        GingoFretShape shapes[GINGODUINO_MAX_FINGERINGS];
+    };
+
+    static bool sameKey(const Key& a, const Key& b) {
+        if (a.numStrings != b.numStrings || a.numFrets != b.numFrets ||
+            a.capo != b.capo || a.mask != b.mask || a.root != b.root ||
+            a.rules.maxSpan != b.rules.maxSpan ||
+            a.rules.maxFingers != b.rules.maxFingers ||
+            a.rules.barre != b.rules.barre ||
+            a.rules.rootInBass != b.rules.rootInBass) return false;
+        for (uint8_t i = 0; i < a.numStrings; i++) {
+            if (a.openMidi[i] != b.openMidi[i]) return false;
+        }
+        return true;
+    }
+
+    Entry   entries_[GINGODUINO_FINGERING_CACHE];
+    uint8_t count_;
+    uint8_t next_;  // entry replaced next when full
+};
+
 /// Fretted string instrument engine.
 ///
 /// Computes note positions, scale patterns, and chord fingerings
@@ -121,15 +190,26 @@ public:
                            GingoFretPos* output, uint8_t maxPositions,
                            uint8_t fretLo = 0, uint8_t fretHi = 255) const;
 
-    /// Find a single fingering for a chord at a given position index.
+    /// Find the best fingering for a chord with its fretted notes inside
+    /// position window positionIdx (frets 1-4, 4-8, 8-12, ...; open
+    /// strings are always allowed). Every chord tone sounds and the
+    /// default GingoFingeringRules hold, except that when no shape in
+    /// the window has the root in the bass the search is repeated
+    /// without rootInBass, so the result may be an inversion.
     /// Returns true if a valid fingering was found.
     bool fingering(const GingoChord& chord, uint8_t positionIdx,
                    GingoFingering& output) const;
 
-    /// Find multiple fingerings for a chord, sorted by playability score.
-    /// Returns the number of fingerings written.
+    /// Find the best fingerings for a chord anywhere on the neck (frets
+    /// past 31 are not searched), sorted by playability score.
+    /// Every chord tone sounds; when the chord has more tones than the
+    /// instrument has strings, the fifth may be left out.
+    /// A cache, if given, is checked first and keeps the result.
+    /// Returns the number written (at most GINGODUINO_MAX_FINGERINGS).
     uint8_t fingerings(const GingoChord& chord,
-                       GingoFingering* output, uint8_t maxResults) const;
+                       GingoFingering* output, uint8_t maxResults,
+                       const GingoFingeringRules& rules = GingoFingeringRules(),
+                       GingoFingeringCache* cache = nullptr) const;
 
     /// Identify a chord from string-fret positions.
     /// @param stringFrets  array of fret numbers per string (255 = muted)
@@ -152,6 +232,17 @@ private:
 
     /// Score a fingering for playability (lower = better).
     uint16_t scoreFingering(const GingoFingering& fg) const;
+
+    /// Branch-and-bound search for the best k shapes with fretted notes
+    /// in [fretLo, fretHi] (fretLo 0 also tries open strings only).
+    /// Returns the number written to best, sorted by score.
+    uint8_t searchShapes(const GingoChord& chord, const GingoFingeringRules& rules,
+                         uint8_t fretLo, uint8_t fretHi,
+                         GingoFretShape* best, uint8_t k) const;
+
+    /// Expand a shape into a full fingering.
+    void toFingering(const GingoFretShape& shape, const GingoChord& chord,
+                     GingoFingering& output) const;
 };
 
 } // namespace gingoduino
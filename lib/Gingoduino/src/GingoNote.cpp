@@ -13,10 +13,21 @@ namespace gingoduino {
 // ---------------------------------------------------------------------------
 
 GingoNote GingoNote::fromMIDI(uint8_t midiNote) {
-    uint8_t semitone = midiNote % 12;
+    return fromSemitone(midiNote % 12);
+}
+
+GingoNote GingoNote::fromSemitone(uint8_t semitone) {
+    semitone %= 12;
     char noteName[3];
     data::readChromaticName(semitone, noteName, sizeof(noteName));
-    return GingoNote(noteName);
+
+    // Chromatic names are already natural: no enharmonic lookup needed
+    GingoNote n;
+    n.name_.set(noteName);
+    n.natural_.set(noteName);
+    n.sound_ = (char)pgm_read_byte(&data::CHROMATIC_SOUND[semitone]);
+    n.semitone_ = semitone;
+    return n;
 }
 
 int8_t GingoNote::octaveFromMIDI(uint8_t midiNote) {
@@ -195,9 +206,7 @@ float GingoNote::frequency(int8_t octave, float tuning) const {
 
 GingoNote GingoNote::transpose(int8_t semitones) const {
     int8_t newIdx = (int8_t)(((int16_t)semitone_ + semitones % 12 + 12) % 12);
-    char name[3];
-    data::readChromaticName((uint8_t)newIdx, name, sizeof(name));
-    return GingoNote(name);
+    return fromSemitone((uint8_t)newIdx);
 }
 
 uint8_t GingoNote::distance(const GingoNote& other) const {
@@ -73,6 +73,10 @@ public:
     /// Uses sharp-based notation (C#, D#, F#, G#, A#).
     static GingoNote fromMIDI(uint8_t midiNote);
 
+    /// Create a note from a chromatic index 0-11 (C = 0), sharp-based.
+    /// Reads the name from the chromatic table; no string parsing.
+    static GingoNote fromSemitone(uint8_t semitone);
+
     /// Extract octave from MIDI number (C4 = 60 → octave 4).
     static int8_t octaveFromMIDI(uint8_t midiNote);
 
@@ -113,7 +113,7 @@ bool GingoProgression::identify(const char* const* branches, uint8_t count,
 
         // Score by valid transitions
         uint8_t totalTrans = inputLen - 1;
-        uint8_t validTrans = t.countValidTransitions(branches, inputLen);
+        uint8_t validTrans = t.countValidTransitions(inputIds, inputLen);
         uint8_t transScore = (uint8_t)((uint16_t)validTrans * 100 / totalTrans);
 
         // Score by schema match
@@ -198,7 +198,7 @@ uint8_t GingoProgression::deduce(const char* const* branches, uint8_t count,
         GingoTree t = tree(trad);
 
         uint8_t totalTrans = inputLen - 1;
-        uint8_t validTrans = t.countValidTransitions(branches, inputLen);
+        uint8_t validTrans = t.countValidTransitions(inputIds, inputLen);
         uint8_t transScore = (uint8_t)((uint16_t)validTrans * 100 / totalTrans);
 
         const data::ProgSchemaTable* st =
@@ -278,7 +278,7 @@ uint8_t GingoProgression::predict(const char* const* branches, uint8_t count,
                                    ProgressionRoute* output, uint8_t maxResults) const {
     if (count == 0 || maxResults == 0) return 0;
 
-    const char* last = branches[count - 1];
+    uint8_t lastId = GingoTree::findBranch(branches[count - 1]);
 
     // Build extended sequence IDs (input + candidate next)
     uint8_t inputIds[16];
@@ -294,15 +294,13 @@ uint8_t GingoProgression::predict(const char* const* branches, uint8_t count,
         GingoTree t = tree(trad);
 
         // Get neighbors of the last branch
-        const char* neighPtrs[16];
-        uint8_t nNeigh = t.neighbors(last, neighPtrs, 16);
+        uint8_t neighIds[16];
+        uint8_t nNeigh = t.neighbors(lastId, neighIds, 16);
 
         for (uint8_t n = 0; n < nNeigh && candCount < 32; n++) {
-            // Read the neighbor name
+            uint8_t nextId = neighIds[n];
             char nextName[24];
-            data::readPgmStr(nextName, neighPtrs[n], sizeof(nextName));
-
-            uint8_t nextId = GingoTree::findBranch(nextName);
+            data::readPgmStr(nextName, GingoTree::branchName(nextId), sizeof(nextName));
 
             // Build candidate sequence: input + next
             uint8_t candIds[16];
@@ -382,6 +380,187 @@ uint8_t GingoProgression::predict(const char* const* branches, uint8_t count,
     return written;
 }
 
+// ---------------------------------------------------------------------------
+// GingoProgressionTracker
+// ---------------------------------------------------------------------------
+
+static_assert(PROG_TRADITION_COUNT == 2, "GingoProgressionTracker keeps one tree per tradition");
+
+static const data::ProgSchema* schemaAt(uint8_t trad, uint8_t index) {
+    const data::ProgSchemaTable* st =
+        (const data::ProgSchemaTable*)&data::PROG_SCHEMA_TABLES[trad];
+    const data::ProgSchema* schemas =
+        (const data::ProgSchema*)pgm_read_ptr(&st->schemas);
+    return &schemas[index];
+}
+
+GingoProgressionTracker::GingoProgressionTracker(const char* tonic, ScaleType type)
+    : trees_{GingoTree(tonic, type, 0), GingoTree(tonic, type, 1)}
+    , schemaCount_(0)
+{
+    for (uint8_t trad = 0; trad < PROG_TRADITION_COUNT; trad++) {
+        const data::ProgSchemaTable* st =
+            (const data::ProgSchemaTable*)&data::PROG_SCHEMA_TABLES[trad];
+        uint8_t n = pgm_read_byte(&st->count);
+
+        for (uint8_t s = 0; s < n && schemaCount_ < MAX_SCHEMAS; s++) {
+            Schema& sc = schemas_[schemaCount_];
+            char name[24];
+            uint8_t ctx;
+            readSchema(schemaAt(trad, s), name, sizeof(name), sc.branches, &sc.count, &ctx);
+            if (ctx != trees_[trad].context()) continue;
+            sc.traditionId = trad;
+            sc.index = s;
+            schemaCount_++;
+        }
+    }
+    reset();
+}
+
+void GingoProgressionTracker::reset() {
+    for (uint8_t s = 0; s < schemaCount_; s++) {
+        for (uint8_t i = 0; i < 8; i++) schemas_[s].run[i] = 0;
+    }
+    validBits_[0] = validBits_[1] = 0;
+    count_ = 0;
+    last_ = 0xFF;
+}
+
+void GingoProgressionTracker::push(const char* branch) {
+    push(GingoTree::findBranch(branch));
+}
+
+void GingoProgressionTracker::push(uint8_t branchId) {
+    for (uint8_t trad = 0; trad < PROG_TRADITION_COUNT; trad++) {
+        bool valid = count_ > 0 && trees_[trad].hasEdge(last_, branchId);
+        validBits_[trad] = (uint16_t)((validBits_[trad] << 1) | (valid ? 1 : 0));
+    }
+    if (count_ < WINDOW) count_++;
+    last_ = branchId;
+
+    // Extend the run ending one position earlier, or break it.
+    // Highest position first, so run[i - 1] is still the previous value.
+    for (uint8_t s = 0; s < schemaCount_; s++) {
+        Schema& sc = schemas_[s];
+        for (uint8_t i = sc.count; i-- > 0; ) {
+            sc.run[i] = (sc.branches[i] == branchId)
+                      ? (uint8_t)((i > 0 ? sc.run[i - 1] : 0) + 1) : 0;
+        }
+    }
+}
+
+uint8_t GingoProgressionTracker::deduce(ProgressionMatch* output, uint8_t maxResults) const {
+    if (count_ < 2 || maxResults == 0) return 0;
+
+    ProgressionMatch candidates[MAX_SCHEMAS + PROG_TRADITION_COUNT];
+    uint8_t candCount = 0;
+
+    uint8_t totalTrans = count_ - 1;
+    for (uint8_t trad = 0; trad < PROG_TRADITION_COUNT; trad++) {
+        uint16_t window = (uint16_t)((1u << totalTrans) - 1);
+        uint8_t validTrans = (uint8_t)__builtin_popcount(validBits_[trad] & window);
+        uint8_t transScore = (uint8_t)((uint16_t)validTrans * 100 / totalTrans);
+
+        bool hasSchemaMatch = false;
+
+        for (uint8_t s = 0; s < schemaCount_; s++) {
+            const Schema& sc = schemas_[s];
+            if (sc.traditionId != trad) continue;
+
+            // Best run: whole schema, from its start (prefix), or inside it
+            uint8_t schemaScore = 0;
+            for (uint8_t i = 0; i < sc.count; i++) {
+                uint8_t len = sc.run[i];
+                if (len < 2) continue;
+                uint8_t ss = (len == sc.count) ? 100
+                           : (len == i + 1) ? (uint8_t)((uint16_t)len * 100 / sc.count)
+                           : (uint8_t)((uint16_t)len * 90 / sc.count);
+                if (ss > schemaScore) schemaScore = ss;
+            }
+
+            if (schemaScore > 0) {
+                hasSchemaMatch = true;
+                ProgressionMatch& m = candidates[candCount++];
+                m.traditionId = trad;
+                data::readPgmStr(m.schema, schemaAt(trad, sc.index)->name, sizeof(m.schema));
+                m.matched = validTrans;
+                m.total = totalTrans;
+                m.scoreNum = (transScore > schemaScore) ? transScore : schemaScore;
+            }
+        }
+
+        if (!hasSchemaMatch && transScore > 0) {
+            ProgressionMatch& m = candidates[candCount++];
+            m.traditionId = trad;
+            m.schema[0] = '\0';
+            m.matched = validTrans;
+            m.total = totalTrans;
+            m.scoreNum = transScore;
+        }
+    }
+
+    sortMatches(candidates, candCount);
+
+    uint8_t written = (candCount < maxResults) ? candCount : maxResults;
+    for (uint8_t i = 0; i < written; i++) {
+        output[i] = candidates[i];
+    }
+    return written;
+}
+
+uint8_t GingoProgressionTracker::predict(ProgressionRoute* output, uint8_t maxResults) const {
+    if (count_ == 0 || maxResults == 0) return 0;
+
+    ProgressionRoute candidates[32];
+    uint8_t candCount = 0;
+
+    for (uint8_t trad = 0; trad < PROG_TRADITION_COUNT; trad++) {
+        uint8_t neighIds[16];
+        uint8_t nNeigh = trees_[trad].neighbors(last_, neighIds, 16);
+
+        for (uint8_t n = 0; n < nNeigh && candCount < 32; n++) {
+            uint8_t nextId = neighIds[n];
+
+            // Runs that nextId would extend (0.8 factor unless from the start)
+            uint8_t confidence = 30; // baseline
+            uint8_t bestSchema = 0xFF;
+            for (uint8_t s = 0; s < schemaCount_; s++) {
+                const Schema& sc = schemas_[s];
+                if (sc.traditionId != trad) continue;
+                for (uint8_t i = 1; i < sc.count; i++) {
+                    if (sc.branches[i] != nextId || sc.run[i - 1] == 0) continue;
+                    uint8_t len = sc.run[i - 1] + 1;
+                    uint8_t c = (len == i + 1) ? (uint8_t)((uint16_t)len * 100 / sc.count)
+                                               : (uint8_t)((uint16_t)len * 80 / sc.count);
+                    if (c > confidence) {
+                        confidence = c;
+                        bestSchema = s;
+                    }
+                }
+            }
+
+            ProgressionRoute& r = candidates[candCount++];
+            data::readPgmStr(r.next, GingoTree::branchName(nextId), sizeof(r.next));
+            r.traditionId = trad;
+            if (bestSchema != 0xFF) {
+                data::readPgmStr(r.schema, schemaAt(trad, schemas_[bestSchema].index)->name,
+                                 sizeof(r.schema));
+            } else {
+                r.schema[0] = '\0';
+            }
+            r.confidenceNum = confidence;
+        }
+    }
+
+    sortRoutes(candidates, candCount);
+
+    uint8_t written = (candCount < maxResults) ? candCount : maxResults;
+    for (uint8_t i = 0; i < written; i++) {
+        output[i] = candidates[i];
+    }
+    return written;
+}
+
 } // namespace gingoduino
 
 #endif // GINGODUINO_HAS_PROGRESSION
@@ -74,6 +74,69 @@ private:
     ScaleType scaleType_;
 };
 
+/// Incremental deduce()/predict() for chords that arrive one at a time,
+/// e.g. from MIDI. The schemas of the key's context are loaded once; each
+/// push() then updates, for every schema position, how many of the latest
+/// chords follow the schema up to there, plus the valid-transition bits of
+/// the last 16 chords. A push costs the same however long the history is.
+///
+/// Scoring is that of deduce()/predict() applied to the latest chords: a
+/// schema matches while the most recent chords follow it, whatever came
+/// before, and transitions are counted over the last 16 chords. A schema
+/// that contains the whole history scores exactly as in deduce().
+///
+/// Examples:
+///   GingoProgressionTracker t("C", SCALE_MAJOR);
+///   t.push("IIm");
+///   t.push("V7");
+///   ProgressionRoute next[4];
+///   t.predict(next, 4);   // "I" first (jazz "ii-V-I")
+///   t.push("I");
+///   ProgressionMatch m[8];
+///   t.deduce(m, 8);       // ..., jazz "ii-V-I" (score=100)
+class GingoProgressionTracker {
+public:
+    static const uint8_t MAX_SCHEMAS = 16;  // per context, both traditions
+    static const uint8_t WINDOW = 16;       // chords scored for transitions
+
+    GingoProgressionTracker(const char* tonic, ScaleType type);
+
+    /// Forget the history.
+    void reset();
+
+    /// Add the next chord by branch name or ID (see GingoTree::findBranch).
+    /// An unknown branch is kept as a chord that matches nothing.
+    void push(const char* branch);
+    void push(uint8_t branchId);
+
+    /// Chords in the transition window (0..WINDOW).
+    uint8_t count() const { return count_; }
+
+    /// Current matches, ranked by score, as deduce() on the history.
+    /// Returns number of results written.
+    uint8_t deduce(ProgressionMatch* output, uint8_t maxResults) const;
+
+    /// Possible next branches, as predict() on the history.
+    /// Returns number of predictions written.
+    uint8_t predict(ProgressionRoute* output, uint8_t maxResults) const;
+
+private:
+    struct Schema {
+        uint8_t traditionId;
+        uint8_t index;        // in the tradition's schema table
+        uint8_t count;
+        uint8_t branches[8];
+        uint8_t run[8];       // latest chords that follow branches[..i]
+    };
+
+    GingoTree trees_[2];      // by tradition ID
+    Schema    schemas_[MAX_SCHEMAS];
+    uint8_t   schemaCount_;
+    uint16_t  validBits_[2];  // bit i: transition i chords ago is valid
+    uint8_t   count_;
+    uint8_t   last_;
+};
+
 } // namespace gingoduino
 
 #endif // GINGODUINO_HAS_PROGRESSION
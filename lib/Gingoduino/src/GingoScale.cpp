@@ -8,6 +8,7 @@
 #if GINGODUINO_HAS_SCALE
 
 #include "gingoduino_progmem.h"
+#include "gingoduino_tables.h"
 
 namespace gingoduino {
 
@@ -77,6 +78,10 @@ GingoScale::GingoScale(const char* tonic, ScaleType type, uint8_t modeNum, bool
     : tonic_(tonic), parent_(type), modeNumber_(modeNum), pentatonic_(penta)
 {}
 
+GingoScale::GingoScale(const GingoNote& tonic, ScaleType type, uint8_t modeNum, bool penta)
+    : tonic_(tonic), parent_(type), modeNumber_(modeNum), pentatonic_(penta)
+{}
+
 GingoScale::GingoScale(const char* tonic, const char* typeName)
     : tonic_(tonic), pentatonic_(false)
 {
@@ -98,6 +103,11 @@ GingoScale::GingoScale(const char* tonic, const char* typeName)
 // ---------------------------------------------------------------------------
 
 uint16_t GingoScale::computeMask12() const {
+#if GINGODUINO_CONSTEXPR_TABLES
+    // Mode rotation precomputed per parent; modes 0 and 13+ are the parent
+    uint8_t modeIdx = (modeNumber_ >= 1 && modeNumber_ <= 12) ? modeNumber_ - 1 : 0;
+    uint16_t mask12 = data::SCALE_MODES.row[parent_].set[modeIdx];
+#else
     // Read the 24-bit scale mask
     uint32_t mask24 = pgm_read_dword(&data::SCALE_MASKS[parent_]);
 
@@ -121,6 +131,7 @@ uint16_t GingoScale::computeMask12() const {
         // Rotate the 12-bit mask
         mask12 = (uint16_t)(((mask12 >> offset) | (mask12 << (12 - offset))) & 0x0FFF);
     }
+#endif
 
     // Apply pentatonic filter if needed
     if (pentatonic_) {
@@ -163,10 +174,7 @@ uint8_t GingoScale::notes(GingoNote* output, uint8_t maxNotes) const {
 
     for (uint8_t i = 0; i < 12 && written < maxNotes; i++) {
         if (mask & (1 << i)) {
-            uint8_t noteSt = (rootSt + i) % 12;
-            char name[3];
-            data::readChromaticName(noteSt, name, sizeof(name));
-            output[written++] = GingoNote(name);
+            output[written++] = GingoNote::fromSemitone((rootSt + i) % 12);
         }
     }
     return written;
@@ -181,10 +189,7 @@ GingoNote GingoScale::degree(uint8_t n) const {
         if (mask & (1 << i)) {
             activeCount++;
             if (activeCount == n) {
-                uint8_t noteSt = (rootSt + i) % 12;
-                char name[3];
-                data::readChromaticName(noteSt, name, sizeof(name));
-                return GingoNote(name);
+                return GingoNote::fromSemitone((rootSt + i) % 12);
             }
         }
     }
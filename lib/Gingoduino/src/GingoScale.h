@@ -29,6 +29,9 @@ public:
     /// Construct from tonic and scale type enum.
     GingoScale(const char* tonic, ScaleType type, uint8_t modeNum = 1, bool penta = false);
 
+    /// Construct from a tonic note and scale type enum (no name parsing).
+    GingoScale(const GingoNote& tonic, ScaleType type, uint8_t modeNum = 1, bool penta = false);
+
     /// Construct from tonic and string name: "major", "dorian", "harmonic minor", etc.
     GingoScale(const char* tonic, const char* typeName);
 
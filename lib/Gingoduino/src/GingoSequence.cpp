@@ -7,51 +7,203 @@
 
 #if GINGODUINO_HAS_SEQUENCE
 
+#include <new>
+#include <stdlib.h>
+#if defined(ESP32)
+  #include <esp_heap_caps.h>
+#endif
+
 namespace gingoduino {
 
+static_assert(GINGODUINO_MAX_EVENTS +
+              (uint32_t)GINGODUINO_SEQUENCE_CHUNK * GINGODUINO_SEQUENCE_MAX_CHUNKS <= 0xFFFF,
+              "GingoSequence indexes events with uint16_t");
+static_assert(GINGODUINO_SEQUENCE_MAX_CHUNKS <= 255,
+              "GingoSequence counts chunks with uint8_t");
+
+// ---------------------------------------------------------------------------
+// Allocators
+// ---------------------------------------------------------------------------
+
+static void* heapAllocate(size_t bytes) { return malloc(bytes); }
+static void  heapRelease(void* ptr)     { free(ptr); }
+
+GingoSequenceAllocator GingoSequenceAllocator::none() {
+    GingoSequenceAllocator a = { nullptr, nullptr };
+    return a;
+}
+
+GingoSequenceAllocator GingoSequenceAllocator::heap() {
+    GingoSequenceAllocator a = { heapAllocate, heapRelease };
+    return a;
+}
+
+#if defined(ESP32)
+static void* psramAllocate(size_t bytes) {
+    return heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+}
+
+GingoSequenceAllocator GingoSequenceAllocator::psram() {
+    GingoSequenceAllocator a = { psramAllocate, heap_caps_free };
+    return a;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// MIDI encoding
+// ---------------------------------------------------------------------------
+
+// NoteOn or NoteOff for the event's note (chord root), as GingoEvent::toMIDI.
+// channel 0 keeps the event's channel; out-of-range channels become 1.
+static void encodeMessage(const GingoEvent& event, uint8_t channel,
+                          bool noteOn, uint8_t* out) {
+    uint8_t ch = channel == 0 ? event.midiChannel()
+               : (channel <= 16 ? channel : 1);
+    out[0] = (noteOn ? 0x90 : 0x80) | ((ch - 1) & 0x0F);
+    out[1] = event.midiNumber();
+    out[2] = noteOn ? event.velocity() : 0;
+}
+
+// ---------------------------------------------------------------------------
+// GingoSequence
+// ---------------------------------------------------------------------------
+
 GingoSequence::GingoSequence(const GingoTempo& tempo, const GingoTimeSig& timeSig)
-    : count_(0), tempo_(tempo), timeSig_(timeSig)
+    : allocator_(GingoSequenceAllocator::none()), count_(0), chunkCount_(0),
+      timed_(0), tempo_(tempo), timeSig_(timeSig)
 {}
 
+GingoSequence::GingoSequence(const GingoSequenceAllocator& allocator,
+                             const GingoTempo& tempo, const GingoTimeSig& timeSig)
+    : allocator_(allocator), count_(0), chunkCount_(0),
+      timed_(0), tempo_(tempo), timeSig_(timeSig)
+{}
+
+GingoSequence::GingoSequence(const GingoSequence& other)
+    : allocator_(other.allocator_), count_(0), chunkCount_(0),
+      timed_(0), tempo_(other.tempo_), timeSig_(other.timeSig_)
+{
+    copyEvents(other);
+}
+
+GingoSequence& GingoSequence::operator=(const GingoSequence& other) {
+    if (this == &other) return *this;
+    releaseChunks();
+    allocator_ = other.allocator_;
+    tempo_ = other.tempo_;
+    timeSig_ = other.timeSig_;
+    copyEvents(other);
+    return *this;
+}
+
+GingoSequence::~GingoSequence() {
+    releaseChunks();
+}
+
+void GingoSequence::copyEvents(const GingoSequence& other) {
+    count_ = 0;
+    timed_ = 0;
+    for (uint16_t i = 0; i < other.count_; i++) {
+        if (!add(other.slot(i)->event)) break;
+    }
+}
+
+void GingoSequence::releaseChunks() {
+    for (uint8_t c = 0; c < chunkCount_; c++) {
+        allocator_.release(chunks_[c]);
+    }
+    chunkCount_ = 0;
+    count_ = 0;
+    timed_ = 0;
+}
+
+GingoSequence::Slot* GingoSequence::slot(uint16_t index) {
+    if (index < GINGODUINO_MAX_EVENTS) return &inline_[index];
+    uint16_t i = index - GINGODUINO_MAX_EVENTS;
+    return &chunks_[i / GINGODUINO_SEQUENCE_CHUNK][i % GINGODUINO_SEQUENCE_CHUNK];
+}
+
+const GingoSequence::Slot* GingoSequence::slot(uint16_t index) const {
+    if (index < GINGODUINO_MAX_EVENTS) return &inline_[index];
+    uint16_t i = index - GINGODUINO_MAX_EVENTS;
+    return &chunks_[i / GINGODUINO_SEQUENCE_CHUNK][i % GINGODUINO_SEQUENCE_CHUNK];
+}
+
+uint16_t GingoSequence::capacity() const {
+    if (!allocator_.allocate) return GINGODUINO_MAX_EVENTS;
+    return GINGODUINO_MAX_EVENTS +
+           GINGODUINO_SEQUENCE_CHUNK * GINGODUINO_SEQUENCE_MAX_CHUNKS;
+}
+
 bool GingoSequence::add(const GingoEvent& event) {
-    if (count_ >= GINGODUINO_MAX_EVENTS) return false;
-    events_[count_++] = event;
+    uint32_t held = GINGODUINO_MAX_EVENTS +
+                    (uint32_t)chunkCount_ * GINGODUINO_SEQUENCE_CHUNK;
+    if (count_ >= held) {
+        if (!allocator_.allocate || chunkCount_ >= GINGODUINO_SEQUENCE_MAX_CHUNKS) {
+            return false;
+        }
+        void* mem = allocator_.allocate(sizeof(Slot) * GINGODUINO_SEQUENCE_CHUNK);
+        if (!mem) return false;
+        Slot* chunk = static_cast<Slot*>(mem);
+        for (uint16_t i = 0; i < GINGODUINO_SEQUENCE_CHUNK; i++) {
+            new (&chunk[i]) Slot();
+        }
+        chunks_[chunkCount_++] = chunk;
+    }
+    slot(count_++)->event = event;
     return true;
 }
 
-bool GingoSequence::remove(uint8_t index) {
+bool GingoSequence::remove(uint16_t index) {
     if (index >= count_) return false;
-    for (uint8_t i = index; i < count_ - 1; i++) {
-        events_[i] = events_[i + 1];
+    for (uint16_t i = index; i < count_ - 1; i++) {
+        slot(i)->event = slot(i + 1)->event;
     }
     count_--;
+    if (timed_ > index) timed_ = index;
     return true;
 }
 
 void GingoSequence::clear() {
     count_ = 0;
+    timed_ = 0;
 }
 
-const GingoEvent& GingoSequence::at(uint8_t index) const {
+const GingoEvent& GingoSequence::at(uint16_t index) const {
     static const GingoEvent fallback;
     if (index >= count_) return fallback;
-    return events_[index];
+    return slot(index)->event;
 }
 
-float GingoSequence::totalBeats() const {
-    float total = 0.0f;
-    for (uint8_t i = 0; i < count_; i++) {
-        total += events_[i].duration().beats();
+void GingoSequence::updateStarts() const {
+    if (timed_ >= count_) return;
+    float start = 0.0f;
+    if (timed_ > 0) {
+        const Slot* prev = slot(timed_ - 1);
+        start = prev->start + prev->event.duration().beats();
+    }
+    for (uint16_t i = timed_; i < count_; i++) {
+        Slot* s = const_cast<Slot*>(slot(i));
+        s->start = start;
+        start += s->event.duration().beats();
     }
-    return total;
+    timed_ = count_;
+}
+
+float GingoSequence::endBeat(uint16_t index) const {
+    if (index + 1 < count_) return slot(index + 1)->start;
+    const Slot* s = slot(index);
+    return s->start + s->event.duration().beats();
+}
+
+float GingoSequence::totalBeats() const {
+    if (count_ == 0) return 0.0f;
+    updateStarts();
+    return endBeat(count_ - 1);
 }
 
 float GingoSequence::totalSeconds() const {
-    float total = 0.0f;
-    for (uint8_t i = 0; i < count_; i++) {
-        total += tempo_.seconds(events_[i].duration());
-    }
-    return total;
+    return totalBeats() * tempo_.secondsPerBeat();
 }
 
 float GingoSequence::barCount() const {
@@ -60,9 +212,35 @@ float GingoSequence::barCount() const {
     return totalBeats() / beatsPerBar;
 }
 
+float GingoSequence::startBeat(uint16_t index) const {
+    if (index >= count_) return totalBeats();
+    updateStarts();
+    return slot(index)->start;
+}
+
+float GingoSequence::startSeconds(uint16_t index) const {
+    return startBeat(index) * tempo_.secondsPerBeat();
+}
+
+uint16_t GingoSequence::indexAtBeat(float beat) const {
+    updateStarts();
+    uint16_t lo = 0, hi = count_;
+    while (lo < hi) {
+        uint16_t mid = lo + (hi - lo) / 2;
+        if (endBeat(mid) > beat) hi = mid;
+        else                     lo = mid + 1;
+    }
+    return lo;
+}
+
+uint16_t GingoSequence::indexAtSeconds(float seconds) const {
+    return indexAtBeat(seconds / tempo_.secondsPerBeat());
+}
+
 void GingoSequence::transpose(int8_t semitones) {
-    for (uint8_t i = 0; i < count_; i++) {
-        events_[i] = events_[i].transpose(semitones);
+    for (uint16_t i = 0; i < count_; i++) {
+        Slot* s = slot(i);
+        s->event = s->event.transpose(semitones);
     }
 }
 
@@ -70,31 +248,89 @@ uint16_t GingoSequence::toMIDI(uint8_t* buf, uint16_t maxLen, uint8_t channel) c
     if (!buf || maxLen == 0) return 0;
 
     uint16_t offset = 0;
-    for (uint8_t i = 0; i < count_; i++) {
-        uint8_t needed = 6;  // max 6 bytes per event (NoteOn + NoteOff)
-        if (events_[i].type() == EVENT_REST) {
-            needed = 0;
-        }
+    for (uint16_t i = 0; i < count_; i++) {
+        const GingoEvent& event = slot(i)->event;
+        if (event.type() == EVENT_REST) continue;  // rests write nothing
 
-        // Check if we have space
-        if (offset + needed > maxLen) {
-            break;  // Stop early if buffer is too small
-        }
+        // NoteOn + NoteOff; stop early if the buffer is too small
+        if (offset + 6 > maxLen) break;
 
-        // For GingoSequence, override MIDI channel if specified (default: use event's channel)
-        GingoEvent eventToSend = events_[i];
-        if (channel != 0) {  // 0 = use event's channel, otherwise override
-            eventToSend.setMidiChannel(channel);
-        }
+        encodeMessage(event, channel, true, buf + offset);
+        encodeMessage(event, channel, false, buf + offset + 3);
+        offset += 6;
+    }
+
+    return offset;
+}
+
+// ---------------------------------------------------------------------------
+// GingoSequenceEncoder
+// ---------------------------------------------------------------------------
+
+GingoSequenceEncoder::GingoSequenceEncoder(const GingoSequence& sequence, uint8_t channel)
+    : seq_(&sequence), index_(0), channel_(channel), noteOff_(false)
+{
+    skipRests();
+}
+
+void GingoSequenceEncoder::seekIndex(uint16_t index) {
+    index_ = index;
+    noteOff_ = false;
+    skipRests();
+}
 
-        // Serialize this event (no longer needs channel/velocity parameters)
-        uint8_t written = eventToSend.toMIDI(buf + offset);
-        offset += written;
+void GingoSequenceEncoder::skipRests() {
+    while (index_ < seq_->size() && seq_->at(index_).type() == EVENT_REST) {
+        index_++;
     }
+}
+
+void GingoSequenceEncoder::seekBeat(float beat) {
+    // First event starting at or after beat.
+    uint16_t index = seq_->indexAtBeat(beat);
+    if (index < seq_->size() && seq_->startBeat(index) < beat) index++;
+    seekIndex(index);
+}
+
+void GingoSequenceEncoder::seekSeconds(float seconds) {
+    seekBeat(seconds / seq_->tempo().secondsPerBeat());
+}
 
+uint32_t GingoSequenceEncoder::nextMicros() const {
+    if (done()) return 0xFFFFFFFFUL;
+    float beat = seq_->startBeat(index_);
+    if (noteOff_) beat += seq_->at(index_).duration().beats();
+    return (uint32_t)(beat * seq_->tempo().secondsPerBeat() * 1000000.0f + 0.5f);
+}
+
+bool GingoSequenceEncoder::next(GingoMIDIMessage& msg) {
+    if (done()) return false;
+    msg.micros = nextMicros();
+    advance(msg.data);
+    return true;
+}
+
+uint16_t GingoSequenceEncoder::poll(uint32_t nowMicros, uint8_t* buf, uint16_t maxLen) {
+    if (!buf) return 0;
+    uint16_t offset = 0;
+    while (offset + 3 <= maxLen && !done() && nextMicros() <= nowMicros) {
+        advance(buf + offset);
+        offset += 3;
+    }
     return offset;
 }
 
+void GingoSequenceEncoder::advance(uint8_t* out) {
+    encodeMessage(seq_->at(index_), channel_, !noteOff_, out);
+    if (noteOff_) {
+        noteOff_ = false;
+        index_++;
+        skipRests();
+    } else {
+        noteOff_ = true;
+    }
+}
+
 } // namespace gingoduino
 
 #endif // GINGODUINO_HAS_SEQUENCE
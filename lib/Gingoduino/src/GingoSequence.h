@@ -17,41 +17,90 @@
 
 namespace gingoduino {
 
-/// A fixed-capacity timeline of musical events.
+/// Where a GingoSequence gets memory for events past the inline ones.
 ///
-/// Capacity is controlled by GINGODUINO_MAX_EVENTS (default 64).
+/// Chunks of GINGODUINO_SEQUENCE_CHUNK events are requested as the
+/// sequence grows and released when it is destroyed.
+///
+/// Examples:
+///   GingoSequence big(GingoSequenceAllocator::heap());
+///   GingoSequence song(GingoSequenceAllocator::psram());   // ESP32
+struct GingoSequenceAllocator {
+    void* (*allocate)(size_t bytes);
+    void  (*release)(void* ptr);
+
+    /// No allocation: only the GINGODUINO_MAX_EVENTS inline events.
+    static GingoSequenceAllocator none();
+
+    /// malloc / free.
+    static GingoSequenceAllocator heap();
+
+#if defined(ESP32)
+    /// External PSRAM (heap_caps_malloc with MALLOC_CAP_SPIRAM).
+    /// On boards without PSRAM nothing is allocated and add() fails.
+    static GingoSequenceAllocator psram();
+#endif
+};
+
+/// A timeline of musical events.
+///
+/// The first GINGODUINO_MAX_EVENTS events (default 64) are stored inline.
+/// With an allocator, the sequence grows in chunks of
+/// GINGODUINO_SEQUENCE_CHUNK events, up to GINGODUINO_SEQUENCE_MAX_CHUNKS
+/// chunks (8256 events by default).
+///
+/// Each event keeps its start in beats. Starts are brought up to date
+/// on the first query after an edit, from the first edited event on, so
+/// totalBeats()/totalSeconds() are O(1) and indexAtBeat() is O(log n)
+/// while the sequence is unchanged.
 ///
 /// Examples:
 ///   GingoSequence seq(GingoTempo(120), GingoTimeSig(4, 4));
 ///   seq.add(GingoEvent::noteEvent(GingoNote("C"), GingoDuration("quarter"), 4));
 ///   seq.add(GingoEvent::rest(GingoDuration("quarter")));
-///   seq.totalBeats();   // 2.0
-///   seq.totalSeconds(); // ~1.0 at 120 BPM
+///   seq.totalBeats();     // 2.0
+///   seq.totalSeconds();   // ~1.0 at 120 BPM
+///   seq.indexAtBeat(1.5); // 1 (the rest)
 class GingoSequence {
 public:
-    /// Construct with tempo and time signature.
+    /// Construct with tempo and time signature (inline events only).
     GingoSequence(const GingoTempo& tempo = GingoTempo(120),
                   const GingoTimeSig& timeSig = GingoTimeSig(4, 4));
 
+    /// Construct with an allocator for events past the inline ones.
+    explicit GingoSequence(const GingoSequenceAllocator& allocator,
+                           const GingoTempo& tempo = GingoTempo(120),
+                           const GingoTimeSig& timeSig = GingoTimeSig(4, 4));
+
+    /// Copies use the same allocator. Events that cannot be allocated
+    /// are left out of the copy.
+    GingoSequence(const GingoSequence& other);
+    GingoSequence& operator=(const GingoSequence& other);
+
+    ~GingoSequence();
+
     /// Add an event to the end of the sequence.
-    /// Returns false if the sequence is full.
+    /// Returns false if the sequence is full or a chunk cannot be allocated.
     bool add(const GingoEvent& event);
 
     /// Remove the event at the given index.
     /// Returns false if the index is out of range.
-    bool remove(uint8_t index);
+    bool remove(uint16_t index);
 
-    /// Remove all events.
+    /// Remove all events. Allocated chunks are kept for reuse.
     void clear();
 
     /// Number of events in the sequence.
-    uint8_t size() const { return count_; }
+    uint16_t size() const { return count_; }
 
     /// Whether the sequence is empty.
     bool empty() const { return count_ == 0; }
 
+    /// Most events this sequence can hold with its allocator.
+    uint16_t capacity() const;
+
     /// Access an event by index (0-based). Returns rest on out-of-range.
-    const GingoEvent& at(uint8_t index) const;
+    const GingoEvent& at(uint16_t index) const;
 
     /// Total duration in beats.
     float totalBeats() const;
@@ -62,12 +111,26 @@ public:
     /// Number of full bars.
     float barCount() const;
 
+    /// Start of the event at index, in beats (totalBeats() past the end).
+    float startBeat(uint16_t index) const;
+
+    /// Start of the event at index, in seconds (based on tempo).
+    float startSeconds(uint16_t index) const;
+
+    /// Index of the event sounding at the given beat: the first one that
+    /// ends after it. Returns size() at or past the end. O(log n).
+    uint16_t indexAtBeat(float beat) const;
+
+    /// Index of the event sounding at the given time in seconds.
+    uint16_t indexAtSeconds(float seconds) const;
+
     /// Transpose all events by a number of semitones.
     void transpose(int8_t semitones);
 
     /// Serialize all events to raw MIDI bytes (NoteOn/NoteOff pairs).
     /// Returns total number of bytes written.
     /// Stops early if buffer is too small for an event.
+    /// See GingoSequenceEncoder to send the same bytes as they fall due.
     uint16_t toMIDI(uint8_t* buf, uint16_t maxLen, uint8_t channel = 1) const;
 
     /// Current tempo.
@@ -83,12 +146,97 @@ public:
     void setTimeSignature(const GingoTimeSig& ts) { timeSig_ = ts; }
 
 private:
-    GingoEvent  events_[GINGODUINO_MAX_EVENTS];
-    uint8_t     count_;
+    struct Slot {
+        GingoEvent event;
+        float      start;   // beats from the start of the sequence
+    };
+
+    Slot*       slot(uint16_t index);
+    const Slot* slot(uint16_t index) const;
+
+    /// Recompute starts from the first stale one.
+    void updateStarts() const;
+
+    /// Beat at which the event at index ends (starts must be current).
+    float endBeat(uint16_t index) const;
+
+    void copyEvents(const GingoSequence& other);
+    void releaseChunks();
+
+    Slot        inline_[GINGODUINO_MAX_EVENTS];
+    Slot*       chunks_[GINGODUINO_SEQUENCE_MAX_CHUNKS];
+    GingoSequenceAllocator allocator_;
+    uint16_t    count_;
+    uint8_t     chunkCount_;
+    mutable uint16_t timed_;   // events whose start is current
     GingoTempo  tempo_;
     GingoTimeSig timeSig_;
 };
 
+/// A MIDI message with the time it falls due.
+struct GingoMIDIMessage {
+    uint32_t micros;     // from the start of the sequence
+    uint8_t  data[3];    // NoteOn or NoteOff
+};
+
+/// Encodes a GingoSequence to MIDI one message at a time.
+///
+/// Produces the bytes of GingoSequence::toMIDI() in the same order, each
+/// NoteOn at its event's start and each NoteOff at its end, so a player
+/// can send them as they fall due instead of rendering the whole sequence.
+/// Rests produce nothing. The encoder only keeps a position: rewind() or
+/// seek after editing the sequence.
+///
+/// Examples:
+///   GingoSequenceEncoder enc(seq);
+///   // in loop(), elapsed = micros() - playStart:
+///   uint8_t buf[48];
+///   uint16_t n = enc.poll(elapsed, buf, sizeof(buf));
+///   // or schedule one at a time:
+///   GingoMIDIMessage msg;
+///   while (enc.next(msg)) scheduler.at(msg.micros, msg.data, 3);
+class GingoSequenceEncoder {
+public:
+    /// channel: MIDI channel for every message (1-16), or 0 to use each
+    /// event's own channel, as in GingoSequence::toMIDI().
+    explicit GingoSequenceEncoder(const GingoSequence& sequence, uint8_t channel = 1);
+
+    /// Go back to the first event.
+    void rewind() { seekIndex(0); }
+
+    /// Continue from the first event starting at or after the given beat.
+    /// Events already sounding there are skipped. O(log n).
+    void seekBeat(float beat);
+
+    /// Continue from the first event starting at or after the given time.
+    void seekSeconds(float seconds);
+
+    /// Whether every message has been produced.
+    bool done() const { return index_ >= seq_->size(); }
+
+    /// Time of the next message in microseconds, or UINT32_MAX when done.
+    uint32_t nextMicros() const;
+
+    /// Write the next message and advance. Returns false when done.
+    bool next(GingoMIDIMessage& msg);
+
+    /// Write the messages due at or before nowMicros, 3 bytes each, as
+    /// many as fit in maxLen. Returns the number of bytes written.
+    uint16_t poll(uint32_t nowMicros, uint8_t* buf, uint16_t maxLen);
+
+private:
+    void seekIndex(uint16_t index);
+    void skipRests();
+
+    /// Encode the next message into out (3 bytes) and move past it.
+    void advance(uint8_t* out);
+
+    const GingoSequence* seq_;
+    uint16_t index_;
+    uint8_t  channel_;
+    bool     noteOff_;   // the NoteOff of index_ comes next
+};
+
 } // namespace gingoduino
 
 #endif // GINGODUINO_HAS_SEQUENCE
@@ -8,6 +8,7 @@
 #if GINGODUINO_HAS_TREE
 
 #include "gingoduino_progmem.h"
+#include "gingoduino_tables.h"
 
 namespace gingoduino {
 
@@ -32,28 +33,39 @@ GingoTree::GingoTree(const char* tonic, ScaleType type, uint8_t traditionId)
 
 uint8_t GingoTree::findBranch(const char* name) {
     if (!name) return 0xFF;
+#if GINGODUINO_CONSTEXPR_TABLES
+    // Perfect hash: the slot holds the only branch that can match
+    uint8_t id = data::BRANCH_SLOTS.branch[data::branchSlot(name)];
+    if (id != 0xFF && strcmp(name, data::PROG_BRANCH_NAMES[id]) == 0) return id;
+#else
     for (uint8_t i = 0; i < PROG_BRANCH_COUNT; i++) {
         const char* ptr = (const char*)pgm_read_ptr(&data::PROG_BRANCH_NAMES[i]);
         char buf[24];
         data::readPgmStr(buf, ptr, sizeof(buf));
         if (strcmp(name, buf) == 0) return i;
     }
+#endif
     return 0xFF;
 }
 
+const char* GingoTree::branchName(uint8_t branchId) {
+    if (branchId >= PROG_BRANCH_COUNT) return nullptr;
+    return (const char*)pgm_read_ptr(&data::PROG_BRANCH_NAMES[branchId]);
+}
+
 // ---------------------------------------------------------------------------
 // Edge lookup
 // ---------------------------------------------------------------------------
 
 bool GingoTree::hasEdge(uint8_t originId, uint8_t targetId) const {
-    // Read edge table pointer and count from PROGMEM
-    const data::ProgEdge* edges;
-    uint8_t edgeCount;
-
+    if (originId >= PROG_BRANCH_COUNT || targetId >= PROG_BRANCH_COUNT) return false;
+#if GINGODUINO_CONSTEXPR_TABLES
+    return (data::PROG_ADJACENCY[traditionId_][ctx_].out[originId] >> targetId) & 1;
+#else
     // Read the ProgEdgeTable struct from PROGMEM
     const data::ProgEdgeTable* tablePtr = &data::PROG_EDGE_TABLES[traditionId_][ctx_];
-    edges = (const data::ProgEdge*)pgm_read_ptr(&tablePtr->edges);
-    edgeCount = pgm_read_byte(&tablePtr->count);
+    const data::ProgEdge* edges = (const data::ProgEdge*)pgm_read_ptr(&tablePtr->edges);
+    uint8_t edgeCount = pgm_read_byte(&tablePtr->count);
 
     for (uint8_t i = 0; i < edgeCount; i++) {
         uint8_t o = pgm_read_byte(&edges[i].origin);
@@ -61,6 +73,33 @@ bool GingoTree::hasEdge(uint8_t originId, uint8_t targetId) const {
         if (o == originId && t == targetId) return true;
     }
     return false;
+#endif
+}
+
+uint8_t GingoTree::countValidTransitions(const uint8_t* ids, uint8_t count) const {
+    if (count < 2) return 0;
+    uint8_t valid = 0;
+    for (uint8_t i = 0; i + 1 < count; i++) {
+        if (hasEdge(ids[i], ids[i + 1])) valid++;
+    }
+    return valid;
+}
+
+uint8_t GingoTree::neighbors(uint8_t branchId, uint8_t* output, uint8_t maxNeighbors) const {
+    if (branchId >= PROG_BRANCH_COUNT) return 0;
+    uint8_t written = 0;
+#if GINGODUINO_CONSTEXPR_TABLES
+    uint64_t row = data::PROG_ADJACENCY[traditionId_][ctx_].out[branchId];
+    while (row && written < maxNeighbors) {
+        output[written++] = (uint8_t)__builtin_ctzll(row);
+        row &= row - 1;
+    }
+#else
+    for (uint8_t t = 0; t < PROG_BRANCH_COUNT && written < maxNeighbors; t++) {
+        if (hasEdge(branchId, t)) output[written++] = t;
+    }
+#endif
+    return written;
 }
 
 // ---------------------------------------------------------------------------
@@ -68,10 +107,7 @@ bool GingoTree::hasEdge(uint8_t originId, uint8_t targetId) const {
 // ---------------------------------------------------------------------------
 
 bool GingoTree::isValid(const char* origin, const char* target) const {
-    uint8_t oid = findBranch(origin);
-    uint8_t tid = findBranch(target);
-    if (oid == 0xFF || tid == 0xFF) return false;
-    return hasEdge(oid, tid);
+    return hasEdge(findBranch(origin), findBranch(target));
 }
 
 bool GingoTree::isValidSequence(const char* const* sequence, uint8_t count) const {
@@ -85,30 +121,20 @@ bool GingoTree::isValidSequence(const char* const* sequence, uint8_t count) cons
 uint8_t GingoTree::countValidTransitions(const char* const* sequence, uint8_t count) const {
     if (count < 2) return 0;
     uint8_t valid = 0;
-    for (uint8_t i = 0; i + 1 < count; i++) {
-        if (isValid(sequence[i], sequence[i + 1])) valid++;
+    uint8_t prev = findBranch(sequence[0]);
+    for (uint8_t i = 1; i < count; i++) {
+        uint8_t cur = findBranch(sequence[i]);
+        if (hasEdge(prev, cur)) valid++;
+        prev = cur;
     }
     return valid;
 }
 
 uint8_t GingoTree::neighbors(const char* branch, const char** output, uint8_t maxNeighbors) const {
-    uint8_t branchId = findBranch(branch);
-    if (branchId == 0xFF) return 0;
-
-    const data::ProgEdgeTable* tablePtr = &data::PROG_EDGE_TABLES[traditionId_][ctx_];
-    const data::ProgEdge* edges = (const data::ProgEdge*)pgm_read_ptr(&tablePtr->edges);
-    uint8_t edgeCount = pgm_read_byte(&tablePtr->count);
-
-    uint8_t written = 0;
-    for (uint8_t i = 0; i < edgeCount && written < maxNeighbors; i++) {
-        uint8_t o = pgm_read_byte(&edges[i].origin);
-        if (o == branchId) {
-            uint8_t t = pgm_read_byte(&edges[i].target);
-            if (t < PROG_BRANCH_COUNT) {
-                output[written++] = (const char*)pgm_read_ptr(&data::PROG_BRANCH_NAMES[t]);
-            }
-        }
-    }
+    uint8_t ids[PROG_BRANCH_COUNT];
+    uint8_t written = neighbors(findBranch(branch), ids,
+                                maxNeighbors < PROG_BRANCH_COUNT ? maxNeighbors : PROG_BRANCH_COUNT);
+    for (uint8_t i = 0; i < written; i++) output[i] = branchName(ids[i]);
     return written;
 }
 
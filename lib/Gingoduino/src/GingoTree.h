@@ -46,6 +46,19 @@ public:
     /// Returns number written.
     uint8_t neighbors(const char* branch, const char** output, uint8_t maxNeighbors) const;
 
+    // --- By branch ID (see findBranch), for callers that look up names once ---
+
+    /// Check if the transition originId→targetId is valid.
+    /// False for an unknown ID (0xFF).
+    bool hasEdge(uint8_t originId, uint8_t targetId) const;
+
+    /// Count valid transitions in a sequence of branch IDs.
+    uint8_t countValidTransitions(const uint8_t* ids, uint8_t count) const;
+
+    /// Write the IDs of the valid targets of a branch, lowest ID first.
+    /// Returns number written.
+    uint8_t neighbors(uint8_t branchId, uint8_t* output, uint8_t maxNeighbors) const;
+
     /// Resolve a branch name to a concrete chord name.
     /// E.g., "V7" in C major → "G7", "IIm" in C major → "Dm".
     /// Returns true if resolved successfully.
@@ -63,13 +76,13 @@ public:
     /// Find the branch ID for a branch name string. Returns 0xFF if not found.
     static uint8_t findBranch(const char* name);
 
+    /// Name of a branch ID (PROGMEM), or nullptr for an unknown ID.
+    static const char* branchName(uint8_t branchId);
+
 private:
     GingoField field_;
     uint8_t    traditionId_;
     uint8_t    ctx_;  // 0=major, 1=minor
-
-    /// Check if edge (origin_id, target_id) exists in the edge table.
-    bool hasEdge(uint8_t originId, uint8_t targetId) const;
 };
 
 } // namespace gingoduino
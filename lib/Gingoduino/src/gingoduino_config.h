@@ -67,6 +67,23 @@
   #define GINGODUINO_HAS_COMPARISON    0
 #endif
 
+// ---------------------------------------------------------------------------
+// Constexpr tables
+// ---------------------------------------------------------------------------
+//
+// Scale modes, harmonic-field chords, chord pitch sets, the progression
+// graph's adjacency bits and its branch-name hash derived at compile time
+// (gingoduino_tables.h) and read as plain const arrays.
+// Off on AVR, where const data is copied to RAM unless kept in PROGMEM.
+
+#ifndef GINGODUINO_CONSTEXPR_TABLES
+  #if defined(__AVR__)
+    #define GINGODUINO_CONSTEXPR_TABLES 0
+  #else
+    #define GINGODUINO_CONSTEXPR_TABLES 1
+  #endif
+#endif
+
 // ---------------------------------------------------------------------------
 // PROGMEM portability
 // ---------------------------------------------------------------------------
@@ -126,6 +143,14 @@
   #ifndef GINGODUINO_MAX_EVENTS
     #define GINGODUINO_MAX_EVENTS  64
   #endif
+  // Events past GINGODUINO_MAX_EVENTS live in chunks from the sequence's
+  // allocator (heap or PSRAM), when it has one.
+  #ifndef GINGODUINO_SEQUENCE_CHUNK
+    #define GINGODUINO_SEQUENCE_CHUNK       256
+  #endif
+  #ifndef GINGODUINO_SEQUENCE_MAX_CHUNKS
+    #define GINGODUINO_SEQUENCE_MAX_CHUNKS  32
+  #endif
 #endif
 
 #if GINGODUINO_HAS_FRETBOARD
@@ -138,6 +163,9 @@
   #ifndef GINGODUINO_MAX_FINGERINGS
     #define GINGODUINO_MAX_FINGERINGS      5
   #endif
+  #ifndef GINGODUINO_FINGERING_CACHE
+    #define GINGODUINO_FINGERING_CACHE     8
+  #endif
 #endif
 
 #endif // GINGODUINO_CONFIG_H
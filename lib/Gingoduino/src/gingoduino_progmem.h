@@ -1,5 +1,7 @@
 // Gingoduino — Music Theory Library for Embedded Systems
 // All music theory lookup data stored in PROGMEM (flash memory).
+// Tables that gingoduino_tables.h derives from are also constexpr, so
+// they can be read at compile time as well as through pgm_read_*.
 //
 // SPDX-License-Identifier: MIT
 
@@ -15,13 +17,13 @@ namespace data {
 // 1. CHROMATIC SCALE — 12 pitch classes
 // ===================================================================
 
-static const char CHROMATIC_NAMES[12][3] PROGMEM = {
+static constexpr char CHROMATIC_NAMES[12][3] PROGMEM = {
     "C", "C#", "D", "D#", "E", "F",
     "F#", "G", "G#", "A", "A#", "B"
 };
 
 // Base letter (sound) for each chromatic index
-static const char CHROMATIC_SOUND[12] PROGMEM = {
+static constexpr char CHROMATIC_SOUND[12] PROGMEM = {
     'C', 'C', 'D', 'D', 'E', 'F', 'F', 'G', 'G', 'A', 'A', 'B'
 };
 
@@ -108,25 +110,25 @@ static const IntervalData INTERVAL_TABLE[24] PROGMEM = {
 // Each uint32_t has bit N set if semitone position N is active.
 // Bit 0 = P1, Bit 1 = 2m, ..., Bit 11 = 7M, Bit 12 = 8J, ...
 
-static const uint32_t SCALE_MASKS[10] PROGMEM = {
+static constexpr uint32_t SCALE_MASKS[10] PROGMEM = {
     // Major:          P1 . 2M .  3M 4J .  5J .  M6 .  7M | .  .  9  .  .  11 .  .  .  13 .  .
     0b00000000001000100010101010110101UL,  // 0 Major
     // NatMinor:       P1 . 2M 3m .  4J .  5J #5 .  7m .  | .  .  9  .  .  11 .  .  b13 .  .  .
-    0b00000000000101000010101011010101UL,  // 1 Natural minor
+    0b00000000000101000010010110101101UL,  // 1 Natural minor
     // HarmMinor:      P1 . 2M 3m .  4J .  5J #5 .  .  7M | .  .  9  .  .  11 .  .  .  13 .  .
-    0b00000000001000100010100011010101UL,  // 2 Harmonic minor
+    0b00000000001000100010100110101101UL,  // 2 Harmonic minor
     // MelodicMinor:   P1 . 2M 3m .  4J .  5J .  M6 .  7M | .  .  9  .  .  11 .  .  .  13 .  .
-    0b00000000001000100010101010010101UL,  // 3 Melodic minor
-    // Diminished:     P1 . 2M 3m .  4J d5 .  #5 .  7m 7M | .  .  9  .  .  11 .  .  .  13 .  .
-    0b00000000001000100010110001110101UL,  // 4 Diminished
+    0b00000000001000100010101010101101UL,  // 3 Melodic minor
+    // Diminished:     P1 . 2M 3m .  4J d5 .  #5 M6 .  7M | .  .  9  .  .  11 .  .  .  13 .  .
+    0b00000000001000100010101101101101UL,  // 4 Diminished
     // HarmonicMajor:  P1 . 2M .  3M 4J .  5J #5 .  .  7M | .  .  9  .  .  11 .  .  .  13 .  .
     0b00000000001000100010100110110101UL,  // 5 Harmonic major
     // WholeTone:      P1 . 2M .  3M .  d5 .  #5 .  7m .  | .  .  9  .  .  .  #11 .  .  13 .  .
     0b00000000001001000000010101010101UL,  // 6 Whole tone
     // Augmented:      P1 .  .  3m 3M .  .  5J #5 .  .  7M | .  .  .  #9 .  .  .  5  .  .  #13 .
-    0b00000000010010000010000110011001UL,  // 7 Augmented
+    0b00000000010010000010100110011001UL,  // 7 Augmented
     // Blues:          P1 .  .  3m .  4J d5 5J .  .  7m .  | .  .  .  #9 .  11 #11 .  .  .  #13 .
-    0b00000000010011000010000011101001UL,  // 8 Blues
+    0b00000000010011000010010011101001UL,  // 8 Blues
     // Chromatic:      all bits set
     0b00000000111111111111111111111111UL,  // 9 Chromatic
 };
@@ -137,7 +139,7 @@ static const uint32_t MODALITY_DIATONIC   PROGMEM = 0b00000000001101100010111111
 static const uint32_t MODALITY_PENTATONIC PROGMEM = 0b00000000001101100010110111101111UL;
 
 // Scale size (number of notes in each parent scale)
-static const uint8_t SCALE_SIZES[10] PROGMEM = {
+static constexpr uint8_t SCALE_SIZES[10] PROGMEM = {
     7, 7, 7, 7, 8, 7, 6, 6, 6, 12
 };
 
@@ -170,7 +172,7 @@ struct ChordFormula {
     uint8_t count;         // how many intervals
 };
 
-static const ChordFormula CHORD_FORMULAS[42] PROGMEM = {
+static constexpr ChordFormula CHORD_FORMULAS[42] PROGMEM = {
     /*  0 M       */ {{0, 4, 7, 0, 0, 0, 0}, 3},
     /*  1 7M      */ {{0, 4, 7, 11, 0, 0, 0}, 4},
     /*  2 6       */ {{0, 4, 7, 9, 0, 0, 0}, 4},
@@ -287,6 +289,118 @@ static const ChordTypeAlias CHORD_TYPE_MAP[] PROGMEM = {
 
 static const uint8_t CHORD_TYPE_MAP_SIZE = sizeof(CHORD_TYPE_MAP) / sizeof(CHORD_TYPE_MAP[0]);
 
+// ===================================================================
+// 5c. CANONICAL CHORD NAMES — one per formula
+// ===================================================================
+//
+// The shortest alias in CHORD_TYPE_MAP for each formula (first in map
+// order on ties), as GingoChord::identify() writes it.
+
+static constexpr char CHORD_CANONICAL_NAMES[42][8] PROGMEM = {
+    /*  0 */ "M",
+    /*  1 */ "7M",
+    /*  2 */ "6",
+    /*  3 */ "6(9)",
+    /*  4 */ "M9",
+    /*  5 */ "m",
+    /*  6 */ "m7",
+    /*  7 */ "m6",
+    /*  8 */ "m11",
+    /*  9 */ "m7M",
+    /* 10 */ "7",
+    /* 11 */ "7/9",
+    /* 12 */ "11",
+    /* 13 */ "dim",
+    /* 14 */ "dim7",
+    /* 15 */ "m7(b5)",
+    /* 16 */ "aug",
+    /* 17 */ "7#5",
+    /* 18 */ "7(b5)",
+    /* 19 */ "13",
+    /* 20 */ "13(#11)",
+    /* 21 */ "7+5",
+    /* 22 */ "7+9",
+    /* 23 */ "7(b9)",
+    /* 24 */ "7(#11)",
+    /* 25 */ "5",
+    /* 26 */ "(9)",
+    /* 27 */ "add2",
+    /* 28 */ "add11",
+    /* 29 */ "add4",
+    /* 30 */ "sus2",
+    /* 31 */ "sus4",
+    /* 32 */ "sus7",
+    /* 33 */ "sus9",
+    /* 34 */ "m13",
+    /* 35 */ "M13",
+    /* 36 */ "sus",
+    /* 37 */ "m9",
+    /* 38 */ "+M7",
+    /* 39 */ "m7(11)",
+    /* 40 */ "(b9)",
+    /* 41 */ "(b13)",
+};
+
+// ===================================================================
+// 5d. CHORD PITCH-CLASS SETS — sorted for binary search
+// ===================================================================
+//
+// Each formula folded into one octave: bit N set if pitch class N above
+// the root is a chord tone (bit 0 = root). Formulas that fold to the same
+// set (add9/add2, sus4/sus, ...) are adjacent, lowest index first.
+
+struct ChordPitchSet {
+    uint16_t mask;         // 12-bit pitch-class set, root = bit 0
+    uint8_t  formulaIdx;   // index into CHORD_FORMULAS
+};
+
+static constexpr ChordPitchSet CHORD_PITCH_SETS[42] PROGMEM = {
+    {0x049, 13},  // dim
+    {0x081, 25},  // 5
+    {0x085, 30},  // sus2
+    {0x089,  5},  // m
+    {0x091,  0},  // M
+    {0x093, 40},  // (b9)
+    {0x095, 26},  // (9)
+    {0x095, 27},  // add2
+    {0x0A1, 31},  // sus4
+    {0x0A1, 36},  // sus
+    {0x0A5, 33},  // sus9
+    {0x0B1, 28},  // add11
+    {0x0B1, 29},  // add4
+    {0x111, 16},  // aug
+    {0x191, 41},  // (b13)
+    {0x249, 14},  // dim7
+    {0x289,  7},  // m6
+    {0x291,  2},  // 6
+    {0x295,  3},  // 6(9)
+    {0x449, 15},  // m7(b5)
+    {0x451, 18},  // 7(b5)
+    {0x489,  6},  // m7
+    {0x48D, 37},  // m9
+    {0x491, 10},  // 7
+    {0x493, 23},  // 7(b9)
+    {0x495, 11},  // 7/9
+    {0x499, 22},  // 7+9
+    {0x4A1, 32},  // sus7
+    {0x4A9,  8},  // m11
+    {0x4A9, 39},  // m7(11)
+    {0x4B5, 12},  // 11
+    {0x4D1, 24},  // 7(#11)
+    {0x511, 17},  // 7#5
+    {0x511, 21},  // 7+5
+    {0x6AD, 34},  // m13
+    {0x6B5, 19},  // 13
+    {0x6D5, 20},  // 13(#11)
+    {0x889,  9},  // m7M
+    {0x891,  1},  // 7M
+    {0x895,  4},  // M9
+    {0x911, 38},  // +M7
+    {0xAD5, 35},  // M13
+};
+
+static constexpr uint8_t CHORD_PITCH_SETS_SIZE = sizeof(CHORD_PITCH_SETS) / sizeof(CHORD_PITCH_SETS[0]);
+
 // ===================================================================
 // 6. TEMPO MARKINGS
 // ===================================================================
@@ -568,54 +682,54 @@ static const uint8_t TUNING_UKULELE[4] PROGMEM = { 67, 60, 64, 69 };
 // All unique branch names across both traditions.
 // Index is the branch ID used in edges and schemas.
 
-static const char BR_00[] PROGMEM = "I";
-static const char BR_01[] PROGMEM = "IIm / IV";
-static const char BR_02[] PROGMEM = "IIm7(b5) / IIm";
-static const char BR_03[] PROGMEM = "IIm7(11) / IV";
-static const char BR_04[] PROGMEM = "SUBV7 / IV";
-static const char BR_05[] PROGMEM = "V7 / IV";
-static const char BR_06[] PROGMEM = "VIm";
-static const char BR_07[] PROGMEM = "V7 / IIm";
-static const char BR_08[] PROGMEM = "Idim";
-static const char BR_09[] PROGMEM = "#Idim";
-static const char BR_10[] PROGMEM = "bIIIdim";
-static const char BR_11[] PROGMEM = "IV#dim";
-static const char BR_12[] PROGMEM = "IV";
-static const char BR_13[] PROGMEM = "V7 / V";
-static const char BR_14[] PROGMEM = "IIm";
-static const char BR_15[] PROGMEM = "IVm";
-static const char BR_16[] PROGMEM = "bVI";
-static const char BR_17[] PROGMEM = "bVII";
-static const char BR_18[] PROGMEM = "IIm7(b5)";
-static const char BR_19[] PROGMEM = "II#dim";
-static const char BR_20[] PROGMEM = "SUBV7";
-static const char BR_21[] PROGMEM = "V7";
-static const char BR_22[] PROGMEM = "V7 / VI";
-static const char BR_23[] PROGMEM = "V7 / Im";
-static const char BR_24[] PROGMEM = "V7 / III";
-static const char BR_25[] PROGMEM = "V7 / bIII";
-static const char BR_26[] PROGMEM = "V7 / bVI";
+static constexpr char BR_00[] PROGMEM = "I";
+static constexpr char BR_01[] PROGMEM = "IIm / IV";
+static constexpr char BR_02[] PROGMEM = "IIm7(b5) / IIm";
+static constexpr char BR_03[] PROGMEM = "IIm7(11) / IV";
+static constexpr char BR_04[] PROGMEM = "SUBV7 / IV";
+static constexpr char BR_05[] PROGMEM = "V7 / IV";
+static constexpr char BR_06[] PROGMEM = "VIm";
+static constexpr char BR_07[] PROGMEM = "V7 / IIm";
+static constexpr char BR_08[] PROGMEM = "Idim";
+static constexpr char BR_09[] PROGMEM = "#Idim";
+static constexpr char BR_10[] PROGMEM = "bIIIdim";
+static constexpr char BR_11[] PROGMEM = "IV#dim";
+static constexpr char BR_12[] PROGMEM = "IV";
+static constexpr char BR_13[] PROGMEM = "V7 / V";
+static constexpr char BR_14[] PROGMEM = "IIm";
+static constexpr char BR_15[] PROGMEM = "IVm";
+static constexpr char BR_16[] PROGMEM = "bVI";
+static constexpr char BR_17[] PROGMEM = "bVII";
+static constexpr char BR_18[] PROGMEM = "IIm7(b5)";
+static constexpr char BR_19[] PROGMEM = "II#dim";
+static constexpr char BR_20[] PROGMEM = "SUBV7";
+static constexpr char BR_21[] PROGMEM = "V7";
+static constexpr char BR_22[] PROGMEM = "V7 / VI";
+static constexpr char BR_23[] PROGMEM = "V7 / Im";
+static constexpr char BR_24[] PROGMEM = "V7 / III";
+static constexpr char BR_25[] PROGMEM = "V7 / bIII";
+static constexpr char BR_26[] PROGMEM = "V7 / bVI";
 // Minor-specific branches
-static const char BR_27[] PROGMEM = "Im";
-static const char BR_28[] PROGMEM = "IIm7(b5) / Ivm";
-static const char BR_29[] PROGMEM = "IVm7 / IVm";
-static const char BR_30[] PROGMEM = "V / IVm";
-static const char BR_31[] PROGMEM = "V / V";
-static const char BR_32[] PROGMEM = "bVI / Im";
-static const char BR_33[] PROGMEM = "II / IIm";
-static const char BR_34[] PROGMEM = "bV / V";
-static const char BR_35[] PROGMEM = "V7 / I";
-static const char BR_36[] PROGMEM = "bIII";
-static const char BR_37[] PROGMEM = "Vm";
+static constexpr char BR_27[] PROGMEM = "Im";
+static constexpr char BR_28[] PROGMEM = "IIm7(b5) / Ivm";
+static constexpr char BR_29[] PROGMEM = "IVm7 / IVm";
+static constexpr char BR_30[] PROGMEM = "V / IVm";
+static constexpr char BR_31[] PROGMEM = "V / V";
+static constexpr char BR_32[] PROGMEM = "bVI / Im";
+static constexpr char BR_33[] PROGMEM = "II / IIm";
+static constexpr char BR_34[] PROGMEM = "bV / V";
+static constexpr char BR_35[] PROGMEM = "V7 / I";
+static constexpr char BR_36[] PROGMEM = "bIII";
+static constexpr char BR_37[] PROGMEM = "Vm";
 // Jazz-specific
-static const char BR_38[] PROGMEM = "IIIm";
-static const char BR_39[] PROGMEM = "VIIdim";
-static const char BR_40[] PROGMEM = "#IIdim";
-static const char BR_41[] PROGMEM = "V7 / V";  // (reuse ID 13 in edges)
+static constexpr char BR_38[] PROGMEM = "IIIm";
+static constexpr char BR_39[] PROGMEM = "VIIdim";
+static constexpr char BR_40[] PROGMEM = "#IIdim";
+static constexpr char BR_41[] PROGMEM = "V7 / V";  // (reuse ID 13 in edges)
 
 #define PROG_BRANCH_COUNT 41
 
-static const char* const PROG_BRANCH_NAMES[PROG_BRANCH_COUNT] PROGMEM = {
+static constexpr const char* PROG_BRANCH_NAMES[PROG_BRANCH_COUNT] PROGMEM = {
     BR_00, BR_01, BR_02, BR_03, BR_04, BR_05, BR_06, BR_07, BR_08, BR_09,
     BR_10, BR_11, BR_12, BR_13, BR_14, BR_15, BR_16, BR_17, BR_18, BR_19,
     BR_20, BR_21, BR_22, BR_23, BR_24, BR_25, BR_26, BR_27, BR_28, BR_29,
@@ -641,7 +755,7 @@ struct ProgEdge {
 };
 
 // ---- harmonic_tree, major (57 edges) ----
-static const ProgEdge HT_MAJOR_EDGES[] PROGMEM = {
+static constexpr ProgEdge HT_MAJOR_EDGES[] PROGMEM = {
     {0, 0},     // I → I
     {0, 1},     // I → IIm / IV
     {0, 2},     // I → IIm7(b5) / IIm
@@ -704,7 +818,7 @@ static const ProgEdge HT_MAJOR_EDGES[] PROGMEM = {
 #define HT_MAJOR_EDGE_COUNT (sizeof(HT_MAJOR_EDGES) / sizeof(HT_MAJOR_EDGES[0]))
 
 // ---- harmonic_tree, minor (25 edges) ----
-static const ProgEdge HT_MINOR_EDGES[] PROGMEM = {
+static constexpr ProgEdge HT_MINOR_EDGES[] PROGMEM = {
     {27, 27},   // Im → Im
     {27, 28},   // Im → IIm7(b5) / Ivm
     {27, 33},   // Im → II / IIm
@@ -734,7 +848,7 @@ static const ProgEdge HT_MINOR_EDGES[] PROGMEM = {
 #define HT_MINOR_EDGE_COUNT (sizeof(HT_MINOR_EDGES) / sizeof(HT_MINOR_EDGES[0]))
 
 // ---- jazz, major (32 edges) ----
-static const ProgEdge JZ_MAJOR_EDGES[] PROGMEM = {
+static constexpr ProgEdge JZ_MAJOR_EDGES[] PROGMEM = {
     {0, 0},     // I → I
     {0, 14},    // I → IIm
     {0, 12},    // I → IV
@@ -771,7 +885,7 @@ static const ProgEdge JZ_MAJOR_EDGES[] PROGMEM = {
 #define JZ_MAJOR_EDGE_COUNT (sizeof(JZ_MAJOR_EDGES) / sizeof(JZ_MAJOR_EDGES[0]))
 
 // ---- jazz, minor (15 edges) ----
-static const ProgEdge JZ_MINOR_EDGES[] PROGMEM = {
+static constexpr ProgEdge JZ_MINOR_EDGES[] PROGMEM = {
     {27, 27},   // Im → Im
     {27, 18},   // Im → IIm7(b5)
     {27, 15},   // Im → IVm
@@ -966,6 +1080,25 @@ inline int8_t findChordType(const char* typeName) {
     return -1;
 }
 
+/// Binary search in sorted PROGMEM ChordPitchSet array.
+/// Returns the first entry with this mask, or -1.
+inline int8_t findChordPitchSet(uint16_t mask) {
+    int8_t lo = 0;
+    int8_t hi = (int8_t)(CHORD_PITCH_SETS_SIZE - 1);
+    int8_t found = -1;
+    while (lo <= hi) {
+        int8_t mid = (lo + hi) / 2;
+        uint16_t m = pgm_read_word(&CHORD_PITCH_SETS[mid].mask);
+        if (m < mask) {
+            lo = mid + 1;
+        } else {
+            if (m == mask) found = mid;
+            hi = mid - 1;
+        }
+    }
+    return found;
+}
+
 /// Read a ChordFormula from PROGMEM
 inline void readChordFormula(uint8_t idx, uint8_t* intervals, uint8_t* count) {
     *count = pgm_read_byte(&CHORD_FORMULAS[idx].count);
@@ -0,0 +1,245 @@
+// Gingoduino — Music Theory Library for Embedded Systems
+// Tables derived at compile time from the PROGMEM source tables.
+//
+// SPDX-License-Identifier: MIT
+
+#ifndef GINGODUINO_TABLES_H
+#define GINGODUINO_TABLES_H
+
+#include "gingoduino_config.h"
+#include "gingoduino_types.h"
+#include "gingoduino_progmem.h"
+
+#if GINGODUINO_CONSTEXPR_TABLES
+
+namespace gingoduino {
+namespace data {
+
+// Everything here is C++11 constexpr (one return statement, recursion
+// instead of loops), so it builds with the default Arduino toolchains.
+// The generated arrays are index-addressed and read directly; no
+// pgm_read_* and no string parsing.
+
+// ===================================================================
+// Helpers
+// ===================================================================
+
+template<uint8_t... I> struct IndexList {};
+template<uint8_t N, uint8_t... I>
+struct MakeIndexList : MakeIndexList<N - 1, N - 1, I...> {};
+template<uint8_t... I>
+struct MakeIndexList<0, I...> { typedef IndexList<I...> type; };
+
+/// Rotate a 12-bit pitch-class set so that pitch class r becomes bit 0.
+constexpr uint16_t rotate12(uint16_t set, uint8_t r) {
+    return (uint16_t)(((set >> (r % 12)) | (set << ((12 - r % 12) % 12))) & 0x0FFF);
+}
+
+constexpr uint8_t popcount12(uint16_t set) {
+    return set ? (uint8_t)((set & 1) + popcount12((uint16_t)(set >> 1))) : 0;
+}
+
+/// Position of the n-th (0-based) set bit at or above bit i; 12 if none.
+constexpr uint8_t nthBit(uint16_t set, uint8_t n, uint8_t i = 0) {
+    return i >= 12 ? 12
+         : (set & (1u << i)) ? (n == 0 ? i : nthBit(set, (uint8_t)(n - 1), (uint8_t)(i + 1)))
+         : nthBit(set, n, (uint8_t)(i + 1));
+}
+
+// ===================================================================
+// Chord pitch-class sets
+// ===================================================================
+
+/// Formula f folded into one octave (root = bit 0).
+constexpr uint16_t formulaSet(uint8_t f, uint8_t i = 0) {
+    return i >= CHORD_FORMULAS[f].count ? 0
+         : (uint16_t)((1u << (CHORD_FORMULAS[f].intervals[i] % 12)) | formulaSet(f, (uint8_t)(i + 1)));
+}
+
+/// Lowest formula whose set is exactly this one; 255 if none.
+constexpr uint8_t formulaOfSet(uint16_t set, uint8_t f = 0) {
+    return f >= CHORD_TYPE_COUNT ? 255 : formulaSet(f) == set ? f : formulaOfSet(set, (uint8_t)(f + 1));
+}
+
+struct ChordSetTable { uint16_t set[CHORD_TYPE_COUNT]; };
+
+template<uint8_t... F>
+constexpr ChordSetTable makeChordSets(IndexList<F...>) {
+    return ChordSetTable{{ formulaSet(F)... }};
+}
+
+/// Pitch-class set of each formula, by ChordType.
+static constexpr ChordSetTable CHORD_SETS =
+    makeChordSets(MakeIndexList<CHORD_TYPE_COUNT>::type());
+
+// CHORD_PITCH_SETS (the sorted search table) is written out by hand so
+// AVR can keep it in PROGMEM; check it against the formulas here.
+constexpr bool pitchSetsValid(uint8_t i = 0) {
+    return i >= CHORD_PITCH_SETS_SIZE ? true
+         : CHORD_PITCH_SETS[i].mask == formulaSet(CHORD_PITCH_SETS[i].formulaIdx) &&
+           (i == 0 || CHORD_PITCH_SETS[i - 1].mask < CHORD_PITCH_SETS[i].mask ||
+            (CHORD_PITCH_SETS[i - 1].mask == CHORD_PITCH_SETS[i].mask &&
+             CHORD_PITCH_SETS[i - 1].formulaIdx < CHORD_PITCH_SETS[i].formulaIdx)) &&
+           pitchSetsValid((uint8_t)(i + 1));
+}
+static_assert(CHORD_PITCH_SETS_SIZE == CHORD_TYPE_COUNT && pitchSetsValid(),
+              "CHORD_PITCH_SETS is out of sync with CHORD_FORMULAS");
+
+// ===================================================================
+// Scale modes
+// ===================================================================
+
+constexpr uint16_t parentSet(uint8_t parent) {
+    return (uint16_t)(SCALE_MASKS[parent] & 0x0FFF);
+}
+
+/// Mode (1-based) of a parent scale: the parent rotated to start on its
+/// mode-th note. Mode 0 or past the last note is the parent itself.
+constexpr uint16_t modeSet(uint8_t parent, uint8_t mode) {
+    return rotate12(parentSet(parent), nthBit(parentSet(parent), (uint8_t)(mode - 1)) % 12);
+}
+
+struct ScaleModeRow { uint16_t set[12]; };
+
+template<uint8_t... M>
+constexpr ScaleModeRow makeModeRow(uint8_t parent, IndexList<M...>) {
+    return ScaleModeRow{{ modeSet(parent, (uint8_t)(M + 1))... }};
+}
+
+template<uint8_t... P>
+struct ScaleModeTable { ScaleModeRow row[sizeof...(P)]; };
+
+template<uint8_t... P>
+constexpr ScaleModeTable<P...> makeModeTable(IndexList<P...>) {
+    return ScaleModeTable<P...>{{ makeModeRow(P, MakeIndexList<12>::type())... }};
+}
+
+/// 12-bit set of each mode: SCALE_MODES.row[parent].set[mode - 1].
+static constexpr auto SCALE_MODES =
+    makeModeTable(MakeIndexList<SCALE_TYPE_COUNT>::type());
+
+// ===================================================================
+// Harmonic fields
+// ===================================================================
+
+/// Semitone of note k of a scale above its tonic, wrapping past the octave.
+constexpr uint8_t scaleStep(uint16_t set, uint8_t k) {
+    return nthBit(set, (uint8_t)(k % popcount12(set)));
+}
+
+/// Chord stacked in thirds on note d of a scale (notes d, d+2, d+4, ...),
+/// as a set relative to note d.
+constexpr uint16_t stackedSet(uint16_t set, uint8_t d, uint8_t notes, uint8_t i = 0) {
+    return i >= notes ? 0
+         : (uint16_t)((1u << ((scaleStep(set, (uint8_t)(d + 2 * i)) - scaleStep(set, d) + 12) % 12)) |
+                      stackedSet(set, d, notes, (uint8_t)(i + 1)));
+}
+
+/// Formula of the chord on degree d (0-based) of a parent scale, or 255.
+constexpr uint8_t fieldChord(uint8_t parent, uint8_t d, uint8_t notes) {
+    return d >= popcount12(parentSet(parent)) ? 255
+         : formulaOfSet(stackedSet(parentSet(parent), d, notes));
+}
+
+struct FieldRow { uint8_t triad[12]; uint8_t seventh[12]; };
+
+template<uint8_t... D>
+constexpr FieldRow makeFieldRow(uint8_t parent, IndexList<D...>) {
+    return FieldRow{{ fieldChord(parent, D, 3)... }, { fieldChord(parent, D, 4)... }};
+}
+
+template<uint8_t... P>
+struct FieldTable { FieldRow row[sizeof...(P)]; };
+
+template<uint8_t... P>
+constexpr FieldTable<P...> makeFieldTable(IndexList<P...>) {
+    return FieldTable<P...>{{ makeFieldRow(P, MakeIndexList<12>::type())... }};
+}
+
+/// Triad and seventh formula on each degree of each parent scale (mode 1):
+/// FIELD_CHORDS.row[parent].triad[degree - 1]. 255 where no formula fits.
+/// Degree d of mode m is degree d + m - 1 of the parent.
+static constexpr auto FIELD_CHORDS =
+    makeFieldTable(MakeIndexList<SCALE_TYPE_COUNT>::type());
+
+#if GINGODUINO_HAS_TREE
+
+// ===================================================================
+// Progression graph
+// ===================================================================
+
+// Branch names hash (FNV-1a from this seed) to a 7-bit slot. The seed is
+// the first one that puts all PROG_BRANCH_NAMES in distinct slots, so a
+// lookup is one hash and one strcmp; the static_assert below keeps it so.
+#define PROG_BRANCH_HASH_SEED  222366u
+#define PROG_BRANCH_HASH_SLOTS 128
+
+constexpr uint32_t branchHash(const char* s, uint32_t h = PROG_BRANCH_HASH_SEED) {
+    return *s ? branchHash(s + 1, (h ^ (uint8_t)*s) * 16777619u) : h;
+}
+
+constexpr uint8_t branchSlot(const char* s) {
+    return (uint8_t)(branchHash(s) >> 25);
+}
+
+/// Branch in a slot; 255 if none.
+constexpr uint8_t branchInSlot(uint8_t slot, uint8_t b = 0) {
+    return b >= PROG_BRANCH_COUNT ? 255
+         : branchSlot(PROG_BRANCH_NAMES[b]) == slot ? b
+         : branchInSlot(slot, (uint8_t)(b + 1));
+}
+
+struct BranchSlotTable { uint8_t branch[PROG_BRANCH_HASH_SLOTS]; };
+
+template<uint8_t... S>
+constexpr BranchSlotTable makeBranchSlots(IndexList<S...>) {
+    return BranchSlotTable{{ branchInSlot(S)... }};
+}
+
+/// Branch ID by hash slot: BRANCH_SLOTS.branch[branchSlot(name)].
+static constexpr BranchSlotTable BRANCH_SLOTS =
+    makeBranchSlots(MakeIndexList<PROG_BRANCH_HASH_SLOTS>::type());
+
+constexpr bool branchSlotsPerfect(uint8_t b = 0) {
+    return b >= PROG_BRANCH_COUNT ? true
+         : BRANCH_SLOTS.branch[branchSlot(PROG_BRANCH_NAMES[b])] == b &&
+           branchSlotsPerfect((uint8_t)(b + 1));
+}
+static_assert(branchSlotsPerfect(),
+              "branch names collide in BRANCH_SLOTS; pick another PROG_BRANCH_HASH_SEED");
+
+// Edges as one row per origin branch: bit t of out[o] is the edge o -> t.
+static_assert(PROG_BRANCH_COUNT <= 64, "branch IDs must fit an adjacency row");
+
+struct ProgAdjacency { uint64_t out[PROG_BRANCH_COUNT]; };
+
+template<size_t N>
+constexpr uint64_t adjacencyRow(const ProgEdge (&edges)[N], uint8_t origin, size_t i = 0) {
+    return i >= N ? 0
+         : (edges[i].origin == origin ? (uint64_t)1 << edges[i].target : 0) |
+           adjacencyRow(edges, origin, i + 1);
+}
+
+template<size_t N, uint8_t... B>
+constexpr ProgAdjacency makeAdjacency(const ProgEdge (&edges)[N], IndexList<B...>) {
+    return ProgAdjacency{{ adjacencyRow(edges, B)... }};
+}
+
+template<size_t N>
+constexpr ProgAdjacency makeAdjacency(const ProgEdge (&edges)[N]) {
+    return makeAdjacency(edges, MakeIndexList<PROG_BRANCH_COUNT>::type());
+}
+
+/// Adjacency bit matrix of each edge table: PROG_ADJACENCY[tradition][ctx].
+static constexpr ProgAdjacency PROG_ADJACENCY[PROG_TRADITION_COUNT][PROG_CTX_COUNT] = {
+    { makeAdjacency(HT_MAJOR_EDGES), makeAdjacency(HT_MINOR_EDGES) },
+    { makeAdjacency(JZ_MAJOR_EDGES), makeAdjacency(JZ_MINOR_EDGES) },
+};
+
+#endif // GINGODUINO_HAS_TREE
+
+} // namespace data
+} // namespace gingoduino
+
+#endif // GINGODUINO_CONSTEXPR_TABLES
+#endif // GINGODUINO_TABLES_H
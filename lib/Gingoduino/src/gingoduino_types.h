@@ -138,6 +138,54 @@ enum ScaleType : uint8_t {
     SCALE_TYPE_COUNT     = 10
 };
 
+/// Chord formulas, by index in CHORD_FORMULAS (see gingoduino_progmem.h).
+/// Comments give the canonical name GingoChord writes for each.
+enum ChordType : uint8_t {
+    CHORD_MAJOR             = 0,   // M
+    CHORD_MAJOR_7           = 1,   // 7M
+    CHORD_SIXTH             = 2,   // 6
+    CHORD_SIX_NINE          = 3,   // 6(9)
+    CHORD_MAJOR_9           = 4,   // M9
+    CHORD_MINOR             = 5,   // m
+    CHORD_MINOR_7           = 6,   // m7
+    CHORD_MINOR_6           = 7,   // m6
+    CHORD_MINOR_11          = 8,   // m11
+    CHORD_MINOR_MAJOR_7     = 9,   // m7M
+    CHORD_DOMINANT_7        = 10,  // 7
+    CHORD_DOMINANT_9        = 11,  // 7/9
+    CHORD_DOMINANT_11       = 12,  // 11
+    CHORD_DIMINISHED        = 13,  // dim
+    CHORD_DIMINISHED_7      = 14,  // dim7
+    CHORD_HALF_DIMINISHED   = 15,  // m7(b5)
+    CHORD_AUGMENTED         = 16,  // aug
+    CHORD_7_SHARP_5         = 17,  // 7#5
+    CHORD_7_FLAT_5          = 18,  // 7(b5)
+    CHORD_DOMINANT_13       = 19,  // 13
+    CHORD_13_SHARP_11       = 20,  // 13(#11)
+    CHORD_7_PLUS_5          = 21,  // 7+5
+    CHORD_7_SHARP_9         = 22,  // 7+9
+    CHORD_7_FLAT_9          = 23,  // 7(b9)
+    CHORD_7_SHARP_11        = 24,  // 7(#11)
+    CHORD_POWER             = 25,  // 5
+    CHORD_ADD_9             = 26,  // (9)
+    CHORD_ADD_2             = 27,  // add2
+    CHORD_ADD_11            = 28,  // add11
+    CHORD_ADD_4             = 29,  // add4
+    CHORD_SUS_2             = 30,  // sus2
+    CHORD_SUS_4             = 31,  // sus4
+    CHORD_SUS_7             = 32,  // sus7
+    CHORD_SUS_9             = 33,  // sus9
+    CHORD_MINOR_13          = 34,  // m13
+    CHORD_MAJOR_13          = 35,  // M13
+    CHORD_SUS               = 36,  // sus
+    CHORD_MINOR_9           = 37,  // m9
+    CHORD_MAJOR_7_SHARP_5   = 38,  // +M7
+    CHORD_MINOR_7_11        = 39,  // m7(11)
+    CHORD_ADD_FLAT_9        = 40,  // (b9)
+    CHORD_ADD_FLAT_13       = 41,  // (b13)
+    CHORD_TYPE_COUNT        = 42
+};
+
 enum HarmonicFunc : uint8_t {
     FUNC_TONIC       = 0,
     FUNC_SUBDOMINANT = 1,
@@ -6,6 +6,7 @@
 
 #include <driver/i2s.h>
 #include <esp_heap_caps.h>
+#include <esp_timer.h>
 
 #include <noftypes.h>
 
@@ -35,6 +36,16 @@ extern void *mem_alloc(int size, bool prefer_fast_memory)
 	}
 }
 
+/* ROM mapping: ROMs are always read from the filesystem here */
+const void *osd_maprom(const char *filename, int *size)
+{
+	return NULL;
+}
+
+void osd_unmaprom(const void *image, int size)
+{
+}
+
 /* audio */
 #define DEFAULT_SAMPLERATE 22050
 
@@ -231,7 +242,6 @@ static void free_write(int num_dirties, rect_t *dirty_rects)
 static void custom_blit(bitmap_t *bmp, int num_dirties, rect_t *dirty_rects)
 {
 	xQueueSend(vidQueue, &bmp, 0);
-	do_audio_frame();
 }
 
 viddriver_t sdlDriver =
@@ -261,6 +271,20 @@ void osd_getsoundinfo(sndinfo_t *info)
 	info->bps = 16;
 }
 
+/* called for every emulated frame, drawn or not */
+void osd_audioframe(void)
+{
+#if defined(HW_AUDIO)
+	if (audio_callback)
+		do_audio_frame();
+#endif /* defined(HW_AUDIO) */
+}
+
+uint32 osd_getmicros(void)
+{
+	return (uint32)esp_timer_get_time();
+}
+
 /* input */
 extern void controller_init();
 extern uint32_t controller_read_input();
@@ -34,6 +34,13 @@
 #define NES6502_JUMPTABLE
 #endif /* __GNUC__ */
 
+#ifdef NES6502_STATS
+static uint32 total_instructions = 0;
+#define COUNT_INSTRUCTION() total_instructions++
+#else /* !NES6502_STATS */
+#define COUNT_INSTRUCTION()
+#endif /* !NES6502_STATS */
+
 #define ADD_CYCLES(x)          \
    {                           \
       remaining_cycles -= (x); \
@@ -1187,28 +1194,19 @@ INLINE void bank_writebyte(register uint32 address, register uint8 value)
 /* read a byte of 6502 memory */
 static uint8 mem_readbyte(uint32 address)
 {
-   nes6502_memread *mr;
+   nes6502_readfunc read_func;
 
-   /* TODO: following 2 cases are N2A03-specific */
+   /* TODO: following case is N2A03-specific */
    if (address < 0x800)
    {
       /* RAM */
       return ram[address];
    }
-   else if (address >= 0x8000)
-   {
-      /* always paged memory */
-      return bank_readbyte(address);
-   }
+
    /* check memory range handlers */
-   else
-   {
-      for (mr = cpu.read_handler; mr->min_range != 0xFFFFFFFF; mr++)
-      {
-         if (address >= mr->min_range && address <= mr->max_range)
-            return mr->read_func(address);
-      }
-   }
+   read_func = cpu.read_page[address >> NES6502_PAGESHIFT];
+   if (NULL != read_func)
+      return read_func(address);
 
    /* return paged memory */
    return bank_readbyte(address);
@@ -1217,7 +1215,7 @@ static uint8 mem_readbyte(uint32 address)
 /* write a byte of data to 6502 memory */
 static void mem_writebyte(uint32 address, uint8 value)
 {
-   nes6502_memwrite *mw;
+   nes6502_writefunc write_func;
 
    /* RAM */
    if (address < 0x800)
@@ -1225,16 +1223,45 @@ static void mem_writebyte(uint32 address, uint8 value)
       ram[address] = value;
       return;
    }
+
    /* check memory range handlers */
-   else
+   write_func = cpu.write_page[address >> NES6502_PAGESHIFT];
+   if (NULL != write_func)
+   {
+      write_func(address, value);
+      return;
+   }
+
+   /* write to paged memory */
+   bank_writebyte(address, value);
+}
+
+/* walk the read handler list for an address */
+uint8 nes6502_scanread(uint32 address)
+{
+   nes6502_memread *mr;
+
+   for (mr = cpu.read_handler; mr->min_range != 0xFFFFFFFF; mr++)
    {
-      for (mw = cpu.write_handler; mw->min_range != 0xFFFFFFFF; mw++)
+      if (address >= mr->min_range && address <= mr->max_range)
+         return mr->read_func(address);
+   }
+
+   /* return paged memory */
+   return bank_readbyte(address);
+}
+
+/* walk the write handler list for an address */
+void nes6502_scanwrite(uint32 address, uint8 value)
+{
+   nes6502_memwrite *mw;
+
+   for (mw = cpu.write_handler; mw->min_range != 0xFFFFFFFF; mw++)
+   {
+      if (address >= mw->min_range && address <= mw->max_range)
       {
-         if (address >= mw->min_range && address <= mw->max_range)
-         {
-            mw->write_func(address, value);
-            return;
-         }
+         mw->write_func(address, value);
+         return;
       }
    }
 
@@ -1248,6 +1275,7 @@ void nes6502_setcontext(nes6502_context *context)
    int loop;
 
    ASSERT(context);
+   ASSERT(context->read_page && context->write_page);
 
    cpu = *context;
 
@@ -1296,6 +1324,18 @@ uint32 nes6502_getcycles(bool reset_flag)
    return cycles;
 }
 
+#ifdef NES6502_STATS
+uint32 nes6502_getinstructions(bool reset_flag)
+{
+   uint32 count = total_instructions;
+
+   if (reset_flag)
+      total_instructions = 0;
+
+   return count;
+}
+#endif /* NES6502_STATS */
+
 #define GET_GLOBAL_REGS()       \
    {                            \
       PC = cpu.pc_reg;          \
@@ -1327,6 +1367,7 @@ uint32 nes6502_getcycles(bool reset_flag)
    if (remaining_cycles <= 0)                                            \
       goto end_execute;                                                  \
    nofrendo_log_printf(nes6502_disasm(PC, COMBINE_FLAGS(), A, X, Y, S)); \
+   COUNT_INSTRUCTION();                                                  \
    goto *opcode_table[bank_readbyte(PC++)];
 
 #else /* !NES6520_DISASM */
@@ -1334,6 +1375,7 @@ uint32 nes6502_getcycles(bool reset_flag)
 #define OPCODE_END            \
    if (remaining_cycles <= 0) \
       goto end_execute;       \
+   COUNT_INSTRUCTION();       \
    goto *opcode_table[bank_readbyte(PC++)];
 
 #endif /* !NES6502_DISASM */
@@ -1438,6 +1480,7 @@ int nes6502_execute(int timeslice_cycles)
 #endif /* NES6502_DISASM */
 
       /* Fetch and execute instruction */
+      COUNT_INSTRUCTION();
       switch (bank_readbyte(PC++))
       {
 #endif /* !NES6502_JUMPTABLE */
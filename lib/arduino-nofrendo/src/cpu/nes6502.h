@@ -34,11 +34,20 @@
 /* Define this to enable decimal mode in ADC / SBC (not needed in NES) */
 /*#define  NES6502_DECIMAL*/
 
+/* Define this to count executed instructions (nes6502_getinstructions) */
+/*#define  NES6502_STATS*/
+
 #define NES6502_NUMBANKS 16
 #define NES6502_BANKSHIFT 12
 #define NES6502_BANKSIZE (0x10000 / NES6502_NUMBANKS)
 #define NES6502_BANKMASK (NES6502_BANKSIZE - 1)
 
+/* memory handlers are dispatched on 256-byte pages */
+#define NES6502_NUMPAGES 256
+#define NES6502_PAGESHIFT 8
+#define NES6502_PAGESIZE (0x10000 / NES6502_NUMPAGES)
+#define NES6502_PAGEMASK (NES6502_PAGESIZE - 1)
+
 /* P (flag) register bitmasks */
 #define N_FLAG 0x80
 #define V_FLAG 0x40
@@ -64,16 +73,19 @@
 /* Stack is located on 6502 page 1 */
 #define STACK_OFFSET 0x0100
 
+typedef uint8 (*nes6502_readfunc)(uint32 address);
+typedef void (*nes6502_writefunc)(uint32 address, uint8 value);
+
 typedef struct
 {
    uint32 min_range, max_range;
-   uint8 (*read_func)(uint32 address);
+   nes6502_readfunc read_func;
 } nes6502_memread;
 
 typedef struct
 {
    uint32 min_range, max_range;
-   void (*write_func)(uint32 address, uint8 value);
+   nes6502_writefunc write_func;
 } nes6502_memwrite;
 
 typedef struct
@@ -83,6 +95,12 @@ typedef struct
    nes6502_memread *read_handler;
    nes6502_memwrite *write_handler;
 
+   /* per-page handler tables (NES6502_NUMPAGES entries each), NULL
+   ** entries go straight to paged memory
+   */
+   nes6502_readfunc *read_page;
+   nes6502_writefunc *write_page;
+
    uint32 pc_reg;
    uint8 a_reg, p_reg;
    uint8 x_reg, y_reg;
@@ -107,9 +125,16 @@ extern "C"
    extern void nes6502_irq(void);
    extern uint8 nes6502_getbyte(uint32 address);
    extern uint32 nes6502_getcycles(bool reset_flag);
+#ifdef NES6502_STATS
+   extern uint32 nes6502_getinstructions(bool reset_flag);
+#endif /* NES6502_STATS */
    extern void nes6502_burn(int cycles);
    extern void nes6502_release(void);
 
+   /* Handler list walkers, for pages shared by several handlers */
+   extern uint8 nes6502_scanread(uint32 address);
+   extern void nes6502_scanwrite(uint32 address, uint8 value);
+
    /* Context get/set */
    extern void nes6502_setcontext(nes6502_context *cpu);
    extern void nes6502_getcontext(nes6502_context *cpu);
@@ -104,6 +104,11 @@ static void func_event_state_load(int code)
       state_load();
 }
 
+static void func_event_state_rewind(int code)
+{
+   state_rewindhold(INP_STATE_MAKE == code);
+}
+
 static void func_event_state_slot_0(int code)
 {
    if (INP_STATE_MAKE == code)
@@ -200,6 +205,12 @@ static void func_event_gui_toggle_fps(int code)
       gui_togglefps();
 }
 
+static void func_event_gui_toggle_pace(int code)
+{
+   if (INP_STATE_MAKE == code)
+      gui_togglepace();
+}
+
 static void func_event_gui_display_info(int code)
 {
    if (INP_STATE_MAKE == code)
@@ -520,6 +531,10 @@ static event_t nes_events[] =
         NULL,
         NULL, /* 70 */
         NULL,
+        /* rewind */
+        func_event_state_rewind,
+        /* GUI */
+        func_event_gui_toggle_pace,
         /* last */
         NULL};
 
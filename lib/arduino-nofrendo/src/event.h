@@ -112,6 +112,10 @@ enum
    event_osd_7,
    event_osd_8,
    event_osd_9,
+   /* rewind, held */
+   event_state_rewind,
+   /* frame pacing overlay */
+   event_gui_toggle_pace,
    /* last */
    event_last
 };
@@ -165,6 +165,7 @@ static bool option_showgui = false;
 static int option_wavetype = GUI_WAVENONE;
 static bool option_showpattern = false;
 static bool option_showoam = false;
+static bool option_showpace = false;
 static int pattern_col = 0;
 
 /* timimg variables */
@@ -392,6 +393,38 @@ static void gui_updatefps(void)
    gui_textout(fpsbuf, gui_surface->width - 1 - 90, 1, &small, GUI_GREEN);
 }
 
+/* Frame pacing overlay, refreshed about once a second */
+static void gui_updatepace(void)
+{
+   static char pacebuf[3][40];
+   static int refresh = 0;
+   nespace_t stats;
+   int i;
+
+   if (0 == refresh--)
+   {
+      refresh = gui_refresh;
+      nes_getpace(&stats);
+
+      sprintf(pacebuf[0], "%d/%d fps skip %d", stats.presented_fps,
+              stats.emulated_fps, stats.frameskip);
+      sprintf(pacebuf[1], "cpu %d/%d vid %d snd %d us",
+              (int)stats.stage_us[NES_PACE_EMULATE], (int)stats.stage_us[NES_PACE_SKIP],
+              (int)stats.stage_us[NES_PACE_VIDEO], (int)stats.stage_us[NES_PACE_AUDIO]);
+      sprintf(pacebuf[2], "%u skipped %u underruns",
+              (unsigned)stats.skipped_frames, (unsigned)stats.audio_underruns);
+   }
+
+   for (i = 0; i < 3; i++)
+      gui_textbar(pacebuf[i], 2, 2 + i * 10, &small, GUI_GREEN, GUI_DKGRAY, BUTTON_UP);
+}
+
+/* Turn frame pacing overlay on/off */
+void gui_togglepace(void)
+{
+   option_showpace ^= true;
+}
+
 /* Turn FPS on/off */
 void gui_togglefps(void)
 {
@@ -572,6 +605,9 @@ void gui_frame(bool draw)
    if (option_showoam)
       gui_updateoam();
 
+   if (option_showpace)
+      gui_updatepace();
+
    if (msg.ttl)
       gui_updatemsg();
 
@@ -79,6 +79,7 @@ extern void gui_togglegui(void);
 extern void gui_togglewave(void);
 extern void gui_togglepattern(void);
 extern void gui_toggleoam(void);
+extern void gui_togglepace(void);
 
 extern void gui_decpatterncol(void);
 extern void gui_incpatterncol(void);
@@ -37,6 +37,7 @@
 #include "nes_ppu.h"
 #include "nes_rom.h"
 #include "nes_mmc.h"
+#include "nesstate.h"
 #include "../vid_drv.h"
 #include "../nofrendo.h"
 
@@ -52,6 +53,21 @@
 
 static nes_t nes;
 
+/* run-ahead: frames emulated past the one shown, to hide input lag */
+static int runahead_frames = 0;
+static uint8 *runahead_state = NULL;
+static int runahead_size = 0;
+
+/* frame pacing */
+#define PACE_MAX_FRAMESKIP 3
+#define PACE_FRAME_US (1000000 / NES_REFRESH_RATE)
+
+static nespace_t pace;
+static uint32 pace_window;                    /* start of this second */
+static uint32 pace_emulated, pace_presented;  /* frames so far this second */
+static int pace_skipped;                      /* skipped since the last drawn frame */
+static uint32 pace_blocked;                   /* OSD waits on the sound clock, this frame */
+
 /* find out if a file is ours */
 int nes_isourfile(const char *filename)
 {
@@ -133,6 +149,57 @@ static nes6502_memwrite default_writehandler[] =
         {0x4014, 0x4017, ppu_writehigh},
         LAST_MEMORY_HANDLER};
 
+/* flatten the handler lists into per-page tables, so the CPU does a
+** single lookup per access.  a page is given straight to a handler only
+** if that handler is the first to claim it and claims all of it; pages
+** shared by several handlers (the $4000 I/O page, mostly) fall back to
+** walking the list.
+*/
+static void build_page_handlers(nes_t *machine)
+{
+   nes6502_memread *mr;
+   nes6502_memwrite *mw;
+   uint32 page, first, last;
+
+   memset(machine->readpage, 0, sizeof(machine->readpage));
+   memset(machine->writepage, 0, sizeof(machine->writepage));
+
+   /* RAM is checked by the CPU before it looks at the page tables */
+   for (page = NES_RAMSIZE >> NES6502_PAGESHIFT; page < NES6502_NUMPAGES; page++)
+   {
+      first = page << NES6502_PAGESHIFT;
+      last = first + NES6502_PAGEMASK;
+
+      /* $8000-$FFFF reads are always paged memory */
+      if (first < 0x8000)
+      {
+         for (mr = machine->readhandler; NULL != mr->read_func; mr++)
+         {
+            if (mr->min_range <= last && mr->max_range >= first)
+            {
+               if (mr->min_range <= first && mr->max_range >= last)
+                  machine->readpage[page] = mr->read_func;
+               else
+                  machine->readpage[page] = nes6502_scanread;
+               break;
+            }
+         }
+      }
+
+      for (mw = machine->writehandler; NULL != mw->write_func; mw++)
+      {
+         if (mw->min_range <= last && mw->max_range >= first)
+         {
+            if (mw->min_range <= first && mw->max_range >= last)
+               machine->writepage[page] = mw->write_func;
+            else
+               machine->writepage[page] = nes6502_scanwrite;
+            break;
+         }
+      }
+   }
+}
+
 /* this big nasty boy sets up the address handlers that the CPU uses */
 static void build_address_handlers(nes_t *machine)
 {
@@ -245,6 +312,8 @@ static void build_address_handlers(nes_t *machine)
    machine->writehandler[num_handlers].write_func = NULL;
    num_handlers++;
    ASSERT(num_handlers <= MAX_MEM_HANDLERS);
+
+   build_page_handlers(machine);
 }
 
 /* raise an IRQ */
@@ -339,6 +408,47 @@ static void nes_renderframe(bool draw_flag)
    nes.scanline = 0;
 }
 
+/* Emulate a frame, then keep going to show the frame runahead_frames
+** further on (where the current input will have taken effect), and
+** come back.  Sound is handed to the OSD after we're back, so only
+** the real frame is heard.
+*/
+static void nes_runahead(void)
+{
+   int frame;
+
+   if (runahead_size != state_memsize())
+   {
+      if (runahead_state)
+         NOFRENDO_FREE(runahead_state);
+
+      runahead_size = state_memsize();
+      runahead_state = NOFRENDO_MALLOC(runahead_size);
+      if (NULL == runahead_state)
+      {
+         runahead_size = 0;
+         runahead_frames = 0;
+         nes_renderframe(true);
+         return;
+      }
+   }
+
+   nes_renderframe(false);
+   state_memsave(runahead_state);
+
+   for (frame = 1; frame < runahead_frames; frame++)
+      nes_renderframe(false);
+   nes_renderframe(true);
+
+   state_memload(runahead_state);
+}
+
+/* Show frames ahead of emulation (0 turns it off) */
+void nes_setrunahead(int frames)
+{
+   runahead_frames = frames;
+}
+
 static void system_video(bool draw)
 {
    /* TODO: hack */
@@ -364,6 +474,117 @@ static void system_video(bool draw)
    osd_getinput();
 }
 
+/* fold one frame's time for a stage into its running average */
+static void pace_average(int stage, uint32 us)
+{
+   int32 diff = (int32)us - (int32)pace.stage_us[stage];
+
+   pace.stage_us[stage] += diff / 8;
+}
+
+/* pick the least frameskip at which a drawn frame plus the frames
+** skipped after it fit in their time, with some headroom.  it only
+** comes back down once the lower level fits comfortably, so it
+** doesn't flap between two levels.
+*/
+static void pace_update(void)
+{
+   uint32 drawn, skipped;
+   int skip;
+
+   drawn = pace.stage_us[NES_PACE_EMULATE] + pace.stage_us[NES_PACE_VIDEO]
+           + pace.stage_us[NES_PACE_AUDIO];
+   skipped = pace.stage_us[NES_PACE_SKIP] + pace.stage_us[NES_PACE_AUDIO];
+
+   for (skip = 0; skip < PACE_MAX_FRAMESKIP; skip++)
+   {
+      if (drawn + skip * skipped <= (skip + 1) * PACE_FRAME_US * 9 / 10)
+         break;
+   }
+
+   if (skip < pace.frameskip)
+   {
+      if (drawn + skip * skipped > (skip + 1) * PACE_FRAME_US * 3 / 4)
+         skip = pace.frameskip;
+   }
+
+   pace.frameskip = skip;
+}
+
+/* emulate, show and play a frame, timing each stage */
+static void nes_paceframe(bool draw)
+{
+   uint32 start, emulated, shown, played;
+
+   start = osd_getmicros();
+
+   if (draw && runahead_frames)
+      nes_runahead();
+   else
+      nes_renderframe(draw);
+   state_rewindframe();
+   emulated = osd_getmicros();
+
+   system_video(draw);
+   shown = osd_getmicros();
+
+   pace_blocked = 0;
+   osd_audioframe();
+   played = osd_getmicros();
+
+   /* waiting for the sound hardware is the pace we keep, not a cost */
+   if (pace_blocked > played - shown)
+      pace_blocked = played - shown;
+
+   pace_average(draw ? NES_PACE_EMULATE : NES_PACE_SKIP, emulated - start);
+   if (draw)
+      pace_average(NES_PACE_VIDEO, shown - emulated);
+   pace_average(NES_PACE_AUDIO, played - shown - pace_blocked);
+
+   pace_emulated++;
+   pace.emulated_frames++;
+   if (draw)
+   {
+      pace_presented++;
+      pace.presented_frames++;
+   }
+   else
+   {
+      pace.skipped_frames++;
+   }
+
+   if (played - pace_window >= 1000000)
+   {
+      pace.emulated_fps = pace_emulated;
+      pace.presented_fps = pace_presented;
+      pace_emulated = pace_presented = 0;
+      pace_window = played;
+
+      if (nes.autoframeskip)
+         pace_update();
+      else
+         pace.frameskip = 0;
+   }
+}
+
+/* Frame pacing stats */
+void nes_getpace(nespace_t *stats)
+{
+   *stats = pace;
+}
+
+/* The OSD lost some sound */
+void nes_paceunderrun(void)
+{
+   pace.audio_underruns++;
+}
+
+/* The OSD spent us of osd_audioframe waiting for the sound hardware */
+void nes_paceblocked(uint32 us)
+{
+   pace_blocked += us;
+}
+
 /* main emulation loop */
 void nes_emulate(void)
 {
@@ -376,6 +597,11 @@ void nes_emulate(void)
    nes.scanline_cycles = 0;
    nes.fiq_cycles = (int)NES_FIQ_PERIOD;
 
+   memset(&pace, 0, sizeof(pace));
+   pace_window = osd_getmicros();
+   pace_emulated = pace_presented = 0;
+   pace_skipped = 0;
+
    while (false == nes.poweroff)
    {
       if (nofrendo_ticks != last_ticks)
@@ -385,25 +611,39 @@ void nes_emulate(void)
          frames_to_render += tick_diff;
          gui_tick(tick_diff);
          last_ticks = nofrendo_ticks;
+
+         /* too far behind to catch up, let it go */
+         if (frames_to_render > NES_SKIP_LIMIT)
+            frames_to_render = NES_SKIP_LIMIT;
       }
 
       if (true == nes.pause)
       {
          /* TODO: dim the screen, and pause/silence the apu */
-         system_video(true);
-         frames_to_render = 0;
+         /* keep the screen and sound going once per tick, not flat out */
+         if (frames_to_render)
+         {
+            system_video(true);
+            osd_audioframe();
+            frames_to_render = 0;
+         }
       }
-      else if (frames_to_render > 1)
+      else if (pace_skipped < NES_SKIP_LIMIT
+               && (frames_to_render > 1
+                   || (1 == frames_to_render && pace_skipped < pace.frameskip)))
       {
          frames_to_render--;
-         nes_renderframe(false);
-         system_video(false);
+         pace_skipped++;
+         nes_paceframe(false);
       }
-      else if ((1 == frames_to_render && true == nes.autoframeskip) || false == nes.autoframeskip)
+      else if (frames_to_render || false == nes.autoframeskip)
       {
+         /* if we've skipped as far as we're willing, draw anyway
+         ** and let the game slow down
+         */
          frames_to_render = 0;
-         nes_renderframe(true);
-         system_video(true);
+         pace_skipped = 0;
+         nes_paceframe(true);
       }
    }
 }
@@ -441,6 +681,12 @@ void nes_destroy(nes_t **machine)
 {
    if (*machine)
    {
+      /* captures are no good without this cart */
+      state_rewindfree();
+      if (runahead_state)
+         NOFRENDO_FREE(runahead_state);
+      runahead_size = 0;
+
       rom_free(&(*machine)->rominfo);
       mmc_destroy(&(*machine)->mmc);
       ppu_destroy(&(*machine)->ppu);
@@ -553,6 +799,8 @@ nes_t *nes_create(void)
 
    machine->cpu->read_handler = machine->readhandler;
    machine->cpu->write_handler = machine->writehandler;
+   machine->cpu->read_page = machine->readpage;
+   machine->cpu->write_page = machine->writepage;
 
    /* apu */
    osd_getsoundinfo(&osd_sound);
@@ -61,6 +61,8 @@ typedef struct nes_s
    nes6502_context *cpu;
    nes6502_memread readhandler[MAX_MEM_HANDLERS];
    nes6502_memwrite writehandler[MAX_MEM_HANDLERS];
+   nes6502_readfunc readpage[NES6502_NUMPAGES];
+   nes6502_writefunc writepage[NES6502_NUMPAGES];
 
    ppu_t *ppu;
    apu_t *apu;
@@ -88,6 +90,25 @@ typedef struct nes_s
 
 } nes_t;
 
+/* frame pacing stages, timed every frame */
+enum
+{
+   NES_PACE_EMULATE, /* running a frame that gets drawn */
+   NES_PACE_SKIP,    /* running a frame that doesn't */
+   NES_PACE_VIDEO,   /* GUI and blit */
+   NES_PACE_AUDIO,   /* handing the frame's sound to the OSD, less waits */
+   NES_PACE_STAGES
+};
+
+typedef struct nespace_s
+{
+   uint32 stage_us[NES_PACE_STAGES]; /* running average per frame */
+   int frameskip;                     /* frames skipped for each one drawn */
+   int emulated_fps, presented_fps;   /* over the last second */
+   uint32 emulated_frames, presented_frames, skipped_frames;
+   uint32 audio_underruns;
+} nespace_t;
+
 extern int nes_isourfile(const char *filename);
 
 /* temp hack */
@@ -105,6 +126,10 @@ extern void nes_setfiq(uint8 state);
 extern void nes_nmi(void);
 extern void nes_irq(void);
 extern void nes_emulate(void);
+extern void nes_setrunahead(int frames);
+extern void nes_getpace(nespace_t *stats);
+extern void nes_paceunderrun(void);
+extern void nes_paceblocked(uint32 us);
 
 extern void nes_reset(int reset_type);
 
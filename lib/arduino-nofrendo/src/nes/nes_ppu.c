@@ -480,7 +480,11 @@ void ppu_write(uint32 address, uint8 value)
       break;
 
    case PPU_VDATA:
-      if (ppu.vaddr < 0x3F00)
+      if (ppu.vaddr < 0x2000 && false == ppu.vram_present)
+      {
+         /* CHR-ROM can't be written, and may well be mapped from flash */
+      }
+      else if (ppu.vaddr < 0x3F00)
       {
          /* VRAM only accessible during scanlines 241-260 */
          if ((ppu.bg_on || ppu.obj_on) && !ppu.vram_accessible)
@@ -78,6 +78,49 @@ typedef struct inesheader_s
 #define SRAM_BANK_LENGTH 0x0400
 #define VRAM_BANK_LENGTH 0x2000
 
+/* Where the image is coming from: a read-only mapping of the whole
+** file that the OSD handed us, or failing that, a plain old file
+*/
+typedef struct romsrc_s
+{
+   FILE *fp;
+   const uint8 *image;
+   int size, pos;
+   bool inuse; /* banks point into the mapping */
+} romsrc_t;
+
+static int rom_read(romsrc_t *src, void *buf, int length)
+{
+   if (NULL != src->fp)
+      return _fread(buf, 1, length, src->fp);
+
+   if (length > src->size - src->pos)
+      length = src->size - src->pos;
+   memcpy(buf, src->image + src->pos, length);
+   src->pos += length;
+   return length;
+}
+
+/* Hand out the next length bytes in place, if we can */
+static const uint8 *rom_view(romsrc_t *src, int length)
+{
+   const uint8 *data;
+
+   if (NULL == src->image || length > src->size - src->pos)
+      return NULL;
+
+   data = src->image + src->pos;
+   src->pos += length;
+   src->inuse = true;
+   return data;
+}
+
+static bool rom_inimage(rominfo_t *rominfo, const uint8 *data)
+{
+   return (NULL != rominfo->image && data >= rominfo->image
+           && data < rominfo->image + rominfo->image_size);
+}
+
 /* Save battery-backed RAM */
 static void rom_savesram(rominfo_t *rominfo)
 {
@@ -141,47 +184,62 @@ static int rom_allocsram(rominfo_t *rominfo)
 }
 
 /* If there's a trainer, load it in at $7000 */
-static void rom_loadtrainer(FILE *fp, rominfo_t *rominfo)
+static void rom_loadtrainer(romsrc_t *src, rominfo_t *rominfo)
 {
-   ASSERT(fp);
+   ASSERT(src);
    ASSERT(rominfo);
 
    if (rominfo->flags & ROM_FLAG_TRAINER)
    {
-      fread(rominfo->sram + TRAINER_OFFSET, TRAINER_LENGTH, 1, fp);
+      rom_read(src, rominfo->sram + TRAINER_OFFSET, TRAINER_LENGTH);
       nofrendo_log_printf("Read in trainer at $7000\n");
    }
 }
 
-static int rom_loadrom(FILE *fp, rominfo_t *rominfo)
+/* Point at the banks in place if the image is mapped, otherwise
+** allocate space and read them in
+*/
+static uint8 *rom_getbanks(romsrc_t *src, int length, const char *what)
 {
-   ASSERT(fp);
+   uint8 *banks;
+
+   banks = (uint8 *)rom_view(src, length);
+   if (NULL != banks)
+      return banks;
+
+   banks = mem_alloc(length, false);
+   if (NULL == banks)
+   {
+      gui_sendmsg(GUI_RED, "Could not allocate space for %s", what);
+      return NULL;
+   }
+
+   if (rom_read(src, banks, length) != length)
+      nofrendo_log_printf("%s image is truncated\n", what);
+
+   return banks;
+}
+
+static int rom_loadrom(romsrc_t *src, rominfo_t *rominfo)
+{
+   ASSERT(src);
    ASSERT(rominfo);
 
-   /* Allocate ROM space, and load it up! */
-   // rominfo->rom = malloc(rominfo->rom_banks * ROM_BANK_LENGTH);
-   rominfo->rom = mem_alloc(rominfo->rom_banks * ROM_BANK_LENGTH, false);
+   /* Map or load the ROM */
+   rominfo->rom = rom_getbanks(src, rominfo->rom_banks * ROM_BANK_LENGTH, "ROM");
    if (NULL == rominfo->rom)
-   {
-      gui_sendmsg(GUI_RED, "Could not allocate space for ROM image");
       return -1;
-   }
-   _fread(rominfo->rom, ROM_BANK_LENGTH, rominfo->rom_banks, fp);
 
-   /* If there's VROM, allocate and stuff it in */
+   /* If there's VROM, map or load that as well */
    if (rominfo->vrom_banks)
    {
-      // rominfo->vrom = malloc((rominfo->vrom_banks * VROM_BANK_LENGTH));
-      rominfo->vrom = mem_alloc(rominfo->vrom_banks * VROM_BANK_LENGTH, false);
+      rominfo->vrom = rom_getbanks(src, rominfo->vrom_banks * VROM_BANK_LENGTH, "VROM");
       if (NULL == rominfo->vrom)
-      {
-         gui_sendmsg(GUI_RED, "Could not allocate space for VROM");
          return -1;
-      }
-      _fread(rominfo->vrom, VROM_BANK_LENGTH, rominfo->vrom_banks, fp);
    }
    else
    {
+      /* CHR-RAM is the only part of the cart that has to be writable */
       rominfo->vram = NOFRENDO_MALLOC(VRAM_LENGTH);
       if (NULL == rominfo->vram)
       {
@@ -252,6 +310,37 @@ static FILE *rom_findrom(const char *filename, rominfo_t *rominfo)
    return fp;
 }
 
+/* Find the image, asking the OSD to map it before opening it as a file.
+** Returns 0 if we've got a source to read from.
+*/
+static int rom_open(romsrc_t *src, const char *filename, rominfo_t *rominfo)
+{
+   memset(src, 0, sizeof(romsrc_t));
+
+   if (NULL == filename)
+      return -1;
+
+   osd_fullname(rominfo->filename, filename);
+   src->image = osd_maprom(rominfo->filename, &src->size);
+   if (NULL != src->image)
+      return 0;
+
+   src->fp = rom_findrom(filename, rominfo);
+   return (NULL == src->fp) ? -1 : 0;
+}
+
+/* Close the file, or drop the mapping if nothing was left pointing into it */
+static void rom_close(romsrc_t *src)
+{
+   if (NULL != src->fp)
+      _fclose(src->fp);
+   else if (NULL != src->image && false == src->inuse)
+      osd_unmaprom(src->image, src->size);
+
+   src->fp = NULL;
+   src->image = NULL;
+}
+
 /* Add ROM name to a list with dirty headers */
 static int rom_adddirty(char *filename)
 {
@@ -292,15 +381,15 @@ int rom_checkmagic(const char *filename)
 {
    inesheader_t head;
    rominfo_t rominfo;
-   FILE *fp;
+   romsrc_t src;
 
-   fp = rom_findrom(filename, &rominfo);
-   if (NULL == fp)
+   if (rom_open(&src, filename, &rominfo))
       return -1;
 
-   _fread(&head, 1, sizeof(head), fp);
+   memset(&head, 0, sizeof(head));
+   rom_read(&src, &head, sizeof(head));
 
-   _fclose(fp);
+   rom_close(&src);
 
    if (0 == memcmp(head.ines_magic, ROM_INES_MAGIC, 4))
       /* not an iNES file */
@@ -309,20 +398,19 @@ int rom_checkmagic(const char *filename)
    return -1;
 }
 
-static int rom_getheader(FILE *fp, rominfo_t *rominfo)
+static int rom_getheader(romsrc_t *src, rominfo_t *rominfo)
 {
 #define RESERVED_LENGTH 8
    inesheader_t head;
    uint8 reserved[RESERVED_LENGTH];
    bool header_dirty;
 
-   ASSERT(fp);
+   ASSERT(src);
    ASSERT(rominfo);
 
    /* Read in the header */
-   _fread(&head, sizeof(head), 1, fp);
-
-   if (memcmp(head.ines_magic, ROM_INES_MAGIC, 4))
+   if (rom_read(src, &head, sizeof(head)) != sizeof(head)
+       || memcmp(head.ines_magic, ROM_INES_MAGIC, 4))
    {
       gui_sendmsg(GUI_RED, "%s is not a valid ROM image", rominfo->filename);
       return -1;
@@ -420,8 +508,9 @@ char *rom_getinfo(rominfo_t *rominfo)
 /* Load a ROM image into memory */
 rominfo_t *rom_load(const char *filename)
 {
-   FILE *fp;
+   romsrc_t src;
    rominfo_t *rominfo;
+   bool found;
 
    rominfo = NOFRENDO_MALLOC(sizeof(rominfo_t));
    if (NULL == rominfo)
@@ -429,15 +518,15 @@ rominfo_t *rom_load(const char *filename)
 
    memset(rominfo, 0, sizeof(rominfo_t));
 
-   fp = rom_findrom(filename, rominfo);
+   found = (0 == rom_open(&src, filename, rominfo));
 
-   if (NULL == fp)
+   if (false == found)
       gui_sendmsg(GUI_RED, "%s not found, will use default ROM", filename);
 
    /* Get the header and stick it into rominfo struct */
-   if (NULL == fp)
+   if (false == found)
       intro_get_header(rominfo);
-   else if (rom_getheader(fp, rominfo))
+   else if (rom_getheader(&src, rominfo))
       goto _fail;
 
    /* Make sure we really support the mapper */
@@ -454,20 +543,26 @@ rominfo_t *rom_load(const char *filename)
    if (rom_allocsram(rominfo))
       goto _fail;
 
-   if (NULL != fp)
-      rom_loadtrainer(fp, rominfo);
+   if (found)
+      rom_loadtrainer(&src, rominfo);
 
-   if (NULL == fp)
+   if (false == found)
    {
       if (intro_get_rom(rominfo))
          goto _fail;
    }
-   else if (rom_loadrom(fp, rominfo))
+   else if (rom_loadrom(&src, rominfo))
       goto _fail;
 
+   /* Hang on to the mapping if the banks are being used in place */
+   if (src.inuse)
+   {
+      rominfo->image = src.image;
+      rominfo->image_size = src.size;
+   }
+
    /* Close the file */
-   if (NULL != fp)
-      _fclose(fp);
+   rom_close(&src);
 
    rom_loadsram(rominfo);
 
@@ -479,8 +574,13 @@ rominfo_t *rom_load(const char *filename)
    return rominfo;
 
 _fail:
-   if (NULL != fp)
-      _fclose(fp);
+   /* rom_free takes care of anything that was mapped */
+   if (src.inuse)
+   {
+      rominfo->image = src.image;
+      rominfo->image_size = src.size;
+   }
+   rom_close(&src);
    rom_free(&rominfo);
    return NULL;
 }
@@ -506,10 +606,12 @@ void rom_free(rominfo_t **rominfo)
 
    if ((*rominfo)->sram)
       NOFRENDO_FREE((*rominfo)->sram);
-   if ((*rominfo)->rom)
+   if ((*rominfo)->rom && false == rom_inimage(*rominfo, (*rominfo)->rom))
       NOFRENDO_FREE((*rominfo)->rom);
-   if ((*rominfo)->vrom)
+   if ((*rominfo)->vrom && false == rom_inimage(*rominfo, (*rominfo)->vrom))
       NOFRENDO_FREE((*rominfo)->vrom);
+   if ((*rominfo)->image)
+      osd_unmaprom((*rominfo)->image, (*rominfo)->image_size);
    if ((*rominfo)->vram)
       NOFRENDO_FREE((*rominfo)->vram);
 
@@ -49,6 +49,10 @@ typedef struct rominfo_s
    /* pointers to SRAM and VRAM */
    uint8 *sram, *vram;
 
+   /* read-only mapping of the whole image, if ROM/VROM are used in place */
+   const uint8 *image;
+   int image_size;
+
    /* number of banks */
    int rom_banks, vrom_banks;
    int sram_banks, vram_banks;
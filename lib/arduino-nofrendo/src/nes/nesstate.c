@@ -493,6 +493,438 @@ _error:
    return -1;
 }
 
+/* MEMORY STATES
+** =============
+** a raw copy of the machine, for things that need to go back in time
+** every frame or so.  nothing is converted, so a memory state is only
+** good for the cart (and the session) it was taken from: SNSS is still
+** the way to keep one around.  like SNSS, mapper internals are covered
+** only as far as the mapper's get_state/set_state go.
+*/
+#define STATE_RAMSIZE 0x800
+
+typedef struct memstate_s
+{
+   nes6502_context cpu;
+   ppu_t ppu;
+   apu_t apu;
+   SnssMapperBlock mapper;
+
+   int scanline;
+   float scanline_cycles;
+   bool fiq_occurred;
+   uint8 fiq_state;
+   int fiq_cycles;
+
+   /* nametable mirroring, ppu.page[8-15] are left NULL */
+   uint8 mirror[4];
+
+   uint8 ram[STATE_RAMSIZE];
+   /* followed by SRAM, then VRAM */
+} memstate_t;
+
+static int state_sramsize(nes_t *machine)
+{
+   return machine->rominfo->sram ? machine->rominfo->sram_banks * SRAM_1K : 0;
+}
+
+static int state_vramsize(nes_t *machine)
+{
+   return machine->rominfo->vram ? machine->rominfo->vram_banks * VRAM_8K : 0;
+}
+
+/* Number of bytes state_memsave needs for the current cart */
+int state_memsize(void)
+{
+   nes_t *machine = nes_getcontextptr();
+   ASSERT(machine);
+
+   return sizeof(memstate_t) + state_sramsize(machine) + state_vramsize(machine);
+}
+
+/* Capture the machine into buffer (state_memsize bytes, malloc-aligned) */
+void state_memsave(uint8 *buffer)
+{
+   memstate_t *state = (memstate_t *)buffer;
+   nes_t *machine;
+   uint8 *cartram;
+   int i;
+
+   machine = nes_getcontextptr();
+   ASSERT(machine && buffer);
+
+   /* keep struct padding constant, so rewind deltas stay small */
+   memset(state, 0, sizeof(memstate_t));
+
+   nes6502_getcontext(&state->cpu);
+   ppu_getcontext(&state->ppu);
+
+   /* the nametable pages point into the copy itself, and must not
+   ** depend on where it lives
+   */
+   for (i = 0; i < 4; i++)
+      state->mirror[i] = (state->ppu.page[i + 8] + 0x2000 + (i * 0x400) - state->ppu.nametab) / 0x400;
+   memset(&state->ppu.page[8], 0, 8 * sizeof(uint8 *));
+
+   apu_getcontext(&state->apu);
+   if (machine->mmc->intf->get_state)
+      machine->mmc->intf->get_state(&state->mapper);
+
+   state->scanline = machine->scanline;
+   state->scanline_cycles = machine->scanline_cycles;
+   state->fiq_occurred = machine->fiq_occurred;
+   state->fiq_state = machine->fiq_state;
+   state->fiq_cycles = machine->fiq_cycles;
+
+   memcpy(state->ram, state->cpu.mem_page[0], STATE_RAMSIZE);
+
+   cartram = buffer + sizeof(memstate_t);
+   memcpy(cartram, machine->rominfo->sram, state_sramsize(machine));
+   cartram += state_sramsize(machine);
+   memcpy(cartram, machine->rominfo->vram, state_vramsize(machine));
+}
+
+/* Put the machine back the way state_memsave found it.  The buffer is
+** borrowed for a moment, but left as it was.
+*/
+void state_memload(uint8 *buffer)
+{
+   memstate_t *state = (memstate_t *)buffer;
+   nes_t *machine;
+   uint8 *cartram;
+   int i;
+
+   machine = nes_getcontextptr();
+   ASSERT(machine && buffer);
+
+   /* mapper first: the contexts below have the final say on banking */
+   if (machine->mmc->intf->set_state)
+      machine->mmc->intf->set_state(&state->mapper);
+
+   nes6502_setcontext(&state->cpu);
+   apu_setcontext(&state->apu);
+
+   for (i = 0; i < 4; i++)
+      state->ppu.page[i + 8] = state->ppu.nametab + (state->mirror[i] * 0x400) - (0x2000 + (i * 0x400));
+   ppu_setcontext(&state->ppu);
+   memset(&state->ppu.page[8], 0, 8 * sizeof(uint8 *));
+
+   machine->scanline = state->scanline;
+   machine->scanline_cycles = state->scanline_cycles;
+   machine->fiq_occurred = state->fiq_occurred;
+   machine->fiq_state = state->fiq_state;
+   machine->fiq_cycles = state->fiq_cycles;
+
+   memcpy(state->cpu.mem_page[0], state->ram, STATE_RAMSIZE);
+
+   cartram = buffer + sizeof(memstate_t);
+   memcpy(machine->rominfo->sram, cartram, state_sramsize(machine));
+   cartram += state_sramsize(machine);
+   memcpy(machine->rominfo->vram, cartram, state_vramsize(machine));
+}
+
+/* REWIND
+** ======
+** every <interval> frames the machine is captured and stored as the
+** XOR against the previous capture, run-length coded (mostly zeros, as
+** little changes in a few frames).  the newest capture is also kept
+** whole, and is where stepping back starts.  deltas live in a ring in
+** slow memory; when it fills up, the oldest ones are dropped.
+**
+** delta encoding: pairs of varints (bytes unchanged, bytes changed),
+** each followed by that many XOR bytes.
+*/
+#define REWIND_HEADER 4 /* record length, before and after each record */
+
+static struct
+{
+   int interval, budget;
+   bool held;
+
+   int size;      /* state_memsize the buffers were made for */
+   int frames;    /* frames since the last capture */
+   bool captured; /* is newest valid? */
+   uint8 *newest; /* newest capture, whole */
+   uint8 *work;   /* the next capture */
+   uint8 *delta;  /* encode buffer, worst case size */
+
+   uint8 *ring;
+   int ring_size, head, tail, used, count;
+} history;
+
+static int rewind_deltasize(int size)
+{
+   return size + (size >> 1) + 16;
+}
+
+static uint8 *rewind_putcount(uint8 *out, int count)
+{
+   while (count >= 0x80)
+   {
+      *out++ = (uint8)(count | 0x80);
+      count >>= 7;
+   }
+   *out++ = (uint8)count;
+   return out;
+}
+
+static const uint8 *rewind_getcount(const uint8 *in, int *count)
+{
+   int shift = 0;
+
+   *count = 0;
+   do
+   {
+      *count |= (*in & 0x7F) << shift;
+      shift += 7;
+   } while (*in++ & 0x80);
+
+   return in;
+}
+
+/* encode a ^ b, return encoded length */
+static int rewind_encode(uint8 *out, const uint8 *a, const uint8 *b, int length)
+{
+   uint8 *start = out;
+   int i = 0, run;
+
+   while (i < length)
+   {
+      for (run = i; i < length && a[i] == b[i]; i++)
+         ;
+      out = rewind_putcount(out, i - run);
+
+      /* changed bytes, up to the next two unchanged ones */
+      for (run = i; i < length; i++)
+      {
+         if (a[i] == b[i] && (i + 1 == length || a[i + 1] == b[i + 1]))
+            break;
+      }
+      out = rewind_putcount(out, i - run);
+
+      for (; run < i; run++)
+         *out++ = a[run] ^ b[run];
+   }
+
+   return out - start;
+}
+
+/* XOR an encoded delta into dest */
+static void rewind_decode(uint8 *dest, const uint8 *in, int length)
+{
+   const uint8 *end = in + length;
+   int count;
+
+   while (in < end)
+   {
+      in = rewind_getcount(in, &count);
+      dest += count;
+      in = rewind_getcount(in, &count);
+      while (count--)
+         *dest++ ^= *in++;
+   }
+}
+
+static void rewind_ringwrite(int pos, const void *data, int length)
+{
+   int first = history.ring_size - pos;
+
+   if (first > length)
+      first = length;
+
+   memcpy(history.ring + pos, data, first);
+   memcpy(history.ring, (const uint8 *)data + first, length - first);
+}
+
+static void rewind_ringread(int pos, void *data, int length)
+{
+   int first = history.ring_size - pos;
+
+   if (first > length)
+      first = length;
+
+   memcpy(data, history.ring + pos, first);
+   memcpy((uint8 *)data + first, history.ring, length - first);
+}
+
+static int rewind_ringpos(int pos, int offset)
+{
+   pos += offset;
+   if (pos >= history.ring_size)
+      pos -= history.ring_size;
+   else if (pos < 0)
+      pos += history.ring_size;
+   return pos;
+}
+
+static void rewind_dropoldest(void)
+{
+   int32 length;
+
+   rewind_ringread(history.tail, &length, REWIND_HEADER);
+   history.tail = rewind_ringpos(history.tail, length + 2 * REWIND_HEADER);
+   history.used -= length + 2 * REWIND_HEADER;
+   history.count--;
+}
+
+static void rewind_push(const uint8 *data, int32 length)
+{
+   int need = length + 2 * REWIND_HEADER;
+
+   /* a delta that doesn't fit at all breaks the chain */
+   if (need > history.ring_size)
+   {
+      history.head = history.tail = history.used = history.count = 0;
+      return;
+   }
+
+   while (history.ring_size - history.used < need)
+      rewind_dropoldest();
+
+   rewind_ringwrite(history.head, &length, REWIND_HEADER);
+   rewind_ringwrite(rewind_ringpos(history.head, REWIND_HEADER), data, length);
+   rewind_ringwrite(rewind_ringpos(history.head, REWIND_HEADER + length), &length, REWIND_HEADER);
+   history.head = rewind_ringpos(history.head, need);
+   history.used += need;
+   history.count++;
+}
+
+/* pop the newest delta into history.delta, return its length */
+static int32 rewind_pop(void)
+{
+   int32 length;
+
+   rewind_ringread(rewind_ringpos(history.head, -REWIND_HEADER), &length, REWIND_HEADER);
+   history.head = rewind_ringpos(history.head, -(length + 2 * REWIND_HEADER));
+   rewind_ringread(rewind_ringpos(history.head, REWIND_HEADER), history.delta, length);
+   history.used -= length + 2 * REWIND_HEADER;
+   history.count--;
+
+   return length;
+}
+
+/* Drop all rewind history, and the buffers holding it */
+void state_rewindfree(void)
+{
+   if (history.newest)
+      NOFRENDO_FREE(history.newest);
+   if (history.work)
+      NOFRENDO_FREE(history.work);
+   if (history.delta)
+      NOFRENDO_FREE(history.delta);
+   if (history.ring)
+      NOFRENDO_FREE(history.ring);
+
+   history.size = 0;
+   history.captured = false;
+   history.ring_size = history.head = history.tail = history.used = history.count = 0;
+}
+
+static int rewind_alloc(void)
+{
+   int size = state_memsize();
+
+   history.ring_size = history.budget - 2 * size - rewind_deltasize(size);
+   if (history.ring_size < rewind_deltasize(size))
+   {
+      nofrendo_log_printf("rewind: budget of %d bytes is too small\n", history.budget);
+      history.interval = 0;
+      return -1;
+   }
+
+   history.newest = mem_alloc(size, false);
+   history.work = mem_alloc(size, false);
+   history.delta = mem_alloc(rewind_deltasize(size), false);
+   history.ring = mem_alloc(history.ring_size, false);
+   if (NULL == history.newest || NULL == history.work || NULL == history.delta || NULL == history.ring)
+   {
+      nofrendo_log_printf("rewind: could not allocate %d bytes\n", history.budget);
+      state_rewindfree();
+      history.interval = 0;
+      return -1;
+   }
+
+   history.size = size;
+   history.frames = 0;
+   return 0;
+}
+
+/* Capture a state every interval frames, in no more than budget bytes of
+** (preferably slow) memory, history and working buffers included.  An
+** interval of 0 turns rewinding off.
+*/
+void state_setrewind(int interval, int budget)
+{
+   state_rewindfree();
+
+   history.interval = interval;
+   history.budget = budget;
+   history.held = false;
+}
+
+/* Step back to the newest capture, dropping it from the history so that
+** the next step goes further back.  Returns -1 if nothing was captured.
+*/
+int state_rewind(void)
+{
+   if (false == history.captured)
+      return -1;
+
+   state_memload(history.newest);
+   history.frames = 0;
+
+   /* at the oldest capture, stay there */
+   if (0 == history.count)
+      return 0;
+
+   /* undo the newest delta, in place */
+   rewind_decode(history.newest, history.delta, rewind_pop());
+   return 0;
+}
+
+/* Rewind a step every frame for as long as held is true */
+void state_rewindhold(bool held)
+{
+   history.held = held;
+}
+
+/* Called once per emulated frame */
+void state_rewindframe(void)
+{
+   uint8 *temp;
+
+   if (0 == history.interval)
+      return;
+
+   if (history.held)
+   {
+      state_rewind();
+      return;
+   }
+
+   if (++history.frames < history.interval)
+      return;
+   history.frames = 0;
+
+   /* (re)size for the cart we've got */
+   if (history.size != state_memsize())
+   {
+      state_rewindfree();
+      if (rewind_alloc())
+         return;
+   }
+
+   state_memsave(history.work);
+
+   if (history.captured)
+      rewind_push(history.delta, rewind_encode(history.delta, history.work, history.newest, history.size));
+
+   temp = history.newest;
+   history.newest = history.work;
+   history.work = temp;
+   history.captured = true;
+}
+
 /*
 ** $Log: nesstate.c,v $
 ** Revision 1.2  2001/04/27 14:37:11  neil
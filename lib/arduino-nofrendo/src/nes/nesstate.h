@@ -32,6 +32,17 @@ extern void state_setslot(int slot);
 extern int state_load();
 extern int state_save();
 
+/* in-memory states, for rewind and the like */
+extern int state_memsize(void);
+extern void state_memsave(uint8 *buffer);
+extern void state_memload(uint8 *buffer);
+
+extern void state_setrewind(int interval, int budget);
+extern void state_rewindfree(void);
+extern void state_rewindframe(void);
+extern void state_rewindhold(bool held);
+extern int state_rewind(void);
+
 #endif /* _NESSTATE_H_ */
 
 /*
@@ -55,6 +55,12 @@
 /* memory allocation */
 extern void *mem_alloc(int size, bool prefer_fast_memory);
 
+/* ROM mapping: return a read-only view of the whole image so it can be
+** used in place, or NULL to have it read from the file
+*/
+extern const void *osd_maprom(const char *filename, int *size);
+extern void osd_unmaprom(const void *image, int size);
+
 /* audio */
 extern void osd_setsound(void (*playfunc)(void *buffer, int size));
 
@@ -78,6 +84,27 @@ typedef struct sndinfo_s
 extern void osd_getvideoinfo(vidinfo_t *info);
 extern void osd_getsoundinfo(sndinfo_t *info);
 
+/* play one emulated frame's worth of sound, whether it was drawn or not */
+extern void osd_audioframe(void);
+
+/* counters of an OSD that synthesizes sound on another core; only such
+** ports (examples/nes with HW_AUDIO_PIPELINE) define osd_getaudiostats
+*/
+typedef struct audio_stats_s
+{
+   uint32 pipelined_frames; /* frames synthesized on the other core */
+   uint32 inline_frames;    /* frames the APU wouldn't give up (DMC, expansion audio) */
+   uint32 stalls;           /* times emulation had to wait for the audio core */
+   uint32 underruns;        /* audio output ran dry */
+   uint32 latency_us;       /* handoff to last sample written, last frame */
+   uint32 max_latency_us;
+} audio_stats_t;
+
+extern void osd_getaudiostats(audio_stats_t *stats);
+
+/* free-running microsecond clock, for timing frames */
+extern uint32 osd_getmicros(void);
+
 /* init / shutdown */
 extern int osd_init(void);
 extern void osd_shutdown(void);
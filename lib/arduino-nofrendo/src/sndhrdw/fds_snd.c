@@ -30,12 +30,9 @@
 static int32 fds_incsize = 0;
 
 /* mix sound channels together */
-static int32 fds_process(void)
+static void fds_process(int num_samples)
 {
-   int32 output;
-   output = 0;
-
-   return output;
+   UNUSED(num_samples);
 }
 
 /* write to registers */
@@ -31,9 +31,6 @@
 
 /* TODO: encapsulate apu/mmc5 rectangle */
 
-#define APU_OVERSAMPLE
-#define APU_VOLUME_DECAY(x) ((x) -= ((x) >> 7))
-
 /* look up table madness */
 static int32 decay_lut[16];
 static int vbl_lut[32];
@@ -89,6 +86,8 @@ typedef struct mmc5dac_s
 {
    int32 output;
    bool enabled;
+
+   int32 level;
 } mmc5dac_t;
 
 static struct
@@ -99,89 +98,95 @@ static struct
    mmc5dac_t dac;
 } mmc5;
 
-#define MMC5_RECTANGLE_OUTPUT chan->output_vol
-static int32 mmc5_rectangle(mmc5rectangle_t *chan)
+/* move an output to level at time */
+INLINE void mmc5_output(int32 *output, float time, int32 level)
 {
-   int32 output;
-
-#ifdef APU_OVERSAMPLE
-   int num_times;
-   int32 total;
-#endif /* APU_OVERSAMPLE */
-
-   /* reg0: 0-3=volume, 4=envelope, 5=hold, 6-7=duty cycle
-   ** reg1: 0-2=sweep shifts, 3=sweep inc/dec, 4-6=sweep length, 7=sweep on
-   ** reg2: 8 bits of freq
-   ** reg3: 0-2=high freq, 7-4=vbl length counter
-   */
-
-   APU_VOLUME_DECAY(chan->output_vol);
-
-   if (false == chan->enabled || 0 == chan->vbl_length)
-      return MMC5_RECTANGLE_OUTPUT;
-
-   /* vbl length counter */
-   if (false == chan->holdnote)
-      chan->vbl_length--;
-
-   /* envelope decay at a rate of (env_delay + 1) / 240 secs */
-   chan->env_phase -= 4; /* 240/60 */
-   while (chan->env_phase < 0)
+   if (level != *output)
    {
-      chan->env_phase += chan->env_delay;
-
-      if (chan->holdnote)
-         chan->env_vol = (chan->env_vol + 1) & 0x0F;
-      else if (chan->env_vol < 0x0F)
-         chan->env_vol++;
+      apu_adddelta(time, level - *output);
+      *output = level;
    }
+}
 
-   if (chan->freq < 4)
-      return MMC5_RECTANGLE_OUTPUT;
-
-   chan->accum -= mmc5.incsize; /* # of cycles per sample */
-   if (chan->accum >= 0)
-      return MMC5_RECTANGLE_OUTPUT;
-
-#ifdef APU_OVERSAMPLE
-   num_times = total = 0;
+static void mmc5_rectangle_tone(mmc5rectangle_t *chan, int start, int end)
+{
+   float t, span;
+   int32 output;
 
    if (chan->fixed_envelope)
       output = chan->volume << 8; /* fixed volume */
    else
       output = (chan->env_vol ^ 0x0F) << 8;
-#endif
 
-   while (chan->accum < 0)
+   mmc5_output(&chan->output_vol, (float)start, (chan->adder < chan->duty_flip) ? output : -output);
+
+   span = (end - start) * mmc5.incsize; /* # of cycles in the stretch */
+   for (t = chan->accum; t < span; t += chan->freq)
    {
-      chan->accum += chan->freq;
       chan->adder = (chan->adder + 1) & 0x0F;
+      mmc5_output(&chan->output_vol, start + t / mmc5.incsize, (chan->adder < chan->duty_flip) ? output : -output);
+   }
 
-#ifdef APU_OVERSAMPLE
-      if (chan->adder < chan->duty_flip)
-         total += output;
-      else
-         total -= output;
+   chan->accum = t - span;
+}
 
-      num_times++;
-#endif
-   }
+static void mmc5_rectangle(mmc5rectangle_t *chan, int num_samples)
+{
+   int pos, ticks;
 
-#ifdef APU_OVERSAMPLE
-   chan->output_vol = total / num_times;
-#else
-   if (chan->fixed_envelope)
-      output = chan->volume << 8; /* fixed volume */
-   else
-      output = (chan->env_vol ^ 0x0F) << 8;
+   /* reg0: 0-3=volume, 4=envelope, 5=hold, 6-7=duty cycle
+   ** reg1: 0-2=sweep shifts, 3=sweep inc/dec, 4-6=sweep length, 7=sweep on
+   ** reg2: 8 bits of freq
+   ** reg3: 0-2=high freq, 7-4=vbl length counter
+   */
 
-   if (0 == chan->adder)
-      chan->output_vol = output;
-   else if (chan->adder == chan->duty_flip)
-      chan->output_vol = -output;
-#endif
+   for (pos = 0; pos < num_samples; pos += ticks)
+   {
+      if (false == chan->enabled || 0 == chan->vbl_length)
+      {
+         mmc5_output(&chan->output_vol, (float)pos, 0);
+         return;
+      }
 
-   return MMC5_RECTANGLE_OUTPUT;
+      /* run up to the next length or envelope clock in one go */
+      ticks = num_samples - pos;
+      if (false == chan->holdnote && chan->vbl_length < ticks)
+         ticks = chan->vbl_length;
+      if (chan->env_phase / 4 < ticks)
+         ticks = chan->env_phase / 4;
+
+      if (ticks)
+      {
+         if (false == chan->holdnote)
+            chan->vbl_length -= ticks;
+         chan->env_phase -= 4 * ticks;
+      }
+      else
+      {
+         ticks = 1;
+
+         /* vbl length counter */
+         if (false == chan->holdnote)
+            chan->vbl_length--;
+
+         /* envelope decay at a rate of (env_delay + 1) / 240 secs */
+         chan->env_phase -= 4; /* 240/60 */
+         while (chan->env_phase < 0)
+         {
+            chan->env_phase += chan->env_delay;
+
+            if (chan->holdnote)
+               chan->env_vol = (chan->env_vol + 1) & 0x0F;
+            else if (chan->env_vol < 0x0F)
+               chan->env_vol++;
+         }
+      }
+
+      if (chan->freq < 4)
+         mmc5_output(&chan->output_vol, (float)pos, 0);
+      else
+         mmc5_rectangle_tone(chan, pos, pos + ticks);
+   }
 }
 
 static uint8 mmc5_read(uint32 address)
@@ -204,16 +209,11 @@ static uint8 mmc5_read(uint32 address)
 }
 
 /* mix vrcvi sound channels together */
-static int32 mmc5_process(void)
+static void mmc5_process(int num_samples)
 {
-   int32 accum;
-
-   accum = mmc5_rectangle(&mmc5.rect[0]);
-   accum += mmc5_rectangle(&mmc5.rect[1]);
-   if (mmc5.dac.enabled)
-      accum += mmc5.dac.output;
-
-   return accum;
+   mmc5_rectangle(&mmc5.rect[0], num_samples);
+   mmc5_rectangle(&mmc5.rect[1], num_samples);
+   mmc5_output(&mmc5.dac.level, 0, mmc5.dac.enabled ? mmc5.dac.output : 0);
 }
 
 /* write to registers */
@@ -324,6 +324,11 @@ static void mmc5_reset(void)
    apu_getcontext(&apu);
    mmc5.incsize = apu.cycle_rate;
 
+   /* the apu has just emptied its mix */
+   mmc5.rect[0].output_vol = 0;
+   mmc5.rect[1].output_vol = 0;
+   mmc5.dac.level = 0;
+
    for (i = 0x5000; i < 0x5008; i++)
       mmc5_write(i, 0);
 
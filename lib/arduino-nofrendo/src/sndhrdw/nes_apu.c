@@ -24,14 +24,31 @@
 */
 
 #include <string.h>
+#include <math.h>
 
 #include "../noftypes.h"
 #include "../log.h"
 #include "nes_apu.h"
 #include "../cpu/nes6502.h"
 
-#define APU_OVERSAMPLE
-#define APU_VOLUME_DECAY(x) ((x) -= ((x) >> 7))
+/* band-limited step synthesis */
+#define APU_BLOCK_SIZE 256  /* samples synthesized per pass */
+#define APU_BLIP_PHASES 32  /* sub-sample step positions, power of two */
+#define APU_BLIP_WIDTH 8    /* taps per step */
+#define APU_BLIP_BITS 12    /* kernel precision */
+#define APU_BLIP_CUTOFF 0.9 /* fraction of nyquist let through */
+#define APU_BLIP_LEAK 9     /* integrator leak, bleeds off DC (~7Hz at 22kHz) */
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif /* !M_PI */
+
+/* mix_enable bits / chan_level slots */
+#define APU_CHAN_RECT0 0
+#define APU_CHAN_RECT1 1
+#define APU_CHAN_TRIANGLE 2
+#define APU_CHAN_NOISE 3
+#define APU_CHAN_DMC 4
 
 /* the following seem to be the correct (empirically determined)
 ** relative volumes between the sound channels
@@ -44,6 +61,24 @@
 /* active APU */
 static apu_t apu;
 
+/* register writes held back while the APU is synthesizing elsewhere */
+#define APU_LOG_SIZE 256
+
+static struct
+{
+   uint32 address;
+   uint8 value;
+} apu_log[APU_LOG_SIZE];
+static int apu_logcount = 0;
+static bool apu_deferred = false;
+static void (*apu_synccallback)(void) = NULL;
+
+/* what apu_status and apu_enabled will return once the frame in flight
+** and the logged writes land, so $4015 reads never wait for the APU
+*/
+static uint8 apu_deferredstatus = 0;
+static uint8 apu_deferredenable = 0;
+
 /* look up table madness */
 static int32 decay_lut[16];
 static int vbl_lut[32];
@@ -95,18 +130,26 @@ const int dmc_clocks[16] =
 /* ratios of pos/neg pulse for rectangle waves */
 static const int duty_flip[4] = {2, 4, 8, 12};
 
+/* The context and channel mask are the APU state proper, so these wait
+** for a deferred frame to finish: at most one apu_process call, which
+** the frame handoff has had a whole frame of emulation to get through.
+** Only savestates, rewind, run-ahead and the GUI get here.
+*/
 void apu_setcontext(apu_t *src_apu)
 {
+   apu_sync();
    apu = *src_apu;
 }
 
 void apu_getcontext(apu_t *dest_apu)
 {
+   apu_sync();
    *dest_apu = apu;
 }
 
 void apu_setchan(int chan, bool enabled)
 {
+   apu_sync();
    if (enabled)
       apu.mix_enable |= (1 << chan);
    else
@@ -163,6 +206,104 @@ static void shift_register15(int8 *buf, int count)
 }
 #endif /* !REALTIME_NOISE */
 
+/* BAND-LIMITED SYNTHESIS
+** ======================
+** channels don't produce samples themselves: they report the times at
+** which their output changes, and each change is stamped into blip_buf
+** as a band-limited step (a windowed sinc, pre-integrated).  apu_process
+** then integrates the buffer into samples.  this costs per transition
+** rather than per sample, and doesn't alias the way point sampling did.
+*/
+static int16 blip_kernel[APU_BLIP_PHASES][APU_BLIP_WIDTH];
+static int32 blip_buf[APU_BLOCK_SIZE + APU_BLIP_WIDTH];
+static int32 blip_sum = 0;
+
+/* weighted output level each channel last reported */
+static int32 chan_level[5];
+
+static void apu_build_blip(void)
+{
+   double x, window, sinc, taps[APU_BLIP_WIDTH];
+   double sum;
+   int32 total;
+   int phase, i;
+
+   for (phase = 0; phase < APU_BLIP_PHASES; phase++)
+   {
+      sum = 0;
+      for (i = 0; i < APU_BLIP_WIDTH; i++)
+      {
+         /* distance from the step, centered between the middle taps */
+         x = (i - (APU_BLIP_WIDTH / 2 - 1)) - (double)phase / APU_BLIP_PHASES;
+
+         /* blackman window over the kernel width */
+         window = 0.42 + 0.5 * cos(2 * M_PI * x / APU_BLIP_WIDTH) + 0.08 * cos(4 * M_PI * x / APU_BLIP_WIDTH);
+
+         /* cut off a little below nyquist */
+         if (0 == x)
+            sinc = 1;
+         else
+            sinc = sin(M_PI * APU_BLIP_CUTOFF * x) / (M_PI * APU_BLIP_CUTOFF * x);
+
+         taps[i] = sinc * window;
+         sum += taps[i];
+      }
+
+      /* each phase must add up to exactly one step, or DC creeps in */
+      total = 0;
+      for (i = 0; i < APU_BLIP_WIDTH; i++)
+      {
+         blip_kernel[phase][i] = (int16)floor(taps[i] * (1 << APU_BLIP_BITS) / sum + 0.5);
+         total += blip_kernel[phase][i];
+      }
+      blip_kernel[phase][APU_BLIP_WIDTH / 2 - 1] += (1 << APU_BLIP_BITS) - total;
+   }
+}
+
+/* Add a step of delta to the output at time (in samples, from the start
+** of the block being synthesized)
+*/
+void apu_adddelta(float time, int32 delta)
+{
+   const int16 *kernel;
+   int32 *out;
+   int pos, i;
+
+   if (time < 0)
+      time = 0;
+
+   pos = (int)time;
+   if (pos >= APU_BLOCK_SIZE)
+      pos = APU_BLOCK_SIZE - 1;
+
+   kernel = blip_kernel[(int)((time - pos) * APU_BLIP_PHASES) & (APU_BLIP_PHASES - 1)];
+   out = blip_buf + pos;
+
+   for (i = 0; i < APU_BLIP_WIDTH; i++)
+      out[i] += delta * kernel[i];
+}
+
+/* move a channel's (weighted) output to level at time */
+INLINE void apu_output(int chan, float time, int32 level)
+{
+   if (0 == (apu.mix_enable & (1 << chan)))
+      level = 0;
+
+   if (level != chan_level[chan])
+   {
+      apu_adddelta(time, level - chan_level[chan]);
+      chan_level[chan] = level;
+   }
+}
+
+/* CONTROL CLOCKS
+** ==============
+** length counters, envelopes and sweeps are clocked once per output
+** sample.  the channels below find how many samples can go by before
+** one of them has something to do, run that stretch in one go, and
+** single-step the sample that has the event.
+*/
+
 /* RECTANGLE WAVE
 ** ==============
 ** reg0: 0-3=volume, 4=envelope, 5=hold, 6-7=duty cycle
@@ -170,170 +311,141 @@ static void shift_register15(int8 *buf, int count)
 ** reg2: 8 bits of freq
 ** reg3: 0-2=high freq, 7-4=vbl length counter
 */
-#ifdef APU_OVERSAMPLE
-
-#define APU_MAKE_RECTANGLE(ch)                                                                                                           \
-   static int32 apu_rectangle_##ch(void)                                                                                                 \
-   {                                                                                                                                     \
-      int32 output, total;                                                                                                               \
-      int num_times;                                                                                                                     \
-                                                                                                                                         \
-      APU_VOLUME_DECAY(apu.rectangle[ch].output_vol);                                                                                    \
-                                                                                                                                         \
-      if (false == apu.rectangle[ch].enabled || 0 == apu.rectangle[ch].vbl_length)                                                       \
-         return APU_RECTANGLE_OUTPUT(ch);                                                                                                \
-                                                                                                                                         \
-      /* vbl length counter */                                                                                                           \
-      if (false == apu.rectangle[ch].holdnote)                                                                                           \
-         apu.rectangle[ch].vbl_length--;                                                                                                 \
-                                                                                                                                         \
-      /* envelope decay at a rate of (env_delay + 1) / 240 secs */                                                                       \
-      apu.rectangle[ch].env_phase -= 4; /* 240/60 */                                                                                     \
-      while (apu.rectangle[ch].env_phase < 0)                                                                                            \
-      {                                                                                                                                  \
-         apu.rectangle[ch].env_phase += apu.rectangle[ch].env_delay;                                                                     \
-                                                                                                                                         \
-         if (apu.rectangle[ch].holdnote)                                                                                                 \
-            apu.rectangle[ch].env_vol = (apu.rectangle[ch].env_vol + 1) & 0x0F;                                                          \
-         else if (apu.rectangle[ch].env_vol < 0x0F)                                                                                      \
-            apu.rectangle[ch].env_vol++;                                                                                                 \
-      }                                                                                                                                  \
-                                                                                                                                         \
-      /* TODO: find true relation of freq_limit to register values */                                                                    \
-      if (apu.rectangle[ch].freq < 8 || (false == apu.rectangle[ch].sweep_inc && apu.rectangle[ch].freq > apu.rectangle[ch].freq_limit)) \
-         return APU_RECTANGLE_OUTPUT(ch);                                                                                                \
-                                                                                                                                         \
-      /* frequency sweeping at a rate of (sweep_delay + 1) / 120 secs */                                                                 \
-      if (apu.rectangle[ch].sweep_on && apu.rectangle[ch].sweep_shifts)                                                                  \
-      {                                                                                                                                  \
-         apu.rectangle[ch].sweep_phase -= 2; /* 120/60 */                                                                                \
-         while (apu.rectangle[ch].sweep_phase < 0)                                                                                       \
-         {                                                                                                                               \
-            apu.rectangle[ch].sweep_phase += apu.rectangle[ch].sweep_delay;                                                              \
-                                                                                                                                         \
-            if (apu.rectangle[ch].sweep_inc) /* ramp up */                                                                               \
-            {                                                                                                                            \
-               if (0 == ch)                                                                                                              \
-                  apu.rectangle[ch].freq += ~(apu.rectangle[ch].freq >> apu.rectangle[ch].sweep_shifts);                                 \
-               else                                                                                                                      \
-                  apu.rectangle[ch].freq -= (apu.rectangle[ch].freq >> apu.rectangle[ch].sweep_shifts);                                  \
-            }                                                                                                                            \
-            else /* ramp down */                                                                                                         \
-            {                                                                                                                            \
-               apu.rectangle[ch].freq += (apu.rectangle[ch].freq >> apu.rectangle[ch].sweep_shifts);                                     \
-            }                                                                                                                            \
-         }                                                                                                                               \
-      }                                                                                                                                  \
-                                                                                                                                         \
-      apu.rectangle[ch].accum -= apu.cycle_rate;                                                                                         \
-      if (apu.rectangle[ch].accum >= 0)                                                                                                  \
-         return APU_RECTANGLE_OUTPUT(ch);                                                                                                \
-                                                                                                                                         \
-      if (apu.rectangle[ch].fixed_envelope)                                                                                              \
-         output = apu.rectangle[ch].volume << 8; /* fixed volume */                                                                      \
-      else                                                                                                                               \
-         output = (apu.rectangle[ch].env_vol ^ 0x0F) << 8;                                                                               \
-                                                                                                                                         \
-      num_times = total = 0;                                                                                                             \
-                                                                                                                                         \
-      while (apu.rectangle[ch].accum < 0)                                                                                                \
-      {                                                                                                                                  \
-         apu.rectangle[ch].accum += apu.rectangle[ch].freq + 1;                                                                          \
-         apu.rectangle[ch].adder = (apu.rectangle[ch].adder + 1) & 0x0F;                                                                 \
-                                                                                                                                         \
-         if (apu.rectangle[ch].adder < apu.rectangle[ch].duty_flip)                                                                      \
-            total += output;                                                                                                             \
-         else                                                                                                                            \
-            total -= output;                                                                                                             \
-                                                                                                                                         \
-         num_times++;                                                                                                                    \
-      }                                                                                                                                  \
-                                                                                                                                         \
-      apu.rectangle[ch].output_vol = total / num_times;                                                                                  \
-      return APU_RECTANGLE_OUTPUT(ch);                                                                                                   \
+/* TODO: find true relation of freq_limit to register values */
+#define APU_RECTANGLE_AUDIBLE(chan) ((chan)->freq >= 8 && ((chan)->sweep_inc || (chan)->freq <= (chan)->freq_limit))
+
+static void apu_rectangle_tone(int ch, int start, int end, bool audible)
+{
+   rectangle_t *chan = &apu.rectangle[ch];
+   float t, span, period, sample_time;
+   int32 output;
+   int steps, target;
+
+   if (false == audible)
+   {
+      apu_output(APU_CHAN_RECT0 + ch, (float)start, 0);
+      return;
    }
 
-#else /* !APU_OVERSAMPLE */
-#define APU_MAKE_RECTANGLE(ch)                                                                                                           \
-   static int32 apu_rectangle_##ch(void)                                                                                                 \
-   {                                                                                                                                     \
-      int32 output;                                                                                                                      \
-                                                                                                                                         \
-      APU_VOLUME_DECAY(apu.rectangle[ch].output_vol);                                                                                    \
-                                                                                                                                         \
-      if (false == apu.rectangle[ch].enabled || 0 == apu.rectangle[ch].vbl_length)                                                       \
-         return APU_RECTANGLE_OUTPUT(ch);                                                                                                \
-                                                                                                                                         \
-      /* vbl length counter */                                                                                                           \
-      if (false == apu.rectangle[ch].holdnote)                                                                                           \
-         apu.rectangle[ch].vbl_length--;                                                                                                 \
-                                                                                                                                         \
-      /* envelope decay at a rate of (env_delay + 1) / 240 secs */                                                                       \
-      apu.rectangle[ch].env_phase -= 4; /* 240/60 */                                                                                     \
-      while (apu.rectangle[ch].env_phase < 0)                                                                                            \
-      {                                                                                                                                  \
-         apu.rectangle[ch].env_phase += apu.rectangle[ch].env_delay;                                                                     \
-                                                                                                                                         \
-         if (apu.rectangle[ch].holdnote)                                                                                                 \
-            apu.rectangle[ch].env_vol = (apu.rectangle[ch].env_vol + 1) & 0x0F;                                                          \
-         else if (apu.rectangle[ch].env_vol < 0x0F)                                                                                      \
-            apu.rectangle[ch].env_vol++;                                                                                                 \
-      }                                                                                                                                  \
-                                                                                                                                         \
-      /* TODO: find true relation of freq_limit to register values */                                                                    \
-      if (apu.rectangle[ch].freq < 8 || (false == apu.rectangle[ch].sweep_inc && apu.rectangle[ch].freq > apu.rectangle[ch].freq_limit)) \
-         return APU_RECTANGLE_OUTPUT(ch);                                                                                                \
-                                                                                                                                         \
-      /* frequency sweeping at a rate of (sweep_delay + 1) / 120 secs */                                                                 \
-      if (apu.rectangle[ch].sweep_on && apu.rectangle[ch].sweep_shifts)                                                                  \
-      {                                                                                                                                  \
-         apu.rectangle[ch].sweep_phase -= 2; /* 120/60 */                                                                                \
-         while (apu.rectangle[ch].sweep_phase < 0)                                                                                       \
-         {                                                                                                                               \
-            apu.rectangle[ch].sweep_phase += apu.rectangle[ch].sweep_delay;                                                              \
-                                                                                                                                         \
-            if (apu.rectangle[ch].sweep_inc) /* ramp up */                                                                               \
-            {                                                                                                                            \
-               if (0 == ch)                                                                                                              \
-                  apu.rectangle[ch].freq += ~(apu.rectangle[ch].freq >> apu.rectangle[ch].sweep_shifts);                                 \
-               else                                                                                                                      \
-                  apu.rectangle[ch].freq -= (apu.rectangle[ch].freq >> apu.rectangle[ch].sweep_shifts);                                  \
-            }                                                                                                                            \
-            else /* ramp down */                                                                                                         \
-            {                                                                                                                            \
-               apu.rectangle[ch].freq += (apu.rectangle[ch].freq >> apu.rectangle[ch].sweep_shifts);                                     \
-            }                                                                                                                            \
-         }                                                                                                                               \
-      }                                                                                                                                  \
-                                                                                                                                         \
-      apu.rectangle[ch].accum -= apu.cycle_rate;                                                                                         \
-      if (apu.rectangle[ch].accum >= 0)                                                                                                  \
-         return APU_RECTANGLE_OUTPUT(ch);                                                                                                \
-                                                                                                                                         \
-      while (apu.rectangle[ch].accum < 0)                                                                                                \
-      {                                                                                                                                  \
-         apu.rectangle[ch].accum += (apu.rectangle[ch].freq + 1);                                                                        \
-         apu.rectangle[ch].adder = (apu.rectangle[ch].adder + 1) & 0x0F;                                                                 \
-      }                                                                                                                                  \
-                                                                                                                                         \
-      if (apu.rectangle[ch].fixed_envelope)                                                                                              \
-         output = apu.rectangle[ch].volume << 8; /* fixed volume */                                                                      \
-      else                                                                                                                               \
-         output = (apu.rectangle[ch].env_vol ^ 0x0F) << 8;                                                                               \
-                                                                                                                                         \
-      if (0 == apu.rectangle[ch].adder)                                                                                                  \
-         apu.rectangle[ch].output_vol = output;                                                                                          \
-      else if (apu.rectangle[ch].adder == apu.rectangle[ch].duty_flip)                                                                   \
-         apu.rectangle[ch].output_vol = -output;                                                                                         \
-                                                                                                                                         \
-      return APU_RECTANGLE_OUTPUT(ch);                                                                                                   \
+   if (chan->fixed_envelope)
+      output = chan->volume << 8; /* fixed volume */
+   else
+      output = (chan->env_vol ^ 0x0F) << 8;
+
+   chan->output_vol = (chan->adder < chan->duty_flip) ? output : -output;
+   apu_output(APU_CHAN_RECT0 + ch, (float)start, APU_RECTANGLE_OUTPUT(ch));
+
+   /* hop straight from one duty transition to the next */
+   sample_time = 1.0f / apu.cycle_rate;
+   period = (float)(chan->freq + 1);
+   span = (end - start) * apu.cycle_rate;
+   t = chan->accum;
+
+   while (t < span)
+   {
+      target = (chan->adder < chan->duty_flip) ? chan->duty_flip : 0;
+      steps = (target - chan->adder) & 0x0F;
+
+      if (t + (steps - 1) * period >= span)
+      {
+         /* run out the block without reaching it */
+         steps = (int)((span - t) / period) + 1;
+         chan->adder = (chan->adder + steps) & 0x0F;
+         t += steps * period;
+         break;
+      }
+
+      t += (steps - 1) * period;
+      chan->adder = target;
+      chan->output_vol = (target < chan->duty_flip) ? output : -output;
+      apu_output(APU_CHAN_RECT0 + ch, start + t * sample_time, APU_RECTANGLE_OUTPUT(ch));
+      t += period;
    }
 
-#endif /* !APU_OVERSAMPLE */
+   chan->accum = t - span;
+}
+
+static void apu_rectangle(int ch, int num_samples)
+{
+   rectangle_t *chan = &apu.rectangle[ch];
+   bool audible, sweeping;
+   int pos, ticks;
+
+   for (pos = 0; pos < num_samples; pos += ticks)
+   {
+      if (false == chan->enabled || 0 == chan->vbl_length)
+      {
+         apu_output(APU_CHAN_RECT0 + ch, (float)pos, 0);
+         return;
+      }
+
+      audible = APU_RECTANGLE_AUDIBLE(chan);
+      sweeping = audible && chan->sweep_on && chan->sweep_shifts;
+
+      ticks = num_samples - pos;
+      if (false == chan->holdnote && chan->vbl_length < ticks)
+         ticks = chan->vbl_length;
+      if (chan->env_phase / 4 < ticks)
+         ticks = chan->env_phase / 4;
+      if (sweeping && chan->sweep_phase / 2 < ticks)
+         ticks = chan->sweep_phase / 2;
+
+      if (ticks)
+      {
+         /* nothing but counting down until the next event */
+         if (false == chan->holdnote)
+            chan->vbl_length -= ticks;
+         chan->env_phase -= 4 * ticks;
+         if (sweeping)
+            chan->sweep_phase -= 2 * ticks;
+
+         apu_rectangle_tone(ch, pos, pos + ticks, audible);
+         continue;
+      }
+
+      ticks = 1;
+
+      /* vbl length counter */
+      if (false == chan->holdnote)
+         chan->vbl_length--;
+
+      /* envelope decay at a rate of (env_delay + 1) / 240 secs */
+      chan->env_phase -= 4; /* 240/60 */
+      while (chan->env_phase < 0)
+      {
+         chan->env_phase += chan->env_delay;
+
+         if (chan->holdnote)
+            chan->env_vol = (chan->env_vol + 1) & 0x0F;
+         else if (chan->env_vol < 0x0F)
+            chan->env_vol++;
+      }
+
+      /* frequency sweeping at a rate of (sweep_delay + 1) / 120 secs */
+      if (sweeping)
+      {
+         chan->sweep_phase -= 2; /* 120/60 */
+         while (chan->sweep_phase < 0)
+         {
+            chan->sweep_phase += chan->sweep_delay;
+
+            if (chan->sweep_inc) /* ramp up */
+            {
+               if (0 == ch)
+                  chan->freq += ~(chan->freq >> chan->sweep_shifts);
+               else
+                  chan->freq -= (chan->freq >> chan->sweep_shifts);
+            }
+            else /* ramp down */
+            {
+               chan->freq += (chan->freq >> chan->sweep_shifts);
+            }
+         }
+      }
 
-/* generate the functions */
-APU_MAKE_RECTANGLE(0)
-APU_MAKE_RECTANGLE(1)
+      apu_rectangle_tone(ch, pos, pos + 1, audible);
+   }
+}
 
 /* TRIANGLE WAVE
 ** =============
@@ -341,42 +453,77 @@ APU_MAKE_RECTANGLE(1)
 ** reg2: low 8 bits of frequency
 ** reg3: 7-3=length counter, 2-0=high 3 bits of frequency
 */
-static int32 apu_triangle(void)
+/* 32-step ramp, centered on zero */
+#define APU_TRIANGLE_LEVEL(adder) ((((adder) & 0x10) ? ((31 - (adder)) << 9) : (((adder) + 1) << 9)) - (8 << 9))
+
+static void apu_triangle_tone(int start, int end)
 {
-   APU_VOLUME_DECAY(apu.triangle.output_vol);
+   float t, span, period, sample_time;
 
-   if (false == apu.triangle.enabled || 0 == apu.triangle.vbl_length)
-      return APU_TRIANGLE_OUTPUT;
+   sample_time = 1.0f / apu.cycle_rate;
+   period = (float)apu.triangle.freq;
+   span = (end - start) * apu.cycle_rate;
 
-   if (apu.triangle.counter_started)
-   {
-      if (apu.triangle.linear_length > 0)
-         apu.triangle.linear_length--;
-      if (apu.triangle.vbl_length && false == apu.triangle.holdnote)
-         apu.triangle.vbl_length--;
-   }
-   else if (false == apu.triangle.holdnote && apu.triangle.write_latency)
+   for (t = apu.triangle.accum; t < span; t += period)
    {
-      if (--apu.triangle.write_latency == 0)
-         apu.triangle.counter_started = true;
+      apu.triangle.adder = (apu.triangle.adder + 1) & 0x1F;
+      apu.triangle.output_vol = APU_TRIANGLE_LEVEL(apu.triangle.adder);
+      apu_output(APU_CHAN_TRIANGLE, start + t * sample_time, APU_TRIANGLE_OUTPUT);
    }
 
-   if (0 == apu.triangle.linear_length || apu.triangle.freq < 4) /* inaudible */
-      return APU_TRIANGLE_OUTPUT;
+   apu.triangle.accum = t - span;
+}
 
-   apu.triangle.accum -= apu.cycle_rate;
-   while (apu.triangle.accum < 0)
+static void apu_triangle(int num_samples)
+{
+   bool audible;
+   int pos, ticks;
+
+   /* a silenced triangle holds its level rather than dropping to zero */
+   apu_output(APU_CHAN_TRIANGLE, 0, APU_TRIANGLE_OUTPUT);
+
+   for (pos = 0; pos < num_samples; pos += ticks)
    {
-      apu.triangle.accum += apu.triangle.freq;
-      apu.triangle.adder = (apu.triangle.adder + 1) & 0x1F;
+      if (false == apu.triangle.enabled || 0 == apu.triangle.vbl_length)
+         return;
 
-      if (apu.triangle.adder & 0x10)
-         apu.triangle.output_vol -= (2 << 8);
+      ticks = num_samples - pos;
+
+      if (apu.triangle.counter_started)
+      {
+         if (false == apu.triangle.holdnote && apu.triangle.vbl_length < ticks)
+            ticks = apu.triangle.vbl_length;
+
+         /* the linear counter silences the channel on the tick it hits zero */
+         audible = (apu.triangle.linear_length > 1);
+         if (audible && apu.triangle.linear_length - 1 < ticks)
+            ticks = apu.triangle.linear_length - 1;
+
+         if (apu.triangle.linear_length > ticks)
+            apu.triangle.linear_length -= ticks;
+         else
+            apu.triangle.linear_length = 0;
+         if (false == apu.triangle.holdnote)
+            apu.triangle.vbl_length -= ticks;
+      }
       else
-         apu.triangle.output_vol += (2 << 8);
-   }
+      {
+         audible = (0 != apu.triangle.linear_length);
 
-   return APU_TRIANGLE_OUTPUT;
+         if (false == apu.triangle.holdnote && apu.triangle.write_latency)
+         {
+            if (apu.triangle.write_latency < ticks)
+               ticks = apu.triangle.write_latency;
+
+            apu.triangle.write_latency -= ticks;
+            if (0 == apu.triangle.write_latency)
+               apu.triangle.counter_started = true;
+         }
+      }
+
+      if (audible && apu.triangle.freq >= 4)
+         apu_triangle_tone(pos, pos + ticks);
+   }
 }
 
 /* WHITE NOISE CHANNEL
@@ -385,123 +532,104 @@ static int32 apu_triangle(void)
 ** reg2: 7=small(93 byte) sample,3-0=freq lookup
 ** reg3: 7-4=vbl length counter
 */
-/* TODO: AAAAAAAAAAAAAAAAAAAAAAAA!  #ifdef MADNESS! */
-static int32 apu_noise(void)
+INLINE int8 apu_noisebit(void)
 {
-   int32 outvol;
-
-#if defined(APU_OVERSAMPLE) && defined(REALTIME_NOISE)
-#else  /* !(APU_OVERSAMPLE && REALTIME_NOISE) */
-   int32 noise_bit;
-#endif /* !(APU_OVERSAMPLE && REALTIME_NOISE) */
-#ifdef APU_OVERSAMPLE
-   int num_times;
-   int32 total;
-#endif /* APU_OVERSAMPLE */
-
-   APU_VOLUME_DECAY(apu.noise.output_vol);
-
-   if (false == apu.noise.enabled || 0 == apu.noise.vbl_length)
-      return APU_NOISE_OUTPUT;
-
-   /* vbl length counter */
-   if (false == apu.noise.holdnote)
-      apu.noise.vbl_length--;
+#ifdef REALTIME_NOISE
+   return shift_register15(apu.noise.xor_tap);
+#else  /* !REALTIME_NOISE */
+   apu.noise.cur_pos++;
 
-   /* envelope decay at a rate of (env_delay + 1) / 240 secs */
-   apu.noise.env_phase -= 4; /* 240/60 */
-   while (apu.noise.env_phase < 0)
+   if (apu.noise.short_sample)
    {
-      apu.noise.env_phase += apu.noise.env_delay;
-
-      if (apu.noise.holdnote)
-         apu.noise.env_vol = (apu.noise.env_vol + 1) & 0x0F;
-      else if (apu.noise.env_vol < 0x0F)
-         apu.noise.env_vol++;
+      if (APU_NOISE_93 == apu.noise.cur_pos)
+         apu.noise.cur_pos = 0;
+      return noise_short_lut[apu.noise.cur_pos];
    }
 
-   apu.noise.accum -= apu.cycle_rate;
-   if (apu.noise.accum >= 0)
-      return APU_NOISE_OUTPUT;
+   if (APU_NOISE_32K == apu.noise.cur_pos)
+      apu.noise.cur_pos = 0;
+   return noise_long_lut[apu.noise.cur_pos];
+#endif /* !REALTIME_NOISE */
+}
+
+static void apu_noise_tone(int start, int end)
+{
+   float t, span, period, sample_time;
+   int32 outvol;
 
-#ifdef APU_OVERSAMPLE
    if (apu.noise.fixed_envelope)
       outvol = apu.noise.volume << 8; /* fixed volume */
    else
       outvol = (apu.noise.env_vol ^ 0x0F) << 8;
 
-   num_times = total = 0;
-#endif /* APU_OVERSAMPLE */
-
-   while (apu.noise.accum < 0)
-   {
-      apu.noise.accum += apu.noise.freq;
+   /* pick up volume changes right away */
+   if (apu.noise.output_vol < 0)
+      apu.noise.output_vol = -outvol;
+   else
+      apu.noise.output_vol = outvol;
+   apu_output(APU_CHAN_NOISE, (float)start, APU_NOISE_OUTPUT);
 
-#ifdef REALTIME_NOISE
+   sample_time = 1.0f / apu.cycle_rate;
+   period = (float)apu.noise.freq;
+   span = (end - start) * apu.cycle_rate;
 
-#ifdef APU_OVERSAMPLE
-      if (shift_register15(apu.noise.xor_tap))
-         total += outvol;
-      else
-         total -= outvol;
+   for (t = apu.noise.accum; t < span; t += period)
+   {
+      apu.noise.output_vol = apu_noisebit() ? outvol : -outvol;
+      apu_output(APU_CHAN_NOISE, start + t * sample_time, APU_NOISE_OUTPUT);
+   }
 
-      num_times++;
-#else  /* !APU_OVERSAMPLE */
-      noise_bit = shift_register15(apu.noise.xor_tap);
-#endif /* !APU_OVERSAMPLE */
+   apu.noise.accum = t - span;
+}
 
-#else /* !REALTIME_NOISE */
-      apu.noise.cur_pos++;
+static void apu_noise(int num_samples)
+{
+   int pos, ticks;
 
-      if (apu.noise.short_sample)
-      {
-         if (APU_NOISE_93 == apu.noise.cur_pos)
-            apu.noise.cur_pos = 0;
-      }
-      else
+   for (pos = 0; pos < num_samples; pos += ticks)
+   {
+      if (false == apu.noise.enabled || 0 == apu.noise.vbl_length)
       {
-         if (APU_NOISE_32K == apu.noise.cur_pos)
-            apu.noise.cur_pos = 0;
+         apu_output(APU_CHAN_NOISE, (float)pos, 0);
+         return;
       }
 
-#ifdef APU_OVERSAMPLE
-      if (apu.noise.short_sample)
-         noise_bit = noise_short_lut[apu.noise.cur_pos];
-      else
-         noise_bit = noise_long_lut[apu.noise.cur_pos];
+      ticks = num_samples - pos;
+      if (false == apu.noise.holdnote && apu.noise.vbl_length < ticks)
+         ticks = apu.noise.vbl_length;
+      if (apu.noise.env_phase / 4 < ticks)
+         ticks = apu.noise.env_phase / 4;
 
-      if (noise_bit)
-         total += outvol;
-      else
-         total -= outvol;
+      if (ticks)
+      {
+         if (false == apu.noise.holdnote)
+            apu.noise.vbl_length -= ticks;
+         apu.noise.env_phase -= 4 * ticks;
 
-      num_times++;
-#endif /* APU_OVERSAMPLE */
-#endif /* !REALTIME_NOISE */
-   }
+         apu_noise_tone(pos, pos + ticks);
+         continue;
+      }
 
-#ifdef APU_OVERSAMPLE
-   apu.noise.output_vol = total / num_times;
-#else /* !APU_OVERSAMPLE */
-   if (apu.noise.fixed_envelope)
-      outvol = apu.noise.volume << 8; /* fixed volume */
-   else
-      outvol = (apu.noise.env_vol ^ 0x0F) << 8;
+      ticks = 1;
 
-#ifndef REALTIME_NOISE
-   if (apu.noise.short_sample)
-      noise_bit = noise_short_lut[apu.noise.cur_pos];
-   else
-      noise_bit = noise_long_lut[apu.noise.cur_pos];
-#endif /* !REALTIME_NOISE */
+      /* vbl length counter */
+      if (false == apu.noise.holdnote)
+         apu.noise.vbl_length--;
 
-   if (noise_bit)
-      apu.noise.output_vol = outvol;
-   else
-      apu.noise.output_vol = -outvol;
-#endif /* !APU_OVERSAMPLE */
+      /* envelope decay at a rate of (env_delay + 1) / 240 secs */
+      apu.noise.env_phase -= 4; /* 240/60 */
+      while (apu.noise.env_phase < 0)
+      {
+         apu.noise.env_phase += apu.noise.env_delay;
+
+         if (apu.noise.holdnote)
+            apu.noise.env_vol = (apu.noise.env_vol + 1) & 0x0F;
+         else if (apu.noise.env_vol < 0x0F)
+            apu.noise.env_vol++;
+      }
 
-   return APU_NOISE_OUTPUT;
+      apu_noise_tone(pos, pos + 1);
+   }
 }
 
 INLINE void apu_dmcreload(void)
@@ -518,85 +646,92 @@ INLINE void apu_dmcreload(void)
 ** reg2: 8 bits of 64-byte aligned address offset : $C000 + (value * 64)
 ** reg3: length, (value * 16) + 1
 */
-static int32 apu_dmc(void)
+static void apu_dmc(int num_samples)
 {
+   float t, span, sample_time;
    int delta_bit;
 
-   APU_VOLUME_DECAY(apu.dmc.output_vol);
+   /* pick up writes to the DAC */
+   apu_output(APU_CHAN_DMC, 0, APU_DMC_OUTPUT);
 
    /* only process when channel is alive */
-   if (apu.dmc.dma_length)
+   if (0 == apu.dmc.dma_length)
+      return;
+
+   sample_time = 1.0f / apu.cycle_rate;
+   span = num_samples * apu.cycle_rate;
+
+   for (t = apu.dmc.accum; t < span; t += apu.dmc.freq)
    {
-      apu.dmc.accum -= apu.cycle_rate;
+      delta_bit = (apu.dmc.dma_length & 7) ^ 7;
 
-      while (apu.dmc.accum < 0)
+      if (7 == delta_bit)
       {
-         apu.dmc.accum += apu.dmc.freq;
+         apu.dmc.cur_byte = nes6502_getbyte(apu.dmc.address);
 
-         delta_bit = (apu.dmc.dma_length & 7) ^ 7;
+         /* steal a cycle from CPU*/
+         nes6502_burn(1);
 
-         if (7 == delta_bit)
-         {
-            apu.dmc.cur_byte = nes6502_getbyte(apu.dmc.address);
-
-            /* steal a cycle from CPU*/
-            nes6502_burn(1);
+         /* prevent wraparound */
+         if (0xFFFF == apu.dmc.address)
+            apu.dmc.address = 0x8000;
+         else
+            apu.dmc.address++;
+      }
 
-            /* prevent wraparound */
-            if (0xFFFF == apu.dmc.address)
-               apu.dmc.address = 0x8000;
-            else
-               apu.dmc.address++;
+      if (--apu.dmc.dma_length == 0)
+      {
+         /* if loop bit set, we're cool to retrigger sample */
+         if (apu.dmc.looping)
+         {
+            apu_dmcreload();
          }
-
-         if (--apu.dmc.dma_length == 0)
+         else
          {
-            /* if loop bit set, we're cool to retrigger sample */
-            if (apu.dmc.looping)
+            /* check to see if we should generate an irq */
+            if (apu.dmc.irq_gen)
             {
-               apu_dmcreload();
+               apu.dmc.irq_occurred = true;
+               if (apu.irq_callback)
+                  apu.irq_callback();
             }
-            else
-            {
-               /* check to see if we should generate an irq */
-               if (apu.dmc.irq_gen)
-               {
-                  apu.dmc.irq_occurred = true;
-                  if (apu.irq_callback)
-                     apu.irq_callback();
-               }
 
-               /* bodge for timestamp queue */
-               apu.dmc.enabled = false;
-               break;
-            }
+            /* bodge for timestamp queue */
+            apu.dmc.enabled = false;
+
+            /* carry the timer to its next tick, as the loop would */
+            t += apu.dmc.freq;
+            break;
          }
+      }
 
-         /* positive delta */
-         if (apu.dmc.cur_byte & (1 << delta_bit))
+      /* positive delta */
+      if (apu.dmc.cur_byte & (1 << delta_bit))
+      {
+         if (apu.dmc.regs[1] < 0x7D)
          {
-            if (apu.dmc.regs[1] < 0x7D)
-            {
-               apu.dmc.regs[1] += 2;
-               apu.dmc.output_vol += (2 << 8);
-            }
+            apu.dmc.regs[1] += 2;
+            apu.dmc.output_vol += (2 << 8);
          }
-         /* negative delta */
-         else
+      }
+      /* negative delta */
+      else
+      {
+         if (apu.dmc.regs[1] > 1)
          {
-            if (apu.dmc.regs[1] > 1)
-            {
-               apu.dmc.regs[1] -= 2;
-               apu.dmc.output_vol -= (2 << 8);
-            }
+            apu.dmc.regs[1] -= 2;
+            apu.dmc.output_vol -= (2 << 8);
          }
       }
+
+      apu_output(APU_CHAN_DMC, t * sample_time, APU_DMC_OUTPUT);
    }
 
-   return APU_DMC_OUTPUT;
+   /* a sample that ended mid-block leaves no cycle debt for the next one */
+   apu.dmc.accum = (t > span) ? t - span : 0;
 }
 
-void apu_write(uint32 address, uint8 value)
+static void apu_regwrite(uint32 address, uint8 value)
 {
    int chan;
 
@@ -812,6 +947,112 @@ void apu_write(uint32 address, uint8 value)
    }
 }
 
+/* length counter still running after ticks more samples */
+#define APU_LENGTH_LEFT(length, holdnote, ticks) \
+   ((length) && ((holdnote) || (length) > (ticks)))
+
+/* $4015 length counter and DMC bits, as they will read once apu_process
+** has synthesized num_samples more samples (0 for the current state).
+** The channel enables are left to the caller: a disabled channel holds
+** its count, and a length written meanwhile shows once it is enabled.
+*/
+static uint8 apu_status(int num_samples)
+{
+   uint8 value = 0;
+   int chan, ticks;
+
+   for (chan = 0; chan < 2; chan++)
+   {
+      if (APU_LENGTH_LEFT(apu.rectangle[chan].vbl_length,
+                          apu.rectangle[chan].holdnote || false == apu.rectangle[chan].enabled,
+                          num_samples))
+         value |= (1 << chan);
+   }
+
+   /* the triangle's length counter only starts after the write latency */
+   ticks = num_samples;
+   if (false == apu.triangle.counter_started)
+      ticks = apu.triangle.write_latency ? ticks - apu.triangle.write_latency : 0;
+   if (APU_LENGTH_LEFT(apu.triangle.vbl_length,
+                       apu.triangle.holdnote || false == apu.triangle.enabled,
+                       ticks))
+      value |= 0x04;
+
+   if (APU_LENGTH_LEFT(apu.noise.vbl_length,
+                       apu.noise.holdnote || false == apu.noise.enabled,
+                       num_samples))
+      value |= 0x08;
+
+   /* bodge for timestamp queue */
+   if (apu.dmc.enabled)
+      value |= 0x10;
+
+   if (apu.dmc.irq_occurred)
+      value |= 0x80;
+
+   return value;
+}
+
+/* $4015 bits of the enabled tone channels */
+static uint8 apu_enabled(void)
+{
+   return (apu.rectangle[0].enabled ? 0x01 : 0) |
+          (apu.rectangle[1].enabled ? 0x02 : 0) |
+          (apu.triangle.enabled ? 0x04 : 0) |
+          (apu.noise.enabled ? 0x08 : 0);
+}
+
+/* keep apu_deferredstatus/apu_deferredenable in step with a logged
+** write, as apu_regwrite would change apu_status/apu_enabled
+*/
+static void apu_logstatus(uint32 address, uint8 value)
+{
+   switch (address)
+   {
+   case APU_WRA3:
+   case APU_WRB3:
+   case APU_WRC3:
+   case APU_WRD3:
+      apu_deferredstatus |= (1 << ((address >> 2) & 3));
+      break;
+
+   case APU_WRE0:
+      if (0 == (value & 0x80))
+         apu_deferredstatus &= ~0x80;
+      break;
+
+   case APU_SMASK:
+      /* disabling a channel zeroes its length counter */
+      apu_deferredenable = value & 0x0F;
+      apu_deferredstatus = (apu_deferredstatus & apu_deferredenable) | (value & 0x10);
+      break;
+
+   default:
+      break;
+   }
+}
+
+/* Write to $4000-$4017 */
+void apu_write(uint32 address, uint8 value)
+{
+   if (apu_deferred)
+   {
+      if (apu_logcount < APU_LOG_SIZE)
+      {
+         apu_log[apu_logcount].address = address;
+         apu_log[apu_logcount].value = value;
+         apu_logcount++;
+         apu_logstatus(address, value);
+         return;
+      }
+
+      /* log is full, take the APU back */
+      apu_sync();
+   }
+
+   apu_regwrite(address, value);
+}
+
 /* Read from $4000-$4017 */
 uint8 apu_read(uint32 address)
 {
@@ -820,23 +1061,13 @@ uint8 apu_read(uint32 address)
    switch (address)
    {
    case APU_SMASK:
-      value = 0;
-      /* Return 1 in 0-5 bit pos if a channel is playing */
-      if (apu.rectangle[0].enabled && apu.rectangle[0].vbl_length)
-         value |= 0x01;
-      if (apu.rectangle[1].enabled && apu.rectangle[1].vbl_length)
-         value |= 0x02;
-      if (apu.triangle.enabled && apu.triangle.vbl_length)
-         value |= 0x04;
-      if (apu.noise.enabled && apu.noise.vbl_length)
-         value |= 0x08;
-
-      /* bodge for timestamp queue */
-      if (apu.dmc.enabled)
-         value |= 0x10;
-
-      if (apu.dmc.irq_occurred)
-         value |= 0x80;
+      /* Return 1 in 0-5 bit pos if a channel is playing; a deferred
+      ** frame is answered from apu_deferredstatus, never by waiting
+      */
+      if (apu_deferred)
+         value = apu_deferredstatus & (apu_deferredenable | 0xF0);
+      else
+         value = apu_status(0) & (apu_enabled() | 0xF0);
 
       if (apu.irqclear_callback)
          value |= apu.irqclear_callback();
@@ -866,6 +1097,7 @@ void apu_process(void *buffer, int num_samples)
 
    int16 *buf16;
    uint8 *buf8;
+   int count, i;
 
    if (NULL != buffer)
    {
@@ -875,54 +1107,107 @@ void apu_process(void *buffer, int num_samples)
       buf16 = (int16 *)buffer;
       buf8 = (uint8 *)buffer;
 
-      while (num_samples--)
+      while (num_samples > 0)
       {
-         int32 next_sample, accum = 0;
-
-         if (apu.mix_enable & 0x01)
-            accum += apu_rectangle_0();
-         if (apu.mix_enable & 0x02)
-            accum += apu_rectangle_1();
-         if (apu.mix_enable & 0x04)
-            accum += apu_triangle();
-         if (apu.mix_enable & 0x08)
-            accum += apu_noise();
-         if (apu.mix_enable & 0x10)
-            accum += apu_dmc();
+         count = (num_samples < APU_BLOCK_SIZE) ? num_samples : APU_BLOCK_SIZE;
+         num_samples -= count;
+
+         /* let each channel lay down its steps for the whole block */
+         apu_rectangle(0, count);
+         apu_rectangle(1, count);
+         apu_triangle(count);
+         apu_noise(count);
+         apu_dmc(count);
          if (apu.ext && (apu.mix_enable & 0x20))
-            accum += apu.ext->process();
+            apu.ext->process(count);
 
-         /* do any filtering */
-         if (APU_FILTER_NONE != apu.filter_type)
+         for (i = 0; i < count; i++)
          {
-            next_sample = accum;
+            int32 next_sample, accum;
+
+            /* integrate, leaking off any DC offset */
+            blip_sum += blip_buf[i];
+            accum = blip_sum >> APU_BLIP_BITS;
+            blip_sum -= blip_sum >> APU_BLIP_LEAK;
 
-            if (APU_FILTER_LOWPASS == apu.filter_type)
+            /* do any filtering */
+            if (APU_FILTER_NONE != apu.filter_type)
             {
-               accum += prev_sample;
-               accum >>= 1;
+               next_sample = accum;
+
+               if (APU_FILTER_LOWPASS == apu.filter_type)
+               {
+                  accum += prev_sample;
+                  accum >>= 1;
+               }
+               else
+                  accum = (accum + accum + accum + prev_sample) >> 2;
+
+               prev_sample = next_sample;
             }
-            else
-               accum = (accum + accum + accum + prev_sample) >> 2;
 
-            prev_sample = next_sample;
-         }
+            /* do clipping */
+            CLIP_OUTPUT16(accum);
 
-         /* do clipping */
-         CLIP_OUTPUT16(accum);
+            /* signed 16-bit output, unsigned 8-bit */
+            if (16 == apu.sample_bits)
+               *buf16++ = (int16)accum;
+            else
+               *buf8++ = (accum >> 8) ^ 0x80;
+         }
 
-         /* signed 16-bit output, unsigned 8-bit */
-         if (16 == apu.sample_bits)
-            *buf16++ = (int16)accum;
-         else
-            *buf8++ = (accum >> 8) ^ 0x80;
+         /* carry the tails of late steps into the next block */
+         memmove(blip_buf, blip_buf + count, APU_BLIP_WIDTH * sizeof(int32));
+         memset(blip_buf + APU_BLIP_WIDTH, 0, count * sizeof(int32));
       }
    }
 }
 
+/* Hand the APU to another thread for the next apu_process call.  Until
+** apu_sync, register writes are logged instead of applied, and anything
+** else that needs the APU state calls sync_func to wait for the other
+** thread to finish.  Returns false if the APU can't run unattended: the
+** DMC fetches from (and steals cycles from) the CPU, and expansion chips
+** are written to directly by the CPU.
+*/
+bool apu_setdeferred(void (*sync_func)(void))
+{
+   ASSERT(sync_func);
+
+   apu_sync();
+
+   if (apu.ext || apu.dmc.dma_length)
+      return false;
+
+   /* the DMC is idle, so only the length counters move this frame */
+   apu_deferredstatus = apu_status(apu.num_samples);
+   apu_deferredenable = apu_enabled();
+
+   apu_synccallback = sync_func;
+   apu_deferred = true;
+   return true;
+}
+
+/* Wait for a deferred apu_process to finish, then replay logged writes */
+void apu_sync(void)
+{
+   int i;
+
+   if (false == apu_deferred)
+      return;
+
+   apu_synccallback();
+   apu_deferred = false;
+
+   for (i = 0; i < apu_logcount; i++)
+      apu_regwrite(apu_log[i].address, apu_log[i].value);
+   apu_logcount = 0;
+}
+
 /* set the filter type */
 void apu_setfilter(int filter_type)
 {
+   apu_sync();
    apu.filter_type = filter_type;
 }
 
@@ -930,6 +1215,13 @@ void apu_reset(void)
 {
    uint32 address;
 
+   apu_sync();
+
+   /* drop anything left in the synthesis buffer */
+   memset(blip_buf, 0, sizeof(blip_buf));
+   memset(chan_level, 0, sizeof(chan_level));
+   blip_sum = 0;
+
    /* initialize all channel members */
    for (address = 0x4000; address <= 0x4013; address++)
       apu_write(address, 0);
@@ -956,6 +1248,9 @@ void apu_build_luts(int num_samples)
    for (i = 0; i < 128; i++)
       trilength_lut[i] = (int)(0.25 * i * num_samples);
 
+   /* band-limited step kernel */
+   apu_build_blip();
+
 #ifndef REALTIME_NOISE
    /* generate noise samples */
    shift_register15(noise_long_lut, APU_NOISE_32K);
@@ -965,6 +1260,8 @@ void apu_build_luts(int num_samples)
 
 void apu_setparams(double base_freq, int sample_rate, int refresh_rate, int sample_bits)
 {
+   apu_sync();
+
    apu.sample_rate = sample_rate;
    apu.refresh_rate = refresh_rate;
    apu.sample_bits = sample_bits;
@@ -1008,7 +1305,8 @@ apu_t *apu_create(double base_freq, int sample_rate, int refresh_rate, int sampl
    for (channel = 0; channel < 6; channel++)
       apu_setchan(channel, true);
 
-   apu_setfilter(APU_FILTER_WEIGHTED);
+   /* synthesis is band-limited already, filtering only dulls it */
+   apu_setfilter(APU_FILTER_NONE);
 
    apu_getcontext(temp_apu);
 
@@ -1017,6 +1315,8 @@ apu_t *apu_create(double base_freq, int sample_rate, int refresh_rate, int sampl
 
 void apu_destroy(apu_t **src_apu)
 {
+   apu_sync();
+
    if (*src_apu)
    {
       if ((*src_apu)->ext && NULL != (*src_apu)->ext->shutdown)
@@ -189,7 +189,7 @@ typedef struct apuext_s
    int (*init)(void);
    void (*shutdown)(void);
    void (*reset)(void);
-   int32 (*process)(void);
+   void (*process)(int num_samples); /* steps out via apu_adddelta */
    apu_memread *mem_read;
    apu_memwrite *mem_write;
 } apuext_t;
@@ -237,8 +237,12 @@ extern "C"
    extern void apu_destroy(apu_t **apu);
 
    extern void apu_process(void *buffer, int num_samples);
+   extern void apu_adddelta(float time, int32 delta);
    extern void apu_reset(void);
 
+   extern bool apu_setdeferred(void (*sync_func)(void));
+   extern void apu_sync(void);
+
    extern void apu_setext(apu_t *apu, apuext_t *ext);
    extern void apu_setfilter(int filter_type);
    extern void apu_setchan(int chan, bool enabled);
@@ -39,6 +39,8 @@ typedef struct vrcvirectangle_s
    int32 freq;
    int32 volume;
    uint8 duty_flip;
+
+   int32 output;
 } vrcvirectangle_t;
 
 typedef struct vrcvisawtooth_s
@@ -53,6 +55,8 @@ typedef struct vrcvisawtooth_s
 
    int32 freq;
    uint8 volume;
+
+   int32 output;
 } vrcvisawtooth_t;
 
 typedef struct vrcvisnd_s
@@ -64,43 +68,56 @@ typedef struct vrcvisnd_s
 
 static vrcvisnd_t vrcvi;
 
+/* move a channel's output to level at time */
+INLINE void vrcvi_output(int32 *output, float time, int32 level)
+{
+   if (level != *output)
+   {
+      apu_adddelta(time, level - *output);
+      *output = level;
+   }
+}
+
+#define VRCVI_RECTANGLE_OUTPUT(chan) ((chan)->enabled ? (((chan)->adder < (chan)->duty_flip) ? -(chan)->volume : (chan)->volume) : 0)
+#define VRCVI_SAWTOOTH_OUTPUT(chan) ((chan)->enabled ? ((chan)->output_acc >> 3) << 9 : 0)
+
 /* VRCVI rectangle wave generation */
-static int32 vrcvi_rectangle(vrcvirectangle_t *chan)
+static void vrcvi_rectangle(vrcvirectangle_t *chan, int num_samples)
 {
+   float t, span;
+
    /* reg0: 0-3=volume, 4-6=duty cycle
    ** reg1: 8 bits of freq
    ** reg2: 0-3=high freq, 7=enable
    */
 
-   chan->accum -= vrcvi.incsize; /* # of clocks per wave cycle */
-   while (chan->accum < 0)
+   vrcvi_output(&chan->output, 0, VRCVI_RECTANGLE_OUTPUT(chan));
+
+   span = num_samples * vrcvi.incsize; /* # of clocks in the block */
+   for (t = chan->accum; t < span; t += chan->freq)
    {
-      chan->accum += chan->freq;
       chan->adder = (chan->adder + 1) & 0x0F;
+      vrcvi_output(&chan->output, t / vrcvi.incsize, VRCVI_RECTANGLE_OUTPUT(chan));
    }
 
-   /* return if not enabled */
-   if (false == chan->enabled)
-      return 0;
-
-   if (chan->adder < chan->duty_flip)
-      return -(chan->volume);
-   else
-      return chan->volume;
+   chan->accum = t - span;
 }
 
 /* VRCVI sawtooth wave generation */
-static int32 vrcvi_sawtooth(vrcvisawtooth_t *chan)
+static void vrcvi_sawtooth(vrcvisawtooth_t *chan, int num_samples)
 {
+   float t, span;
+
    /* reg0: 0-5=phase accumulator bits
    ** reg1: 8 bits of freq
    ** reg2: 0-3=high freq, 7=enable
    */
 
-   chan->accum -= vrcvi.incsize; /* # of clocks per wav cycle */
-   while (chan->accum < 0)
+   vrcvi_output(&chan->output, 0, VRCVI_SAWTOOTH_OUTPUT(chan));
+
+   span = num_samples * vrcvi.incsize; /* # of clocks in the block */
+   for (t = chan->accum; t < span; t += chan->freq)
    {
-      chan->accum += chan->freq;
       chan->output_acc += chan->volume;
 
       chan->adder++;
@@ -109,25 +126,19 @@ static int32 vrcvi_sawtooth(vrcvisawtooth_t *chan)
          chan->adder = 0;
          chan->output_acc = 0;
       }
-   }
 
-   /* return if not enabled */
-   if (false == chan->enabled)
-      return 0;
+      vrcvi_output(&chan->output, t / vrcvi.incsize, VRCVI_SAWTOOTH_OUTPUT(chan));
+   }
 
-   return (chan->output_acc >> 3) << 9;
+   chan->accum = t - span;
 }
 
 /* mix vrcvi sound channels together */
-static int32 vrcvi_process(void)
+static void vrcvi_process(int num_samples)
 {
-   int32 output;
-
-   output = vrcvi_rectangle(&vrcvi.rectangle[0]);
-   output += vrcvi_rectangle(&vrcvi.rectangle[1]);
-   output += vrcvi_sawtooth(&vrcvi.saw);
-
-   return output;
+   vrcvi_rectangle(&vrcvi.rectangle[0], num_samples);
+   vrcvi_rectangle(&vrcvi.rectangle[1], num_samples);
+   vrcvi_sawtooth(&vrcvi.saw, num_samples);
 }
 
 /* write to registers */
@@ -188,6 +199,11 @@ static void vrcvi_reset(void)
    apu_getcontext(&apu);
    vrcvi.incsize = apu.cycle_rate;
 
+   /* the apu has just emptied its mix */
+   vrcvi.rectangle[0].output = 0;
+   vrcvi.rectangle[1].output = 0;
+   vrcvi.saw.output = 0;
+
    /* preload regs */
    for (i = 0; i < 3; i++)
    {